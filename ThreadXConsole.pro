@@ -6,11 +6,18 @@ CONFIG -= qt
 SOURCES += \
     application.c \
     console.c \
+    console_benchmark.c \
     console_callbacks.c \
     gui.c \
+    log.c \
+    metrics.c \
     main.c \
+    profiler.c \
     sf_console/sf_cmd_comms.c \
     sf_console/sf_console.c \
+    sf_console/sf_console_jobs.c \
+    sf_console/sf_console_rpc.c \
+    sf_console/sf_replay_comms.c \
 
 win32: LIBS += -L$$PWD/./ -ltx
 
@@ -23,12 +30,18 @@ HEADERS += \
     application.h \
     console.h \
     gui.h \
+    log.h \
+    metrics.h \
+    profiler.h \
     sf_console/sf_cmd_comms.h \
     sf_console/sf_comms_api.h \
     sf_console/sf_console.h \
     sf_console/sf_console_api.h \
     sf_console/sf_console_cfg.h \
+    sf_console/sf_console_jobs.h \
+    sf_console/sf_console_rpc.h \
     sf_console/sf_console_private_api.h \
+    sf_console/sf_replay_comms.h \
     tx_api.h \
     tx_port.h
 
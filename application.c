@@ -3,11 +3,19 @@
  *****************************************************************************/
 #include "application.h"
 #include "tx_api.h"
+#include <ctype.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
 /* Features */
 #include "console.h"
+#include "log.h"
+#include "profiler.h"
 #include "gui.h"
 
 /******************************************************************************
@@ -17,21 +25,57 @@
 /******************************************************************************
  * GLOBALS
  *****************************************************************************/
+static char const * const g_log_dependencies[] = { "Log", NULL };
+
 feature_t g_features[] =
 {
+    /* First, so the features after it can log. Writers may be using the ring
+     * at any time, so it is never stopped */
+    {
+        .feature_name = "Log",
+        .autostart = true,
+        .feature_define = log_define,
+        .feature_get_status = log_get_status,
+        .feature_start = log_start,
+        .feature_suspend = log_suspend,
+        .feature_stop = NULL
+    },
     {
         .feature_name = "Application",
+        .autostart = true,
+        .p_dependencies = g_log_dependencies,
         .feature_define = application_define,
-        .feature_get_status = application_get_status
+        .feature_get_status = application_get_status,
+        .feature_start = application_start,
+        .feature_suspend = application_suspend,
+        .feature_stop = application_stop
     },
+    /* The console is how features are started, so it is never stopped */
     {
         .feature_name = "Console",
+        .autostart = true,
+        .p_dependencies = g_log_dependencies,
         .feature_define = console_define,
-        .feature_get_status = console_get_status
+        .feature_get_status = console_get_status,
+        .feature_start = NULL,
+        .feature_suspend = NULL,
+        .feature_stop = NULL
+    },
+    /* Started by the top command, or by hand */
+    {
+        .feature_name = "Profiler",
+        .autostart = false,
+        .p_dependencies = g_log_dependencies,
+        .feature_define = profiler_define,
+        .feature_get_status = profiler_get_status,
+        .feature_start = profiler_start,
+        .feature_suspend = profiler_suspend,
+        .feature_stop = profiler_stop
     },
 #if 0
     {
         .feature_name = "GUI - GUIX",
+        .autostart = false,
         .feature_define = gui_define,
         .feature_get_status = gui_get_status
     }
@@ -58,20 +102,44 @@ application_t g_application =
     /* Features */
     .p_features                 = g_features,
     .feature_count              = sizeof(g_features) / sizeof(g_features[0]),
+    .feature_lock_name          = "Feature Lock",
+};
+
+static metric_t g_application_metrics[APPLICATION_METRIC_COUNT] =
+{
+    METRICS_THREAD("thread"),
+    METRICS_POOL("pool"),
+    METRIC_COUNTER("periods"),
+    METRIC_GAUGE("features_running"),
+};
+
+static char const * const g_feature_state_names[] =
+{
+    "Stopped",
+    "Running",
+    "Suspended",
 };
 
 /******************************************************************************
  * PROTOTYPES
  *****************************************************************************/
+static feature_t * application_dependency_get(feature_t const * p_feature, ULONG dependency_num);
+static UINT application_feature_start_locked(feature_t * p_feature, ULONG depth);
+static ULONG application_boot_wave_plan(ULONG wave);
+static void application_boot_wave_run(ULONG wave);
+static void application_boot_feature_define(feature_t * p_feature);
+static void application_boot_worker_entry(ULONG worker_num);
+static void application_boot_path_find(void);
+static void application_boot_release(void);
 
 /******************************************************************************
  * FUNCTION: application_define
  *****************************************************************************/
-void application_define(TX_BYTE_POOL * p_memory_pool)
+UINT application_define(TX_BYTE_POOL * p_memory_pool)
 {
     UINT tx_err = TX_SUCCESS;
 
-    printf("Initializing application...\r\n");
+    LOG_INFO("Initializing application...");
 
     /* FOR MAIN THREAD: */
     /* Allocate the stack */
@@ -81,7 +149,8 @@ void application_define(TX_BYTE_POOL * p_memory_pool)
                               TX_NO_WAIT);
     if(TX_SUCCESS != tx_err)
     {
-        printf("Failed application_tx_define::tx_byte_allocate, tx_err = %d\r\n", tx_err);
+        LOG_ERROR("Failed application_tx_define::tx_byte_allocate, tx_err = %d", tx_err);
+        return tx_err;
     }
 
     /* Create the thread.  */
@@ -97,8 +166,12 @@ void application_define(TX_BYTE_POOL * p_memory_pool)
                               TX_AUTO_START);
     if(TX_SUCCESS != tx_err)
     {
-        printf("Failed application_tx_define::tx_thread_create, tx_err = %d\r\n", tx_err);
+        LOG_ERROR("Failed application_tx_define::tx_thread_create, tx_err = %d", tx_err);
+        tx_byte_release(g_application.p_thread_stack);
+        g_application.p_thread_stack = NULL;
     }
+
+    return tx_err;
 }
 
 /******************************************************************************
@@ -106,7 +179,20 @@ void application_define(TX_BYTE_POOL * p_memory_pool)
  *****************************************************************************/
 void application_get_status(feature_status_t * p_status)
 {
+    ULONG running = 0;
+
+    for(ULONG feature_num = 0; feature_num < g_application.feature_count; feature_num++)
+    {
+        running += (FEATURE_STATE_RUNNING == g_application.p_features[feature_num].state) ? 1U : 0U;
+    }
+
+    metrics_thread_collect(&g_application_metrics[APPLICATION_METRIC_THREAD], &g_application.thread);
+    metrics_pool_collect(&g_application_metrics[APPLICATION_METRIC_POOL], &g_application.memory_byte_pool);
+    metric_set(&g_application_metrics[APPLICATION_METRIC_RUNNING], running);
 
+    p_status->return_code   = 0;
+    p_status->p_metrics     = g_application_metrics;
+    p_status->metric_count  = APPLICATION_METRIC_COUNT;
 }
 
 /******************************************************************************
@@ -118,7 +204,7 @@ void application_thread_entry(ULONG thread_input)
     static ULONG    prev_ticks  = 0;
     static time_t   prev_time   = 0;
 
-    printf("Started application\r\n");
+    LOG_INFO("Started application");
 
     while(1)
     {
@@ -131,8 +217,9 @@ void application_thread_entry(ULONG thread_input)
         {
             prev_ticks += elapsed_ticks;
             prev_time += elapsed_time;
+            metric_add(&g_application_metrics[APPLICATION_METRIC_PERIODS], 1U);
 #if 0
-            printf("APPLICATION: Ticks = %010d, Time = %010d(%03d)\r\n",
+            LOG_INFO("APPLICATION: Ticks = %010d, Time = %010d(%03d)",
                    (int)prev_ticks, (int)prev_time, (int)elapsed_time);
 #endif
         }
@@ -140,3 +227,637 @@ void application_thread_entry(ULONG thread_input)
         tx_thread_sleep(APPLICATION_THREAD_PERIOD - elapsed_ticks);
     }
 }
+
+/******************************************************************************
+ * FUNCTION: application_start
+ *****************************************************************************/
+UINT application_start(void)
+{
+    return tx_thread_resume(&g_application.thread);
+}
+
+/******************************************************************************
+ * FUNCTION: application_suspend
+ *****************************************************************************/
+UINT application_suspend(void)
+{
+    return tx_thread_suspend(&g_application.thread);
+}
+
+/******************************************************************************
+ * FUNCTION: application_stop
+ *****************************************************************************/
+UINT application_stop(void)
+{
+    UINT tx_err = tx_thread_terminate(&g_application.thread);
+    if(TX_SUCCESS == tx_err)
+    {
+        tx_err = tx_thread_delete(&g_application.thread);
+    }
+    if(TX_SUCCESS != tx_err)
+    {
+        return tx_err;
+    }
+
+    tx_err = tx_byte_release(g_application.p_thread_stack);
+    g_application.p_thread_stack = 0;
+
+    return tx_err;
+}
+
+/******************************************************************************
+ * FUNCTION: application_features_define
+ *****************************************************************************/
+void application_features_define(void)
+{
+    UINT tx_err = tx_mutex_create(&g_application.feature_lock, g_application.feature_lock_name, TX_INHERIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        printf("Failed application_features_define::tx_mutex_create, tx_err = %d\r\n", tx_err);
+    }
+
+    tx_err = tx_event_flags_create(&g_application.boot_events, BOOT_EVENTS_NAME);
+    if(TX_SUCCESS != tx_err)
+    {
+        printf("Failed application_features_define::tx_event_flags_create, tx_err = %d\r\n", tx_err);
+    }
+
+    /* Features are defined by the boot thread once the kernel runs */
+    tx_err = tx_byte_allocate(&g_application.memory_byte_pool,
+                              (VOID **) &g_application.p_boot_thread_stack,
+                              BOOT_THREAD_STACK_SIZE,
+                              TX_NO_WAIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        printf("Failed application_features_define::tx_byte_allocate, tx_err = %d\r\n", tx_err);
+        return;
+    }
+
+    tx_err = tx_thread_create(&g_application.boot_thread,
+                              BOOT_THREAD_NAME,
+                              application_boot_thread_entry,
+                              0,
+                              g_application.p_boot_thread_stack,
+                              BOOT_THREAD_STACK_SIZE,
+                              BOOT_THREAD_PRIORITY,
+                              BOOT_THREAD_PRIORITY,
+                              TX_NO_TIME_SLICE,
+                              TX_AUTO_START);
+    if(TX_SUCCESS != tx_err)
+    {
+        printf("Failed application_features_define::tx_thread_create, tx_err = %d\r\n", tx_err);
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: application_boot_thread_entry
+ *****************************************************************************/
+void application_boot_thread_entry(ULONG thread_input)
+{
+    (void) thread_input;
+
+    /* Features cannot be started or stopped from the console until boot ends */
+    tx_mutex_get(&g_application.feature_lock, TX_WAIT_FOREVER);
+
+    g_application.boot_start_us = application_time_us();
+    ULONG start_ticks = tx_time_get();
+
+    for(ULONG worker_num = 0; worker_num < BOOT_WORKERS_MAX; worker_num++)
+    {
+        UINT tx_err = tx_byte_allocate(&g_application.memory_byte_pool,
+                                       (VOID **) &g_application.p_boot_worker_stacks[worker_num],
+                                       BOOT_THREAD_STACK_SIZE,
+                                       TX_NO_WAIT);
+        if(TX_SUCCESS != tx_err)
+        {
+            /* Features left without a worker are defined by the boot thread */
+            g_application.p_boot_worker_stacks[worker_num] = NULL;
+            LOG_ERROR("Failed application_boot_thread_entry::tx_byte_allocate, tx_err = %d", tx_err);
+        }
+    }
+
+    for(ULONG feature_num = 0; feature_num < g_application.feature_count; feature_num++)
+    {
+        g_application.p_features[feature_num].boot.wave = BOOT_WAVE_NONE;
+    }
+
+    ULONG wave = 0;
+    while(0U != application_boot_wave_plan(wave))
+    {
+        application_boot_wave_run(wave);
+        wave++;
+    }
+
+    g_application.boot_waves    = wave;
+    g_application.boot_ticks    = tx_time_get() - start_ticks;
+    g_application.boot_us       = application_time_us() - g_application.boot_start_us;
+
+    for(ULONG worker_num = 0; worker_num < BOOT_WORKERS_MAX; worker_num++)
+    {
+        if(NULL != g_application.p_boot_worker_stacks[worker_num])
+        {
+            tx_byte_release(g_application.p_boot_worker_stacks[worker_num]);
+            g_application.p_boot_worker_stacks[worker_num] = NULL;
+        }
+    }
+
+    /* What is left depends on a feature that is unknown, not started at boot,
+     * failed to define, or on itself through others */
+    for(ULONG feature_num = 0; feature_num < g_application.feature_count; feature_num++)
+    {
+        feature_t *p_feature = &g_application.p_features[feature_num];
+        if(p_feature->autostart && (BOOT_WAVE_NONE == p_feature->boot.wave))
+        {
+            LOG_ERROR("Failed application_boot_thread_entry, dependencies of %s never started",
+                      p_feature->feature_name);
+        }
+    }
+
+    application_boot_path_find();
+    g_application.boot_done = true;
+    LOG_INFO("Booted in %lu waves, %lu ticks", g_application.boot_waves, g_application.boot_ticks);
+
+    tx_mutex_put(&g_application.feature_lock);
+}
+
+/******************************************************************************
+ * FUNCTION: application_boot_wave_plan
+ *****************************************************************************/
+static ULONG application_boot_wave_plan(ULONG wave)
+{
+    ULONG feature_count = 0;
+
+    /* A feature joins the wave once every dependency was defined by an
+     * earlier one, so features of the same wave never depend on each other.
+     * Features whose dependencies failed to define are never planned */
+    for(ULONG feature_num = 0; feature_num < g_application.feature_count; feature_num++)
+    {
+        feature_t   *p_feature  = &g_application.p_features[feature_num];
+        bool        ready       = p_feature->autostart && (BOOT_WAVE_NONE == p_feature->boot.wave);
+
+        for(ULONG dependency_num = 0; ready && (NULL != p_feature->p_dependencies) &&
+                                      (NULL != p_feature->p_dependencies[dependency_num]); dependency_num++)
+        {
+            feature_t *p_dependency = application_dependency_get(p_feature, dependency_num);
+            ready = (NULL != p_dependency) && (p_dependency->boot.wave < wave) &&
+                    (FEATURE_STATE_RUNNING == p_dependency->state);
+        }
+
+        if(ready)
+        {
+            p_feature->boot.wave = wave;
+            feature_count++;
+        }
+    }
+
+    return feature_count;
+}
+
+/******************************************************************************
+ * FUNCTION: application_boot_wave_run
+ *****************************************************************************/
+static void application_boot_wave_run(ULONG wave)
+{
+    ULONG worker_count  = 0;
+    ULONG feature_num   = 0;
+
+    while(feature_num <= g_application.feature_count)
+    {
+        feature_t *p_feature = (feature_num < g_application.feature_count) ?
+                               &g_application.p_features[feature_num] : NULL;
+
+        /* Wait for the workers when all are busy or the wave is handed out */
+        if((NULL == p_feature) || (BOOT_WORKERS_MAX == worker_count))
+        {
+            if(0U != worker_count)
+            {
+                ULONG actual_flags = 0;
+                tx_event_flags_get(&g_application.boot_events,
+                                   (1UL << worker_count) - 1U,
+                                   TX_AND_CLEAR,
+                                   &actual_flags,
+                                   TX_WAIT_FOREVER);
+                for(ULONG worker_num = 0; worker_num < worker_count; worker_num++)
+                {
+                    tx_thread_terminate(&g_application.boot_workers[worker_num]);
+                    tx_thread_delete(&g_application.boot_workers[worker_num]);
+                }
+                worker_count = 0;
+            }
+            if(NULL == p_feature)
+            {
+                break;
+            }
+        }
+
+        feature_num++;
+        if(wave != p_feature->boot.wave)
+        {
+            continue;
+        }
+
+        UINT tx_err = TX_NO_MEMORY;
+        if(NULL != g_application.p_boot_worker_stacks[worker_count])
+        {
+            g_application.boot_worker_features[worker_count] = feature_num - 1U;
+            snprintf(g_application.boot_worker_names[worker_count], THREAD_OBJECT_NAME_LENGTH_MAX,
+                     BOOT_WORKER_THREAD_NAME, worker_count);
+            tx_err = tx_thread_create(&g_application.boot_workers[worker_count],
+                                      g_application.boot_worker_names[worker_count],
+                                      application_boot_worker_entry,
+                                      worker_count,
+                                      g_application.p_boot_worker_stacks[worker_count],
+                                      BOOT_THREAD_STACK_SIZE,
+                                      BOOT_THREAD_PRIORITY,
+                                      BOOT_THREAD_PRIORITY,
+                                      BOOT_WORKER_TIME_SLICE,
+                                      TX_AUTO_START);
+        }
+
+        if(TX_SUCCESS == tx_err)
+        {
+            worker_count++;
+        }
+        else
+        {
+            application_boot_feature_define(p_feature);
+        }
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: application_boot_worker_entry
+ *****************************************************************************/
+static void application_boot_worker_entry(ULONG worker_num)
+{
+    ULONG feature_num = g_application.boot_worker_features[worker_num];
+
+    application_boot_feature_define(&g_application.p_features[feature_num]);
+    tx_event_flags_set(&g_application.boot_events, 1UL << worker_num, TX_OR);
+}
+
+/******************************************************************************
+ * FUNCTION: application_boot_feature_define
+ *****************************************************************************/
+static void application_boot_feature_define(feature_t * p_feature)
+{
+    uint64_t    start_us    = application_time_us();
+    ULONG       start_ticks = tx_time_get();
+
+    UINT tx_err = p_feature->feature_define(&g_application.memory_byte_pool);
+    if(TX_SUCCESS == tx_err)
+    {
+        p_feature->state = FEATURE_STATE_RUNNING;
+    }
+    else
+    {
+        LOG_ERROR("Failed application_boot_feature_define, %s, tx_err = %d", p_feature->feature_name, tx_err);
+    }
+
+    p_feature->boot.define_err      = tx_err;
+    p_feature->boot.define_ticks    = tx_time_get() - start_ticks;
+    p_feature->boot.define_us       = application_time_us() - start_us;
+    p_feature->boot.start_us        = start_us - g_application.boot_start_us;
+}
+
+/******************************************************************************
+ * FUNCTION: application_boot_path_find
+ *****************************************************************************/
+static void application_boot_path_find(void)
+{
+    /* Waves are in dependency order, so the paths of the dependencies of a
+     * feature are known before its own */
+    for(ULONG wave = 0; wave < g_application.boot_waves; wave++)
+    {
+        for(ULONG feature_num = 0; feature_num < g_application.feature_count; feature_num++)
+        {
+            feature_t *p_feature = &g_application.p_features[feature_num];
+            if(wave != p_feature->boot.wave)
+            {
+                continue;
+            }
+
+            p_feature->boot.path_us         = 0;
+            p_feature->boot.path_previous   = BOOT_FEATURE_NONE;
+            for(ULONG dependency_num = 0; (NULL != p_feature->p_dependencies) &&
+                                          (NULL != p_feature->p_dependencies[dependency_num]); dependency_num++)
+            {
+                feature_t *p_dependency = application_dependency_get(p_feature, dependency_num);
+                if(p_dependency->boot.path_us >= p_feature->boot.path_us)
+                {
+                    p_feature->boot.path_us         = p_dependency->boot.path_us;
+                    p_feature->boot.path_previous   = (ULONG) (p_dependency - g_application.p_features);
+                }
+            }
+            p_feature->boot.path_us += p_feature->boot.define_us;
+        }
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: application_boot_path_last
+ *****************************************************************************/
+ULONG application_boot_path_last(void)
+{
+    ULONG last = BOOT_FEATURE_NONE;
+
+    for(ULONG feature_num = 0; feature_num < g_application.feature_count; feature_num++)
+    {
+        feature_t const *p_feature = &g_application.p_features[feature_num];
+        if((BOOT_WAVE_NONE != p_feature->boot.wave) &&
+           ((BOOT_FEATURE_NONE == last) || (p_feature->boot.path_us > g_application.p_features[last].boot.path_us)))
+        {
+            last = feature_num;
+        }
+    }
+
+    return last;
+}
+
+/******************************************************************************
+ * FUNCTION: application_boot_release
+ *****************************************************************************/
+static void application_boot_release(void)
+{
+    /* The boot thread cannot give back its own stack, the first feature
+     * change after boot does it. Called with the feature lock held, so boot
+     * is done with everything but returning */
+    if(g_application.boot_done && (NULL != g_application.p_boot_thread_stack))
+    {
+        tx_thread_terminate(&g_application.boot_thread);
+        tx_thread_delete(&g_application.boot_thread);
+        tx_byte_release(g_application.p_boot_thread_stack);
+        g_application.p_boot_thread_stack = NULL;
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: application_dependency_get
+ *****************************************************************************/
+static feature_t * application_dependency_get(feature_t const * p_feature, ULONG dependency_num)
+{
+    char const *p_name = p_feature->p_dependencies[dependency_num];
+
+    return application_feature_find(p_name, (uint32_t) strlen(p_name));
+}
+
+/******************************************************************************
+ * FUNCTION: application_feature_find
+ *****************************************************************************/
+feature_t * application_feature_find(char const * p_name, uint32_t length)
+{
+    /* Names are matched case insensitive, p_name need not be terminated */
+    for(ULONG feature_num = 0; feature_num < g_application.feature_count; feature_num++)
+    {
+        char const  *p_feature_name = g_application.p_features[feature_num].feature_name;
+        uint32_t    char_num        = 0;
+
+        while((char_num < length) &&
+              (tolower((unsigned char) p_name[char_num]) == tolower((unsigned char) p_feature_name[char_num])))
+        {
+            char_num++;
+        }
+        if((char_num == length) && ('\0' == p_feature_name[char_num]))
+        {
+            return &g_application.p_features[feature_num];
+        }
+    }
+
+    return NULL;
+}
+
+/******************************************************************************
+ * FUNCTION: application_feature_start
+ *****************************************************************************/
+UINT application_feature_start(feature_t * p_feature)
+{
+    UINT tx_err = tx_mutex_get(&g_application.feature_lock, TX_WAIT_FOREVER);
+    if(TX_SUCCESS != tx_err)
+    {
+        return tx_err;
+    }
+    application_boot_release();
+
+    tx_err = application_feature_start_locked(p_feature, 0);
+
+    tx_mutex_put(&g_application.feature_lock);
+
+    return tx_err;
+}
+
+/******************************************************************************
+ * FUNCTION: application_feature_start_locked
+ *****************************************************************************/
+static UINT application_feature_start_locked(feature_t * p_feature, ULONG depth)
+{
+    UINT tx_err = TX_SUCCESS;
+
+    /* Deeper than there are features means the dependencies go round */
+    if(depth > g_application.feature_count)
+    {
+        return TX_NOT_AVAILABLE;
+    }
+
+    if(FEATURE_STATE_STOPPED == p_feature->state)
+    {
+        /* Dependencies are started first, and resumed if suspended */
+        for(ULONG dependency_num = 0; (TX_SUCCESS == tx_err) && (NULL != p_feature->p_dependencies) &&
+                                      (NULL != p_feature->p_dependencies[dependency_num]); dependency_num++)
+        {
+            feature_t *p_dependency = application_dependency_get(p_feature, dependency_num);
+            tx_err = (NULL != p_dependency) ? application_feature_start_locked(p_dependency, depth + 1U) :
+                                              TX_NOT_AVAILABLE;
+        }
+        if(TX_SUCCESS != tx_err)
+        {
+            return tx_err;
+        }
+
+        /* Defined on first start, and again after every stop */
+        tx_err = p_feature->feature_define(&g_application.memory_byte_pool);
+        if(TX_SUCCESS == tx_err)
+        {
+            p_feature->state = FEATURE_STATE_RUNNING;
+        }
+    }
+    else if(FEATURE_STATE_SUSPENDED == p_feature->state)
+    {
+        tx_err = (NULL != p_feature->feature_start) ? p_feature->feature_start() : TX_NOT_AVAILABLE;
+        if(TX_SUCCESS == tx_err)
+        {
+            p_feature->state = FEATURE_STATE_RUNNING;
+        }
+    }
+
+    return tx_err;
+}
+
+/******************************************************************************
+ * FUNCTION: application_feature_suspend
+ *****************************************************************************/
+UINT application_feature_suspend(feature_t * p_feature)
+{
+    UINT tx_err = tx_mutex_get(&g_application.feature_lock, TX_WAIT_FOREVER);
+    if(TX_SUCCESS != tx_err)
+    {
+        return tx_err;
+    }
+    application_boot_release();
+
+    if(FEATURE_STATE_RUNNING == p_feature->state)
+    {
+        tx_err = (NULL != p_feature->feature_suspend) ? p_feature->feature_suspend() : TX_NOT_AVAILABLE;
+        if(TX_SUCCESS == tx_err)
+        {
+            p_feature->state = FEATURE_STATE_SUSPENDED;
+        }
+    }
+    else if(FEATURE_STATE_STOPPED == p_feature->state)
+    {
+        tx_err = TX_NOT_AVAILABLE;
+    }
+
+    tx_mutex_put(&g_application.feature_lock);
+
+    return tx_err;
+}
+
+/******************************************************************************
+ * FUNCTION: application_feature_stop
+ *****************************************************************************/
+UINT application_feature_stop(feature_t * p_feature)
+{
+    UINT tx_err = tx_mutex_get(&g_application.feature_lock, TX_WAIT_FOREVER);
+    if(TX_SUCCESS != tx_err)
+    {
+        return tx_err;
+    }
+    application_boot_release();
+
+    /* Features that depend on it are stopped first */
+    for(ULONG feature_num = 0; feature_num < g_application.feature_count; feature_num++)
+    {
+        feature_t const *p_dependent = &g_application.p_features[feature_num];
+
+        for(ULONG dependency_num = 0; (FEATURE_STATE_STOPPED != p_dependent->state) &&
+                                      (NULL != p_dependent->p_dependencies) &&
+                                      (NULL != p_dependent->p_dependencies[dependency_num]); dependency_num++)
+        {
+            if(p_feature == application_dependency_get(p_dependent, dependency_num))
+            {
+                tx_err = TX_NOT_DONE;
+            }
+        }
+    }
+
+    /* A suspended feature is stopped the same way, its threads are
+     * terminated wherever they were held */
+    if((TX_SUCCESS == tx_err) && (FEATURE_STATE_STOPPED != p_feature->state))
+    {
+        tx_err = (NULL != p_feature->feature_stop) ? p_feature->feature_stop() : TX_NOT_AVAILABLE;
+        if(TX_SUCCESS == tx_err)
+        {
+            p_feature->state = FEATURE_STATE_STOPPED;
+        }
+    }
+
+    tx_mutex_put(&g_application.feature_lock);
+
+    return tx_err;
+}
+
+/******************************************************************************
+ * FUNCTION: application_feature_state_name
+ *****************************************************************************/
+char const * application_feature_state_name(feature_state_t state)
+{
+    return (state < (sizeof(g_feature_state_names) / sizeof(g_feature_state_names[0]))) ?
+           g_feature_state_names[state] : "?";
+}
+
+/******************************************************************************
+ * FUNCTION: application_feature_status_get
+ *****************************************************************************/
+bool application_feature_status_get(feature_t * p_feature, feature_status_t * p_status)
+{
+    /* A stopped feature has nothing to report, and the lock keeps it from
+     * stopping while its threads are looked at */
+    p_status->return_code   = 0;
+    p_status->p_metrics     = NULL;
+    p_status->metric_count  = 0;
+
+    if(TX_SUCCESS != tx_mutex_get(&g_application.feature_lock, TX_WAIT_FOREVER))
+    {
+        return false;
+    }
+
+    bool running = (FEATURE_STATE_STOPPED != p_feature->state);
+    if(running)
+    {
+        p_feature->feature_get_status(p_status);
+    }
+
+    tx_mutex_put(&g_application.feature_lock);
+
+    return running;
+}
+
+/******************************************************************************
+ * FUNCTION: application_time_us
+ *****************************************************************************/
+uint64_t application_time_us(void)
+{
+    /* Monotonic microseconds for measurements finer than a tick */
+#if defined(_WIN32)
+    static LARGE_INTEGER    frequency   = { 0 };
+    LARGE_INTEGER           counter     = { 0 };
+
+    if(0 == frequency.QuadPart)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+
+    return ((uint64_t) (counter.QuadPart / frequency.QuadPart) * 1000000U) +
+           (((uint64_t) (counter.QuadPart % frequency.QuadPart) * 1000000U) / (uint64_t) frequency.QuadPart);
+#else
+    struct timespec now = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t) now.tv_sec * 1000000U) + ((uint64_t) now.tv_nsec / 1000U);
+#endif
+}
+
+/******************************************************************************
+ * FUNCTION: application_option_find
+ *****************************************************************************/
+bool application_option_find(char const * p_option)
+{
+    for(int arg_num = 1; arg_num < g_application.argc; arg_num++)
+    {
+        if(0 == strcmp(g_application.argv[arg_num], p_option))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/******************************************************************************
+ * FUNCTION: application_option_value
+ *****************************************************************************/
+char const * application_option_value(char const * p_option)
+{
+    /* The value is the argument after the option, NULL if either is missing */
+    for(int arg_num = 1; arg_num < (g_application.argc - 1); arg_num++)
+    {
+        if(0 == strcmp(g_application.argv[arg_num], p_option))
+        {
+            return g_application.argv[arg_num + 1];
+        }
+    }
+
+    return NULL;
+}
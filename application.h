@@ -5,37 +5,119 @@
  * INCLUDES
  *****************************************************************************/
 #include "tx_api.h"
+#include "metrics.h"
+#include <stdbool.h>
+#include <stdint.h>
 
 /******************************************************************************
  * CONSTANTS
  *****************************************************************************/
 #define APPLICATION_THREAD_PERIOD       (TX_TIMER_TICKS_PER_SECOND)
-#define APPLICATION_MEMORY_MAX          (8192U)
+/* The pool is carved out of the port's first unused memory, which the
+ * Win32 port reserves TX_WIN32_MEMORY_SIZE bytes for */
+#if defined(TX_WIN32_MEMORY_SIZE)
+#define APPLICATION_MEMORY_MAX          (TX_WIN32_MEMORY_SIZE)
+#else
+#define APPLICATION_MEMORY_MAX          (64000U)
+#endif
 #define APPLICATION_THREAD_STACK_SIZE   (1024U)
 
 #define THREAD_OBJECT_NAME_LENGTH_MAX   (32)
 #define FEATURE_NAME_MAX_LENGTH         (32)
 
+/* Boot thread that defines the autostart features in waves, each wave holds
+ * the features whose dependencies were all defined by earlier waves. Up to
+ * BOOT_WORKERS_MAX features of a wave are defined at once, by workers that
+ * share the boot priority and a time slice */
+#define BOOT_THREAD_NAME                ("Boot Thread")
+#define BOOT_WORKER_THREAD_NAME         ("Boot Worker %lu")
+#define BOOT_EVENTS_NAME                ("Boot Events")
+#define BOOT_THREAD_STACK_SIZE          (APPLICATION_THREAD_STACK_SIZE)
+#define BOOT_THREAD_PRIORITY            (0)
+#define BOOT_WORKER_TIME_SLICE          (1)
+#define BOOT_WORKERS_MAX                (4U)
+#define BOOT_WAVE_NONE                  (0xFFFFFFFFUL)
+#define BOOT_FEATURE_NONE               (0xFFFFFFFFUL)
+
+/* Metrics of the application feature, indexes into g_application_metrics */
+#define APPLICATION_METRIC_THREAD       (0U)
+#define APPLICATION_METRIC_POOL         (APPLICATION_METRIC_THREAD + METRICS_THREAD_COUNT)
+#define APPLICATION_METRIC_PERIODS      (APPLICATION_METRIC_POOL + METRICS_POOL_COUNT)
+#define APPLICATION_METRIC_RUNNING      (APPLICATION_METRIC_PERIODS + 1U)
+#define APPLICATION_METRIC_COUNT        (APPLICATION_METRIC_RUNNING + 1U)
+
 /******************************************************************************
  * TYPES
  *****************************************************************************/
 typedef struct st_feature_status
 {
     ULONG return_code;
+
+    /* Metrics the feature publishes, brought up to date by feature_get_status
+     * and read with metric_read. NULL when it publishes none */
+    metric_t const * p_metrics;
+    ULONG metric_count;
 } feature_status_t;
 
+typedef enum e_feature_state
+{
+    FEATURE_STATE_STOPPED,
+    FEATURE_STATE_RUNNING,
+    FEATURE_STATE_SUSPENDED,
+} feature_state_t;
+
+/* Definition of a feature during boot, times are in microseconds of
+ * application_time_us unless in ticks */
+typedef struct st_feature_boot
+{
+    ULONG       wave;           /* BOOT_WAVE_NONE when not defined at boot */
+    UINT        define_err;     /* Returned by feature_define */
+    uint64_t    start_us;       /* From the start of boot */
+    ULONG       define_ticks;
+    uint64_t    define_us;
+
+    /* Longest chain of definitions ending with this feature, and the
+     * dependency it goes through, for the critical path */
+    uint64_t    path_us;
+    ULONG       path_previous;
+} feature_boot_t;
+
 typedef struct st_feature
 {
     /* Readable name */
     CHAR feature_name[FEATURE_NAME_MAX_LENGTH];
 
-    /* Function to be called with tx_application_define.
-     * - Allocates memory from p_memory_pool for everything */
-    void (*feature_define)(TX_BYTE_POOL * p_memory_pool);
+    /* When true, the feature is defined with tx_application_define. Otherwise
+     * it is only defined the first time it is started */
+    bool autostart;
+
+    /* Function to be called when the feature starts from stopped.
+     * - Allocates memory from p_memory_pool for everything
+     * - Returns a ThreadX error code, the feature only runs on TX_SUCCESS.
+     *   A feature that has a stop hook gives back what it took on failure */
+    UINT (*feature_define)(TX_BYTE_POOL * p_memory_pool);
 
     /* Function to be use by console (or other features in general?) to get the status
      * of the feature */
     void (*feature_get_status)(feature_status_t * p_status);
+
+    /* Lifecycle hooks, NULL when the feature cannot do it. Suspend holds the
+     * threads of the feature and start resumes them. Stop terminates and
+     * deletes the threads and releases all memory to the pool, the next start
+     * defines the feature again. Each returns a ThreadX error code */
+    UINT (*feature_start)(void);
+    UINT (*feature_suspend)(void);
+    UINT (*feature_stop)(void);
+
+    /* Names of the features that must be defined first, NULL terminated. NULL
+     * when the feature depends on nothing */
+    char const * const * p_dependencies;
+
+    /* Changed by the application_feature_* functions only */
+    feature_state_t state;
+
+    /* Measured while booting, see application_boot_thread_entry */
+    feature_boot_t boot;
 } feature_t;
 
 typedef struct st_application
@@ -57,6 +139,28 @@ typedef struct st_application
 
     feature_t       *p_features;
     ULONG           feature_count;
+
+    /* Serialises starting, suspending and stopping features */
+    TX_MUTEX        feature_lock;
+    CHAR            feature_lock_name[THREAD_OBJECT_NAME_LENGTH_MAX];
+
+    /* Boot */
+    TX_THREAD       boot_thread;
+    VOID            *p_boot_thread_stack;
+    TX_THREAD       boot_workers[BOOT_WORKERS_MAX];
+    CHAR            boot_worker_names[BOOT_WORKERS_MAX][THREAD_OBJECT_NAME_LENGTH_MAX];
+    VOID            *p_boot_worker_stacks[BOOT_WORKERS_MAX];
+    ULONG           boot_worker_features[BOOT_WORKERS_MAX];
+    TX_EVENT_FLAGS_GROUP boot_events;
+    bool volatile   boot_done;
+    ULONG           boot_waves;
+    ULONG           boot_ticks;
+    uint64_t        boot_start_us;
+    uint64_t        boot_us;
+
+    /* Command line of the process, for features with options */
+    int             argc;
+    char            **argv;
 } application_t;
 
 /******************************************************************************
@@ -67,8 +171,23 @@ extern application_t    g_application;
 /******************************************************************************
  * PROTOTYPES
  *****************************************************************************/
-void application_define(TX_BYTE_POOL * p_memory_pool);
+UINT application_define(TX_BYTE_POOL * p_memory_pool);
 void application_get_status(feature_status_t * p_status);
 void application_thread_entry(ULONG thread_input);
+UINT application_start(void);
+UINT application_suspend(void);
+UINT application_stop(void);
+void application_features_define(void);
+void application_boot_thread_entry(ULONG thread_input);
+ULONG application_boot_path_last(void);
+feature_t * application_feature_find(char const * p_name, uint32_t length);
+UINT application_feature_start(feature_t * p_feature);
+UINT application_feature_suspend(feature_t * p_feature);
+UINT application_feature_stop(feature_t * p_feature);
+char const * application_feature_state_name(feature_state_t state);
+bool application_feature_status_get(feature_t * p_feature, feature_status_t * p_status);
+uint64_t application_time_us(void);
+bool application_option_find(char const * p_option);
+char const * application_option_value(char const * p_option);
 
 #endif // APPLICATION_H
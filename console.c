@@ -3,6 +3,15 @@
  *****************************************************************************/
 #include "console.h"
 #include "sf_cmd_comms.h"
+#include <stdlib.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
 
 /******************************************************************************
  * CONSTANTS
@@ -11,112 +20,499 @@
 /******************************************************************************
  * PROTOTYPES
  *****************************************************************************/
+static UINT console_session_define(TX_BYTE_POOL * p_memory_pool, console_transport_t transport);
+static bool console_session_connect(console_session_t * p_session);
+static void console_session_disconnect(console_session_t * p_session);
+static void console_history_load(console_session_t * p_session);
+static void console_history_save(console_session_t * p_session);
+static void console_batch_run(console_session_t * p_session);
+static void console_record_open(console_session_t * p_session);
+static void console_replay_report(console_session_t * p_session);
 
 /******************************************************************************
  * GLOBALS
  *****************************************************************************/
 console_t * gp_console = 0;
 
+/* Transport of each session. The comms driver reads and writes CRT file
+ * descriptors, which winsock handles are not, so Windows hosts only get the
+ * stdio session */
+static console_transport_t const g_console_session_transports[] =
+{
+    CONSOLE_TRANSPORT_STDIO,
+#if !defined(_WIN32)
+    CONSOLE_TRANSPORT_UNIX_SOCKET,
+#endif
+};
+
+/* Argument of the feature lifecycle commands, names with spaces are quoted */
+static sf_console_arg_spec_t const g_feature_args[] =
+{
+    {
+        .name           = (uint8_t *) "feature_name",
+        .type           = SF_CONSOLE_ARG_TYPE_STRING,
+        .optional       = false
+    },
+};
+
+static sf_console_arg_spec_t const g_metrics_args[] =
+{
+    {
+        .name           = (uint8_t *) "feature_name",
+        .type           = SF_CONSOLE_ARG_TYPE_STRING,
+        .optional       = true
+    },
+};
+
+/* Units the custom command can show the field in, see custom_code_callback */
+static uint8_t const * const g_custom_code_units[] =
+{
+    (uint8_t const *) "uT",
+    (uint8_t const *) "mT",
+};
+
+/* Arguments of the custom command, checked by the console before the
+ * callback runs */
+static sf_console_arg_spec_t const g_custom_code_args[] =
+{
+    {
+        .name           = (uint8_t *) "max_current",
+        .type           = SF_CONSOLE_ARG_TYPE_FLOAT,
+        .optional       = true
+    },
+    {
+        .name           = (uint8_t *) "steps",
+        .type           = SF_CONSOLE_ARG_TYPE_INT,
+        .optional       = true
+    },
+    {
+        .name           = (uint8_t *) "unit",
+        .type           = SF_CONSOLE_ARG_TYPE_ENUM,
+        .optional       = true,
+        .p_choices      = g_custom_code_units,
+        .num_choices    = sizeof(g_custom_code_units) / sizeof(g_custom_code_units[0])
+    },
+};
+
+/* Levels the log level command takes, in the order of log_level_t */
+static uint8_t const * const g_log_level_choices[] =
+{
+    (uint8_t const *) "debug",
+    (uint8_t const *) "info",
+    (uint8_t const *) "warning",
+    (uint8_t const *) "error",
+};
+
+static sf_console_arg_spec_t const g_log_level_args[] =
+{
+    {
+        .name           = (uint8_t *) "level",
+        .type           = SF_CONSOLE_ARG_TYPE_ENUM,
+        .optional       = true,
+        .p_choices      = g_log_level_choices,
+        .num_choices    = sizeof(g_log_level_choices) / sizeof(g_log_level_choices[0])
+    },
+};
+
 /* Assigns the callback functions to each command */
 sf_console_command_t            g_console_commands[] =
 {
     {
         .command    = (uint8_t *) "feature start",
-        .help       = (uint8_t *) "Starts a feature. USAGE: feature start <feature_name> (NOT IMPLEMENTED)",
+        .help       = (uint8_t *) "Starts a feature, defining it if it was stopped. USAGE: feature start <feature_name>",
         .callback   = feature_start_callback,
-        .context    = NULL
+        .context    = NULL,
+        .flags      = SF_CONSOLE_COMMAND_FLAG_ASYNC,
+        .p_arg_specs    = g_feature_args,
+        .num_arg_specs  = sizeof(g_feature_args) / sizeof(g_feature_args[0])
+    },
+    {
+        .command    = (uint8_t *) "feature suspend",
+        .help       = (uint8_t *) "Holds the threads of a feature. USAGE: feature suspend <feature_name>",
+        .callback   = feature_suspend_callback,
+        .context    = NULL,
+        .flags      = SF_CONSOLE_COMMAND_FLAG_ASYNC,
+        .p_arg_specs    = g_feature_args,
+        .num_arg_specs  = sizeof(g_feature_args) / sizeof(g_feature_args[0])
     },
     {
         .command    = (uint8_t *) "feature stop",
-        .help       = (uint8_t *) "Stops a feature. USAGE: feature stop <feature_name> (NOT IMPLEMENTED)",
-        .callback   = feature_start_callback,
-        .context    = NULL
+        .help       = (uint8_t *) "Stops a feature and releases its memory. USAGE: feature stop <feature_name>",
+        .callback   = feature_stop_callback,
+        .context    = NULL,
+        .flags      = SF_CONSOLE_COMMAND_FLAG_ASYNC,
+        .p_arg_specs    = g_feature_args,
+        .num_arg_specs  = sizeof(g_feature_args) / sizeof(g_feature_args[0])
     },
     {
         .command    = (uint8_t *) "feature status",
-        .help       = (uint8_t *) "Starts a feature.",
+        .help       = (uint8_t *) "Shows the state and status of every feature.",
         .callback   = feature_status_callback,
         .context    = NULL
     },
+    {
+        .command    = (uint8_t *) "metrics",
+        .help       = (uint8_t *) "Shows the metrics of every running feature, or of one. USAGE: metrics [feature_name]",
+        .callback   = metrics_callback,
+        .context    = NULL,
+        .p_arg_specs    = g_metrics_args,
+        .num_arg_specs  = sizeof(g_metrics_args) / sizeof(g_metrics_args[0])
+    },
+    {
+        .command    = (uint8_t *) "boot report",
+        .help       = (uint8_t *) "Shows when each feature was defined at boot, and the critical path.",
+        .callback   = boot_report_callback,
+        .context    = NULL
+    },
+    {
+        .command    = (uint8_t *) "top",
+        .help       = (uint8_t *) "Shows busy time split by thread runs over the last second. Use watch 1 top to follow it.",
+        .callback   = top_callback,
+        .context    = NULL
+    },
+    {
+        .command    = (uint8_t *) "comms stats",
+        .help       = (uint8_t *) "Shows lock contention statistics of the console transport.",
+        .callback   = comms_stats_callback,
+        .context    = NULL
+    },
+    {
+        .command    = (uint8_t *) "log stats",
+        .help       = (uint8_t *) "Shows messages written and dropped by the log, per level.",
+        .callback   = log_stats_callback,
+        .context    = NULL
+    },
+    {
+        .command    = (uint8_t *) "log level",
+        .help       = (uint8_t *) "Shows or sets the lowest level the log writes.",
+        .callback   = log_level_callback,
+        .context    = NULL,
+        .p_arg_specs    = g_log_level_args,
+        .num_arg_specs  = sizeof(g_log_level_args) / sizeof(g_log_level_args[0])
+    },
     {
         .command    = (uint8_t *) "custom",
-        .help       = (uint8_t *) "Does some custom code.",
+        .help       = (uint8_t *) "Tabulates the field around a wire. Defaults: max_current 2 A, 10 steps, uT.",
         .callback   = custom_code_callback,
+        .context    = NULL,
+        .flags      = SF_CONSOLE_COMMAND_FLAG_ASYNC,
+        .p_arg_specs    = g_custom_code_args,
+        .num_arg_specs  = sizeof(g_custom_code_args) / sizeof(g_custom_code_args[0])
+    },
+    {
+        .command    = (uint8_t *) "bench parse",
+        .help       = (uint8_t *) "Compares indexed and linear command lookup with 10, 100 and 1000 commands.",
+        .callback   = benchmark_parse_callback,
+        .context    = NULL
+    },
+    {
+        .command    = (uint8_t *) "bench edit",
+        .help       = (uint8_t *) "Counts transport writes per keystroke while editing a line.",
+        .callback   = benchmark_edit_callback,
+        .context    = NULL
+    },
+    {
+        .command    = (uint8_t *) "bench help",
+        .help       = (uint8_t *) "Counts transport writes per help request, with and without help memory.",
+        .callback   = benchmark_help_callback,
         .context    = NULL
     },
 };
 
+/* One METRICS_THREAD for each of the CONSOLE_SESSIONS_MAX sessions */
+static metric_t g_console_metrics[CONSOLE_METRIC_COUNT] =
+{
+    METRIC_GAUGE("sessions"),
+    METRIC_COUNTER("commands"),
+    METRICS_THREAD("session0"),
+    METRICS_THREAD("session1"),
+};
+
+/* Latency of each command, in the order of g_console_commands. Shared by
+ * every session, see the perf command */
+static sf_console_command_stats_t g_console_command_stats[sizeof(g_console_commands) / sizeof(g_console_commands[0])];
+
 /******************************************************************************
  * FUNCTION: console_define
  *****************************************************************************/
-void console_define(TX_BYTE_POOL * p_memory_pool)
+UINT console_define(TX_BYTE_POOL * p_memory_pool)
 {
     UINT tx_err = TX_SUCCESS;
 
-    printf("Initializing console...\r\n");
+    LOG_INFO("Initializing console...");
 
     /* Allocate memory for the console object */
     tx_err = tx_byte_allocate(p_memory_pool,
                               (VOID **) &gp_console,
                               sizeof(console_t),
                               TX_NO_WAIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        LOG_ERROR("Failed console_tx_define::tx_byte_allocate, tx_err = %d", tx_err);
+        gp_console = NULL;
+        return tx_err;
+    }
 
     /* Initialize the console object */
     memset((void *)gp_console, 0, sizeof(console_t));
-    snprintf(gp_console->thread_name, THREAD_OBJECT_NAME_LENGTH_MAX, CONSOLE_THREAD_NAME);
-    gp_console->thread_entry                    = console_thread_entry;
-    gp_console->thread_input                    = 0; // TODO: Use for something useful
-    gp_console->thread_stack_size               = CONSOLE_THREAD_STACK_SIZE;
-    gp_console->thread_priority                 = CONSOLE_THREAD_PRIORITY;
-    gp_console->thread_preempt_threshold        = CONSOLE_THREAD_PREEMPT_THRESHOLD;
-    gp_console->sf_comms_cfg.p_extend           = &gp_console->sf_comms_cfg_extend;
-    gp_console->sf_comms_api.open               = SF_CMD_COMMS_Open,
-    gp_console->sf_comms_api.close              = SF_CMD_COMMS_Close,
-    gp_console->sf_comms_api.read               = SF_CMD_COMMS_Read,
-    gp_console->sf_comms_api.write              = SF_CMD_COMMS_Write,
-    gp_console->sf_comms_api.lock               = SF_CMD_COMMS_Lock,
-    gp_console->sf_comms_api.unlock             = SF_CMD_COMMS_Unlock,
-    gp_console->sf_comms.p_api                  = &gp_console->sf_comms_api;
-    gp_console->sf_comms.p_cfg                  = &gp_console->sf_comms_cfg;
-    gp_console->sf_comms.p_ctrl                 = &gp_console->sf_comms_ctrl;
     gp_console->p_sf_console_commands           = &g_console_commands;
     gp_console->sf_console_menu.menu_prev       = NULL;
     gp_console->sf_console_menu.menu_name       = (uint8_t*) "#";
     gp_console->sf_console_menu.num_commands    = sizeof(g_console_commands) / sizeof(g_console_commands[0]);
     gp_console->sf_console_menu.command_list    = g_console_commands;
-    gp_console->sf_console_cfg.p_comms          = &gp_console->sf_comms;
-    gp_console->sf_console_cfg.p_initial_menu   = &gp_console->sf_console_menu;
-    gp_console->sf_console_cfg.echo             = true;
-    gp_console->sf_console_cfg.autostart        = false;
-    gp_console->sf_console.p_ctrl               = &gp_console->sf_console_instance_ctrl;
-    gp_console->sf_console.p_cfg                = &gp_console->sf_console_cfg;
-    gp_console->sf_console.p_api                = &g_sf_console_on_sf_console;
+    gp_console->sf_console_menu.p_stats         = g_console_command_stats;
+
+#if !defined(_WIN32)
+    /* A session whose operator disconnects must see a failed write, not end the process */
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    benchmark_define();
+
+    gp_console->batch_mode      = application_option_find(CONSOLE_BATCH_OPTION);
+    gp_console->p_record_path   = application_option_value(CONSOLE_RECORD_OPTION);
+    gp_console->p_replay_path   = application_option_value(CONSOLE_REPLAY_OPTION);
+
+    /* Allocate the stacks for the workers, which run async commands of every session */
+    tx_err = tx_byte_allocate(p_memory_pool,
+                              (VOID **) &gp_console->p_worker_stacks,
+                              CONSOLE_WORKER_COUNT * CONSOLE_WORKER_STACK_SIZE,
+                              TX_NO_WAIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        LOG_ERROR("Failed console_define::tx_byte_allocate, tx_err = %d", tx_err);
+    }
+    else
+    {
+        gp_console->sf_console_jobs_cfg.p_worker_stacks     = gp_console->p_worker_stacks;
+        gp_console->sf_console_jobs_cfg.worker_stack_size   = CONSOLE_WORKER_STACK_SIZE;
+        gp_console->sf_console_jobs_cfg.worker_count        = CONSOLE_WORKER_COUNT;
+        gp_console->sf_console_jobs_cfg.worker_priority     = CONSOLE_WORKER_PRIORITY;
+        gp_console->sf_console_jobs_cfg.worker_time_slice   = CONSOLE_WORKER_TIME_SLICE;
+
+        /* Without workers, async commands run on the session thread as before */
+        fsp_err_t fsp_err = SF_CONSOLE_JobsOpen(&gp_console->sf_console_jobs, &gp_console->sf_console_jobs_cfg);
+        if(FSP_SUCCESS != fsp_err)
+        {
+            LOG_ERROR("Failed console_define::SF_CONSOLE_JobsOpen, fsp_err = %d", fsp_err);
+        }
+    }
+
+    /* A batch run only has the stdio session, it must not take the socket
+     * over from an interactive instance */
+    ULONG session_count = sizeof(g_console_session_transports) / sizeof(g_console_session_transports[0]);
+    if(gp_console->batch_mode)
+    {
+        session_count = 1;
+    }
+
+    /* Neither does a replay, which stands in for the operator of the stdio session */
+    if(NULL != gp_console->p_replay_path)
+    {
+        return console_session_define(p_memory_pool, CONSOLE_TRANSPORT_REPLAY);
+    }
+
+    /* The console runs with the sessions that could be defined. It is never
+     * stopped, so what it took is kept even when none could */
+    for(ULONG session_num = 0; session_num < session_count; session_num++)
+    {
+        UINT session_err = console_session_define(p_memory_pool, g_console_session_transports[session_num]);
+        if(TX_SUCCESS != session_err)
+        {
+            tx_err = session_err;
+        }
+    }
+
+    return (0U != gp_console->session_count) ? TX_SUCCESS : tx_err;
+}
+
+/******************************************************************************
+ * FUNCTION: console_session_define
+ *****************************************************************************/
+static UINT console_session_define(TX_BYTE_POOL * p_memory_pool, console_transport_t transport)
+{
+    UINT                tx_err      = TX_SUCCESS;
+    console_session_t   *p_session  = NULL;
+
+    if(gp_console->session_count >= CONSOLE_SESSIONS_MAX)
+    {
+        LOG_ERROR("Failed console_session_define, no more than %u sessions", CONSOLE_SESSIONS_MAX);
+        return TX_NOT_AVAILABLE;
+    }
+
+    /* Allocate memory for the session object */
+    tx_err = tx_byte_allocate(p_memory_pool,
+                              (VOID **) &p_session,
+                              sizeof(console_session_t),
+                              TX_NO_WAIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        LOG_ERROR("Failed console_session_define::tx_byte_allocate, tx_err = %d", tx_err);
+        return tx_err;
+    }
+
+    /* Initialize the session object, the thread input is its session number */
+    memset((void *)p_session, 0, sizeof(console_session_t));
+    snprintf(p_session->thread_name, THREAD_OBJECT_NAME_LENGTH_MAX, CONSOLE_THREAD_NAME, gp_console->session_count);
+    p_session->thread_entry                     = console_thread_entry;
+    p_session->thread_input                     = gp_console->session_count;
+    p_session->thread_stack_size                = CONSOLE_THREAD_STACK_SIZE;
+    p_session->thread_priority                  = CONSOLE_THREAD_PRIORITY;
+    p_session->thread_preempt_threshold         = CONSOLE_THREAD_PREEMPT_THRESHOLD;
+    p_session->thread_time_slice                = CONSOLE_THREAD_TIME_SLICE;
+    p_session->transport                        = transport;
+    p_session->listen_fd                        = -1;
+    p_session->connection_fd                    = -1;
+    p_session->sf_comms_cfg_extend.rx_fd        = 0; /* stdin */
+    p_session->sf_comms_cfg_extend.tx_fd        = 1; /* stdout */
+    p_session->sf_comms_cfg_extend.buffered     = true;
+    p_session->sf_comms_cfg_extend.hangup_on_eof = (CONSOLE_TRANSPORT_STDIO != transport);
+    p_session->sf_comms_cfg_extend.rx_thread_stack_size = CONSOLE_RX_THREAD_STACK_SIZE;
+    p_session->sf_comms_cfg_extend.rx_thread_priority   = CONSOLE_RX_THREAD_PRIORITY;
+    p_session->sf_comms_cfg_extend.rx_thread_time_slice = CONSOLE_RX_THREAD_TIME_SLICE;
+    p_session->sf_comms_cfg_extend.record_fd    = -1;
+    p_session->sf_comms_cfg_extend.p_time_us    = application_time_us;
+    p_session->sf_comms_cfg.p_extend            = &p_session->sf_comms_cfg_extend;
+    p_session->sf_comms_api.open                = SF_CMD_COMMS_Open,
+    p_session->sf_comms_api.close               = SF_CMD_COMMS_Close,
+    p_session->sf_comms_api.read                = SF_CMD_COMMS_Read,
+    p_session->sf_comms_api.write               = SF_CMD_COMMS_Write,
+    p_session->sf_comms_api.lock                = SF_CMD_COMMS_Lock,
+    p_session->sf_comms_api.unlock              = SF_CMD_COMMS_Unlock,
+    p_session->sf_comms_api.readSpan            = SF_CMD_COMMS_ReadSpan,
+    p_session->sf_comms_api.readRelease         = SF_CMD_COMMS_ReadRelease,
+    p_session->sf_comms_api.writeSpan           = SF_CMD_COMMS_WriteSpan,
+    p_session->sf_comms_api.writeCommit         = SF_CMD_COMMS_WriteCommit,
+    p_session->sf_comms.p_api                   = &p_session->sf_comms_api;
+    p_session->sf_comms.p_cfg                   = &p_session->sf_comms_cfg;
+    p_session->sf_comms.p_ctrl                  = &p_session->sf_comms_ctrl;
+    if(NULL != gp_console->p_record_path)
+    {
+        snprintf(p_session->record_path, CONSOLE_RECORD_PATH_LENGTH_MAX, CONSOLE_RECORD_PATH,
+                 gp_console->p_record_path, gp_console->session_count);
+    }
+
+    /* A replay swaps the transport for one that reads the recording and compares the output with it */
+    if(CONSOLE_TRANSPORT_REPLAY == transport)
+    {
+        p_session->sf_replay_comms_cfg_extend.rx_fd         = -1;
+        p_session->sf_replay_comms_cfg_extend.tx_fd         = -1;
+        p_session->sf_replay_comms_cfg_extend.paced         = application_option_find(CONSOLE_PACED_OPTION);
+        p_session->sf_replay_comms_cfg_extend.sync_timeout  = CONSOLE_REPLAY_SYNC_TIMEOUT;
+        p_session->sf_replay_comms_cfg_extend.p_time_us     = application_time_us;
+        p_session->sf_comms_cfg.p_extend        = &p_session->sf_replay_comms_cfg_extend;
+        memset(&p_session->sf_comms_api, 0, sizeof(sf_comms_api_t));
+        p_session->sf_comms_api.open            = SF_REPLAY_COMMS_Open;
+        p_session->sf_comms_api.close           = SF_REPLAY_COMMS_Close;
+        p_session->sf_comms_api.read            = SF_REPLAY_COMMS_Read;
+        p_session->sf_comms_api.write           = SF_REPLAY_COMMS_Write;
+        p_session->sf_comms_api.lock            = SF_REPLAY_COMMS_Lock;
+        p_session->sf_comms_api.unlock          = SF_REPLAY_COMMS_Unlock;
+        p_session->sf_comms.p_ctrl              = &p_session->sf_replay_comms_ctrl;
+    }
+    p_session->sf_console_cfg.p_comms           = &p_session->sf_comms;
+    p_session->sf_console_cfg.p_initial_menu    = &gp_console->sf_console_menu;
+    p_session->sf_console_cfg.echo              = true;
+    p_session->sf_console_cfg.autostart         = false;
+    p_session->sf_console_cfg.index_memory_size = CONSOLE_INDEX_MEMORY_SIZE;
+    p_session->sf_console_cfg.help_memory_size  = CONSOLE_HELP_MEMORY_SIZE;
+    p_session->sf_console_cfg.p_jobs            = gp_console->sf_console_jobs.open ? &gp_console->sf_console_jobs : NULL;
+    p_session->sf_console_cfg.p_time_us         = application_time_us;
+    p_session->sf_console_cfg.rpc               = true;
+    p_session->sf_console_cfg.output            = SF_CONSOLE_OUTPUT_TEXT;
+    p_session->sf_console.p_ctrl                = &p_session->sf_console_instance_ctrl;
+    p_session->sf_console.p_cfg                 = &p_session->sf_console_cfg;
+    p_session->sf_console.p_api                 = &g_sf_console_on_sf_console;
 
     /* Allocate the stack for the thread */
     tx_err = tx_byte_allocate(p_memory_pool,
-                              (VOID **) &gp_console->p_thread_stack,
-                              gp_console->thread_stack_size,
+                              (VOID **) &p_session->p_thread_stack,
+                              p_session->thread_stack_size,
+                              TX_NO_WAIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        LOG_ERROR("Failed console_session_define::tx_byte_allocate, tx_err = %d", tx_err);
+        tx_byte_release(p_session);
+        return tx_err;
+    }
+
+    /* Allocate the stack for the RX thread, which the comms driver creates when opened */
+    tx_err = tx_byte_allocate(p_memory_pool,
+                              (VOID **) &p_session->p_rx_thread_stack,
+                              CONSOLE_RX_THREAD_STACK_SIZE,
                               TX_NO_WAIT);
     if(TX_SUCCESS != tx_err)
     {
-        printf("Failed console_tx_define::tx_byte_allocate, tx_err = %d\r\n", tx_err);
+        LOG_ERROR("Failed console_session_define::tx_byte_allocate, tx_err = %d", tx_err);
     }
+    p_session->sf_comms_cfg_extend.p_rx_thread_stack = p_session->p_rx_thread_stack;
+
+    /* Allocate the memory for the command index, which the console builds when opened */
+    tx_err = tx_byte_allocate(p_memory_pool,
+                              (VOID **) &p_session->p_index_memory,
+                              CONSOLE_INDEX_MEMORY_SIZE,
+                              TX_NO_WAIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        LOG_ERROR("Failed console_session_define::tx_byte_allocate, tx_err = %d", tx_err);
+    }
+    p_session->sf_console_cfg.p_index_memory    = p_session->p_index_memory;
+
+    /* Allocate the memory the help menu is rendered into, which the console fills on the first help request */
+    tx_err = tx_byte_allocate(p_memory_pool,
+                              (VOID **) &p_session->p_help_memory,
+                              CONSOLE_HELP_MEMORY_SIZE,
+                              TX_NO_WAIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        LOG_ERROR("Failed console_session_define::tx_byte_allocate, tx_err = %d", tx_err);
+    }
+    p_session->sf_console_cfg.p_help_memory     = p_session->p_help_memory;
+
+    /* Allocate the memory for the command history, which is kept across connections through the history file */
+    tx_err = tx_byte_allocate(p_memory_pool,
+                              (VOID **) &p_session->p_history_memory,
+                              CONSOLE_HISTORY_MEMORY_SIZE,
+                              TX_NO_WAIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        LOG_ERROR("Failed console_session_define::tx_byte_allocate, tx_err = %d", tx_err);
+    }
+    p_session->sf_console_cfg.p_history_memory      = p_session->p_history_memory;
+    p_session->sf_console_cfg.history_memory_size   = CONSOLE_HISTORY_MEMORY_SIZE;
+    snprintf(p_session->history_path, CONSOLE_HISTORY_PATH_LENGTH_MAX, CONSOLE_HISTORY_PATH, p_session->thread_input);
+
+    /* Allocate the memory scripts are read and compiled into */
+    tx_err = tx_byte_allocate(p_memory_pool,
+                              (VOID **) &p_session->p_batch_memory,
+                              CONSOLE_BATCH_MEMORY_SIZE,
+                              TX_NO_WAIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        LOG_ERROR("Failed console_session_define::tx_byte_allocate, tx_err = %d", tx_err);
+    }
+    p_session->sf_console_cfg.p_batch_memory    = p_session->p_batch_memory;
+    p_session->sf_console_cfg.batch_memory_size = CONSOLE_BATCH_MEMORY_SIZE;
+
+    gp_console->p_sessions[gp_console->session_count++] = p_session;
 
     /* Create the thread.  */
-    tx_err = tx_thread_create(&gp_console->thread,
-                              gp_console->thread_name,
-                              gp_console->thread_entry,
-                              gp_console->thread_input,
-                              gp_console->p_thread_stack,
-                              gp_console->thread_stack_size,
-                              gp_console->thread_priority,
-                              gp_console->thread_preempt_threshold,
-                              TX_NO_TIME_SLICE,
+    tx_err = tx_thread_create(&p_session->thread,
+                              p_session->thread_name,
+                              p_session->thread_entry,
+                              p_session->thread_input,
+                              p_session->p_thread_stack,
+                              p_session->thread_stack_size,
+                              p_session->thread_priority,
+                              p_session->thread_preempt_threshold,
+                              p_session->thread_time_slice,
                               TX_AUTO_START);
     if(TX_SUCCESS != tx_err)
     {
-        printf("Failed console_tx_define::tx_thread_create, tx_err = %d\r\n", tx_err);
+        LOG_ERROR("Failed console_session_define::tx_thread_create, tx_err = %d", tx_err);
     }
+
+    return tx_err;
 }
 
 /******************************************************************************
@@ -124,7 +520,30 @@ void console_define(TX_BYTE_POOL * p_memory_pool)
  *****************************************************************************/
 void console_get_status(feature_status_t * p_status)
 {
+    ULONG commands = 0;
+
+    if(NULL == gp_console)
+    {
+        return;
+    }
+
+    /* Calls are counted by the console as it times them */
+    for(ULONG command_num = 0; command_num < (sizeof(g_console_command_stats) / sizeof(g_console_command_stats[0])); command_num++)
+    {
+        commands += g_console_command_stats[command_num].count;
+    }
+
+    metric_set(&g_console_metrics[CONSOLE_METRIC_SESSIONS], gp_console->session_count);
+    metric_set(&g_console_metrics[CONSOLE_METRIC_COMMANDS], commands);
+    for(ULONG session_num = 0; session_num < gp_console->session_count; session_num++)
+    {
+        metrics_thread_collect(&g_console_metrics[CONSOLE_METRIC_SESSION_THREADS + (session_num * METRICS_THREAD_COUNT)],
+                               &gp_console->p_sessions[session_num]->thread);
+    }
 
+    p_status->return_code   = 0;
+    p_status->p_metrics     = g_console_metrics;
+    p_status->metric_count  = CONSOLE_METRIC_COUNT;
 }
 
 /******************************************************************************
@@ -132,31 +551,362 @@ void console_get_status(feature_status_t * p_status)
  *****************************************************************************/
 void console_thread_entry(ULONG thread_input)
 {
-    static ULONG            prev_ticks  = 0;
     fsp_err_t               fsp_err     = FSP_SUCCESS;
-    sf_console_instance_t   *p_console  = &gp_console->sf_console;
+    console_session_t       *p_session  = gp_console->p_sessions[thread_input];
+    sf_console_instance_t   *p_console  = &p_session->sf_console;
+
+    LOG_INFO("Started console session %lu", thread_input);
+
+    if(gp_console->batch_mode && (CONSOLE_TRANSPORT_STDIO == p_session->transport))
+    {
+        console_batch_run(p_session);
+        return;
+    }
+
+    while(1)
+    {
+        /* Wait for an operator, the stdio session always has one */
+        if(!console_session_connect(p_session))
+        {
+            return;
+        }
+
+        console_record_open(p_session);
+
+        fsp_err = p_console->p_api->open(p_console->p_ctrl, p_console->p_cfg);
+        if(FSP_SUCCESS != fsp_err)
+        {
+            LOG_ERROR("Failed console_thread_entry::p_console->p_api->open, fsp_err = %d", fsp_err);
+            console_session_disconnect(p_session);
+
+            /* A recording that cannot be read does not get any better */
+            if(CONSOLE_TRANSPORT_REPLAY == p_session->transport)
+            {
+                log_flush();
+                exit(EXIT_FAILURE);
+            }
+            tx_thread_sleep(CONSOLE_THREAD_PERIOD);
+            continue;
+        }
+
+        console_history_load(p_session);
+
+        fsp_err = p_console->p_api->write(p_console->p_ctrl, "\r\nWelcome to Grutter's example ThreadX System Developer\r\nEnter '?' for a list of commands...\r\n", 100);
+        if(FSP_SUCCESS != fsp_err)
+        {
+            LOG_ERROR("Failed console_thread_entry::p_console->p_api->write, fsp_err = %d", fsp_err);
+        }
+
+        while(1)
+        {
+            /* Returns with FSP_ERR_TIMEOUT while the line is idle, which leaves room to service other work here */
+            fsp_err = p_console->p_api->prompt(p_console->p_ctrl, &gp_console->sf_console_menu, CONSOLE_PROMPT_TIMEOUT);
+            if(FSP_ERR_TIMEOUT == fsp_err)
+            {
+                continue;
+            }
+            else if(FSP_ERR_ABORTED == fsp_err)
+            {
+                /* The operator hung up or the transport failed */
+                break;
+            }
+            else if(FSP_SUCCESS != fsp_err)
+            {
+                LOG_ERROR("Failed console_thread_entry::p_console->p_api->prompt, fsp_err = %d", fsp_err);
+            }
+
+            /* A line was entered, which the history now ends with */
+            console_history_save(p_session);
+        }
+
+        p_console->p_api->close(p_console->p_ctrl);
+        console_session_disconnect(p_session);
+
+        /* A replay runs once, its outcome is the status of the process */
+        if(CONSOLE_TRANSPORT_REPLAY == p_session->transport)
+        {
+            console_replay_report(p_session);
+        }
+
+        /* stdin does not come back any sooner by retrying straight away */
+        if(CONSOLE_TRANSPORT_STDIO == p_session->transport)
+        {
+            tx_thread_sleep(CONSOLE_THREAD_PERIOD);
+        }
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: console_session_connect
+ *****************************************************************************/
+static bool console_session_connect(console_session_t * p_session)
+{
+    if(CONSOLE_TRANSPORT_STDIO == p_session->transport)
+    {
+        return true;
+    }
+
+    if(CONSOLE_TRANSPORT_REPLAY == p_session->transport)
+    {
+        /* Input and expected output are read from the recording at their own pace */
+        p_session->p_replay_rx_file = fopen(gp_console->p_replay_path, "rb");
+        p_session->p_replay_tx_file = fopen(gp_console->p_replay_path, "rb");
+        if((NULL == p_session->p_replay_rx_file) || (NULL == p_session->p_replay_tx_file))
+        {
+            LOG_ERROR("Failed console_session_connect::fopen, path = %s", gp_console->p_replay_path);
+            log_flush();
+            exit(EXIT_FAILURE);
+        }
+
+        p_session->sf_replay_comms_cfg_extend.rx_fd = fileno(p_session->p_replay_rx_file);
+        p_session->sf_replay_comms_cfg_extend.tx_fd = fileno(p_session->p_replay_tx_file);
+        return true;
+    }
+
+#if !defined(_WIN32)
+    if(p_session->listen_fd < 0)
+    {
+        struct sockaddr_un address = { 0 };
+        address.sun_family = AF_UNIX;
+        snprintf(address.sun_path, sizeof(address.sun_path), "%s", CONSOLE_SOCKET_PATH);
+        unlink(CONSOLE_SOCKET_PATH);
+
+        p_session->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if((p_session->listen_fd < 0) ||
+           (0 != bind(p_session->listen_fd, (struct sockaddr *) &address, sizeof(address))) ||
+           (0 != listen(p_session->listen_fd, 1)))
+        {
+            LOG_ERROR("Failed console_session_connect::listen, path = %s", CONSOLE_SOCKET_PATH);
+            return false;
+        }
 
-    printf("Started console\r\n");
+        /* A blocked accept would hold up every thread below this one, so it is polled */
+        fcntl(p_session->listen_fd, F_SETFL, fcntl(p_session->listen_fd, F_GETFL) | O_NONBLOCK);
+        LOG_INFO("Console session %lu listening on %s", p_session->thread_input, CONSOLE_SOCKET_PATH);
+    }
+
+    while(p_session->connection_fd < 0)
+    {
+        p_session->connection_fd = accept(p_session->listen_fd, NULL, NULL);
+        if(p_session->connection_fd < 0)
+        {
+            tx_thread_sleep(CONSOLE_ACCEPT_PERIOD);
+        }
+    }
+
+    /* The comms RX thread does blocking reads */
+    fcntl(p_session->connection_fd, F_SETFL, fcntl(p_session->connection_fd, F_GETFL) & ~O_NONBLOCK);
+    p_session->sf_comms_cfg_extend.rx_fd = p_session->connection_fd;
+    p_session->sf_comms_cfg_extend.tx_fd = p_session->connection_fd;
+    return true;
+#else
+    return false;
+#endif
+}
+
+/******************************************************************************
+ * FUNCTION: console_session_disconnect
+ *****************************************************************************/
+static void console_session_disconnect(console_session_t * p_session)
+{
+    if(NULL != p_session->p_record_file)
+    {
+        fclose(p_session->p_record_file);
+        p_session->p_record_file = NULL;
+        p_session->sf_comms_cfg_extend.record = false;
+    }
+
+    if(NULL != p_session->p_replay_rx_file)
+    {
+        fclose(p_session->p_replay_rx_file);
+        p_session->p_replay_rx_file = NULL;
+    }
+
+    if(NULL != p_session->p_replay_tx_file)
+    {
+        fclose(p_session->p_replay_tx_file);
+        p_session->p_replay_tx_file = NULL;
+    }
+
+#if !defined(_WIN32)
+    if(p_session->connection_fd >= 0)
+    {
+        close(p_session->connection_fd);
+        p_session->connection_fd = -1;
+    }
+#endif
+}
+
+/******************************************************************************
+ * FUNCTION: console_history_load
+ *****************************************************************************/
+static void console_history_load(console_session_t * p_session)
+{
+    sf_console_instance_t   *p_console  = &p_session->sf_console;
+    char                    line[SF_CONSOLE_MAX_INPUT_LENGTH + 1];
+
+    /* A replay must start from the history the recording started from, which is none */
+    if((NULL == p_session->p_history_memory) || (CONSOLE_TRANSPORT_REPLAY == p_session->transport))
+    {
+        return;
+    }
+
+    /* There is no history file before the first line of the first run */
+    FILE * p_file = fopen(p_session->history_path, "r");
+    if(NULL == p_file)
+    {
+        return;
+    }
+
+    while(NULL != fgets(line, sizeof(line), p_file))
+    {
+        size_t length = strcspn(line, "\r\n");
+
+        /* A line too long to have come from the prompt is skipped along with the rest of it */
+        if(('\0' == line[length]) && !feof(p_file))
+        {
+            int ch = 0;
+            while((EOF != (ch = fgetc(p_file))) && ('\n' != ch))
+            {
+            }
+            continue;
+        }
+
+        line[length] = '\0';
+        p_console->p_api->historyAdd(p_console->p_ctrl, (uint8_t *) line);
+    }
+
+    fclose(p_file);
+}
+
+/******************************************************************************
+ * FUNCTION: console_history_save
+ *****************************************************************************/
+static void console_history_save(console_session_t * p_session)
+{
+    sf_console_instance_t   *p_console  = &p_session->sf_console;
+    uint8_t                 line[SF_CONSOLE_MAX_INPUT_LENGTH];
+
+    if((NULL == p_session->p_history_memory) || (CONSOLE_TRANSPORT_REPLAY == p_session->transport))
+    {
+        return;
+    }
+
+    FILE * p_file = fopen(p_session->history_path, "w");
+    if(NULL == p_file)
+    {
+        LOG_ERROR("Failed console_history_save::fopen, path = %s", p_session->history_path);
+        return;
+    }
+
+    /* Oldest line first, so loading adds them back in the same order */
+    for(uint32_t index = 0;
+        FSP_SUCCESS == p_console->p_api->historyGet(p_console->p_ctrl, index, line, sizeof(line));
+        index++)
+    {
+        fprintf(p_file, "%s\n", (char *) line);
+    }
+
+    fclose(p_file);
+}
+
+/******************************************************************************
+ * FUNCTION: console_batch_run
+ *****************************************************************************/
+static void console_batch_run(console_session_t * p_session)
+{
+    fsp_err_t                   fsp_err     = FSP_SUCCESS;
+    sf_console_instance_t       *p_console  = &p_session->sf_console;
+    sf_console_batch_result_t   result      = { 0 };
+
+    /* The script is read straight from stdin, so the transport must not
+     * start a reception thread that competes for it */
+    p_session->sf_comms_cfg_extend.buffered = false;
 
     fsp_err = p_console->p_api->open(p_console->p_ctrl, p_console->p_cfg);
     if(FSP_SUCCESS != fsp_err)
     {
-        printf("Failed console_thread_entry::g_sf_console0.p_api->open, fsp_err = %d\r\n", fsp_err);
+        LOG_ERROR("Failed console_batch_run::p_console->p_api->open, fsp_err = %d", fsp_err);
+        log_flush();
+        exit(EXIT_FAILURE);
     }
 
-    fsp_err = p_console->p_api->write(p_console->p_ctrl, "\r\nWelcome to Grutter's example ThreadX System Developer\r\nEnter '?' for a list of commands...\r\n", 100);
+    fsp_err = p_console->p_api->source(p_console->p_ctrl,
+                                       &gp_console->sf_console_menu,
+                                       SF_CONSOLE_SOURCE_STDIN,
+                                       &result);
     if(FSP_SUCCESS != fsp_err)
     {
-        printf("Failed console_thread_entry::g_sf_console0.p_api->write, fsp_err = %d\r\n", fsp_err);
+        LOG_ERROR("Failed console_batch_run::p_console->p_api->source, fsp_err = %d", fsp_err);
     }
 
-    while(1)
+    p_console->p_api->close(p_console->p_ctrl);
+
+    log_flush();
+    exit(((FSP_SUCCESS == fsp_err) && (0U == result.failed)) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/******************************************************************************
+ * FUNCTION: console_record_open
+ *****************************************************************************/
+static void console_record_open(console_session_t * p_session)
+{
+    if((NULL == gp_console->p_record_path) || (CONSOLE_TRANSPORT_REPLAY == p_session->transport))
     {
-        /* This version blocks, so its unclear if it is sleeping or not */
-        fsp_err = p_console->p_api->prompt(p_console->p_ctrl, &gp_console->sf_console_menu, 100);
-        if(FSP_SUCCESS != fsp_err)
-        {
-            printf("Failed console_thread_entry::g_sf_console0.p_api->write, fsp_err = %d\r\n", fsp_err);
-        }
+        return;
+    }
+
+    /* The comms driver writes the recording as the connection goes, the file only has to be there */
+    p_session->p_record_file = fopen(p_session->record_path, "wb");
+    if(NULL == p_session->p_record_file)
+    {
+        LOG_ERROR("Failed console_record_open::fopen, path = %s", p_session->record_path);
+        return;
     }
+
+    p_session->sf_comms_cfg_extend.record_fd    = fileno(p_session->p_record_file);
+    p_session->sf_comms_cfg_extend.record       = true;
+}
+
+/******************************************************************************
+ * FUNCTION: console_replay_report
+ *****************************************************************************/
+static void console_replay_report(console_session_t * p_session)
+{
+    sf_replay_comms_stats_t stats = { 0 };
+
+    SF_REPLAY_COMMS_StatsGet(&p_session->sf_replay_comms_ctrl, &stats);
+
+    ULONG differences = stats.lines_differ + stats.lines_missing + stats.lines_extra;
+
+    /* The report follows whatever was logged during the replay */
+    log_flush();
+    printf("\r\nReplay of %s %s\r\n", gp_console->p_replay_path,
+           !stats.finished ? "did not finish" : ((0U == differences) ? "matched" : "differed"));
+    printf("  input    %llu bytes in %lu exchanges, %lu stalled\r\n",
+           (unsigned long long) stats.rx_bytes, stats.exchanges, stats.stalls);
+    printf("  output   %llu bytes in %lu lines, %lu differ, %lu missing, %lu extra\r\n",
+           (unsigned long long) stats.tx_bytes, stats.lines, stats.lines_differ, stats.lines_missing,
+           stats.lines_extra);
+    printf("  elapsed  %llu us", (unsigned long long) stats.elapsed_us);
+    if(stats.elapsed_us > 0U)
+    {
+        printf(", %.1f exchanges/s", ((double) stats.exchanges * 1000000.0) / (double) stats.elapsed_us);
+    }
+    printf("\r\n");
+
+    if(stats.latency_count > 0U)
+    {
+        printf("  latency  %llu us average, %llu us max over %lu exchanges\r\n",
+               (unsigned long long) (stats.latency_total_us / stats.latency_count),
+               (unsigned long long) stats.latency_max_us, stats.latency_count);
+    }
+
+    if(0U != stats.first_difference)
+    {
+        printf("  line %lu\r\n    expected \"%s\"\r\n    actual   \"%s\"\r\n",
+               stats.first_difference, stats.expected, stats.actual);
+    }
+
+    exit((stats.finished && (0U == differences)) ? EXIT_SUCCESS : EXIT_FAILURE);
 }
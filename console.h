@@ -5,28 +5,108 @@
  * INCLUDES
  *****************************************************************************/
 #include "application.h"
+#include "log.h"
 #include "sf_console.h"
 #include "sf_console_api.h"
+#include "sf_console_jobs.h"
+#include "sf_cmd_comms.h"
+#include "sf_replay_comms.h"
 
 /******************************************************************************
  * CONSTANTS
  *****************************************************************************/
-#define CONSOLE_THREAD_NAME                 ("Console Thread")
+#define CONSOLE_THREAD_NAME                 ("Console Thread %lu")
 #define CONSOLE_THREAD_PRIORITY             (1)
 #define CONSOLE_THREAD_PREEMPT_THRESHOLD    (1)
 #define CONSOLE_THREAD_PERIOD               (TX_TIMER_TICKS_PER_SECOND)
 #define CONSOLE_THREAD_STACK_SIZE           (APPLICATION_THREAD_STACK_SIZE)
+#define CONSOLE_PROMPT_TIMEOUT              (CONSOLE_THREAD_PERIOD)
+
+/* Session threads share a priority, so a long command in one session must
+ * not keep the others from running */
+#define CONSOLE_THREAD_TIME_SLICE           (TX_TIMER_TICKS_PER_SECOND / 20)
+
+/* The RX threads sit in blocking reads, so they run below everything else
+ * and take turns with each other */
+#define CONSOLE_RX_THREAD_PRIORITY          (TX_MAX_PRIORITIES - 1)
+#define CONSOLE_RX_THREAD_STACK_SIZE        (APPLICATION_THREAD_STACK_SIZE)
+#define CONSOLE_RX_THREAD_TIME_SLICE        (1)
+
+/* Commands flagged async run on a pool of workers shared by all sessions.
+ * They run below the session threads so the prompt stays responsive, and
+ * take turns when several long commands are outstanding */
+#define CONSOLE_WORKER_COUNT                (2U)
+#define CONSOLE_WORKER_PRIORITY             (CONSOLE_THREAD_PRIORITY + 1)
+#define CONSOLE_WORKER_STACK_SIZE           (APPLICATION_THREAD_STACK_SIZE)
+#define CONSOLE_WORKER_TIME_SLICE           (TX_TIMER_TICKS_PER_SECOND / 20)
+
+/* Every session has its own threads, transport and console instance, and
+ * they all share the command tree */
+#define CONSOLE_SESSIONS_MAX                (2U)
+
+/* Metrics of the console feature, indexes into g_console_metrics. Each
+ * session has the metrics of its thread */
+#define CONSOLE_METRIC_SESSIONS             (0U)
+#define CONSOLE_METRIC_COMMANDS             (CONSOLE_METRIC_SESSIONS + 1U)
+#define CONSOLE_METRIC_SESSION_THREADS      (CONSOLE_METRIC_COMMANDS + 1U)
+#define CONSOLE_METRIC_COUNT                (CONSOLE_METRIC_SESSION_THREADS + (CONSOLE_SESSIONS_MAX * METRICS_THREAD_COUNT))
+
+/* Local socket the second session listens on, one operator at a time */
+#define CONSOLE_SOCKET_PATH                 ("/tmp/threadx_console.sock")
+#define CONSOLE_ACCEPT_PERIOD               (TX_TIMER_TICKS_PER_SECOND / 10)
+
+/* Output of command callbacks goes to the console that received the command */
+#define CONSOLE_WRITE_TIMEOUT               (TX_WAIT_FOREVER)
+#define CONSOLE_PRINTF(p_args, ...)         g_sf_console_on_sf_console.writeFormat((p_args)->p_ctrl,       \
+                                                                                   CONSOLE_WRITE_TIMEOUT,  \
+                                                                                   __VA_ARGS__)
+
+/* Command trie nodes for all menus, 8 bytes per distinct command prefix */
+#define CONSOLE_INDEX_MEMORY_SIZE           (1024U)
+
+/* Rendered help of the most recently listed menu */
+#define CONSOLE_HELP_MEMORY_SIZE            (1024U)
+
+/* Command history ring, each line takes its length plus 2 bytes. It is
+ * written to a file per session after every line and read back when the
+ * session opens, so it survives a restart */
+#define CONSOLE_HISTORY_MEMORY_SIZE         (512U)
+#define CONSOLE_HISTORY_PATH                ("threadx_console_%lu.history")
+#define CONSOLE_HISTORY_PATH_LENGTH_MAX     (64)
+
+/* Scripts run by the source command, and the one read from stdin in batch
+ * mode. Holds the script text followed by its command list */
+#define CONSOLE_BATCH_MEMORY_SIZE           (2048U)
+
+/* Command line option that makes the stdio session run stdin as a script,
+ * then end the process with a non-zero status if any command failed */
+#define CONSOLE_BATCH_OPTION                ("--batch")
+
+/* Command line option that records each session to the given path followed
+ * by its session number. A session records its latest connection only */
+#define CONSOLE_RECORD_OPTION               ("--record")
+#define CONSOLE_RECORD_PATH                 ("%s.%lu")
+#define CONSOLE_RECORD_PATH_LENGTH_MAX      (256)
+
+/* Command line option that runs one session from a recording instead of an
+ * operator, then ends the process with a non-zero status if the output
+ * differed from the recorded one. Input is given as fast as the console
+ * answers, or at the recorded pace with the paced option */
+#define CONSOLE_REPLAY_OPTION               ("--replay")
+#define CONSOLE_PACED_OPTION                ("--paced")
+#define CONSOLE_REPLAY_SYNC_TIMEOUT         (2 * TX_TIMER_TICKS_PER_SECOND)
 
 /******************************************************************************
  * TYPES
  *****************************************************************************/
-/* TODO: Define console interface functions according to SF COMMS API, use sf_uart as example */
-#if 1
-typedef void * sf_cmd_comms_instance_ctrl_t;
-typedef void * sf_cmd_comms_cfg_t;
-#endif
+typedef enum e_console_transport
+{
+    CONSOLE_TRANSPORT_STDIO,            /* stdin and stdout of the process */
+    CONSOLE_TRANSPORT_UNIX_SOCKET,      /* Connections to CONSOLE_SOCKET_PATH, POSIX hosts only */
+    CONSOLE_TRANSPORT_REPLAY,           /* A recording given with CONSOLE_REPLAY_OPTION */
+} console_transport_t;
 
-typedef struct st_console
+typedef struct st_console_session
 {
     /* Thread Related */
     TX_THREAD       thread;
@@ -37,35 +117,89 @@ typedef struct st_console
     ULONG           thread_stack_size;
     UINT            thread_priority;
     UINT            thread_preempt_threshold;
+    ULONG           thread_time_slice;
+
+    /* Transport Related */
+    console_transport_t             transport;
+    int                             listen_fd;
+    int                             connection_fd;
 
     /* CMD Interface Related */
-    sf_cmd_comms_instance_ctrl_t    sf_comms_ctrl;          /* TODO: Define console interface functions according to SF COMMS API, use sf_uart as example */
-    sf_cmd_comms_cfg_t              sf_comms_cfg_extend;    /* TODO: Define console interface functions according to SF COMMS API, use sf_uart as example */
+    VOID                            *p_rx_thread_stack;
+    sf_cmd_comms_instance_ctrl_t    sf_comms_ctrl;
+    sf_cmd_comms_cfg_t              sf_comms_cfg_extend;
     sf_comms_cfg_t                  sf_comms_cfg;
     sf_comms_api_t                  sf_comms_api;
     sf_comms_instance_t             sf_comms;
 
+    /* Recording of the current connection, NULL when not recording */
+    FILE                            *p_record_file;
+    CHAR                            record_path[CONSOLE_RECORD_PATH_LENGTH_MAX];
+
+    /* Replay Related, the recording is read through two files */
+    FILE                            *p_replay_rx_file;
+    FILE                            *p_replay_tx_file;
+    sf_replay_comms_instance_ctrl_t sf_replay_comms_ctrl;
+    sf_replay_comms_cfg_t           sf_replay_comms_cfg_extend;
+
     /* Console Related */
-    sf_console_command_t            *p_sf_console_commands;
-    sf_console_menu_t               sf_console_menu;
+    VOID                            *p_index_memory;
+    VOID                            *p_help_memory;
+    VOID                            *p_history_memory;
+    CHAR                            history_path[CONSOLE_HISTORY_PATH_LENGTH_MAX];
+    VOID                            *p_batch_memory;
     sf_console_instance_ctrl_t      sf_console_instance_ctrl;
     sf_console_cfg_t                sf_console_cfg;
     sf_console_instance_t           sf_console;
+} console_session_t;
+
+typedef struct st_console
+{
+    /* Command tree, shared read-only by all sessions */
+    sf_console_command_t            *p_sf_console_commands;
+    sf_console_menu_t               sf_console_menu;
+
+    /* Workers for async commands */
+    VOID                            *p_worker_stacks;
+    sf_console_jobs_cfg_t           sf_console_jobs_cfg;
+    sf_console_jobs_t               sf_console_jobs;
+
+    /* Sessions */
+    console_session_t               *p_sessions[CONSOLE_SESSIONS_MAX];
+    ULONG                           session_count;
+
+    /* Only the stdio session runs in batch mode, reading its script from stdin */
+    bool                            batch_mode;
+
+    /* Command line options of session recording and replay, NULL if not given */
+    char const                      *p_record_path;
+    char const                      *p_replay_path;
 } console_t;
 
 /******************************************************************************
  * PROTOTYPES
  *****************************************************************************/
-void console_define(TX_BYTE_POOL * p_memory_pool);
+UINT console_define(TX_BYTE_POOL * p_memory_pool);
 void console_get_status(feature_status_t * p_status);
 void console_thread_entry(ULONG thread_input);
+void benchmark_define(void);
 
 /******************************************************************************
  * CALLBACK FUNCTIONS
  *****************************************************************************/
 void feature_start_callback(sf_console_callback_args_t * p_args);
+void feature_suspend_callback(sf_console_callback_args_t * p_args);
 void feature_stop_callback(sf_console_callback_args_t * p_args);
 void feature_status_callback(sf_console_callback_args_t * p_args);
+void boot_report_callback(sf_console_callback_args_t * p_args);
+void metrics_callback(sf_console_callback_args_t * p_args);
+void top_callback(sf_console_callback_args_t * p_args);
+void comms_stats_callback(sf_console_callback_args_t * p_args);
+void log_stats_callback(sf_console_callback_args_t * p_args);
+void log_level_callback(sf_console_callback_args_t * p_args);
 void custom_code_callback(sf_console_callback_args_t * p_args);
+void benchmark_parse_callback(sf_console_callback_args_t * p_args);
+void benchmark_edit_callback(sf_console_callback_args_t * p_args);
+void benchmark_help_callback(sf_console_callback_args_t * p_args);
 
 #endif // CONSOLE_H
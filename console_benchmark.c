@@ -0,0 +1,607 @@
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "console.h"
+#include "application.h"
+
+/******************************************************************************
+ * CONSTANTS
+ *****************************************************************************/
+#define BENCHMARK_PARSE_COMMANDS_MAX        (1000U)
+#define BENCHMARK_PARSE_COMMAND_LENGTH      (16U)
+#define BENCHMARK_PARSE_INPUT_LENGTH        (BENCHMARK_PARSE_COMMAND_LENGTH + 4U)
+#define BENCHMARK_PARSE_LOOKUPS             (20000U)
+#define BENCHMARK_PARSE_INDEX_NODES         (BENCHMARK_PARSE_COMMANDS_MAX * BENCHMARK_PARSE_COMMAND_LENGTH)
+#define BENCHMARK_EDIT_LINE_LENGTH          (100U)
+#define BENCHMARK_EDIT_SCRIPT_LENGTH        (1024U)
+#define BENCHMARK_HELP_REQUESTS             (10U)
+#define BENCHMARK_HELP_MEMORY_SIZE          (4096U)
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+typedef enum e_benchmark_edit_key
+{
+    BENCHMARK_EDIT_KEY_TEXT,
+    BENCHMARK_EDIT_KEY_LEFT,
+    BENCHMARK_EDIT_KEY_RIGHT,
+    BENCHMARK_EDIT_KEY_BACKSPACE,
+    BENCHMARK_EDIT_KEY_DELETE,
+} benchmark_edit_key_t;
+
+/* One step of an edit scenario, a key pressed a number of times */
+typedef struct st_benchmark_edit_step
+{
+    benchmark_edit_key_t    key;
+    uint32_t                count;
+} benchmark_edit_step_t;
+
+typedef struct st_benchmark_edit_scenario
+{
+    char const              *name;
+    benchmark_edit_step_t   steps[4];
+} benchmark_edit_scenario_t;
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+static fsp_err_t benchmark_comms_open(sf_comms_ctrl_t * const p_ctrl, sf_comms_cfg_t const * const p_cfg);
+static fsp_err_t benchmark_comms_close(sf_comms_ctrl_t * const p_ctrl);
+static fsp_err_t benchmark_comms_read(sf_comms_ctrl_t * const p_ctrl,
+                                      uint8_t * const p_dest,
+                                      uint32_t const bytes,
+                                      UINT const timeout);
+static fsp_err_t benchmark_comms_write(sf_comms_ctrl_t * const p_ctrl,
+                                       uint8_t const * const p_src,
+                                       uint32_t const bytes,
+                                       UINT const timeout);
+static fsp_err_t benchmark_comms_lock(sf_comms_ctrl_t * const p_ctrl, sf_comms_lock_t lock_type, UINT timeout);
+static fsp_err_t benchmark_comms_unlock(sf_comms_ctrl_t * const p_ctrl, sf_comms_lock_t lock_type);
+static bool benchmark_acquire(sf_console_callback_args_t * p_args);
+static void benchmark_parse(sf_console_callback_args_t * p_args);
+static void benchmark_edit(sf_console_callback_args_t * p_args);
+static void benchmark_help(sf_console_callback_args_t * p_args);
+static void benchmark_parse_command_callback(sf_console_callback_args_t * p_args);
+static uint64_t benchmark_parse_run(sf_console_cfg_t const * p_cfg, sf_console_menu_t const * p_menu);
+static uint32_t benchmark_edit_script_add(benchmark_edit_key_t key, uint32_t count);
+
+/******************************************************************************
+ * GLOBALS
+ *****************************************************************************/
+/* Everything lives in static memory so the benchmark does not need the byte pool.
+ * Console sessions share it, so one benchmark runs at a time */
+static TX_MUTEX                     g_benchmark_mutex;
+static sf_comms_api_t g_benchmark_comms_api =
+{
+    .open   = benchmark_comms_open,
+    .close  = benchmark_comms_close,
+    .read   = benchmark_comms_read,
+    .write  = benchmark_comms_write,
+    .lock   = benchmark_comms_lock,
+    .unlock = benchmark_comms_unlock,
+};
+static sf_comms_cfg_t               g_benchmark_comms_cfg       = { 0 };
+static sf_comms_instance_t          g_benchmark_comms           =
+{
+    .p_ctrl = NULL,
+    .p_cfg  = &g_benchmark_comms_cfg,
+    .p_api  = &g_benchmark_comms_api,
+};
+static sf_console_instance_ctrl_t   g_benchmark_console_ctrl;
+static sf_console_index_node_t      g_benchmark_index_nodes[BENCHMARK_PARSE_INDEX_NODES];
+static sf_console_command_t         g_benchmark_commands[BENCHMARK_PARSE_COMMANDS_MAX];
+static char                         g_benchmark_command_names[BENCHMARK_PARSE_COMMANDS_MAX][BENCHMARK_PARSE_COMMAND_LENGTH];
+static uint8_t                      g_benchmark_inputs[BENCHMARK_PARSE_COMMANDS_MAX][BENCHMARK_PARSE_INPUT_LENGTH];
+static ULONG                        g_benchmark_callback_count;
+
+/* Input the stub transport plays back, and what it was asked to send */
+static uint8_t                      g_benchmark_script[BENCHMARK_EDIT_SCRIPT_LENGTH];
+static uint32_t                     g_benchmark_script_length;
+static uint32_t                     g_benchmark_script_position;
+static uint32_t                     g_benchmark_mark_start;
+static uint32_t                     g_benchmark_mark_end;
+static ULONG                        g_benchmark_write_count;
+static ULONG                        g_benchmark_write_bytes;
+static ULONG                        g_benchmark_writes_at_start;
+static ULONG                        g_benchmark_bytes_at_start;
+static ULONG                        g_benchmark_writes_at_end;
+static ULONG                        g_benchmark_bytes_at_end;
+static uint8_t                      g_benchmark_help_memory[BENCHMARK_HELP_MEMORY_SIZE];
+
+static benchmark_edit_scenario_t const g_benchmark_edit_scenarios[] =
+{
+    {
+        .name   = "Type a line",
+        .steps  = { { BENCHMARK_EDIT_KEY_TEXT, BENCHMARK_EDIT_LINE_LENGTH } },
+    },
+    {
+        .name   = "Cursor to start",
+        .steps  = { { BENCHMARK_EDIT_KEY_LEFT, BENCHMARK_EDIT_LINE_LENGTH } },
+    },
+    {
+        .name   = "Insert at start",
+        .steps  = { { BENCHMARK_EDIT_KEY_LEFT, BENCHMARK_EDIT_LINE_LENGTH }, { BENCHMARK_EDIT_KEY_TEXT, 20U } },
+    },
+    {
+        .name   = "Delete at start",
+        .steps  = { { BENCHMARK_EDIT_KEY_LEFT, BENCHMARK_EDIT_LINE_LENGTH }, { BENCHMARK_EDIT_KEY_DELETE, 20U } },
+    },
+    {
+        .name   = "Backspace at end",
+        .steps  = { { BENCHMARK_EDIT_KEY_BACKSPACE, 20U } },
+    },
+    {
+        .name   = "Backspace at start",
+        .steps  = { { BENCHMARK_EDIT_KEY_LEFT, 80U }, { BENCHMARK_EDIT_KEY_BACKSPACE, 20U } },
+    },
+};
+
+/******************************************************************************
+ * FUNCTION: benchmark_define
+ *****************************************************************************/
+void benchmark_define(void)
+{
+    UINT tx_err = tx_mutex_create(&g_benchmark_mutex, "Benchmark Mutex", TX_NO_INHERIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        LOG_ERROR("Failed benchmark_define::tx_mutex_create, tx_err = %d", tx_err);
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_acquire
+ *****************************************************************************/
+static bool benchmark_acquire(sf_console_callback_args_t * p_args)
+{
+    if(TX_SUCCESS != tx_mutex_get(&g_benchmark_mutex, TX_NO_WAIT))
+    {
+        CONSOLE_PRINTF(p_args, "A benchmark is already running in another session\r\n");
+        return false;
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_parse_callback
+ *****************************************************************************/
+void benchmark_parse_callback(sf_console_callback_args_t * p_args)
+{
+    if(benchmark_acquire(p_args))
+    {
+        benchmark_parse(p_args);
+        tx_mutex_put(&g_benchmark_mutex);
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_parse
+ *****************************************************************************/
+static void benchmark_parse(sf_console_callback_args_t * p_args)
+{
+    static char const   *groups[]       = { "adc", "can", "dac", "gpio", "i2c", "spi", "uart", "usb" };
+    static char const   *verbs[]        = { "get", "set", "read", "write", "start", "stop" };
+    static uint32_t const command_counts[] = { 10U, 100U, 1000U };
+    ULONG               group_count     = sizeof(groups) / sizeof(groups[0]);
+    ULONG               verb_count      = sizeof(verbs) / sizeof(verbs[0]);
+
+    /* Command names shaped like a real menu, "<group> <verb><n>", so they share prefixes */
+    for(uint32_t command_num = 0; command_num < BENCHMARK_PARSE_COMMANDS_MAX; command_num++)
+    {
+        snprintf(g_benchmark_command_names[command_num],
+                 BENCHMARK_PARSE_COMMAND_LENGTH,
+                 "%s %s%lu",
+                 groups[command_num % group_count],
+                 verbs[(command_num / group_count) % verb_count],
+                 (unsigned long) (command_num / (group_count * verb_count)));
+
+        /* Looked up with an argument after it like a real command line */
+        snprintf((char *) g_benchmark_inputs[command_num],
+                 BENCHMARK_PARSE_INPUT_LENGTH,
+                 "%s 1",
+                 g_benchmark_command_names[command_num]);
+
+        g_benchmark_commands[command_num].command   = (uint8_t *) g_benchmark_command_names[command_num];
+        g_benchmark_commands[command_num].help      = (uint8_t *) "";
+        g_benchmark_commands[command_num].callback  = benchmark_parse_command_callback;
+        g_benchmark_commands[command_num].context   = NULL;
+    }
+
+    CONSOLE_PRINTF(p_args, "Benchmarking command lookup, %u lookups each...\r\n", BENCHMARK_PARSE_LOOKUPS);
+    CONSOLE_PRINTF(p_args, "| Commands | Linear (ns) | Indexed (ns) | Speedup |\r\n");
+    CONSOLE_PRINTF(p_args, "|----------|-------------|--------------|---------|\r\n");
+
+    for(uint32_t count_num = 0; count_num < (sizeof(command_counts) / sizeof(command_counts[0])); count_num++)
+    {
+        sf_console_menu_t menu =
+        {
+            .menu_prev      = NULL,
+            .menu_name      = (uint8_t *) "bench",
+            .num_commands   = command_counts[count_num],
+            .command_list   = g_benchmark_commands,
+        };
+        sf_console_cfg_t cfg =
+        {
+            .p_comms            = &g_benchmark_comms,
+            .p_initial_menu     = &menu,
+            .echo               = false,
+            .autostart          = false,
+            .p_index_memory     = NULL,
+            .index_memory_size  = 0U,
+        };
+
+        uint64_t linear_us = benchmark_parse_run(&cfg, &menu);
+
+        cfg.p_index_memory      = g_benchmark_index_nodes;
+        cfg.index_memory_size   = sizeof(g_benchmark_index_nodes);
+        uint64_t indexed_us = benchmark_parse_run(&cfg, &menu);
+
+        if(0U == indexed_us)
+        {
+            indexed_us = 1U;
+        }
+
+        uint64_t speedup_tenths = (linear_us * 10U) / indexed_us;
+        CONSOLE_PRINTF(p_args, "| %8lu | %11lu | %12lu | %4lu.%lux |\r\n",
+                       (unsigned long) command_counts[count_num],
+                       (unsigned long) ((linear_us * 1000U) / BENCHMARK_PARSE_LOOKUPS),
+                       (unsigned long) ((indexed_us * 1000U) / BENCHMARK_PARSE_LOOKUPS),
+                       (unsigned long) (speedup_tenths / 10U),
+                       (unsigned long) (speedup_tenths % 10U));
+    }
+
+    CONSOLE_PRINTF(p_args, "done\r\n");
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_parse_run
+ *****************************************************************************/
+static uint64_t benchmark_parse_run(sf_console_cfg_t const * p_cfg, sf_console_menu_t const * p_menu)
+{
+    fsp_err_t   fsp_err     = FSP_SUCCESS;
+
+    fsp_err = g_sf_console_on_sf_console.open(&g_benchmark_console_ctrl, p_cfg);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        LOG_ERROR("Failed benchmark_parse_run::g_sf_console_on_sf_console.open, fsp_err = %d", fsp_err);
+        return 0;
+    }
+
+    /* Every command is looked up equally often, in an order that jumps around the list */
+    g_benchmark_callback_count = 0;
+    uint64_t start_us = application_time_us();
+    for(uint32_t lookup_num = 0; lookup_num < BENCHMARK_PARSE_LOOKUPS; lookup_num++)
+    {
+        uint32_t command_num = (lookup_num * 7919U) % p_menu->num_commands;
+        g_sf_console_on_sf_console.parse(&g_benchmark_console_ctrl,
+                                         p_menu,
+                                         g_benchmark_inputs[command_num],
+                                         BENCHMARK_PARSE_INPUT_LENGTH);
+    }
+    uint64_t elapsed_us = application_time_us() - start_us;
+
+    g_sf_console_on_sf_console.close(&g_benchmark_console_ctrl);
+
+    if(BENCHMARK_PARSE_LOOKUPS != g_benchmark_callback_count)
+    {
+        LOG_WARNING("Benchmark matched %lu of %u lookups", g_benchmark_callback_count, BENCHMARK_PARSE_LOOKUPS);
+    }
+
+    return elapsed_us;
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_edit_callback
+ *****************************************************************************/
+void benchmark_edit_callback(sf_console_callback_args_t * p_args)
+{
+    if(benchmark_acquire(p_args))
+    {
+        benchmark_edit(p_args);
+        tx_mutex_put(&g_benchmark_mutex);
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_edit
+ *****************************************************************************/
+static void benchmark_edit(sf_console_callback_args_t * p_args)
+{
+    fsp_err_t           fsp_err = FSP_SUCCESS;
+    uint8_t             line[SF_CONSOLE_MAX_INPUT_LENGTH];
+    sf_console_menu_t   menu    =
+    {
+        .menu_prev      = NULL,
+        .menu_name      = (uint8_t *) "bench",
+        .num_commands   = 0,
+        .command_list   = NULL,
+    };
+    sf_console_cfg_t    cfg     =
+    {
+        .p_comms            = &g_benchmark_comms,
+        .p_initial_menu     = &menu,
+        .echo               = true,
+        .autostart          = false,
+        .p_index_memory     = NULL,
+        .index_memory_size  = 0U,
+    };
+
+    CONSOLE_PRINTF(p_args, "Benchmarking line editing, each scenario starts from a typed line of %u characters...\r\n",
+                   BENCHMARK_EDIT_LINE_LENGTH);
+    CONSOLE_PRINTF(p_args, "|           Scenario | Keys | Writes | Writes/key | Bytes/key |\r\n");
+    CONSOLE_PRINTF(p_args, "|--------------------|------|--------|------------|-----------|\r\n");
+
+    for(uint32_t scenario_num = 0;
+        scenario_num < (sizeof(g_benchmark_edit_scenarios) / sizeof(g_benchmark_edit_scenarios[0]));
+        scenario_num++)
+    {
+        benchmark_edit_scenario_t const *p_scenario = &g_benchmark_edit_scenarios[scenario_num];
+
+        fsp_err = g_sf_console_on_sf_console.open(&g_benchmark_console_ctrl, &cfg);
+        if(FSP_SUCCESS != fsp_err)
+        {
+            LOG_ERROR("Failed benchmark_edit_callback::g_sf_console_on_sf_console.open, fsp_err = %d", fsp_err);
+            return;
+        }
+
+        /* Every scenario starts from a typed line, but only its own keys are counted. The transport notes the write
+         * counters when playback reaches the scenario's first key and the final carriage return */
+        g_benchmark_script_length = 0;
+        g_benchmark_script_position = 0;
+        if(BENCHMARK_EDIT_KEY_TEXT != p_scenario->steps[0].key)
+        {
+            benchmark_edit_script_add(BENCHMARK_EDIT_KEY_TEXT, BENCHMARK_EDIT_LINE_LENGTH);
+        }
+        g_benchmark_mark_start = g_benchmark_script_length;
+
+        ULONG keys = 0;
+        for(uint32_t step_num = 0; step_num < (sizeof(p_scenario->steps) / sizeof(p_scenario->steps[0])); step_num++)
+        {
+            keys += benchmark_edit_script_add(p_scenario->steps[step_num].key, p_scenario->steps[step_num].count);
+        }
+        g_benchmark_mark_end = g_benchmark_script_length;
+        g_benchmark_script[g_benchmark_script_length++] = '\r';
+
+        g_benchmark_write_count = 0;
+        g_benchmark_write_bytes = 0;
+
+        fsp_err = g_sf_console_on_sf_console.read(&g_benchmark_console_ctrl, line, sizeof(line), TX_NO_WAIT);
+        g_sf_console_on_sf_console.close(&g_benchmark_console_ctrl);
+        if(FSP_SUCCESS != fsp_err)
+        {
+            LOG_ERROR("Failed benchmark_edit_callback::g_sf_console_on_sf_console.read, fsp_err = %d", fsp_err);
+            continue;
+        }
+
+        ULONG writes = g_benchmark_writes_at_end - g_benchmark_writes_at_start;
+        ULONG bytes = g_benchmark_bytes_at_end - g_benchmark_bytes_at_start;
+        CONSOLE_PRINTF(p_args, "| %18s | %4lu | %6lu | %10.2f | %9.1f |\r\n",
+                       p_scenario->name,
+                       keys,
+                       writes,
+                       (double) writes / (double) keys,
+                       (double) bytes / (double) keys);
+    }
+
+    CONSOLE_PRINTF(p_args, "done\r\n");
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_help_callback
+ *****************************************************************************/
+void benchmark_help_callback(sf_console_callback_args_t * p_args)
+{
+    if(benchmark_acquire(p_args))
+    {
+        benchmark_help(p_args);
+        tx_mutex_put(&g_benchmark_mutex);
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_help
+ *****************************************************************************/
+static void benchmark_help(sf_console_callback_args_t * p_args)
+{
+    fsp_err_t           fsp_err     = FSP_SUCCESS;
+    sf_console_menu_t   const *p_menu = ((sf_console_instance_ctrl_t *) p_args->p_ctrl)->p_current_menu;
+    uint32_t const      help_memory_sizes[] = { 0U, BENCHMARK_HELP_MEMORY_SIZE };
+    sf_console_cfg_t    cfg         =
+    {
+        .p_comms            = &g_benchmark_comms,
+        .p_initial_menu     = p_menu,
+        .echo               = false,
+        .autostart          = false,
+        .p_index_memory     = NULL,
+        .index_memory_size  = 0U,
+    };
+
+    CONSOLE_PRINTF(p_args, "Benchmarking help of the current menu, %u requests each...\r\n", BENCHMARK_HELP_REQUESTS);
+    CONSOLE_PRINTF(p_args, "| Help memory | First writes | Repeat writes | Bytes |\r\n");
+    CONSOLE_PRINTF(p_args, "|-------------|--------------|---------------|-------|\r\n");
+
+    for(uint32_t size_num = 0; size_num < (sizeof(help_memory_sizes) / sizeof(help_memory_sizes[0])); size_num++)
+    {
+        cfg.p_help_memory       = (0U == help_memory_sizes[size_num]) ? NULL : g_benchmark_help_memory;
+        cfg.help_memory_size    = help_memory_sizes[size_num];
+
+        fsp_err = g_sf_console_on_sf_console.open(&g_benchmark_console_ctrl, &cfg);
+        if(FSP_SUCCESS != fsp_err)
+        {
+            LOG_ERROR("Failed benchmark_help_callback::g_sf_console_on_sf_console.open, fsp_err = %d", fsp_err);
+            return;
+        }
+
+        /* The first request renders the help, the rest can reuse it */
+        ULONG first_writes = 0;
+        ULONG first_bytes = 0;
+        g_benchmark_write_count = 0;
+        g_benchmark_write_bytes = 0;
+        for(uint32_t request_num = 0; request_num < BENCHMARK_HELP_REQUESTS; request_num++)
+        {
+            g_sf_console_on_sf_console.parse(&g_benchmark_console_ctrl, p_menu, (uint8_t const *) "?", 2U);
+            if(0U == request_num)
+            {
+                first_writes = g_benchmark_write_count;
+                first_bytes = g_benchmark_write_bytes;
+            }
+        }
+
+        g_sf_console_on_sf_console.close(&g_benchmark_console_ctrl);
+
+        CONSOLE_PRINTF(p_args, "| %11lu | %12lu | %13.1f | %5lu |\r\n",
+                       (unsigned long) help_memory_sizes[size_num],
+                       first_writes,
+                       (double) (g_benchmark_write_count - first_writes) / (double) (BENCHMARK_HELP_REQUESTS - 1U),
+                       first_bytes);
+    }
+
+    CONSOLE_PRINTF(p_args, "done\r\n");
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_edit_script_add
+ *****************************************************************************/
+static uint32_t benchmark_edit_script_add(benchmark_edit_key_t key, uint32_t count)
+{
+    for(uint32_t key_num = 0; key_num < count; key_num++)
+    {
+        if((g_benchmark_script_length + 3U) > BENCHMARK_EDIT_SCRIPT_LENGTH)
+        {
+            return key_num;
+        }
+
+        switch(key)
+        {
+            case BENCHMARK_EDIT_KEY_TEXT:
+                g_benchmark_script[g_benchmark_script_length++] = (uint8_t) ('a' + (key_num % 26U));
+                break;
+
+            case BENCHMARK_EDIT_KEY_LEFT:
+            case BENCHMARK_EDIT_KEY_RIGHT:
+                g_benchmark_script[g_benchmark_script_length++] = 0x1B;
+                g_benchmark_script[g_benchmark_script_length++] = '[';
+                g_benchmark_script[g_benchmark_script_length++] = (BENCHMARK_EDIT_KEY_LEFT == key) ? 'D' : 'C';
+                break;
+
+            case BENCHMARK_EDIT_KEY_BACKSPACE:
+                g_benchmark_script[g_benchmark_script_length++] = 0x08;
+                break;
+
+            case BENCHMARK_EDIT_KEY_DELETE:
+                g_benchmark_script[g_benchmark_script_length++] = 0x7F;
+                break;
+        }
+    }
+
+    return count;
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_parse_command_callback
+ *****************************************************************************/
+static void benchmark_parse_command_callback(sf_console_callback_args_t * p_args)
+{
+    (void) p_args;
+
+    g_benchmark_callback_count++;
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_comms_open
+ *****************************************************************************/
+static fsp_err_t benchmark_comms_open(sf_comms_ctrl_t * const p_ctrl, sf_comms_cfg_t const * const p_cfg)
+{
+    (void) p_ctrl;
+    (void) p_cfg;
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_comms_close
+ *****************************************************************************/
+static fsp_err_t benchmark_comms_close(sf_comms_ctrl_t * const p_ctrl)
+{
+    (void) p_ctrl;
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_comms_read
+ *****************************************************************************/
+static fsp_err_t benchmark_comms_read(sf_comms_ctrl_t * const p_ctrl,
+                                      uint8_t * const p_dest,
+                                      uint32_t const bytes,
+                                      UINT const timeout)
+{
+    (void) p_ctrl;
+    (void) timeout;
+
+    /* Plays back the edit script, there is never more input after it */
+    if((g_benchmark_script_position + bytes) > g_benchmark_script_length)
+    {
+        return FSP_ERR_UNSUPPORTED;
+    }
+
+    /* Everything echoed before a key is read belongs to the keys before it */
+    if(g_benchmark_mark_start == g_benchmark_script_position)
+    {
+        g_benchmark_writes_at_start = g_benchmark_write_count;
+        g_benchmark_bytes_at_start = g_benchmark_write_bytes;
+    }
+    if(g_benchmark_mark_end == g_benchmark_script_position)
+    {
+        g_benchmark_writes_at_end = g_benchmark_write_count;
+        g_benchmark_bytes_at_end = g_benchmark_write_bytes;
+    }
+
+    memcpy(p_dest, &g_benchmark_script[g_benchmark_script_position], bytes);
+    g_benchmark_script_position += bytes;
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_comms_write
+ *****************************************************************************/
+static fsp_err_t benchmark_comms_write(sf_comms_ctrl_t * const p_ctrl,
+                                       uint8_t const * const p_src,
+                                       uint32_t const bytes,
+                                       UINT const timeout)
+{
+    (void) p_ctrl;
+    (void) p_src;
+    (void) timeout;
+
+    g_benchmark_write_count++;
+    g_benchmark_write_bytes += bytes;
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_comms_lock
+ *****************************************************************************/
+static fsp_err_t benchmark_comms_lock(sf_comms_ctrl_t * const p_ctrl, sf_comms_lock_t lock_type, UINT timeout)
+{
+    (void) p_ctrl;
+    (void) lock_type;
+    (void) timeout;
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: benchmark_comms_unlock
+ *****************************************************************************/
+static fsp_err_t benchmark_comms_unlock(sf_comms_ctrl_t * const p_ctrl, sf_comms_lock_t lock_type)
+{
+    (void) p_ctrl;
+    (void) lock_type;
+
+    return FSP_SUCCESS;
+}
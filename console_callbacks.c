@@ -1,19 +1,69 @@
 /******************************************************************************
  * INCLUDES
  *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
 #include "console.h"
 #include "application.h"
+#include "profiler.h"
+
+/******************************************************************************
+ * FUNCTION: feature_lifecycle_run
+ *****************************************************************************/
+static void feature_lifecycle_run(sf_console_callback_args_t * p_args,
+                                  UINT (*p_action)(feature_t * p_feature),
+                                  char const * p_action_name)
+{
+    feature_t *p_feature = application_feature_find((char const *) p_args->p_argv[0].p_text,
+                                                    p_args->p_argv[0].length);
+    if(NULL == p_feature)
+    {
+        CONSOLE_PRINTF(p_args, "No feature named \"%.*s\"\r\n",
+                       (int) p_args->p_argv[0].length, (char const *) p_args->p_argv[0].p_text);
+        return;
+    }
+
+    UINT tx_err = p_action(p_feature);
+    if(TX_NOT_AVAILABLE == tx_err)
+    {
+        CONSOLE_PRINTF(p_args, "%s cannot be %s while %s\r\n", p_feature->feature_name, p_action_name,
+                       application_feature_state_name(p_feature->state));
+        return;
+    }
+    if(TX_NOT_DONE == tx_err)
+    {
+        CONSOLE_PRINTF(p_args, "%s cannot be %s before the features that depend on it\r\n",
+                       p_feature->feature_name, p_action_name);
+        return;
+    }
+    if(TX_SUCCESS != tx_err)
+    {
+        CONSOLE_PRINTF(p_args, "%s could not be %s, tx_err = %u\r\n", p_feature->feature_name, p_action_name, tx_err);
+        return;
+    }
+
+    /* What stopping gave back, or starting took */
+    ULONG available_bytes = 0;
+    tx_byte_pool_info_get(&g_application.memory_byte_pool, NULL, &available_bytes, NULL, NULL, NULL, NULL);
+    CONSOLE_PRINTF(p_args, "%s %s, %lu bytes of application memory free\r\n",
+                   p_feature->feature_name, application_feature_state_name(p_feature->state),
+                   (unsigned long) available_bytes);
+}
 
 /******************************************************************************
  * FUNCTION: feature_start_callback
  *****************************************************************************/
 void feature_start_callback(sf_console_callback_args_t * p_args)
 {
-    printf("Starting feature...");
-
-    tx_thread_sleep(100);
+    feature_lifecycle_run(p_args, application_feature_start, "started");
+}
 
-    printf("done\r\n");
+/******************************************************************************
+ * FUNCTION: feature_suspend_callback
+ *****************************************************************************/
+void feature_suspend_callback(sf_console_callback_args_t * p_args)
+{
+    feature_lifecycle_run(p_args, application_feature_suspend, "suspended");
 }
 
 /******************************************************************************
@@ -21,11 +71,7 @@ void feature_start_callback(sf_console_callback_args_t * p_args)
  *****************************************************************************/
 void feature_stop_callback(sf_console_callback_args_t * p_args)
 {
-    printf("Stopping feature...");
-
-    tx_thread_sleep(100);
-
-    printf("done\r\n");
+    feature_lifecycle_run(p_args, application_feature_stop, "stopped");
 }
 
 /******************************************************************************
@@ -33,22 +79,511 @@ void feature_stop_callback(sf_console_callback_args_t * p_args)
  *****************************************************************************/
 void feature_status_callback(sf_console_callback_args_t * p_args)
 {
-    printf("Getting feature status...\n");
+    static sf_console_column_t const columns[] =
+    {
+        { .p_name = (uint8_t const *) "Feature",    .width = 32 },
+        { .p_name = (uint8_t const *) "State",      .width = 10 },
+        { .p_name = (uint8_t const *) "Status",     .width = 10 },
+        { .p_name = (uint8_t const *) "Metrics",    .width = 7 },
+    };
 
     ULONG               feature_count   = g_application.feature_count;
     feature_status_t    status          = { 0 };
 
-    printf("|                          Feature |   Status   |\n");
-    printf("|----------------------------------|------------|\n");
+    /* Rendered as the session chose, or sent as values frames to host tools */
+    fsp_err_t fsp_err = g_sf_console_on_sf_console.tableStart(p_args->p_ctrl, columns, 4U);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        LOG_ERROR("Failed feature_status_callback::tableStart, fsp_err = %d", fsp_err);
+        return;
+    }
+
+    for(uint32_t feature_num = 0; (FSP_SUCCESS == fsp_err) && (feature_num < feature_count); feature_num++)
+    {
+        feature_t           *p_feature  = &g_application.p_features[feature_num];
+        char const          *p_state    = application_feature_state_name(p_feature->state);
+        sf_console_value_t  values[4]   = { 0 };
+
+        application_feature_status_get(p_feature, &status);
+        values[0].type              = SF_CONSOLE_ARG_TYPE_STRING;
+        values[0].arg.p_text        = (uint8_t const *) p_feature->feature_name;
+        values[0].arg.length        = (uint32_t) strlen(p_feature->feature_name);
+        values[1].type              = SF_CONSOLE_ARG_TYPE_STRING;
+        values[1].arg.p_text        = (uint8_t const *) p_state;
+        values[1].arg.length        = (uint32_t) strlen(p_state);
+        values[2].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[2].arg.value.integer = (int32_t) status.return_code;
+        values[3].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[3].arg.value.integer = (int32_t) status.metric_count;
+
+        fsp_err = g_sf_console_on_sf_console.tableRow(p_args->p_ctrl, values);
+    }
+
+    if(FSP_SUCCESS != fsp_err)
+    {
+        LOG_ERROR("Failed feature_status_callback::tableRow, fsp_err = %d", fsp_err);
+    }
+
+    g_sf_console_on_sf_console.tableEnd(p_args->p_ctrl);
+}
+
+/******************************************************************************
+ * FUNCTION: metrics_row_write
+ *****************************************************************************/
+static fsp_err_t metrics_row_write(sf_console_callback_args_t * p_args,
+                                   char const * p_feature_name,
+                                   char const * p_metric_name,
+                                   char const * p_type,
+                                   uint64_t value,
+                                   ULONG count)
+{
+    sf_console_value_t  values[5]   = { 0 };
+    char                text[24];
+
+    /* Values can pass what an INT column holds */
+    snprintf(text, sizeof(text), "%llu", (unsigned long long) value);
+
+    values[0].type              = SF_CONSOLE_ARG_TYPE_STRING;
+    values[0].arg.p_text        = (uint8_t const *) p_feature_name;
+    values[0].arg.length        = (uint32_t) strlen(p_feature_name);
+    values[1].type              = SF_CONSOLE_ARG_TYPE_STRING;
+    values[1].arg.p_text        = (uint8_t const *) p_metric_name;
+    values[1].arg.length        = (uint32_t) strlen(p_metric_name);
+    values[2].type              = SF_CONSOLE_ARG_TYPE_STRING;
+    values[2].arg.p_text        = (uint8_t const *) p_type;
+    values[2].arg.length        = (uint32_t) strlen(p_type);
+    values[3].type              = SF_CONSOLE_ARG_TYPE_STRING;
+    values[3].arg.p_text        = (uint8_t const *) text;
+    values[3].arg.length        = (uint32_t) strlen(text);
+    values[4].type              = SF_CONSOLE_ARG_TYPE_INT;
+    values[4].arg.value.integer = (int32_t) count;
+
+    return g_sf_console_on_sf_console.tableRow(p_args->p_ctrl, values);
+}
+
+/******************************************************************************
+ * FUNCTION: metrics_callback
+ *****************************************************************************/
+void metrics_callback(sf_console_callback_args_t * p_args)
+{
+    static sf_console_column_t const columns[] =
+    {
+        { .p_name = (uint8_t const *) "Feature",    .width = 12 },
+        { .p_name = (uint8_t const *) "Metric",     .width = 24 },
+        { .p_name = (uint8_t const *) "Type",       .width = 9 },
+        { .p_name = (uint8_t const *) "Value",      .width = 20 },
+        { .p_name = (uint8_t const *) "Count",      .width = 10 },
+    };
+
+    feature_t *p_only = NULL;
+    if(p_args->argc > 0)
+    {
+        p_only = application_feature_find((char const *) p_args->p_argv[0].p_text, p_args->p_argv[0].length);
+        if(NULL == p_only)
+        {
+            CONSOLE_PRINTF(p_args, "No feature named \"%.*s\"\r\n",
+                           (int) p_args->p_argv[0].length, (char const *) p_args->p_argv[0].p_text);
+            return;
+        }
+    }
+
+    fsp_err_t fsp_err = g_sf_console_on_sf_console.tableStart(p_args->p_ctrl, columns, 5U);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        LOG_ERROR("Failed metrics_callback::tableStart, fsp_err = %d", fsp_err);
+        return;
+    }
+
+    /* Each metric is a snapshot of its own, taken without stopping the
+     * feature. Histograms are followed by a row for each bucket */
+    for(ULONG feature_num = 0; (FSP_SUCCESS == fsp_err) && (feature_num < g_application.feature_count); feature_num++)
+    {
+        feature_t           *p_feature  = &g_application.p_features[feature_num];
+        feature_status_t    status      = { 0 };
+
+        if(((NULL != p_only) && (p_only != p_feature)) || !application_feature_status_get(p_feature, &status))
+        {
+            continue;
+        }
+
+        for(ULONG metric_num = 0; (FSP_SUCCESS == fsp_err) && (metric_num < status.metric_count); metric_num++)
+        {
+            metric_t const      *p_metric = &status.p_metrics[metric_num];
+            metric_snapshot_t   snapshot;
+
+            metric_read(p_metric, &snapshot);
+            fsp_err = metrics_row_write(p_args, p_feature->feature_name, p_metric->p_name,
+                                        metric_type_name(snapshot.type), snapshot.value, snapshot.count);
+
+            /* Bucket rows count the samples up to their bound, and those
+             * since the previous bound */
+            ULONG cumulative = 0;
+            for(ULONG bucket = 0; (FSP_SUCCESS == fsp_err) && (METRIC_TYPE_HISTOGRAM == snapshot.type) &&
+                                  (bucket <= p_metric->bound_count); bucket++)
+            {
+                char bucket_name[THREAD_OBJECT_NAME_LENGTH_MAX];
+
+                if(bucket < p_metric->bound_count)
+                {
+                    snprintf(bucket_name, sizeof(bucket_name), "%s.le_%lu", p_metric->p_name,
+                             (unsigned long) p_metric->p_bounds[bucket]);
+                }
+                else
+                {
+                    snprintf(bucket_name, sizeof(bucket_name), "%s.le_inf", p_metric->p_name);
+                }
+                cumulative += snapshot.buckets[bucket];
+                fsp_err = metrics_row_write(p_args, p_feature->feature_name, bucket_name, "bucket",
+                                            cumulative, snapshot.buckets[bucket]);
+            }
+        }
+    }
+
+    if(FSP_SUCCESS != fsp_err)
+    {
+        LOG_ERROR("Failed metrics_callback::tableRow, fsp_err = %d", fsp_err);
+    }
+
+    g_sf_console_on_sf_console.tableEnd(p_args->p_ctrl);
+}
+
+/******************************************************************************
+ * FUNCTION: boot_path_print
+ *****************************************************************************/
+static void boot_path_print(sf_console_callback_args_t * p_args, ULONG feature_num)
+{
+    /* From the first feature of the path, the path runs back from the last */
+    feature_t const *p_feature = &g_application.p_features[feature_num];
+
+    if(BOOT_FEATURE_NONE != p_feature->boot.path_previous)
+    {
+        boot_path_print(p_args, p_feature->boot.path_previous);
+        CONSOLE_PRINTF(p_args, " -> ");
+    }
+    CONSOLE_PRINTF(p_args, "%s", p_feature->feature_name);
+}
+
+/******************************************************************************
+ * FUNCTION: boot_report_callback
+ *****************************************************************************/
+void boot_report_callback(sf_console_callback_args_t * p_args)
+{
+    static sf_console_column_t const columns[] =
+    {
+        { .p_name = (uint8_t const *) "Feature",    .width = 32 },
+        { .p_name = (uint8_t const *) "Wave",       .width = 4 },
+        { .p_name = (uint8_t const *) "Start(us)",  .width = 10 },
+        { .p_name = (uint8_t const *) "Init(us)",   .width = 10 },
+        { .p_name = (uint8_t const *) "Ticks",      .width = 6 },
+        { .p_name = (uint8_t const *) "Path(us)",   .width = 10 },
+        { .p_name = (uint8_t const *) "Result",     .width = 6 },
+    };
+
+    if(!g_application.boot_done)
+    {
+        CONSOLE_PRINTF(p_args, "Boot has not finished\r\n");
+        return;
+    }
+
+    fsp_err_t fsp_err = g_sf_console_on_sf_console.tableStart(p_args->p_ctrl, columns, 7U);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        LOG_ERROR("Failed boot_report_callback::tableStart, fsp_err = %d", fsp_err);
+        return;
+    }
+
+    /* Features in the order they were defined, path is the longest chain of
+     * definitions ending with the feature. Result is the ThreadX error code
+     * returned by the definition, the feature only runs when it is 0 */
+    for(ULONG wave = 0; wave < g_application.boot_waves; wave++)
+    {
+        for(ULONG feature_num = 0; (FSP_SUCCESS == fsp_err) && (feature_num < g_application.feature_count); feature_num++)
+        {
+            feature_t const     *p_feature  = &g_application.p_features[feature_num];
+            sf_console_value_t  values[7]   = { 0 };
+
+            if(wave != p_feature->boot.wave)
+            {
+                continue;
+            }
+
+            values[0].type              = SF_CONSOLE_ARG_TYPE_STRING;
+            values[0].arg.p_text        = (uint8_t const *) p_feature->feature_name;
+            values[0].arg.length        = (uint32_t) strlen(p_feature->feature_name);
+            values[1].type              = SF_CONSOLE_ARG_TYPE_INT;
+            values[1].arg.value.integer = (int32_t) wave;
+            values[2].type              = SF_CONSOLE_ARG_TYPE_INT;
+            values[2].arg.value.integer = (int32_t) p_feature->boot.start_us;
+            values[3].type              = SF_CONSOLE_ARG_TYPE_INT;
+            values[3].arg.value.integer = (int32_t) p_feature->boot.define_us;
+            values[4].type              = SF_CONSOLE_ARG_TYPE_INT;
+            values[4].arg.value.integer = (int32_t) p_feature->boot.define_ticks;
+            values[5].type              = SF_CONSOLE_ARG_TYPE_INT;
+            values[5].arg.value.integer = (int32_t) p_feature->boot.path_us;
+            values[6].type              = SF_CONSOLE_ARG_TYPE_INT;
+            values[6].arg.value.integer = (int32_t) p_feature->boot.define_err;
+
+            fsp_err = g_sf_console_on_sf_console.tableRow(p_args->p_ctrl, values);
+        }
+    }
+
+    if(FSP_SUCCESS != fsp_err)
+    {
+        LOG_ERROR("Failed boot_report_callback::tableRow, fsp_err = %d", fsp_err);
+    }
+
+    g_sf_console_on_sf_console.tableEnd(p_args->p_ctrl);
+
+    ULONG last = application_boot_path_last();
+    if(BOOT_FEATURE_NONE == last)
+    {
+        return;
+    }
+
+    CONSOLE_PRINTF(p_args, "Critical path ");
+    boot_path_print(p_args, last);
+    CONSOLE_PRINTF(p_args, ", %lu of %lu us in %lu waves, %lu ticks\r\n",
+                   (unsigned long) g_application.p_features[last].boot.path_us,
+                   (unsigned long) g_application.boot_us,
+                   (unsigned long) g_application.boot_waves,
+                   (unsigned long) g_application.boot_ticks);
+}
+
+/******************************************************************************
+ * FUNCTION: top_callback
+ *****************************************************************************/
+void top_callback(sf_console_callback_args_t * p_args)
+{
+    static sf_console_column_t const columns[] =
+    {
+        { .p_name = (uint8_t const *) "Thread",     .width = 32 },
+        { .p_name = (uint8_t const *) "Prio",       .width = 4 },
+        { .p_name = (uint8_t const *) "State",      .width = 10 },
+        { .p_name = (uint8_t const *) "RunWt(%)",   .width = 8, .precision = 1 },
+        { .p_name = (uint8_t const *) "Resume/s",   .width = 9 },
+        { .p_name = (uint8_t const *) "Preempt/s",  .width = 9 },
+        { .p_name = (uint8_t const *) "Slices/s",   .width = 9 },
+    };
+
+    /* Started on first use, it has nothing to show before two samples */
+    feature_t *p_feature = application_feature_find("Profiler", 8U);
+    if((NULL != p_feature) && (FEATURE_STATE_RUNNING != p_feature->state))
+    {
+        UINT tx_err = application_feature_start(p_feature);
+        if(TX_SUCCESS != tx_err)
+        {
+            CONSOLE_PRINTF(p_args, "Profiler could not be started, tx_err = %u\r\n", tx_err);
+            return;
+        }
+    }
+
+    profiler_system_t system = { 0 };
+    if(!profiler_system_get(&system) || (system.samples < 2U))
+    {
+        CONSOLE_PRINTF(p_args, "Profiler is sampling, rates follow its next sample\r\n");
+        return;
+    }
+
+    CONSOLE_PRINTF(p_args, "%lu threads, %lu.%lu%% busy, %lu resumptions/s, %lu preemptions/s over %lu ticks\r\n",
+                   (unsigned long) system.thread_count,
+                   (unsigned long) (system.busy / 10U),
+                   (unsigned long) (system.busy % 10U),
+                   (unsigned long) system.resumption_rate,
+                   (unsigned long) system.preemption_rate,
+                   (unsigned long) system.period_ticks);
+    if(0U != system.untracked)
+    {
+        CONSOLE_PRINTF(p_args, "%lu threads past the first %lu are not shown\r\n",
+                       (unsigned long) system.untracked, (unsigned long) PROFILER_THREADS_MAX);
+    }
+
+    fsp_err_t fsp_err = g_sf_console_on_sf_console.tableStart(p_args->p_ctrl, columns, 7U);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        LOG_ERROR("Failed top_callback::tableStart, fsp_err = %d", fsp_err);
+        return;
+    }
+
+    /* RunWt(%) is the busy time weighted by how often each thread ran, not
+     * by how long, most run first. Threads are copied one at a time, a sample
+     * taken in between may move them, which only matters for that listing */
+    profiler_thread_t thread;
+    for(ULONG rank = 0; (FSP_SUCCESS == fsp_err) && profiler_thread_get(rank, &thread); rank++)
+    {
+        sf_console_value_t  values[7]       = { 0 };
+        char const          *p_state_name   = profiler_state_name(thread.state);
+
+        values[0].type              = SF_CONSOLE_ARG_TYPE_STRING;
+        values[0].arg.p_text        = (uint8_t const *) thread.name;
+        values[0].arg.length        = (uint32_t) strlen(thread.name);
+        values[1].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[1].arg.value.integer = (int32_t) thread.priority;
+        values[2].type              = SF_CONSOLE_ARG_TYPE_STRING;
+        values[2].arg.p_text        = (uint8_t const *) p_state_name;
+        values[2].arg.length        = (uint32_t) strlen(p_state_name);
+        values[3].type              = SF_CONSOLE_ARG_TYPE_FLOAT;
+        values[3].arg.value.real    = (float) thread.run_share / 10.0f;
+        values[4].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[4].arg.value.integer = (int32_t) thread.resumption_rate;
+        values[5].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[5].arg.value.integer = (int32_t) thread.preemption_rate;
+        values[6].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[6].arg.value.integer = (int32_t) thread.time_slice_rate;
+
+        fsp_err = g_sf_console_on_sf_console.tableRow(p_args->p_ctrl, values);
+    }
+
+    if(FSP_SUCCESS != fsp_err)
+    {
+        LOG_ERROR("Failed top_callback::tableRow, fsp_err = %d", fsp_err);
+    }
+
+    g_sf_console_on_sf_console.tableEnd(p_args->p_ctrl);
+}
+
+/******************************************************************************
+ * FUNCTION: comms_stats_callback
+ *****************************************************************************/
+void comms_stats_callback(sf_console_callback_args_t * p_args)
+{
+    static sf_console_column_t const columns[] =
+    {
+        { .p_name = (uint8_t const *) "Lock",           .width = 4 },
+        { .p_name = (uint8_t const *) "Acquires",       .width = 10 },
+        { .p_name = (uint8_t const *) "Contended",      .width = 10 },
+        { .p_name = (uint8_t const *) "Timeouts",       .width = 8 },
+        { .p_name = (uint8_t const *) "Inherited",      .width = 9 },
+        { .p_name = (uint8_t const *) "Wait avg (us)",  .width = 13 },
+        { .p_name = (uint8_t const *) "Wait max (us)",  .width = 13 },
+        { .p_name = (uint8_t const *) "Hold avg (us)",  .width = 13 },
+        { .p_name = (uint8_t const *) "Hold max (us)",  .width = 13 },
+    };
+
+    sf_console_instance_ctrl_t  *p_console_ctrl = (sf_console_instance_ctrl_t *) p_args->p_ctrl;
+    sf_comms_ctrl_t             *p_comms_ctrl   = p_console_ctrl->p_comms->p_ctrl;
+    sf_comms_lock_t             lock_types[]    = { SF_COMMS_LOCK_RX, SF_COMMS_LOCK_TX };
+    char const                  *lock_names[]   = { "RX", "TX" };
+
+    /* Only the sf_cmd_comms driver keeps lock statistics, a replay transport has its own control block */
+    if(SF_CMD_COMMS_Lock != p_console_ctrl->p_comms->p_api->lock)
+    {
+        CONSOLE_PRINTF(p_args, "Lock statistics are not supported by this transport\r\n");
+        return;
+    }
+
+    fsp_err_t fsp_err = g_sf_console_on_sf_console.tableStart(p_args->p_ctrl, columns, 9U);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        LOG_ERROR("Failed comms_stats_callback::tableStart, fsp_err = %d", fsp_err);
+        return;
+    }
+
+    for(uint32_t lock_num = 0; (FSP_SUCCESS == fsp_err) && (lock_num < (sizeof(lock_types) / sizeof(lock_types[0]))); lock_num++)
+    {
+        sf_cmd_comms_lock_stats_t   stats       = { 0 };
+        sf_console_value_t          values[9]   = { 0 };
+
+        fsp_err = SF_CMD_COMMS_LockStatsGet(p_comms_ctrl, lock_types[lock_num], &stats);
+        if(FSP_SUCCESS != fsp_err)
+        {
+            LOG_ERROR("Failed comms_stats_callback::SF_CMD_COMMS_LockStatsGet, fsp_err = %d", fsp_err);
+            break;
+        }
+
+        ULONG acquires = (0U == stats.acquires) ? 1U : stats.acquires;
+
+        values[0].type              = SF_CONSOLE_ARG_TYPE_STRING;
+        values[0].arg.p_text        = (uint8_t const *) lock_names[lock_num];
+        values[0].arg.length        = (uint32_t) strlen(lock_names[lock_num]);
+        values[1].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[1].arg.value.integer = (int32_t) stats.acquires;
+        values[2].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[2].arg.value.integer = (int32_t) stats.contentions;
+        values[3].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[3].arg.value.integer = (int32_t) stats.timeouts;
+        values[4].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[4].arg.value.integer = (int32_t) stats.inheritances;
+        values[5].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[5].arg.value.integer = (int32_t) (stats.acquire_us_total / acquires);
+        values[6].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[6].arg.value.integer = (int32_t) stats.acquire_us_max;
+        values[7].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[7].arg.value.integer = (int32_t) (stats.hold_us_total / acquires);
+        values[8].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[8].arg.value.integer = (int32_t) stats.hold_us_max;
+
+        fsp_err = g_sf_console_on_sf_console.tableRow(p_args->p_ctrl, values);
+        if(FSP_SUCCESS != fsp_err)
+        {
+            LOG_ERROR("Failed comms_stats_callback::tableRow, fsp_err = %d", fsp_err);
+        }
+    }
+
+    g_sf_console_on_sf_console.tableEnd(p_args->p_ctrl);
+}
+
+/******************************************************************************
+ * FUNCTION: log_stats_callback
+ *****************************************************************************/
+void log_stats_callback(sf_console_callback_args_t * p_args)
+{
+    static sf_console_column_t const columns[] =
+    {
+        { .p_name = (uint8_t const *) "Level",      .width = 8 },
+        { .p_name = (uint8_t const *) "Written",    .width = 10 },
+        { .p_name = (uint8_t const *) "Dropped",    .width = 10 },
+    };
+
+    log_stats_t stats = { 0 };
+
+    log_stats_get(&stats);
+
+    fsp_err_t fsp_err = g_sf_console_on_sf_console.tableStart(p_args->p_ctrl, columns, 3U);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        LOG_ERROR("Failed log_stats_callback::tableStart, fsp_err = %d", fsp_err);
+        return;
+    }
+
+    for(uint32_t level = 0; (FSP_SUCCESS == fsp_err) && (level < LOG_LEVEL_COUNT); level++)
+    {
+        sf_console_value_t  values[3]   = { 0 };
+        char const          *p_name     = log_level_name((log_level_t) level);
+
+        values[0].type              = SF_CONSOLE_ARG_TYPE_STRING;
+        values[0].arg.p_text        = (uint8_t const *) p_name;
+        values[0].arg.length        = (uint32_t) strlen(p_name);
+        values[1].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[1].arg.value.integer = (int32_t) stats.written[level];
+        values[2].type              = SF_CONSOLE_ARG_TYPE_INT;
+        values[2].arg.value.integer = (int32_t) stats.dropped[level];
+
+        fsp_err = g_sf_console_on_sf_console.tableRow(p_args->p_ctrl, values);
+    }
 
-    for(uint32_t feature_num = 0; feature_num < feature_count; feature_num++)
+    if(FSP_SUCCESS != fsp_err)
     {
-        /* Do something */
-        g_application.p_features[feature_num].feature_get_status(&status);
-        printf("| %32s | %10d |\n", g_application.p_features[feature_num].feature_name, status.return_code);
+        LOG_ERROR("Failed log_stats_callback::tableRow, fsp_err = %d", fsp_err);
     }
 
-    printf("done\r\n");
+    g_sf_console_on_sf_console.tableEnd(p_args->p_ctrl);
+
+    CONSOLE_PRINTF(p_args, "Truncated %lu, most waiting %lu of %u\r\n",
+                   (unsigned long) stats.truncated, (unsigned long) stats.high_water, LOG_RECORDS);
+}
+
+/******************************************************************************
+ * FUNCTION: log_level_callback
+ *****************************************************************************/
+void log_level_callback(sf_console_callback_args_t * p_args)
+{
+    /* The choices are in the order of log_level_t */
+    if(p_args->argc > 0)
+    {
+        log_level_set((log_level_t) p_args->p_argv[0].value.choice);
+    }
+
+    CONSOLE_PRINTF(p_args, "Log level %s\r\n", log_level_name(log_level_get()));
 }
 
 #ifndef M_PI
@@ -59,24 +594,63 @@ void feature_status_callback(sf_console_callback_args_t * p_args)
  *****************************************************************************/
 void custom_code_callback(sf_console_callback_args_t * p_args)
 {
+    /* Arguments were checked against g_custom_code_args, the ones left out
+     * keep their defaults */
+    static double const unit_scales[] = { 1000000.0, 1000.0 };
+    static char const * const field_names[] = { "B(uT)", "B(mT)" };
+    double max_current = (p_args->argc > 0) ? p_args->p_argv[0].value.real : 2.0; // A
+    int32_t steps = (p_args->argc > 1) ? p_args->p_argv[1].value.integer : 10;
+    uint32_t unit = (p_args->argc > 2) ? p_args->p_argv[2].value.choice : 0;
+
+    if((max_current <= 0.0) || (steps < 1))
+    {
+        CONSOLE_PRINTF(p_args, "max_current and steps must be positive\r\n");
+        return;
+    }
+
     double vacuum_permeability = 4 * M_PI * 0.0000001; // T m/A
-    double max_current = 2.0; // A
-    double current_inc = max_current / 10.0;
+    double current_inc = max_current / steps;
     double distance_from_wire = 0.005; // m
 
-    printf("Starting custom code...\n");
-    printf("|   B(uT)   | Dist(mm) | Current(A) |\n");
-    printf("|-----------|----------|------------|\n");
+    sf_console_column_t const columns[] =
+    {
+        { .p_name = (uint8_t const *) field_names[unit], .width = 9, .precision = 3 },
+        { .p_name = (uint8_t const *) "Dist(mm)",        .width = 8, .precision = 1 },
+        { .p_name = (uint8_t const *) "Current(A)",      .width = 10, .precision = 1 },
+    };
+
+    /* Rows are rendered as the session chose and buffered, so the whole
+     * table takes a few writes */
+    fsp_err_t fsp_err = g_sf_console_on_sf_console.tableStart(p_args->p_ctrl, columns, 3U);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        LOG_ERROR("Failed custom_code_callback::tableStart, fsp_err = %d", fsp_err);
+        return;
+    }
 
-    for(double current = current_inc; current < max_current; current += current_inc)
+    for(double current = current_inc; (FSP_SUCCESS == fsp_err) && (current < max_current); current += current_inc)
     {
-        for(distance_from_wire = 0.0001; distance_from_wire < 0.0010; distance_from_wire +=0.0001)
+        for(distance_from_wire = 0.0001; (FSP_SUCCESS == fsp_err) && (distance_from_wire < 0.0010); distance_from_wire +=0.0001)
         {
-            double magnetic_field = (vacuum_permeability * current) / (2 * M_PI * distance_from_wire) * 1000000;
-            printf("| %8.3f | %8.1f | %10.1f |\n", magnetic_field, distance_from_wire * 1000, current);
+            double magnetic_field = (vacuum_permeability * current) / (2 * M_PI * distance_from_wire) * unit_scales[unit];
+            sf_console_value_t values[3] = { 0 };
+
+            values[0].type              = SF_CONSOLE_ARG_TYPE_FLOAT;
+            values[0].arg.value.real    = (float) magnetic_field;
+            values[1].type              = SF_CONSOLE_ARG_TYPE_FLOAT;
+            values[1].arg.value.real    = (float) (distance_from_wire * 1000);
+            values[2].type              = SF_CONSOLE_ARG_TYPE_FLOAT;
+            values[2].arg.value.real    = (float) current;
+
+            fsp_err = g_sf_console_on_sf_console.tableRow(p_args->p_ctrl, values);
         }
     }
 
-    printf("done\r\n");
+    if(FSP_SUCCESS != fsp_err)
+    {
+        LOG_ERROR("Failed custom_code_callback::tableRow, fsp_err = %d", fsp_err);
+    }
+
+    g_sf_console_on_sf_console.tableEnd(p_args->p_ctrl);
 }
 
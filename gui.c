@@ -18,9 +18,9 @@
 /******************************************************************************
  * FUNCTION: gui_define
  *****************************************************************************/
-void gui_define(TX_BYTE_POOL * p_memory_pool)
+UINT gui_define(TX_BYTE_POOL * p_memory_pool)
 {
-
+    return TX_SUCCESS;
 }
 
 /******************************************************************************
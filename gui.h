@@ -29,7 +29,7 @@ typedef struct st_gui
 /******************************************************************************
  * PROTOTYPES
  *****************************************************************************/
-void gui_define(TX_BYTE_POOL * p_memory_pool);
+UINT gui_define(TX_BYTE_POOL * p_memory_pool);
 void gui_get_status(feature_status_t * p_status);
 void gui_thread_entry(ULONG thread_input);
 
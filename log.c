@@ -0,0 +1,747 @@
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include "log.h"
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/******************************************************************************
+ * CONSTANTS
+ *****************************************************************************/
+#define LOG_RECORDS_MASK    (LOG_RECORDS - 1U)
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+/* How an argument is read from the writer's argument list */
+typedef enum e_log_arg_type
+{
+    LOG_ARG_TYPE_NONE,
+    LOG_ARG_TYPE_SIGNED,
+    LOG_ARG_TYPE_UNSIGNED,
+    LOG_ARG_TYPE_DOUBLE,
+    LOG_ARG_TYPE_POINTER,
+    LOG_ARG_TYPE_STRING,
+} log_arg_type_t;
+
+/* Length modifier of a conversion */
+typedef enum e_log_length
+{
+    LOG_LENGTH_NONE,
+    LOG_LENGTH_CHAR,
+    LOG_LENGTH_SHORT,
+    LOG_LENGTH_LONG,
+    LOG_LENGTH_LONG_LONG,
+    LOG_LENGTH_INTMAX,
+    LOG_LENGTH_SIZE,
+    LOG_LENGTH_PTRDIFF,
+    LOG_LENGTH_LONG_DOUBLE,
+} log_length_t;
+
+/* One conversion of a format, from its '%' to its conversion character */
+typedef struct st_log_conversion
+{
+    char const          *p_start;
+    char const          *p_flags;       /* Flags, width and precision */
+    uint32_t            flags_length;
+    uint32_t            stars;          /* Width and precision given as arguments */
+    log_length_t        length;
+    char                conversion;
+    log_arg_type_t      type;
+    char const          *p_end;
+} log_conversion_t;
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+static void log_conversion_parse(char const * p_format, log_conversion_t * p_conversion);
+static bool log_arg_capture(log_record_t * p_record, log_conversion_t const * p_conversion, va_list * p_args);
+static uint32_t log_record_format(log_record_t const * p_record, char * p_dest);
+static void log_output_flush(void);
+
+/******************************************************************************
+ * GLOBALS
+ *****************************************************************************/
+log_t * gp_log = 0;
+
+/* Records written together, for the batch histogram */
+static ULONG const g_log_batch_bounds[] = { 1, 2, 4, 8, 16, 32 };
+
+static metric_t g_log_metrics[LOG_METRIC_COUNT] =
+{
+    METRICS_THREAD("thread"),
+    METRIC_COUNTER("written"),
+    METRIC_COUNTER("dropped"),
+    METRIC_COUNTER("truncated"),
+    METRIC_GAUGE("pending"),
+    METRIC_GAUGE("high_water"),
+    METRIC_HISTOGRAM("batch", g_log_batch_bounds),
+};
+
+static char const * const g_log_level_names[LOG_LEVEL_COUNT] =
+{
+    "DEBUG",
+    "INFO",
+    "WARN",
+    "ERROR",
+};
+
+/******************************************************************************
+ * FUNCTION: log_define
+ *****************************************************************************/
+UINT log_define(TX_BYTE_POOL * p_memory_pool)
+{
+    UINT        tx_err  = TX_SUCCESS;
+    log_t       *p_log  = NULL;
+
+    /* Allocate memory for the log object and its ring */
+    tx_err = tx_byte_allocate(p_memory_pool,
+                              (VOID **) &p_log,
+                              sizeof(log_t) + (LOG_RECORDS * sizeof(log_record_t)),
+                              TX_NO_WAIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        printf("Failed log_define::tx_byte_allocate, tx_err = %d\r\n", tx_err);
+        return tx_err;
+    }
+
+    /* Record n of the ring is free for the writer at position n */
+    memset((void *) p_log, 0, sizeof(log_t));
+    p_log->p_records = (log_record_t *) &p_log[1];
+    for(ULONG record_num = 0; record_num < LOG_RECORDS; record_num++)
+    {
+        p_log->p_records[record_num].sequence = record_num;
+    }
+    p_log->level = LOG_LEVEL_INFO;
+
+    tx_err = tx_byte_allocate(p_memory_pool,
+                              (VOID **) &p_log->p_thread_stack,
+                              LOG_THREAD_STACK_SIZE,
+                              TX_NO_WAIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        printf("Failed log_define::tx_byte_allocate, tx_err = %d\r\n", tx_err);
+        tx_byte_release(p_log);
+        return tx_err;
+    }
+
+    /* Messages are written unbuffered, the drain thread already collects them */
+    p_log->sf_comms_cfg_extend.rx_fd        = -1;
+    p_log->sf_comms_cfg_extend.tx_fd        = LOG_FD;
+    p_log->sf_comms_cfg_extend.buffered     = false;
+    p_log->sf_comms_cfg_extend.record_fd    = -1;
+    p_log->sf_comms_cfg_extend.p_time_us    = application_time_us;
+    p_log->sf_comms_cfg.p_extend            = &p_log->sf_comms_cfg_extend;
+    p_log->sf_comms_api.open                = SF_CMD_COMMS_Open;
+    p_log->sf_comms_api.close               = SF_CMD_COMMS_Close;
+    p_log->sf_comms_api.write               = SF_CMD_COMMS_Write;
+    p_log->sf_comms_api.lock                = SF_CMD_COMMS_Lock;
+    p_log->sf_comms_api.unlock              = SF_CMD_COMMS_Unlock;
+    p_log->sf_comms.p_api                   = &p_log->sf_comms_api;
+    p_log->sf_comms.p_cfg                   = &p_log->sf_comms_cfg;
+    p_log->sf_comms.p_ctrl                  = &p_log->sf_comms_ctrl;
+
+    fsp_err_t fsp_err = p_log->sf_comms.p_api->open(p_log->sf_comms.p_ctrl, p_log->sf_comms.p_cfg);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        printf("Failed log_define::p_api->open, fsp_err = %d\r\n", fsp_err);
+        tx_byte_release(p_log->p_thread_stack);
+        tx_byte_release(p_log);
+        return TX_NOT_AVAILABLE;
+    }
+
+    tx_err = tx_event_flags_create(&p_log->events, LOG_EVENTS_NAME);
+    if(TX_SUCCESS != tx_err)
+    {
+        printf("Failed log_define::tx_event_flags_create, tx_err = %d\r\n", tx_err);
+        p_log->sf_comms.p_api->close(p_log->sf_comms.p_ctrl);
+        tx_byte_release(p_log->p_thread_stack);
+        tx_byte_release(p_log);
+        return tx_err;
+    }
+
+    /* Writers may fill the ring before the drain thread first runs */
+    gp_log = p_log;
+
+    tx_err = tx_thread_create(&p_log->thread,
+                              LOG_THREAD_NAME,
+                              log_thread_entry,
+                              0,
+                              p_log->p_thread_stack,
+                              LOG_THREAD_STACK_SIZE,
+                              LOG_THREAD_PRIORITY,
+                              LOG_THREAD_PRIORITY,
+                              TX_NO_TIME_SLICE,
+                              TX_AUTO_START);
+    if(TX_SUCCESS != tx_err)
+    {
+        printf("Failed log_define::tx_thread_create, tx_err = %d\r\n", tx_err);
+        /* Writers may still be in the ring, so only what they do not use
+         * is given back */
+        gp_log = NULL;
+        tx_event_flags_delete(&p_log->events);
+        p_log->sf_comms.p_api->close(p_log->sf_comms.p_ctrl);
+        tx_byte_release(p_log->p_thread_stack);
+    }
+
+    return tx_err;
+}
+
+/******************************************************************************
+ * FUNCTION: log_get_status
+ *****************************************************************************/
+void log_get_status(feature_status_t * p_status)
+{
+    log_stats_t stats   = { 0 };
+    ULONG       written = 0;
+    ULONG       dropped = 0;
+
+    /* Dropped messages, which the log stats command breaks down */
+    log_stats_get(&stats);
+    for(ULONG level = 0; level < LOG_LEVEL_COUNT; level++)
+    {
+        written += stats.written[level];
+        dropped += stats.dropped[level];
+    }
+    p_status->return_code = dropped;
+
+    if(NULL == gp_log)
+    {
+        return;
+    }
+
+    metrics_thread_collect(&g_log_metrics[LOG_METRIC_THREAD], &gp_log->thread);
+    metric_set(&g_log_metrics[LOG_METRIC_WRITTEN], written);
+    metric_set(&g_log_metrics[LOG_METRIC_DROPPED], dropped);
+    metric_set(&g_log_metrics[LOG_METRIC_TRUNCATED], stats.truncated);
+    metric_set(&g_log_metrics[LOG_METRIC_PENDING], gp_log->head - gp_log->tail);
+    metric_set(&g_log_metrics[LOG_METRIC_HIGH_WATER], stats.high_water);
+    p_status->p_metrics     = g_log_metrics;
+    p_status->metric_count  = LOG_METRIC_COUNT;
+}
+
+/******************************************************************************
+ * FUNCTION: log_start
+ *****************************************************************************/
+UINT log_start(void)
+{
+    if(NULL == gp_log)
+    {
+        return TX_NOT_AVAILABLE;
+    }
+
+    return tx_thread_resume(&gp_log->thread);
+}
+
+/******************************************************************************
+ * FUNCTION: log_suspend
+ *****************************************************************************/
+UINT log_suspend(void)
+{
+    if(NULL == gp_log)
+    {
+        return TX_NOT_AVAILABLE;
+    }
+
+    /* Writers carry on, what does not fit in the ring meanwhile is dropped */
+    return tx_thread_suspend(&gp_log->thread);
+}
+
+/******************************************************************************
+ * FUNCTION: log_thread_entry
+ *****************************************************************************/
+void log_thread_entry(ULONG thread_input)
+{
+    (void) thread_input;
+
+    log_t *p_log = gp_log;
+
+    while(1)
+    {
+        ULONG           position    = p_log->tail;
+        log_record_t    *p_record   = &p_log->p_records[position & LOG_RECORDS_MASK];
+
+        /* Write what was collected before waiting for more */
+        if(p_record->sequence != (position + 1U))
+        {
+            log_output_flush();
+
+            ULONG actual_flags = 0;
+            tx_event_flags_get(&p_log->events, LOG_EVENT_WRITTEN, TX_OR_CLEAR, &actual_flags, TX_WAIT_FOREVER);
+            continue;
+        }
+
+        if((p_log->output_length + LOG_LINE_MAX) > LOG_OUTPUT_SIZE)
+        {
+            log_output_flush();
+        }
+        p_log->output_length += log_record_format(p_record, &p_log->output[p_log->output_length]);
+        p_log->output_records++;
+        p_log->stats.written[p_record->level]++;
+
+        /* Hand the record back to writers a whole ring later */
+        TX_INTERRUPT_SAVE_AREA
+        TX_DISABLE
+        p_record->sequence = position + LOG_RECORDS;
+        p_log->tail = position + 1U;
+        TX_RESTORE
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: log_write
+ *****************************************************************************/
+bool log_write(log_level_t level, char const * p_format, ...)
+{
+    log_t       *p_log  = gp_log;
+    va_list     args;
+
+    /* Before the log is defined, or if it could not be, messages go straight out */
+    if(NULL == p_log)
+    {
+        va_start(args, p_format);
+        vfprintf(stderr, p_format, args);
+        va_end(args);
+        fprintf(stderr, "\r\n");
+        return true;
+    }
+
+    if(level < p_log->level)
+    {
+        return true;
+    }
+
+    /* Claim the next record, or drop the message if the drain thread has not
+     * freed it yet. Interrupts are only off for the claim itself, so writers
+     * never wait on each other or on the drain thread */
+    TX_INTERRUPT_SAVE_AREA
+    TX_DISABLE
+    ULONG           position    = p_log->head;
+    log_record_t    *p_record   = &p_log->p_records[position & LOG_RECORDS_MASK];
+    bool            claimed     = (p_record->sequence == position);
+    if(claimed)
+    {
+        p_log->head = position + 1U;
+        if((position + 1U - p_log->tail) > p_log->stats.high_water)
+        {
+            p_log->stats.high_water = position + 1U - p_log->tail;
+        }
+    }
+    else
+    {
+        p_log->stats.dropped[level]++;
+    }
+    TX_RESTORE
+
+    if(!claimed)
+    {
+        return false;
+    }
+
+    /* Capture the arguments, formatting is left to the drain thread */
+    p_record->level         = level;
+    p_record->ticks         = tx_time_get();
+    p_record->p_format      = p_format;
+    p_record->arg_count     = 0;
+    p_record->text_length   = 0;
+
+    bool complete = true;
+    va_start(args, p_format);
+    for(char const * p_char = strchr(p_format, '%'); complete && (NULL != p_char); p_char = strchr(p_char, '%'))
+    {
+        log_conversion_t conversion;
+        log_conversion_parse(p_char, &conversion);
+        complete = log_arg_capture(p_record, &conversion, &args);
+        p_char = conversion.p_end;
+    }
+    va_end(args);
+
+    /* Publish the record */
+    TX_DISABLE
+    if(!complete)
+    {
+        p_log->stats.truncated++;
+    }
+    p_record->sequence = position + 1U;
+    TX_RESTORE
+
+    tx_event_flags_set(&p_log->events, LOG_EVENT_WRITTEN, TX_OR);
+
+    return true;
+}
+
+/******************************************************************************
+ * FUNCTION: log_level_set
+ *****************************************************************************/
+void log_level_set(log_level_t level)
+{
+    if((NULL != gp_log) && (level < LOG_LEVEL_COUNT))
+    {
+        gp_log->level = level;
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: log_level_get
+ *****************************************************************************/
+log_level_t log_level_get(void)
+{
+    return (NULL != gp_log) ? gp_log->level : LOG_LEVEL_DEBUG;
+}
+
+/******************************************************************************
+ * FUNCTION: log_level_name
+ *****************************************************************************/
+char const * log_level_name(log_level_t level)
+{
+    return (level < LOG_LEVEL_COUNT) ? g_log_level_names[level] : "?";
+}
+
+/******************************************************************************
+ * FUNCTION: log_stats_get
+ *****************************************************************************/
+void log_stats_get(log_stats_t * p_stats)
+{
+    if(NULL == gp_log)
+    {
+        memset(p_stats, 0, sizeof(log_stats_t));
+        return;
+    }
+
+    /* A consistent copy, writers update the counters with interrupts off */
+    TX_INTERRUPT_SAVE_AREA
+    TX_DISABLE
+    *p_stats = gp_log->stats;
+    TX_RESTORE
+}
+
+/******************************************************************************
+ * FUNCTION: log_flush
+ *****************************************************************************/
+void log_flush(void)
+{
+    /* Gives the drain thread time to write out the ring, for callers about to
+     * end the process */
+    ULONG start_ticks = tx_time_get();
+
+    while((NULL != gp_log) && ((gp_log->tail != gp_log->head) || (0U != gp_log->output_length)) &&
+          ((tx_time_get() - start_ticks) < LOG_FLUSH_TIMEOUT))
+    {
+        tx_thread_sleep(1);
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: log_conversion_parse
+ *****************************************************************************/
+static void log_conversion_parse(char const * p_format, log_conversion_t * p_conversion)
+{
+    char const *p_char = p_format + 1;
+
+    p_conversion->p_start       = p_format;
+    p_conversion->p_flags       = p_char;
+    p_conversion->stars         = 0;
+    p_conversion->length        = LOG_LENGTH_NONE;
+    p_conversion->type          = LOG_ARG_TYPE_NONE;
+
+    /* Flags, width and precision are kept as written */
+    while((NULL != strchr("-+ #0123456789.*", *p_char)) && ('\0' != *p_char))
+    {
+        p_conversion->stars += ('*' == *p_char) ? 1U : 0U;
+        p_char++;
+    }
+    p_conversion->flags_length = (uint32_t) (p_char - p_conversion->p_flags);
+
+    switch(*p_char)
+    {
+        case 'h':
+            p_conversion->length = ('h' == p_char[1]) ? LOG_LENGTH_CHAR : LOG_LENGTH_SHORT;
+            p_char += ('h' == p_char[1]) ? 2 : 1;
+            break;
+        case 'l':
+            p_conversion->length = ('l' == p_char[1]) ? LOG_LENGTH_LONG_LONG : LOG_LENGTH_LONG;
+            p_char += ('l' == p_char[1]) ? 2 : 1;
+            break;
+        case 'j':
+            p_conversion->length = LOG_LENGTH_INTMAX;
+            p_char++;
+            break;
+        case 'z':
+            p_conversion->length = LOG_LENGTH_SIZE;
+            p_char++;
+            break;
+        case 't':
+            p_conversion->length = LOG_LENGTH_PTRDIFF;
+            p_char++;
+            break;
+        case 'L':
+            p_conversion->length = LOG_LENGTH_LONG_DOUBLE;
+            p_char++;
+            break;
+        default:
+            break;
+    }
+
+    /* A format ending in the middle of a conversion ends with it */
+    p_conversion->conversion = *p_char;
+    p_conversion->p_end = ('\0' != *p_char) ? (p_char + 1) : p_char;
+
+    if(NULL != strchr("di", p_conversion->conversion))
+    {
+        p_conversion->type = LOG_ARG_TYPE_SIGNED;
+    }
+    else if(NULL != strchr("uoxXc", p_conversion->conversion))
+    {
+        p_conversion->type = LOG_ARG_TYPE_UNSIGNED;
+    }
+    else if(NULL != strchr("fFeEgGaA", p_conversion->conversion))
+    {
+        p_conversion->type = LOG_ARG_TYPE_DOUBLE;
+    }
+    else if('p' == p_conversion->conversion)
+    {
+        p_conversion->type = LOG_ARG_TYPE_POINTER;
+    }
+    else if('s' == p_conversion->conversion)
+    {
+        p_conversion->type = LOG_ARG_TYPE_STRING;
+    }
+
+    /* strchr finds the terminator of its set too */
+    if('\0' == p_conversion->conversion)
+    {
+        p_conversion->type = LOG_ARG_TYPE_NONE;
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: log_arg_capture
+ *****************************************************************************/
+static bool log_arg_capture(log_record_t * p_record, log_conversion_t const * p_conversion, va_list * p_args)
+{
+    /* Widths and precisions given as arguments come first */
+    for(uint32_t star = 0; star < p_conversion->stars; star++)
+    {
+        if(p_record->arg_count >= LOG_ARGS_MAX)
+        {
+            return false;
+        }
+        p_record->args[p_record->arg_count++].s = va_arg(*p_args, int);
+    }
+
+    /* %n is not written through, its pointer is only stepped over */
+    if('n' == p_conversion->conversion)
+    {
+        (void) va_arg(*p_args, void *);
+        return true;
+    }
+    if(LOG_ARG_TYPE_NONE == p_conversion->type)
+    {
+        return true;
+    }
+    if(p_record->arg_count >= LOG_ARGS_MAX)
+    {
+        return false;
+    }
+
+    log_arg_t *p_arg = &p_record->args[p_record->arg_count++];
+    switch(p_conversion->type)
+    {
+        case LOG_ARG_TYPE_SIGNED:
+            switch(p_conversion->length)
+            {
+                case LOG_LENGTH_LONG:       p_arg->s = va_arg(*p_args, long);       break;
+                case LOG_LENGTH_LONG_LONG:  p_arg->s = va_arg(*p_args, long long);  break;
+                case LOG_LENGTH_INTMAX:     p_arg->s = va_arg(*p_args, intmax_t);   break;
+                case LOG_LENGTH_SIZE:       p_arg->s = (intmax_t) va_arg(*p_args, size_t);      break;
+                case LOG_LENGTH_PTRDIFF:    p_arg->s = va_arg(*p_args, ptrdiff_t);  break;
+                default:                    p_arg->s = va_arg(*p_args, int);        break;
+            }
+            break;
+
+        case LOG_ARG_TYPE_UNSIGNED:
+            switch(p_conversion->length)
+            {
+                case LOG_LENGTH_LONG:       p_arg->u = va_arg(*p_args, unsigned long);      break;
+                case LOG_LENGTH_LONG_LONG:  p_arg->u = va_arg(*p_args, unsigned long long); break;
+                case LOG_LENGTH_INTMAX:     p_arg->u = va_arg(*p_args, uintmax_t);          break;
+                case LOG_LENGTH_SIZE:       p_arg->u = va_arg(*p_args, size_t);             break;
+                case LOG_LENGTH_PTRDIFF:    p_arg->u = (uintmax_t) va_arg(*p_args, ptrdiff_t);  break;
+                default:                    p_arg->u = va_arg(*p_args, unsigned int);       break;
+            }
+            break;
+
+        case LOG_ARG_TYPE_DOUBLE:
+            p_arg->d = (LOG_LENGTH_LONG_DOUBLE == p_conversion->length) ? (double) va_arg(*p_args, long double) :
+                                                                          va_arg(*p_args, double);
+            break;
+
+        case LOG_ARG_TYPE_POINTER:
+            p_arg->p = va_arg(*p_args, void *);
+            break;
+
+        default:
+        {
+            /* Strings are copied, the writer's buffer may be gone by the time
+             * the message is formatted */
+            char const  *p_text     = va_arg(*p_args, char const *);
+            uint32_t    space       = LOG_TEXT_MAX - p_record->text_length;
+            uint32_t    length      = (NULL != p_text) ? (uint32_t) strlen(p_text) : 0U;
+            bool        complete    = (length < space);
+
+            if(0U == space)
+            {
+                p_record->arg_count--;
+                return false;
+            }
+            length = complete ? length : (space - 1U);
+            memcpy(&p_record->text[p_record->text_length], p_text, length);
+            p_record->text[p_record->text_length + length] = '\0';
+            p_arg->text = p_record->text_length;
+            p_record->text_length += length + 1U;
+
+            return complete;
+        }
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * FUNCTION: log_record_format
+ *****************************************************************************/
+static uint32_t log_record_format(log_record_t const * p_record, char * p_dest)
+{
+    /* Leaves room for the line ending */
+    uint32_t    size    = LOG_LINE_MAX - 2U;
+    uint32_t    length  = 0;
+    uint32_t    arg_num = 0;
+    int         written = snprintf(p_dest, size, "%010lu %-5s ", (unsigned long) p_record->ticks,
+                                   g_log_level_names[p_record->level]);
+    length = ((written > 0) && ((uint32_t) written < size)) ? (uint32_t) written : 0U;
+
+    char const *p_char = p_record->p_format;
+    while(('\0' != *p_char) && (length < (size - 1U)))
+    {
+        if('%' != *p_char)
+        {
+            p_dest[length++] = *p_char++;
+            continue;
+        }
+
+        log_conversion_t conversion;
+        log_conversion_parse(p_char, &conversion);
+        p_char = conversion.p_end;
+
+        if('%' == conversion.conversion)
+        {
+            p_dest[length++] = '%';
+            continue;
+        }
+
+        /* Rebuild the specification with the captured widths in place of the
+         * stars, and the length of the widened argument */
+        char        spec[LOG_SPEC_LENGTH];
+        uint32_t    spec_length = 0;
+        spec[spec_length++] = '%';
+        for(uint32_t flag = 0; flag < conversion.flags_length; flag++)
+        {
+            char c = conversion.p_flags[flag];
+            if(('*' == c) && (arg_num < p_record->arg_count))
+            {
+                spec_length += (uint32_t) snprintf(&spec[spec_length], LOG_SPEC_LENGTH - spec_length - 4U, "%d",
+                                                   (int) p_record->args[arg_num++].s);
+            }
+            else if((spec_length < (LOG_SPEC_LENGTH - 4U)) && ('*' != c))
+            {
+                spec[spec_length++] = c;
+            }
+        }
+        if(((LOG_ARG_TYPE_SIGNED == conversion.type) || (LOG_ARG_TYPE_UNSIGNED == conversion.type)) &&
+           ('c' != conversion.conversion))
+        {
+            spec[spec_length++] = 'j';
+        }
+        spec[spec_length++] = conversion.conversion;
+        spec[spec_length] = '\0';
+
+        /* The message was cut short where its arguments ran out */
+        if((LOG_ARG_TYPE_NONE == conversion.type) || (arg_num >= p_record->arg_count))
+        {
+            if(LOG_ARG_TYPE_NONE != conversion.type)
+            {
+                break;
+            }
+            continue;
+        }
+
+        log_arg_t const *p_arg = &p_record->args[arg_num++];
+        uint32_t        space  = size - length;
+        switch(conversion.type)
+        {
+            case LOG_ARG_TYPE_SIGNED:
+                written = snprintf(&p_dest[length], space, spec, p_arg->s);
+                break;
+            case LOG_ARG_TYPE_UNSIGNED:
+                if('c' == conversion.conversion)
+                {
+                    written = snprintf(&p_dest[length], space, spec, (int) p_arg->u);
+                }
+                else
+                {
+                    written = snprintf(&p_dest[length], space, spec, p_arg->u);
+                }
+                break;
+            case LOG_ARG_TYPE_DOUBLE:
+                written = snprintf(&p_dest[length], space, spec, p_arg->d);
+                break;
+            case LOG_ARG_TYPE_POINTER:
+                written = snprintf(&p_dest[length], space, spec, p_arg->p);
+                break;
+            default:
+                written = snprintf(&p_dest[length], space, spec, &p_record->text[p_arg->text]);
+                break;
+        }
+
+        /* A conversion that did not fit ends the line */
+        if(written < 0)
+        {
+            break;
+        }
+        length += ((uint32_t) written < space) ? (uint32_t) written : (space - 1U);
+    }
+
+    p_dest[length++] = '\r';
+    p_dest[length++] = '\n';
+
+    return length;
+}
+
+/******************************************************************************
+ * FUNCTION: log_output_flush
+ *****************************************************************************/
+static void log_output_flush(void)
+{
+    log_t *p_log = gp_log;
+
+    if(0U == p_log->output_length)
+    {
+        return;
+    }
+
+    fsp_err_t fsp_err = p_log->sf_comms.p_api->write(p_log->sf_comms.p_ctrl,
+                                                     (uint8_t const *) p_log->output,
+                                                     p_log->output_length,
+                                                     TX_WAIT_FOREVER);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        /* Nothing else to tell, the log is the way to tell */
+        p_log->stats.truncated++;
+    }
+
+    metric_observe(&g_log_metrics[LOG_METRIC_BATCH], p_log->output_records);
+    p_log->output_length = 0;
+    p_log->output_records = 0;
+}
@@ -0,0 +1,156 @@
+#ifndef LOG_H
+#define LOG_H
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include "application.h"
+#include "sf_cmd_comms.h"
+#include <stdint.h>
+
+/******************************************************************************
+ * CONSTANTS
+ *****************************************************************************/
+#define LOG_THREAD_NAME                 ("Log Thread")
+#define LOG_EVENTS_NAME                 ("Log Events")
+#define LOG_EVENT_WRITTEN               (0x00000001UL)
+#define LOG_THREAD_STACK_SIZE           (APPLICATION_THREAD_STACK_SIZE)
+
+/* The drain thread formats and writes whenever nothing else has work. It
+ * stays above the console RX threads, which do not yield while blocked in a
+ * read on hosted ports */
+#define LOG_THREAD_PRIORITY             (TX_MAX_PRIORITIES - 2)
+
+/* Messages waiting to be written, must be a power of two. Records are
+ * claimed and published in a short critical section with interrupts off. A
+ * message that finds the ring full is dropped and counted, the writer never
+ * suspends */
+#define LOG_RECORDS                     (32U)
+
+/* Arguments kept per message, including * widths and precisions, and bytes
+ * kept of the strings given for %s. What does not fit is cut off and the
+ * message is counted as truncated */
+#define LOG_ARGS_MAX                    (6U)
+#define LOG_TEXT_MAX                    (48U)
+
+/* A formatted message is cut at LOG_LINE_MAX bytes. Messages are collected
+ * into the output buffer and written together when the ring runs empty */
+#define LOG_LINE_MAX                    (160U)
+#define LOG_OUTPUT_SIZE                 (512U)
+
+/* Longest conversion specification rebuilt by the drain thread */
+#define LOG_SPEC_LENGTH                 (32U)
+
+/* File descriptor messages are written to. The stdio console session owns
+ * stdout and its TX lock, so the log keeps to stderr and never cuts into a
+ * line the console is writing */
+#define LOG_FD                          (2) /* stderr */
+
+/* Metrics of the log feature, indexes into g_log_metrics */
+#define LOG_METRIC_THREAD               (0U)
+#define LOG_METRIC_WRITTEN              (LOG_METRIC_THREAD + METRICS_THREAD_COUNT)
+#define LOG_METRIC_DROPPED              (LOG_METRIC_WRITTEN + 1U)
+#define LOG_METRIC_TRUNCATED            (LOG_METRIC_DROPPED + 1U)
+#define LOG_METRIC_PENDING              (LOG_METRIC_TRUNCATED + 1U)
+#define LOG_METRIC_HIGH_WATER           (LOG_METRIC_PENDING + 1U)
+#define LOG_METRIC_BATCH                (LOG_METRIC_HIGH_WATER + 1U)
+#define LOG_METRIC_COUNT                (LOG_METRIC_BATCH + 1U)
+
+/* How long log_flush waits for the drain thread */
+#define LOG_FLUSH_TIMEOUT               (TX_TIMER_TICKS_PER_SECOND)
+
+/* Messages below the level are left out. Formats are kept as pointers until
+ * the drain thread formats them, so they must be string literals */
+#define LOG_DEBUG(...)                  log_write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...)                   log_write(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARNING(...)                log_write(LOG_LEVEL_WARNING, __VA_ARGS__)
+#define LOG_ERROR(...)                  log_write(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+typedef enum e_log_level
+{
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARNING,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_COUNT
+} log_level_t;
+
+/* Argument of a message, widened when it is captured */
+typedef union u_log_arg
+{
+    intmax_t                    s;
+    uintmax_t                   u;
+    double                      d;
+    void const                  *p;
+    uint32_t                    text;   /* Offset of a %s string in the text of the record */
+} log_arg_t;
+
+/* Message waiting in the ring. The sequence says who owns the record: it is
+ * free for the writer at ring position n while it equals n, and ready for
+ * the drain thread once it is n + 1 */
+typedef struct st_log_record
+{
+    ULONG volatile              sequence;
+    log_level_t                 level;
+    ULONG                       ticks;
+    char const                  *p_format;
+    uint32_t                    arg_count;
+    uint32_t                    text_length;
+    log_arg_t                   args[LOG_ARGS_MAX];
+    char                        text[LOG_TEXT_MAX];
+} log_record_t;
+
+typedef struct st_log_stats
+{
+    ULONG                       written[LOG_LEVEL_COUNT];
+    ULONG                       dropped[LOG_LEVEL_COUNT];
+    ULONG                       truncated;
+
+    /* Most records waiting at once */
+    ULONG                       high_water;
+} log_stats_t;
+
+typedef struct st_log
+{
+    /* Thread Related */
+    TX_THREAD                       thread;
+    VOID                            *p_thread_stack;
+    TX_EVENT_FLAGS_GROUP            events;
+
+    /* Ring of records. Writers claim head, the drain thread alone moves tail */
+    log_record_t                    *p_records;
+    ULONG volatile                  head;
+    ULONG volatile                  tail;
+    log_level_t volatile            level;
+    log_stats_t                     stats;
+
+    /* Output */
+    sf_cmd_comms_instance_ctrl_t    sf_comms_ctrl;
+    sf_cmd_comms_cfg_t              sf_comms_cfg_extend;
+    sf_comms_cfg_t                  sf_comms_cfg;
+    sf_comms_api_t                  sf_comms_api;
+    sf_comms_instance_t             sf_comms;
+    char                            output[LOG_OUTPUT_SIZE];
+    uint32_t                        output_length;
+    ULONG                           output_records;
+} log_t;
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+UINT log_define(TX_BYTE_POOL * p_memory_pool);
+void log_get_status(feature_status_t * p_status);
+void log_thread_entry(ULONG thread_input);
+UINT log_start(void);
+UINT log_suspend(void);
+bool log_write(log_level_t level, char const * p_format, ...);
+void log_level_set(log_level_t level);
+log_level_t log_level_get(void);
+char const * log_level_name(log_level_t level);
+void log_stats_get(log_stats_t * p_stats);
+void log_flush(void);
+
+#endif // LOG_H
@@ -21,6 +21,9 @@
  *****************************************************************************/
 int main(int argc, char ** argv)
 {
+    g_application.argc = argc;
+    g_application.argv = argv;
+
     /* Enter the ThreadX kernel.  */
     tx_kernel_enter();
     return 0;
@@ -43,8 +46,5 @@ void tx_application_define(void *first_unused_memory)
         printf("Failed application_tx_define::tx_byte_pool_create, tx_err = %d\r\n", tx_err);
     }
 
-    for(ULONG feature_num = 0; feature_num < g_application.feature_count; feature_num++)
-    {
-        g_application.p_features[feature_num].feature_define(&g_application.memory_byte_pool);
-    }
+    application_features_define();
 }
@@ -0,0 +1,151 @@
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include "metrics.h"
+
+/******************************************************************************
+ * CONSTANTS
+ *****************************************************************************/
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+
+/******************************************************************************
+ * GLOBALS
+ *****************************************************************************/
+static char const * const g_metric_type_names[] =
+{
+    "counter",
+    "gauge",
+    "histogram",
+};
+
+/******************************************************************************
+ * FUNCTION: metric_add
+ *****************************************************************************/
+void metric_add(metric_t * p_metric, uint64_t delta)
+{
+    /* Writes are a few instructions with interrupts off, so writers of the
+     * same metric never see each other half way */
+    TX_INTERRUPT_SAVE_AREA
+    TX_DISABLE
+    p_metric->sequence++;
+    p_metric->value += delta;
+    p_metric->sequence++;
+    TX_RESTORE
+}
+
+/******************************************************************************
+ * FUNCTION: metric_set
+ *****************************************************************************/
+void metric_set(metric_t * p_metric, uint64_t value)
+{
+    TX_INTERRUPT_SAVE_AREA
+    TX_DISABLE
+    p_metric->sequence++;
+    p_metric->value = value;
+    p_metric->sequence++;
+    TX_RESTORE
+}
+
+/******************************************************************************
+ * FUNCTION: metric_observe
+ *****************************************************************************/
+void metric_observe(metric_t * p_metric, ULONG sample)
+{
+    /* The bounds are few, a linear search is as quick as any */
+    ULONG bucket = 0;
+    while((bucket < p_metric->bound_count) && (sample > p_metric->p_bounds[bucket]))
+    {
+        bucket++;
+    }
+
+    TX_INTERRUPT_SAVE_AREA
+    TX_DISABLE
+    p_metric->sequence++;
+    p_metric->value += sample;
+    p_metric->count++;
+    p_metric->buckets[bucket]++;
+    p_metric->sequence++;
+    TX_RESTORE
+}
+
+/******************************************************************************
+ * FUNCTION: metric_read
+ *****************************************************************************/
+void metric_read(metric_t const * p_metric, metric_snapshot_t * p_snapshot)
+{
+    ULONG sequence  = 0;
+    ULONG buckets   = (METRIC_TYPE_HISTOGRAM == p_metric->type) ? (p_metric->bound_count + 1U) : 0U;
+
+    /* Copied again if a write started or finished meanwhile. Writers have
+     * interrupts off, so this only repeats when the copy was preempted by
+     * one, or on ports where threads run in parallel */
+    do
+    {
+        sequence = p_metric->sequence;
+        p_snapshot->type    = p_metric->type;
+        p_snapshot->value   = p_metric->value;
+        p_snapshot->count   = p_metric->count;
+        for(ULONG bucket = 0; bucket < buckets; bucket++)
+        {
+            p_snapshot->buckets[bucket] = p_metric->buckets[bucket];
+        }
+    } while((0U != (sequence & 1U)) || (sequence != p_metric->sequence));
+}
+
+/******************************************************************************
+ * FUNCTION: metric_type_name
+ *****************************************************************************/
+char const * metric_type_name(metric_type_t type)
+{
+    return (type < (sizeof(g_metric_type_names) / sizeof(g_metric_type_names[0]))) ?
+           g_metric_type_names[type] : "?";
+}
+
+/******************************************************************************
+ * FUNCTION: metrics_thread_collect
+ *****************************************************************************/
+void metrics_thread_collect(metric_t * p_metrics, TX_THREAD * p_thread)
+{
+    UINT    state       = 0;
+    ULONG   run_count   = 0;
+
+    if(TX_SUCCESS != tx_thread_info_get(p_thread, NULL, &state, &run_count, NULL, NULL, NULL, NULL, NULL))
+    {
+        return;
+    }
+
+    /* ThreadX fills stacks with TX_STACK_FILL when threads are created, the
+     * stack grows down so the untouched part is at its start */
+    ULONG const *p_word     = (ULONG const *) p_thread->tx_thread_stack_start;
+    ULONG const *p_end      = p_word + (p_thread->tx_thread_stack_size / sizeof(ULONG));
+    while((p_word < p_end) && (TX_STACK_FILL == *p_word))
+    {
+        p_word++;
+    }
+
+    metric_set(&p_metrics[0], state);
+    metric_set(&p_metrics[1], run_count);
+    metric_set(&p_metrics[2], (uint64_t) p_thread->tx_thread_stack_size -
+                              (uint64_t) ((uintptr_t) p_word - (uintptr_t) p_thread->tx_thread_stack_start));
+}
+
+/******************************************************************************
+ * FUNCTION: metrics_pool_collect
+ *****************************************************************************/
+void metrics_pool_collect(metric_t * p_metrics, TX_BYTE_POOL * p_pool)
+{
+    ULONG available = 0;
+    ULONG fragments = 0;
+
+    if(TX_SUCCESS != tx_byte_pool_info_get(p_pool, NULL, &available, &fragments, NULL, NULL, NULL))
+    {
+        return;
+    }
+
+    metric_set(&p_metrics[0], available);
+    metric_set(&p_metrics[1], fragments);
+    metric_set(&p_metrics[2], p_pool->tx_byte_pool_size);
+}
@@ -0,0 +1,87 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include "tx_api.h"
+#include <stdint.h>
+
+/******************************************************************************
+ * CONSTANTS
+ *****************************************************************************/
+/* Bucket bounds a histogram can have, samples above the last bound are
+ * counted in one more bucket */
+#define METRICS_HISTOGRAM_BOUNDS_MAX    (8U)
+
+/* Metrics declared by METRICS_THREAD and METRICS_POOL */
+#define METRICS_THREAD_COUNT            (3U)
+#define METRICS_POOL_COUNT              (3U)
+
+/* Declare metrics in a feature's array of metric_t */
+#define METRIC_COUNTER(name)            { .p_name = (name), .type = METRIC_TYPE_COUNTER }
+#define METRIC_GAUGE(name)              { .p_name = (name), .type = METRIC_TYPE_GAUGE }
+#define METRIC_HISTOGRAM(name, bounds)  { .p_name = (name), .type = METRIC_TYPE_HISTOGRAM, .p_bounds = (bounds), \
+                                          .bound_count = sizeof(bounds) / sizeof((bounds)[0]) }
+
+/* State, run count and bytes of stack used of a thread, see
+ * metrics_thread_collect */
+#define METRICS_THREAD(prefix)          METRIC_GAUGE(prefix ".state"), \
+                                        METRIC_COUNTER(prefix ".runs"), \
+                                        METRIC_GAUGE(prefix ".stack_used")
+
+/* Bytes available, fragments and size of a byte pool, see
+ * metrics_pool_collect */
+#define METRICS_POOL(prefix)            METRIC_GAUGE(prefix ".available"), \
+                                        METRIC_GAUGE(prefix ".fragments"), \
+                                        METRIC_GAUGE(prefix ".size")
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+typedef enum e_metric_type
+{
+    METRIC_TYPE_COUNTER,        /* Only goes up */
+    METRIC_TYPE_GAUGE,          /* Value at the time it was set */
+    METRIC_TYPE_HISTOGRAM,      /* Samples by bucket, with their count and sum */
+} metric_type_t;
+
+/* Metric published by a feature. The feature writes it with metric_add,
+ * metric_set or metric_observe, and readers take a snapshot with
+ * metric_read. The sequence is odd while a write is under way, so readers
+ * retry instead of stopping the writer */
+typedef struct st_metric
+{
+    char const                  *p_name;
+    metric_type_t               type;
+
+    /* Upper bounds of the histogram buckets, ascending */
+    ULONG const                 *p_bounds;
+    ULONG                       bound_count;
+
+    ULONG volatile              sequence;
+    uint64_t volatile           value;      /* Total, level, or sum of the samples */
+    ULONG volatile              count;      /* Samples of a histogram */
+    ULONG volatile              buckets[METRICS_HISTOGRAM_BOUNDS_MAX + 1U];
+} metric_t;
+
+typedef struct st_metric_snapshot
+{
+    metric_type_t               type;
+    uint64_t                    value;
+    ULONG                       count;
+    ULONG                       buckets[METRICS_HISTOGRAM_BOUNDS_MAX + 1U];
+} metric_snapshot_t;
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+void metric_add(metric_t * p_metric, uint64_t delta);
+void metric_set(metric_t * p_metric, uint64_t value);
+void metric_observe(metric_t * p_metric, ULONG sample);
+void metric_read(metric_t const * p_metric, metric_snapshot_t * p_snapshot);
+char const * metric_type_name(metric_type_t type);
+void metrics_thread_collect(metric_t * p_metrics, TX_THREAD * p_thread);
+void metrics_pool_collect(metric_t * p_metrics, TX_BYTE_POOL * p_pool);
+
+#endif // METRICS_H
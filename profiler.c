@@ -0,0 +1,473 @@
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include "profiler.h"
+#include "log.h"
+#include <string.h>
+
+/******************************************************************************
+ * CONSTANTS
+ *****************************************************************************/
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+static void profiler_sample(profiler_t * p_profiler);
+static void profiler_thread_sample(profiler_t * p_profiler, TX_THREAD * p_thread, ULONG elapsed_ticks);
+static ULONG profiler_rate(ULONG delta, ULONG elapsed_ticks);
+static void profiler_order(profiler_t * p_profiler);
+
+/* Created threads, kept by ThreadX in tx_thread.h which is not in the port */
+extern TX_THREAD *  _tx_thread_created_ptr;
+extern ULONG        _tx_thread_created_count;
+
+/******************************************************************************
+ * GLOBALS
+ *****************************************************************************/
+profiler_t * gp_profiler = 0;
+
+static metric_t g_profiler_metrics[PROFILER_METRIC_COUNT] =
+{
+    METRICS_THREAD("thread"),
+    METRIC_COUNTER("samples"),
+    METRIC_GAUGE("threads"),
+    METRIC_GAUGE("untracked"),
+    METRIC_GAUGE("busy_permille"),
+};
+
+/* Thread states in the order of their ThreadX values */
+static char const * const g_profiler_state_names[] =
+{
+    "ready",
+    "completed",
+    "terminated",
+    "suspended",
+    "sleep",
+    "queue",
+    "semaphore",
+    "-",
+    "events",
+    "block",
+    "byte",
+    "io",
+    "file",
+    "tcp/ip",
+    "mutex",
+    "priority",
+};
+
+/******************************************************************************
+ * FUNCTION: profiler_define
+ *****************************************************************************/
+UINT profiler_define(TX_BYTE_POOL * p_memory_pool)
+{
+    UINT        tx_err      = TX_SUCCESS;
+    profiler_t  *p_profiler = NULL;
+
+    tx_err = tx_byte_allocate(p_memory_pool, (VOID **) &p_profiler, sizeof(profiler_t), TX_NO_WAIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        LOG_ERROR("Failed profiler_define::tx_byte_allocate, tx_err = %d", tx_err);
+        return tx_err;
+    }
+    memset((void *) p_profiler, 0, sizeof(profiler_t));
+
+    tx_err = tx_byte_allocate(p_memory_pool, &p_profiler->p_thread_stack, PROFILER_THREAD_STACK_SIZE, TX_NO_WAIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        LOG_ERROR("Failed profiler_define::tx_byte_allocate, tx_err = %d", tx_err);
+        tx_byte_release(p_profiler);
+        return tx_err;
+    }
+
+    tx_err = tx_mutex_create(&p_profiler->lock, PROFILER_LOCK_NAME, TX_INHERIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        LOG_ERROR("Failed profiler_define::tx_mutex_create, tx_err = %d", tx_err);
+        tx_byte_release(p_profiler->p_thread_stack);
+        tx_byte_release(p_profiler);
+        return tx_err;
+    }
+
+    /* Readers may look as soon as the thread takes its first sample */
+    gp_profiler = p_profiler;
+
+    tx_err = tx_thread_create(&p_profiler->thread,
+                              PROFILER_THREAD_NAME,
+                              profiler_thread_entry,
+                              0,
+                              p_profiler->p_thread_stack,
+                              PROFILER_THREAD_STACK_SIZE,
+                              PROFILER_THREAD_PRIORITY,
+                              PROFILER_THREAD_PRIORITY,
+                              TX_NO_TIME_SLICE,
+                              TX_AUTO_START);
+    if(TX_SUCCESS != tx_err)
+    {
+        LOG_ERROR("Failed profiler_define::tx_thread_create, tx_err = %d", tx_err);
+        gp_profiler = NULL;
+        tx_mutex_delete(&p_profiler->lock);
+        tx_byte_release(p_profiler->p_thread_stack);
+        tx_byte_release(p_profiler);
+        return tx_err;
+    }
+
+    LOG_INFO("Started profiler, sampling every %u ticks", PROFILER_PERIOD);
+
+    return TX_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: profiler_get_status
+ *****************************************************************************/
+void profiler_get_status(feature_status_t * p_status)
+{
+    profiler_system_t system = { 0 };
+
+    if(!profiler_system_get(&system))
+    {
+        return;
+    }
+
+    metrics_thread_collect(&g_profiler_metrics[PROFILER_METRIC_THREAD], &gp_profiler->thread);
+    metric_set(&g_profiler_metrics[PROFILER_METRIC_SAMPLES], system.samples);
+    metric_set(&g_profiler_metrics[PROFILER_METRIC_THREADS], system.thread_count);
+    metric_set(&g_profiler_metrics[PROFILER_METRIC_UNTRACKED], system.untracked);
+    metric_set(&g_profiler_metrics[PROFILER_METRIC_BUSY], system.busy);
+
+    p_status->return_code   = system.untracked;
+    p_status->p_metrics     = g_profiler_metrics;
+    p_status->metric_count  = PROFILER_METRIC_COUNT;
+}
+
+/******************************************************************************
+ * FUNCTION: profiler_start
+ *****************************************************************************/
+UINT profiler_start(void)
+{
+    /* The period it was suspended for is not counted as one */
+    gp_profiler->last_ticks = tx_time_get();
+
+    return tx_thread_resume(&gp_profiler->thread);
+}
+
+/******************************************************************************
+ * FUNCTION: profiler_suspend
+ *****************************************************************************/
+UINT profiler_suspend(void)
+{
+    /* Not while it holds the lock, which readers would then wait on */
+    UINT tx_err = tx_mutex_get(&gp_profiler->lock, TX_WAIT_FOREVER);
+    if(TX_SUCCESS == tx_err)
+    {
+        tx_err = tx_thread_suspend(&gp_profiler->thread);
+        tx_mutex_put(&gp_profiler->lock);
+    }
+
+    return tx_err;
+}
+
+/******************************************************************************
+ * FUNCTION: profiler_stop
+ *****************************************************************************/
+UINT profiler_stop(void)
+{
+    profiler_t *p_profiler = gp_profiler;
+
+    /* Readers take the feature lock, which is held here, so none is left */
+    UINT tx_err = tx_mutex_get(&p_profiler->lock, TX_WAIT_FOREVER);
+    if(TX_SUCCESS == tx_err)
+    {
+        tx_err = tx_thread_terminate(&p_profiler->thread);
+        tx_mutex_put(&p_profiler->lock);
+    }
+    if(TX_SUCCESS == tx_err)
+    {
+        tx_err = tx_thread_delete(&p_profiler->thread);
+    }
+    if(TX_SUCCESS != tx_err)
+    {
+        return tx_err;
+    }
+
+    gp_profiler = NULL;
+    tx_mutex_delete(&p_profiler->lock);
+    tx_byte_release(p_profiler->p_thread_stack);
+
+    return tx_byte_release(p_profiler);
+}
+
+/******************************************************************************
+ * FUNCTION: profiler_thread_entry
+ *****************************************************************************/
+void profiler_thread_entry(ULONG thread_input)
+{
+    (void) thread_input;
+
+    profiler_t *p_profiler = gp_profiler;
+
+    /* The first sample only takes the counters, rates need two */
+    tx_mutex_get(&p_profiler->lock, TX_WAIT_FOREVER);
+    p_profiler->last_ticks = tx_time_get();
+    profiler_sample(p_profiler);
+    tx_mutex_put(&p_profiler->lock);
+
+    while(1)
+    {
+        tx_thread_sleep(PROFILER_PERIOD);
+
+        tx_mutex_get(&p_profiler->lock, TX_WAIT_FOREVER);
+        profiler_sample(p_profiler);
+        tx_mutex_put(&p_profiler->lock);
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: profiler_system_get
+ *****************************************************************************/
+bool profiler_system_get(profiler_system_t * p_system)
+{
+    /* The feature lock keeps the profiler from stopping meanwhile, it is
+     * already held when called for the feature's status */
+    if(TX_SUCCESS != tx_mutex_get(&g_application.feature_lock, TX_WAIT_FOREVER))
+    {
+        return false;
+    }
+
+    bool running = (NULL != gp_profiler);
+    if(running)
+    {
+        tx_mutex_get(&gp_profiler->lock, TX_WAIT_FOREVER);
+        *p_system = gp_profiler->system;
+        tx_mutex_put(&gp_profiler->lock);
+    }
+
+    tx_mutex_put(&g_application.feature_lock);
+
+    return running;
+}
+
+/******************************************************************************
+ * FUNCTION: profiler_thread_get
+ *****************************************************************************/
+bool profiler_thread_get(ULONG rank, profiler_thread_t * p_thread)
+{
+    /* Threads by run share, rank 0 was run the most. Each is copied on its
+     * own, so the sampler never waits on a reader writing out a table */
+    if(TX_SUCCESS != tx_mutex_get(&g_application.feature_lock, TX_WAIT_FOREVER))
+    {
+        return false;
+    }
+
+    bool found = false;
+    if((NULL != gp_profiler) && (rank < PROFILER_THREADS_MAX))
+    {
+        tx_mutex_get(&gp_profiler->lock, TX_WAIT_FOREVER);
+        found = (NULL != gp_profiler->threads[gp_profiler->order[rank]].p_thread);
+        if(found)
+        {
+            *p_thread = gp_profiler->threads[gp_profiler->order[rank]];
+        }
+        tx_mutex_put(&gp_profiler->lock);
+    }
+
+    tx_mutex_put(&g_application.feature_lock);
+
+    return found;
+}
+
+/******************************************************************************
+ * FUNCTION: profiler_state_name
+ *****************************************************************************/
+char const * profiler_state_name(UINT state)
+{
+    return (state < (sizeof(g_profiler_state_names) / sizeof(g_profiler_state_names[0]))) ?
+           g_profiler_state_names[state] : "?";
+}
+
+/******************************************************************************
+ * FUNCTION: profiler_sample
+ *****************************************************************************/
+static void profiler_sample(profiler_t * p_profiler)
+{
+    TX_THREAD   *p_threads[PROFILER_THREADS_MAX];
+    ULONG       thread_count    = 0;
+    ULONG       created_count   = 0;
+    ULONG       now_ticks       = tx_time_get();
+    ULONG       elapsed_ticks   = now_ticks - p_profiler->last_ticks;
+    ULONG       resumptions     = 0;
+    ULONG       solicited       = 0;
+    ULONG       interrupted     = 0;
+    ULONG       non_idle        = 0;
+    ULONG       idle            = 0;
+
+    /* The list of created threads is only walked with interrupts off, the
+     * threads are looked at after. One deleted in between fails its lookup */
+    TX_INTERRUPT_SAVE_AREA
+    TX_DISABLE
+    created_count = _tx_thread_created_count;
+    TX_THREAD *p_thread = _tx_thread_created_ptr;
+    while((thread_count < created_count) && (thread_count < PROFILER_THREADS_MAX) && (NULL != p_thread))
+    {
+        p_threads[thread_count++] = p_thread;
+        p_thread = p_thread->tx_thread_created_next;
+    }
+    TX_RESTORE
+
+    tx_thread_performance_system_info_get(&resumptions, NULL, &solicited, &interrupted, NULL, NULL, NULL, NULL, NULL,
+                                          &non_idle, &idle);
+
+    /* Returns from interrupts land in a thread or in the idle loop, the
+     * timer tick spreads them over time like samples of the CPU */
+    profiler_system_t   *p_system       = &p_profiler->system;
+    ULONG               idle_delta      = idle - p_system->idle_returns;
+    ULONG               non_idle_delta  = non_idle - p_system->non_idle_returns;
+    bool                first           = (0U == p_system->samples);
+
+    p_system->period_ticks      = elapsed_ticks;
+    p_system->thread_count      = created_count;
+    p_system->untracked         = created_count - thread_count;
+    p_system->resumption_rate   = first ? 0U : profiler_rate(resumptions - p_system->resumptions, elapsed_ticks);
+    p_system->preemption_rate   = first ? 0U : profiler_rate((solicited + interrupted) - p_system->preemptions, elapsed_ticks);
+    p_system->busy              = (first || (0U == (idle_delta + non_idle_delta))) ? 0U :
+                                  (ULONG) (((uint64_t) non_idle_delta * PROFILER_SHARE_SCALE) / (idle_delta + non_idle_delta));
+    p_system->resumptions       = resumptions;
+    p_system->preemptions       = solicited + interrupted;
+    p_system->non_idle_returns  = non_idle;
+    p_system->idle_returns      = idle;
+
+    /* Entries of threads that are gone are freed first, so new threads
+     * can take them */
+    for(ULONG entry_num = 0; entry_num < PROFILER_THREADS_MAX; entry_num++)
+    {
+        bool found = false;
+        for(ULONG thread_num = 0; !found && (thread_num < thread_count); thread_num++)
+        {
+            found = (p_threads[thread_num] == p_profiler->threads[entry_num].p_thread);
+        }
+        if(!found)
+        {
+            p_profiler->threads[entry_num].p_thread = NULL;
+        }
+    }
+
+    for(ULONG thread_num = 0; thread_num < thread_count; thread_num++)
+    {
+        profiler_thread_sample(p_profiler, p_threads[thread_num], first ? 0U : elapsed_ticks);
+    }
+
+    /* The busy time is split by how often each thread was given the CPU,
+     * how long it kept it is not known */
+    ULONG runs = 0;
+    for(ULONG entry_num = 0; entry_num < PROFILER_THREADS_MAX; entry_num++)
+    {
+        runs += (NULL != p_profiler->threads[entry_num].p_thread) ? p_profiler->threads[entry_num].runs : 0U;
+    }
+    for(ULONG entry_num = 0; entry_num < PROFILER_THREADS_MAX; entry_num++)
+    {
+        profiler_thread_t *p_entry = &p_profiler->threads[entry_num];
+        p_entry->run_share = (0U == runs) ? 0U : (ULONG) (((uint64_t) p_system->busy * p_entry->runs) / runs);
+    }
+
+    profiler_order(p_profiler);
+
+    p_profiler->last_ticks = now_ticks;
+    p_system->samples++;
+}
+
+/******************************************************************************
+ * FUNCTION: profiler_thread_sample
+ *****************************************************************************/
+static void profiler_thread_sample(profiler_t * p_profiler, TX_THREAD * p_thread, ULONG elapsed_ticks)
+{
+    CHAR    *p_name         = NULL;
+    UINT    state           = 0;
+    UINT    priority        = 0;
+    ULONG   run_count       = 0;
+    ULONG   resumptions     = 0;
+    ULONG   solicited       = 0;
+    ULONG   interrupted     = 0;
+    ULONG   time_slices     = 0;
+
+    if((TX_SUCCESS != tx_thread_info_get(p_thread, &p_name, &state, &run_count, &priority, NULL, NULL, NULL, NULL)) ||
+       (TX_SUCCESS != tx_thread_performance_info_get(p_thread, &resumptions, NULL, &solicited, &interrupted, NULL,
+                                                     &time_slices, NULL, NULL, NULL, NULL)))
+    {
+        return;
+    }
+
+    /* A thread seen before keeps its entry, a new one takes a free entry and
+     * has no rates until the next sample */
+    profiler_thread_t   *p_entry    = NULL;
+    profiler_thread_t   *p_free     = NULL;
+    for(ULONG entry_num = 0; (NULL == p_entry) && (entry_num < PROFILER_THREADS_MAX); entry_num++)
+    {
+        if(p_thread == p_profiler->threads[entry_num].p_thread)
+        {
+            p_entry = &p_profiler->threads[entry_num];
+        }
+        else if((NULL == p_free) && (NULL == p_profiler->threads[entry_num].p_thread))
+        {
+            p_free = &p_profiler->threads[entry_num];
+        }
+    }
+    if(NULL == p_entry)
+    {
+        p_entry = p_free;
+        elapsed_ticks = 0;
+        p_entry->p_thread = p_thread;
+        strncpy(p_entry->name, (NULL != p_name) ? p_name : "", THREAD_OBJECT_NAME_LENGTH_MAX - 1);
+        p_entry->name[THREAD_OBJECT_NAME_LENGTH_MAX - 1] = '\0';
+    }
+
+    bool rated = (0U != elapsed_ticks);
+    p_entry->state              = state;
+    p_entry->priority           = priority;
+    p_entry->runs               = rated ? (run_count - p_entry->run_count) : 0U;
+    p_entry->resumption_rate    = rated ? profiler_rate(resumptions - p_entry->resumptions, elapsed_ticks) : 0U;
+    p_entry->preemption_rate    = rated ? profiler_rate((solicited + interrupted) - p_entry->preemptions, elapsed_ticks) : 0U;
+    p_entry->time_slice_rate    = rated ? profiler_rate(time_slices - p_entry->time_slices, elapsed_ticks) : 0U;
+    p_entry->run_count          = run_count;
+    p_entry->resumptions        = resumptions;
+    p_entry->preemptions        = solicited + interrupted;
+    p_entry->time_slices        = time_slices;
+}
+
+/******************************************************************************
+ * FUNCTION: profiler_rate
+ *****************************************************************************/
+static ULONG profiler_rate(ULONG delta, ULONG elapsed_ticks)
+{
+    return (0U == elapsed_ticks) ? 0U :
+           (ULONG) (((uint64_t) delta * TX_TIMER_TICKS_PER_SECOND) / elapsed_ticks);
+}
+
+/******************************************************************************
+ * FUNCTION: profiler_order
+ *****************************************************************************/
+static void profiler_order(profiler_t * p_profiler)
+{
+    /* Insertion sort, by run share then resumptions, free entries last */
+    for(uint8_t entry_num = 0; entry_num < PROFILER_THREADS_MAX; entry_num++)
+    {
+        profiler_thread_t const *p_entry = &p_profiler->threads[entry_num];
+        ULONG                   rank     = entry_num;
+
+        while(rank > 0U)
+        {
+            profiler_thread_t const *p_above = &p_profiler->threads[p_profiler->order[rank - 1U]];
+            bool                    before   = (NULL != p_entry->p_thread) &&
+                                               ((NULL == p_above->p_thread) ||
+                                                (p_entry->run_share > p_above->run_share) ||
+                                                ((p_entry->run_share == p_above->run_share) &&
+                                                 (p_entry->resumption_rate > p_above->resumption_rate)));
+            if(!before)
+            {
+                break;
+            }
+            p_profiler->order[rank] = p_profiler->order[rank - 1U];
+            rank--;
+        }
+        p_profiler->order[rank] = entry_num;
+    }
+}
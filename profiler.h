@@ -0,0 +1,116 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include "application.h"
+#include "metrics.h"
+#include <stdint.h>
+
+/******************************************************************************
+ * CONSTANTS
+ *****************************************************************************/
+#define PROFILER_THREAD_NAME            ("Profiler Thread")
+#define PROFILER_LOCK_NAME              ("Profiler Lock")
+#define PROFILER_THREAD_STACK_SIZE      (APPLICATION_THREAD_STACK_SIZE)
+
+/* Samples are taken above every other thread so periods stay even, they
+ * are short and only taken once a period */
+#define PROFILER_THREAD_PRIORITY        (0)
+
+/* Ticks between samples, rates are per second whatever the period */
+#define PROFILER_PERIOD                 (TX_TIMER_TICKS_PER_SECOND)
+
+/* Threads followed, threads past these are only counted */
+#define PROFILER_THREADS_MAX            (32U)
+
+/* Busy time and run shares are in tenths of a percent */
+#define PROFILER_SHARE_SCALE            (1000U)
+
+/* Metrics of the profiler feature, indexes into g_profiler_metrics */
+#define PROFILER_METRIC_THREAD          (0U)
+#define PROFILER_METRIC_SAMPLES         (PROFILER_METRIC_THREAD + METRICS_THREAD_COUNT)
+#define PROFILER_METRIC_THREADS         (PROFILER_METRIC_SAMPLES + 1U)
+#define PROFILER_METRIC_UNTRACKED       (PROFILER_METRIC_THREADS + 1U)
+#define PROFILER_METRIC_BUSY            (PROFILER_METRIC_UNTRACKED + 1U)
+#define PROFILER_METRIC_COUNT           (PROFILER_METRIC_BUSY + 1U)
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+/* A thread as of the last two samples. ThreadX keeps no run time per
+ * thread, so its share of the busy time is weighted by how often it was
+ * given the CPU, not by how long it kept it. A thread that wakes often to
+ * do little ranks above one that spins */
+typedef struct st_profiler_thread
+{
+    TX_THREAD                   *p_thread;      /* NULL when the entry is free */
+    CHAR                        name[THREAD_OBJECT_NAME_LENGTH_MAX];
+    UINT                        state;
+    UINT                        priority;
+
+    /* Counters at the last sample */
+    ULONG                       run_count;
+    ULONG                       resumptions;
+    ULONG                       preemptions;    /* Solicited and by interrupts */
+    ULONG                       time_slices;
+
+    /* Over the last period, rates are per second */
+    ULONG                       runs;
+    ULONG                       resumption_rate;
+    ULONG                       preemption_rate;
+    ULONG                       time_slice_rate;
+    ULONG                       run_share;      /* Of the busy time by runs, see PROFILER_SHARE_SCALE */
+} profiler_thread_t;
+
+/* The system as of the last two samples */
+typedef struct st_profiler_system
+{
+    ULONG                       samples;
+    ULONG                       period_ticks;   /* Between the last two samples */
+    ULONG                       thread_count;
+    ULONG                       untracked;      /* Threads past PROFILER_THREADS_MAX */
+
+    /* Counters at the last sample */
+    ULONG                       resumptions;
+    ULONG                       preemptions;
+    ULONG                       non_idle_returns;
+    ULONG                       idle_returns;
+
+    /* Over the last period */
+    ULONG                       resumption_rate;
+    ULONG                       preemption_rate;
+    ULONG                       busy;           /* See PROFILER_SHARE_SCALE */
+} profiler_system_t;
+
+typedef struct st_profiler
+{
+    /* Thread Related */
+    TX_THREAD                   thread;
+    VOID                        *p_thread_stack;
+    TX_MUTEX                    lock;
+
+    /* Taken by the profiler thread, read under the lock */
+    ULONG                       last_ticks;
+    profiler_system_t           system;
+    profiler_thread_t           threads[PROFILER_THREADS_MAX];
+
+    /* Entries of threads by run share, most run first */
+    uint8_t                     order[PROFILER_THREADS_MAX];
+} profiler_t;
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+UINT profiler_define(TX_BYTE_POOL * p_memory_pool);
+void profiler_get_status(feature_status_t * p_status);
+UINT profiler_start(void);
+UINT profiler_suspend(void);
+UINT profiler_stop(void);
+void profiler_thread_entry(ULONG thread_input);
+bool profiler_system_get(profiler_system_t * p_system);
+bool profiler_thread_get(ULONG rank, profiler_thread_t * p_thread);
+char const * profiler_state_name(UINT state);
+
+#endif // PROFILER_H
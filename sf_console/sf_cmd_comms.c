@@ -2,15 +2,60 @@
  * INCLUDES
  *****************************************************************************/
 #include <stdio.h>
+#include <string.h>
 #include "sf_cmd_comms.h"
 
+#if defined(_WIN32)
+#include <io.h>
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+
 /******************************************************************************
  * CONSTANTS
  *****************************************************************************/
+#if defined(_WIN32)
+#define SF_CMD_COMMS_SYS_READ(fd, p_buf, bytes)     _read((fd), (p_buf), (unsigned int) (bytes))
+#define SF_CMD_COMMS_SYS_WRITE(fd, p_buf, bytes)    _write((fd), (p_buf), (unsigned int) (bytes))
+#else
+#define SF_CMD_COMMS_SYS_READ(fd, p_buf, bytes)     read((fd), (p_buf), (size_t) (bytes))
+#define SF_CMD_COMMS_SYS_WRITE(fd, p_buf, bytes)    write((fd), (p_buf), (size_t) (bytes))
+#endif
+
+#define SF_CMD_COMMS_RX_MASK    (SF_CMD_COMMS_RX_BUFFER_SIZE - 1U)
+#define SF_CMD_COMMS_TX_MASK    (SF_CMD_COMMS_TX_BUFFER_SIZE - 1U)
 
 /******************************************************************************
  * PROTOTYPES
  *****************************************************************************/
+static fsp_err_t sf_cmd_comms_sys_read(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl,
+                                       uint8_t * p_dest,
+                                       uint32_t bytes,
+                                       uint32_t * p_bytes_read);
+static fsp_err_t sf_cmd_comms_sys_write(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl,
+                                        uint8_t const * p_src,
+                                        uint32_t bytes);
+static fsp_err_t sf_cmd_comms_rx_fill(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl);
+static fsp_err_t sf_cmd_comms_rx_wait(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl, uint32_t bytes, UINT timeout);
+static VOID sf_cmd_comms_rx_thread_entry(ULONG thread_input);
+static void sf_cmd_comms_stdio_sync(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl);
+static fsp_err_t sf_cmd_comms_tx_flush(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl);
+static fsp_err_t sf_cmd_comms_tx_flush_unlocked(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl);
+static fsp_err_t sf_cmd_comms_tx_unlock(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl);
+static fsp_err_t sf_cmd_comms_mutex_create(sf_cmd_comms_mutex_t * p_mutex, CHAR * p_name);
+static fsp_err_t sf_cmd_comms_mutex_get(sf_cmd_comms_mutex_t * p_mutex, UINT timeout);
+static fsp_err_t sf_cmd_comms_mutex_put(sf_cmd_comms_mutex_t * p_mutex);
+static ULONG sf_cmd_comms_mutex_depth(sf_cmd_comms_mutex_t * p_mutex);
+static uint64_t sf_cmd_comms_mutex_time_us(void);
+static fsp_err_t sf_cmd_comms_record_start(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl);
+static void sf_cmd_comms_record(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl,
+                                uint8_t direction,
+                                uint8_t const * p_data,
+                                uint32_t bytes);
+static bool sf_cmd_comms_record_write(int fd, uint8_t const * p_data, uint32_t bytes);
+static uint32_t sf_cmd_comms_varint_put(uint8_t * p_dest, uint64_t value);
 
 /******************************************************************************
  * GLOBALS
@@ -24,6 +69,10 @@ sf_comms_api_t g_sf_comms_on_sf_cmd_comms =
     .write         = SF_CMD_COMMS_Write,
     .lock          = SF_CMD_COMMS_Lock,
     .unlock        = SF_CMD_COMMS_Unlock,
+    .readSpan      = SF_CMD_COMMS_ReadSpan,
+    .readRelease   = SF_CMD_COMMS_ReadRelease,
+    .writeSpan     = SF_CMD_COMMS_WriteSpan,
+    .writeCommit   = SF_CMD_COMMS_WriteCommit,
 };
 #endif
 
@@ -33,8 +82,82 @@ sf_comms_api_t g_sf_comms_on_sf_cmd_comms =
 fsp_err_t SF_CMD_COMMS_Open(sf_comms_ctrl_t * const p_ctrl, sf_comms_cfg_t const * const p_cfg)
 {
     fsp_err_t fsp_err = FSP_SUCCESS;
+    sf_cmd_comms_instance_ctrl_t * p_comms_ctrl = (sf_cmd_comms_instance_ctrl_t *) p_ctrl;
+
+    if((NULL == p_comms_ctrl) || (NULL == p_cfg) || (NULL == p_cfg->p_extend))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if(p_comms_ctrl->open)
+    {
+        return FSP_ERR_ALREADY_OPEN;
+    }
+
+    p_comms_ctrl->p_cfg     = (sf_cmd_comms_cfg_t const *) p_cfg->p_extend;
+    p_comms_ctrl->rx_head   = 0;
+    p_comms_ctrl->rx_tail   = 0;
+    p_comms_ctrl->tx_head   = 0;
+    p_comms_ctrl->tx_tail   = 0;
+    p_comms_ctrl->rx_error  = false;
+
+    fsp_err = sf_cmd_comms_mutex_create(&p_comms_ctrl->rx_lock, SF_CMD_COMMS_RX_MUTEX_NAME);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        return fsp_err;
+    }
+
+    fsp_err = sf_cmd_comms_mutex_create(&p_comms_ctrl->tx_lock, SF_CMD_COMMS_TX_MUTEX_NAME);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        tx_mutex_delete(&p_comms_ctrl->rx_lock.mutex);
+        return fsp_err;
+    }
+
+    /* Reads only honour their timeout when a thread does the blocking syscall on their behalf */
+    p_comms_ctrl->rx_thread_enabled = (p_comms_ctrl->p_cfg->buffered) && (NULL != p_comms_ctrl->p_cfg->p_rx_thread_stack);
+    if(p_comms_ctrl->rx_thread_enabled)
+    {
+        UINT tx_err = tx_event_flags_create(&p_comms_ctrl->rx_events, SF_CMD_COMMS_RX_THREAD_NAME);
+        if(TX_SUCCESS != tx_err)
+        {
+            tx_mutex_delete(&p_comms_ctrl->tx_lock.mutex);
+            tx_mutex_delete(&p_comms_ctrl->rx_lock.mutex);
+            return FSP_ERR_INTERNAL;
+        }
 
-    /* TODO: IMPLEMENT? */
+        tx_err = tx_thread_create(&p_comms_ctrl->rx_thread,
+                                  SF_CMD_COMMS_RX_THREAD_NAME,
+                                  sf_cmd_comms_rx_thread_entry,
+                                  (ULONG) p_comms_ctrl,
+                                  p_comms_ctrl->p_cfg->p_rx_thread_stack,
+                                  p_comms_ctrl->p_cfg->rx_thread_stack_size,
+                                  p_comms_ctrl->p_cfg->rx_thread_priority,
+                                  p_comms_ctrl->p_cfg->rx_thread_priority,
+                                  p_comms_ctrl->p_cfg->rx_thread_time_slice,
+                                  TX_DONT_START);
+        if(TX_SUCCESS != tx_err)
+        {
+            tx_event_flags_delete(&p_comms_ctrl->rx_events);
+            tx_mutex_delete(&p_comms_ctrl->tx_lock.mutex);
+            tx_mutex_delete(&p_comms_ctrl->rx_lock.mutex);
+            return FSP_ERR_INTERNAL;
+        }
+    }
+
+    /* A recording that cannot start leaves the session unrecorded rather than closed */
+    fsp_err_t record_err = sf_cmd_comms_record_start(p_comms_ctrl);
+    if(FSP_SUCCESS != record_err)
+    {
+        printf("Failed SF_CMD_COMMS_Open::sf_cmd_comms_record_start, fsp_err = %d\r\n", record_err);
+    }
+
+    p_comms_ctrl->open      = true;
+
+    if(p_comms_ctrl->rx_thread_enabled)
+    {
+        tx_thread_resume(&p_comms_ctrl->rx_thread);
+    }
 
     return fsp_err;
 }
@@ -45,8 +168,34 @@ fsp_err_t SF_CMD_COMMS_Open(sf_comms_ctrl_t * const p_ctrl, sf_comms_cfg_t const
 fsp_err_t SF_CMD_COMMS_Close(sf_comms_ctrl_t * const p_ctrl)
 {
     fsp_err_t fsp_err = FSP_SUCCESS;
+    sf_cmd_comms_instance_ctrl_t * p_comms_ctrl = (sf_cmd_comms_instance_ctrl_t *) p_ctrl;
+
+    if(!p_comms_ctrl->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
 
-    /* TODO: IMPLEMENT? */
+    /* Anything still staged must reach the output before the transport goes away */
+    fsp_err = SF_CMD_COMMS_Flush(p_ctrl);
+
+    p_comms_ctrl->open = false;
+
+    if(p_comms_ctrl->rx_thread_enabled)
+    {
+        tx_thread_terminate(&p_comms_ctrl->rx_thread);
+        tx_thread_delete(&p_comms_ctrl->rx_thread);
+        tx_event_flags_delete(&p_comms_ctrl->rx_events);
+        p_comms_ctrl->rx_thread_enabled = false;
+    }
+
+    if(p_comms_ctrl->record_enabled)
+    {
+        tx_mutex_delete(&p_comms_ctrl->record_mutex);
+        p_comms_ctrl->record_enabled = false;
+    }
+
+    tx_mutex_delete(&p_comms_ctrl->tx_lock.mutex);
+    tx_mutex_delete(&p_comms_ctrl->rx_lock.mutex);
 
     return fsp_err;
 }
@@ -60,26 +209,78 @@ fsp_err_t SF_CMD_COMMS_Read(sf_comms_ctrl_t * const p_ctrl,
                        UINT const timeout)
 {
     fsp_err_t fsp_err = FSP_SUCCESS;
-    char c;
+    sf_cmd_comms_instance_ctrl_t * p_comms_ctrl = (sf_cmd_comms_instance_ctrl_t *) p_ctrl;
     uint8_t * p_buffer = p_dest;
     uint32_t bytes_read = 0;
 
-    while(1)
+    if(!p_comms_ctrl->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    /* Hold reception for the whole transfer so concurrent readers cannot interleave */
+    fsp_err = sf_cmd_comms_mutex_get(&p_comms_ctrl->rx_lock, timeout);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        return fsp_err;
+    }
+
+    if(!p_comms_ctrl->p_cfg->buffered)
     {
-        /* getchar does not support timeout */
-        c = getchar();
-        if(c != EOF)
+        while((FSP_SUCCESS == fsp_err) && (bytes_read < bytes))
         {
-            *p_buffer++ = c;
-            bytes_read++;
+            uint32_t chunk = 0;
+            fsp_err = sf_cmd_comms_sys_read(p_comms_ctrl, p_buffer, bytes - bytes_read, &chunk);
+            p_buffer += chunk;
+            bytes_read += chunk;
         }
 
-        if(bytes_read == bytes)
+        sf_cmd_comms_mutex_put(&p_comms_ctrl->rx_lock);
+        return fsp_err;
+    }
+
+    while(bytes_read < bytes)
+    {
+        uint8_t const * p_span = NULL;
+        uint32_t span_bytes = 0;
+
+        if(p_comms_ctrl->rx_thread_enabled)
+        {
+            /* Only consume once the ring holds the whole piece, so a timeout leaves the received
+             * bytes for the next read. After the first piece nothing is dropped, so wait it out. */
+            uint32_t needed = bytes - bytes_read;
+            if(needed > SF_CMD_COMMS_RX_BUFFER_SIZE)
+            {
+                needed = SF_CMD_COMMS_RX_BUFFER_SIZE;
+            }
+
+            fsp_err = sf_cmd_comms_rx_wait(p_comms_ctrl, needed, (0U == bytes_read) ? timeout : TX_WAIT_FOREVER);
+            if(FSP_SUCCESS != fsp_err)
+            {
+                break;
+            }
+        }
+
+        fsp_err = SF_CMD_COMMS_ReadSpan(p_ctrl, &p_span, &span_bytes, timeout);
+        if(FSP_SUCCESS != fsp_err)
         {
             break;
         }
+
+        if(span_bytes > (bytes - bytes_read))
+        {
+            span_bytes = bytes - bytes_read;
+        }
+
+        memcpy(p_buffer, p_span, span_bytes);
+        p_buffer += span_bytes;
+        bytes_read += span_bytes;
+
+        SF_CMD_COMMS_ReadRelease(p_ctrl, span_bytes);
     }
 
+    sf_cmd_comms_mutex_put(&p_comms_ctrl->rx_lock);
+
     return fsp_err;
 }
 
@@ -92,19 +293,58 @@ fsp_err_t SF_CMD_COMMS_Write(sf_comms_ctrl_t * const p_ctrl,
                         UINT const timeout)
 {
     fsp_err_t fsp_err = FSP_SUCCESS;
+    sf_cmd_comms_instance_ctrl_t * p_comms_ctrl = (sf_cmd_comms_instance_ctrl_t *) p_ctrl;
     uint8_t const *p_buffer = p_src;
     uint32_t bytes_written = 0;
 
-    while(1)
+    if(!p_comms_ctrl->open)
     {
-        /* putchar does not support timeout */
-        putchar(*p_buffer++);
-        bytes_written++;
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    /* Hold transmission for the whole transfer so concurrent writers cannot interleave. Releasing it flushes unless
+     * the caller holds the lock itself, in which case its own unlock does */
+    fsp_err = sf_cmd_comms_mutex_get(&p_comms_ctrl->tx_lock, timeout);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        return fsp_err;
+    }
 
-        if(bytes_written == bytes)
+    if(!p_comms_ctrl->p_cfg->buffered)
+    {
+        sf_cmd_comms_stdio_sync(p_comms_ctrl);
+        fsp_err = sf_cmd_comms_sys_write(p_comms_ctrl, p_src, bytes);
+        sf_cmd_comms_mutex_put(&p_comms_ctrl->tx_lock);
+        return fsp_err;
+    }
+
+    while(bytes_written < bytes)
+    {
+        uint8_t * p_span = NULL;
+        uint32_t span_bytes = 0;
+
+        fsp_err = SF_CMD_COMMS_WriteSpan(p_ctrl, &p_span, &span_bytes, timeout);
+        if(FSP_SUCCESS != fsp_err)
         {
             break;
         }
+
+        if(span_bytes > (bytes - bytes_written))
+        {
+            span_bytes = bytes - bytes_written;
+        }
+
+        memcpy(p_span, p_buffer, span_bytes);
+        p_buffer += span_bytes;
+        bytes_written += span_bytes;
+
+        SF_CMD_COMMS_WriteCommit(p_ctrl, span_bytes);
+    }
+
+    fsp_err_t unlock_err = sf_cmd_comms_tx_unlock(p_comms_ctrl);
+    if(FSP_SUCCESS == fsp_err)
+    {
+        fsp_err = unlock_err;
     }
 
     return fsp_err;
@@ -116,9 +356,40 @@ fsp_err_t SF_CMD_COMMS_Write(sf_comms_ctrl_t * const p_ctrl,
 fsp_err_t SF_CMD_COMMS_Lock(sf_comms_ctrl_t * const p_ctrl, sf_comms_lock_t lock_type, UINT timeout)
 {
     fsp_err_t fsp_err = FSP_SUCCESS;
+    sf_cmd_comms_instance_ctrl_t * p_comms_ctrl = (sf_cmd_comms_instance_ctrl_t *) p_ctrl;
 
-    /* TODO: IMPLEMENT? */
-    //printf("SF_CMD_COMMS_Lock not implemented, lock_type = %d\n", lock_type);
+    if(!p_comms_ctrl->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    switch(lock_type)
+    {
+        case SF_COMMS_LOCK_TX:
+            fsp_err = sf_cmd_comms_mutex_get(&p_comms_ctrl->tx_lock, timeout);
+            break;
+
+        case SF_COMMS_LOCK_RX:
+            fsp_err = sf_cmd_comms_mutex_get(&p_comms_ctrl->rx_lock, timeout);
+            break;
+
+        case SF_COMMS_LOCK_ALL:
+            /* Always RX before TX, the console takes them in this order too */
+            fsp_err = sf_cmd_comms_mutex_get(&p_comms_ctrl->rx_lock, timeout);
+            if(FSP_SUCCESS == fsp_err)
+            {
+                fsp_err = sf_cmd_comms_mutex_get(&p_comms_ctrl->tx_lock, timeout);
+                if(FSP_SUCCESS != fsp_err)
+                {
+                    sf_cmd_comms_mutex_put(&p_comms_ctrl->rx_lock);
+                }
+            }
+            break;
+
+        default:
+            fsp_err = FSP_ERR_INVALID_ARGUMENT;
+            break;
+    }
 
     return fsp_err;
 }
@@ -129,10 +400,789 @@ fsp_err_t SF_CMD_COMMS_Lock(sf_comms_ctrl_t * const p_ctrl, sf_comms_lock_t lock
 fsp_err_t SF_CMD_COMMS_Unlock(sf_comms_ctrl_t * const p_ctrl, sf_comms_lock_t lock_type)
 {
     fsp_err_t fsp_err = FSP_SUCCESS;
+    sf_cmd_comms_instance_ctrl_t * p_comms_ctrl = (sf_cmd_comms_instance_ctrl_t *) p_ctrl;
+
+    if(!p_comms_ctrl->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    switch(lock_type)
+    {
+        case SF_COMMS_LOCK_TX:
+            fsp_err = sf_cmd_comms_tx_unlock(p_comms_ctrl);
+            break;
+
+        case SF_COMMS_LOCK_RX:
+            fsp_err = sf_cmd_comms_mutex_put(&p_comms_ctrl->rx_lock);
+            break;
+
+        case SF_COMMS_LOCK_ALL:
+            fsp_err = sf_cmd_comms_tx_unlock(p_comms_ctrl);
+            if(FSP_SUCCESS == fsp_err)
+            {
+                fsp_err = sf_cmd_comms_mutex_put(&p_comms_ctrl->rx_lock);
+            }
+            break;
+
+        default:
+            fsp_err = FSP_ERR_INVALID_ARGUMENT;
+            break;
+    }
+
+    return fsp_err;
+}
+
+/******************************************************************************
+ * FUNCTION: SF_CMD_COMMS_ReadSpan
+ *****************************************************************************/
+fsp_err_t SF_CMD_COMMS_ReadSpan(sf_comms_ctrl_t * const p_ctrl,
+                           uint8_t const ** const pp_span,
+                           uint32_t * const p_bytes,
+                           UINT const timeout)
+{
+    fsp_err_t fsp_err = FSP_SUCCESS;
+    sf_cmd_comms_instance_ctrl_t * p_comms_ctrl = (sf_cmd_comms_instance_ctrl_t *) p_ctrl;
+
+    if(!p_comms_ctrl->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    if(!p_comms_ctrl->p_cfg->buffered)
+    {
+        return FSP_ERR_UNSUPPORTED;
+    }
+
+    /* Held until the matching release so the span cannot be consumed by another reader */
+    fsp_err = sf_cmd_comms_mutex_get(&p_comms_ctrl->rx_lock, timeout);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        return fsp_err;
+    }
+
+    if(p_comms_ctrl->rx_head == p_comms_ctrl->rx_tail)
+    {
+        if(p_comms_ctrl->rx_thread_enabled)
+        {
+            fsp_err = sf_cmd_comms_rx_wait(p_comms_ctrl, 1U, timeout);
+        }
+        else
+        {
+            /* Without the reception thread the read syscall blocks, so timeout is not supported */
+            fsp_err = sf_cmd_comms_rx_fill(p_comms_ctrl);
+        }
+
+        if(FSP_SUCCESS != fsp_err)
+        {
+            sf_cmd_comms_mutex_put(&p_comms_ctrl->rx_lock);
+            return fsp_err;
+        }
+    }
+
+    /* Only hand out the part up to the end of the buffer, the caller comes back for the wrapped part */
+    uint32_t offset = p_comms_ctrl->rx_tail & SF_CMD_COMMS_RX_MASK;
+    uint32_t available = p_comms_ctrl->rx_head - p_comms_ctrl->rx_tail;
+    if(available > (SF_CMD_COMMS_RX_BUFFER_SIZE - offset))
+    {
+        available = SF_CMD_COMMS_RX_BUFFER_SIZE - offset;
+    }
+
+    *pp_span = &p_comms_ctrl->rx_buffer[offset];
+    *p_bytes = available;
+
+    return fsp_err;
+}
+
+/******************************************************************************
+ * FUNCTION: SF_CMD_COMMS_ReadRelease
+ *****************************************************************************/
+fsp_err_t SF_CMD_COMMS_ReadRelease(sf_comms_ctrl_t * const p_ctrl, uint32_t const bytes)
+{
+    sf_cmd_comms_instance_ctrl_t * p_comms_ctrl = (sf_cmd_comms_instance_ctrl_t *) p_ctrl;
+
+    if(bytes > (p_comms_ctrl->rx_head - p_comms_ctrl->rx_tail))
+    {
+        sf_cmd_comms_mutex_put(&p_comms_ctrl->rx_lock);
+        return FSP_ERR_INVALID_SIZE;
+    }
+
+    p_comms_ctrl->rx_tail += bytes;
+
+    /* Wake the reception thread in case it stopped because the buffer was full. It may have filled the buffer
+     * after the tail was looked at, so space is signalled on every release. The thread checks the buffer again
+     * when woken, so a flag set while it was not waiting only costs it one more check */
+    if((bytes > 0U) && p_comms_ctrl->rx_thread_enabled)
+    {
+        tx_event_flags_set(&p_comms_ctrl->rx_events, SF_CMD_COMMS_EVENT_RX_SPACE, TX_OR);
+    }
+
+    return sf_cmd_comms_mutex_put(&p_comms_ctrl->rx_lock);
+}
+
+/******************************************************************************
+ * FUNCTION: SF_CMD_COMMS_WriteSpan
+ *****************************************************************************/
+fsp_err_t SF_CMD_COMMS_WriteSpan(sf_comms_ctrl_t * const p_ctrl,
+                            uint8_t ** const pp_span,
+                            uint32_t * const p_bytes,
+                            UINT const timeout)
+{
+    fsp_err_t fsp_err = FSP_SUCCESS;
+    sf_cmd_comms_instance_ctrl_t * p_comms_ctrl = (sf_cmd_comms_instance_ctrl_t *) p_ctrl;
+
+    if(!p_comms_ctrl->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    if(!p_comms_ctrl->p_cfg->buffered)
+    {
+        return FSP_ERR_UNSUPPORTED;
+    }
 
-    /* TODO: IMPLEMENT? */
-    //printf("SF_CMD_COMMS_Unlock not implemented, lock_type = %d\n", lock_type);
+    /* Held until the matching commit so nothing else is staged into the middle of the span */
+    fsp_err = sf_cmd_comms_mutex_get(&p_comms_ctrl->tx_lock, timeout);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        return fsp_err;
+    }
+
+    /* Drain the buffer once it is full, this is the only place large outputs cost a syscall */
+    if((p_comms_ctrl->tx_head - p_comms_ctrl->tx_tail) == SF_CMD_COMMS_TX_BUFFER_SIZE)
+    {
+        fsp_err = sf_cmd_comms_tx_flush(p_comms_ctrl);
+        if(FSP_SUCCESS != fsp_err)
+        {
+            sf_cmd_comms_mutex_put(&p_comms_ctrl->tx_lock);
+            return fsp_err;
+        }
+    }
+
+    uint32_t offset = p_comms_ctrl->tx_head & SF_CMD_COMMS_TX_MASK;
+    uint32_t free_bytes = SF_CMD_COMMS_TX_BUFFER_SIZE - (p_comms_ctrl->tx_head - p_comms_ctrl->tx_tail);
+    if(free_bytes > (SF_CMD_COMMS_TX_BUFFER_SIZE - offset))
+    {
+        free_bytes = SF_CMD_COMMS_TX_BUFFER_SIZE - offset;
+    }
+
+    *pp_span = &p_comms_ctrl->tx_buffer[offset];
+    *p_bytes = free_bytes;
 
     return fsp_err;
 }
 
+/******************************************************************************
+ * FUNCTION: SF_CMD_COMMS_WriteCommit
+ *****************************************************************************/
+fsp_err_t SF_CMD_COMMS_WriteCommit(sf_comms_ctrl_t * const p_ctrl, uint32_t const bytes)
+{
+    sf_cmd_comms_instance_ctrl_t * p_comms_ctrl = (sf_cmd_comms_instance_ctrl_t *) p_ctrl;
+
+    if(bytes > (SF_CMD_COMMS_TX_BUFFER_SIZE - (p_comms_ctrl->tx_head - p_comms_ctrl->tx_tail)))
+    {
+        sf_cmd_comms_tx_unlock(p_comms_ctrl);
+        return FSP_ERR_INVALID_SIZE;
+    }
+
+    p_comms_ctrl->tx_head += bytes;
+
+    return sf_cmd_comms_tx_unlock(p_comms_ctrl);
+}
+
+/******************************************************************************
+ * FUNCTION: SF_CMD_COMMS_Flush
+ *****************************************************************************/
+fsp_err_t SF_CMD_COMMS_Flush(sf_comms_ctrl_t * const p_ctrl)
+{
+    sf_cmd_comms_instance_ctrl_t * p_comms_ctrl = (sf_cmd_comms_instance_ctrl_t *) p_ctrl;
+
+    if(!p_comms_ctrl->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    fsp_err_t fsp_err = sf_cmd_comms_mutex_get(&p_comms_ctrl->tx_lock, TX_WAIT_FOREVER);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        return fsp_err;
+    }
+
+    fsp_err = sf_cmd_comms_tx_flush(p_comms_ctrl);
+    sf_cmd_comms_mutex_put(&p_comms_ctrl->tx_lock);
+
+    return fsp_err;
+}
+
+/******************************************************************************
+ * FUNCTION: SF_CMD_COMMS_LockStatsGet
+ *****************************************************************************/
+fsp_err_t SF_CMD_COMMS_LockStatsGet(sf_comms_ctrl_t * const p_ctrl,
+                                    sf_comms_lock_t lock_type,
+                                    sf_cmd_comms_lock_stats_t * const p_stats)
+{
+    sf_cmd_comms_instance_ctrl_t * p_comms_ctrl = (sf_cmd_comms_instance_ctrl_t *) p_ctrl;
+    sf_cmd_comms_mutex_t * p_mutex = NULL;
+
+    if(!p_comms_ctrl->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    if(SF_COMMS_LOCK_TX == lock_type)
+    {
+        p_mutex = &p_comms_ctrl->tx_lock;
+    }
+    else if(SF_COMMS_LOCK_RX == lock_type)
+    {
+        p_mutex = &p_comms_ctrl->rx_lock;
+    }
+    else
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    p_stats->acquires               = p_mutex->acquires;
+    p_stats->acquire_us_total       = p_mutex->acquire_us_total;
+    p_stats->acquire_us_max         = p_mutex->acquire_us_max;
+    p_stats->hold_us_total          = p_mutex->hold_us_total;
+    p_stats->hold_us_max            = p_mutex->hold_us_max;
+
+    /* Contention is counted by the kernel, a get that suspended is one that found the mutex taken */
+    ULONG puts = 0;
+    ULONG gets = 0;
+    ULONG suspensions = 0;
+    ULONG timeouts = 0;
+    ULONG inversions = 0;
+    ULONG inheritances = 0;
+    UINT tx_err = tx_mutex_performance_info_get(&p_mutex->mutex,
+                                                &puts,
+                                                &gets,
+                                                &suspensions,
+                                                &timeouts,
+                                                &inversions,
+                                                &inheritances);
+    if(TX_SUCCESS != tx_err)
+    {
+        suspensions = 0;
+        timeouts = 0;
+        inheritances = 0;
+    }
+
+    p_stats->contentions    = suspensions;
+    p_stats->timeouts       = timeouts;
+    p_stats->inheritances   = inheritances;
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_sys_read
+ *****************************************************************************/
+static fsp_err_t sf_cmd_comms_sys_read(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl,
+                                       uint8_t * p_dest,
+                                       uint32_t bytes,
+                                       uint32_t * p_bytes_read)
+{
+    *p_bytes_read = 0;
+
+    while(1)
+    {
+        /* Returns whatever is available, which for a terminal is a whole line */
+        int result = (int) SF_CMD_COMMS_SYS_READ(p_comms_ctrl->p_cfg->rx_fd, p_dest, bytes);
+        if(result > 0)
+        {
+            *p_bytes_read = (uint32_t) result;
+            sf_cmd_comms_record(p_comms_ctrl, SF_CMD_COMMS_RECORD_RX, p_dest, (uint32_t) result);
+            return FSP_SUCCESS;
+        }
+
+        if((result < 0) || (p_comms_ctrl->p_cfg->hangup_on_eof))
+        {
+            return FSP_ERR_ABORTED;
+        }
+
+        /* End of input, wait for more the same way getchar polling did */
+        tx_thread_sleep(1);
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_sys_write
+ *****************************************************************************/
+static fsp_err_t sf_cmd_comms_sys_write(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl,
+                                        uint8_t const * p_src,
+                                        uint32_t bytes)
+{
+    sf_cmd_comms_record(p_comms_ctrl, SF_CMD_COMMS_RECORD_TX, p_src, bytes);
+
+    while(bytes > 0)
+    {
+        int result = (int) SF_CMD_COMMS_SYS_WRITE(p_comms_ctrl->p_cfg->tx_fd, p_src, bytes);
+        if(result <= 0)
+        {
+            return FSP_ERR_WRITE_FAILED;
+        }
+
+        p_src += result;
+        bytes -= (uint32_t) result;
+    }
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_rx_fill
+ *****************************************************************************/
+static fsp_err_t sf_cmd_comms_rx_fill(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl)
+{
+    fsp_err_t fsp_err = FSP_SUCCESS;
+
+    /* Whoever is waiting for input has to see everything written before it */
+    fsp_err = sf_cmd_comms_tx_flush_unlocked(p_comms_ctrl);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        return fsp_err;
+    }
+
+    /* Only called on an empty buffer, so restart at the beginning to get the largest contiguous span */
+    p_comms_ctrl->rx_head = 0;
+    p_comms_ctrl->rx_tail = 0;
+
+    uint32_t bytes_read = 0;
+    fsp_err = sf_cmd_comms_sys_read(p_comms_ctrl, &p_comms_ctrl->rx_buffer[0], SF_CMD_COMMS_RX_BUFFER_SIZE, &bytes_read);
+    p_comms_ctrl->rx_head += bytes_read;
+
+    return fsp_err;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_stdio_sync
+ *****************************************************************************/
+static void sf_cmd_comms_stdio_sync(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl)
+{
+    /* Keep ordering with anything other modules still have pending in stdio. Only done once per flush, and only
+     * when writing to stdout, so staged writes do not each cost a call into stdio */
+    if(fileno(stdout) == p_comms_ctrl->p_cfg->tx_fd)
+    {
+        fflush(stdout);
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_tx_flush
+ *****************************************************************************/
+static fsp_err_t sf_cmd_comms_tx_flush(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl)
+{
+    fsp_err_t fsp_err = FSP_SUCCESS;
+
+    if(p_comms_ctrl->tx_head != p_comms_ctrl->tx_tail)
+    {
+        sf_cmd_comms_stdio_sync(p_comms_ctrl);
+    }
+
+    /* At most two writes, one up to the end of the buffer and one for the wrapped part */
+    while((FSP_SUCCESS == fsp_err) && (p_comms_ctrl->tx_head != p_comms_ctrl->tx_tail))
+    {
+        uint32_t offset = p_comms_ctrl->tx_tail & SF_CMD_COMMS_TX_MASK;
+        uint32_t pending = p_comms_ctrl->tx_head - p_comms_ctrl->tx_tail;
+        if(pending > (SF_CMD_COMMS_TX_BUFFER_SIZE - offset))
+        {
+            pending = SF_CMD_COMMS_TX_BUFFER_SIZE - offset;
+        }
+
+        fsp_err = sf_cmd_comms_sys_write(p_comms_ctrl, &p_comms_ctrl->tx_buffer[offset], pending);
+        p_comms_ctrl->tx_tail += pending;
+    }
+
+    return fsp_err;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_tx_flush_unlocked
+ *****************************************************************************/
+static fsp_err_t sf_cmd_comms_tx_flush_unlocked(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl)
+{
+    fsp_err_t fsp_err = FSP_SUCCESS;
+
+    /* For callers that do not hold transmission. If another thread has it, that thread flushes when it lets go, so
+     * there is no reason to wait for it here */
+    if(FSP_SUCCESS == sf_cmd_comms_mutex_get(&p_comms_ctrl->tx_lock, TX_NO_WAIT))
+    {
+        fsp_err = sf_cmd_comms_tx_flush(p_comms_ctrl);
+        sf_cmd_comms_mutex_put(&p_comms_ctrl->tx_lock);
+    }
+
+    return fsp_err;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_tx_unlock
+ *****************************************************************************/
+static fsp_err_t sf_cmd_comms_tx_unlock(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl)
+{
+    fsp_err_t fsp_err = FSP_SUCCESS;
+
+    /* The outermost release ends the exchange, so push out what has been staged while the lock still keeps other
+     * writers away. Nested releases leave it for the owner */
+    if(1U == sf_cmd_comms_mutex_depth(&p_comms_ctrl->tx_lock))
+    {
+        fsp_err = sf_cmd_comms_tx_flush(p_comms_ctrl);
+    }
+
+    fsp_err_t put_err = sf_cmd_comms_mutex_put(&p_comms_ctrl->tx_lock);
+    if(FSP_SUCCESS == fsp_err)
+    {
+        fsp_err = put_err;
+    }
+
+    return fsp_err;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_mutex_create
+ *****************************************************************************/
+static fsp_err_t sf_cmd_comms_mutex_create(sf_cmd_comms_mutex_t * p_mutex, CHAR * p_name)
+{
+    memset(p_mutex, 0, sizeof(*p_mutex));
+
+    /* Priority inheritance keeps a low priority writer holding the lock from stalling the console */
+    UINT tx_err = tx_mutex_create(&p_mutex->mutex, p_name, TX_INHERIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        return FSP_ERR_INTERNAL;
+    }
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_mutex_get
+ *****************************************************************************/
+static fsp_err_t sf_cmd_comms_mutex_get(sf_cmd_comms_mutex_t * p_mutex, UINT timeout)
+{
+    uint64_t start_us = sf_cmd_comms_mutex_time_us();
+
+    UINT tx_err = tx_mutex_get(&p_mutex->mutex, timeout);
+    if(TX_NOT_AVAILABLE == tx_err)
+    {
+        return FSP_ERR_TIMEOUT;
+    }
+    else if(TX_WAIT_ABORTED == tx_err)
+    {
+        return FSP_ERR_WAIT_ABORTED;
+    }
+    else if(TX_SUCCESS != tx_err)
+    {
+        return FSP_ERR_INTERNAL;
+    }
+
+    /* Nested gets by the owner are free, only the outermost one is a real acquisition */
+    if(1U == sf_cmd_comms_mutex_depth(p_mutex))
+    {
+        uint64_t now_us = sf_cmd_comms_mutex_time_us();
+        ULONG acquire_us = (ULONG) (now_us - start_us);
+
+        p_mutex->acquires++;
+        p_mutex->acquire_us_total += acquire_us;
+        if(acquire_us > p_mutex->acquire_us_max)
+        {
+            p_mutex->acquire_us_max = acquire_us;
+        }
+        p_mutex->hold_start_us = now_us;
+    }
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_mutex_put
+ *****************************************************************************/
+static fsp_err_t sf_cmd_comms_mutex_put(sf_cmd_comms_mutex_t * p_mutex)
+{
+    ULONG depth = sf_cmd_comms_mutex_depth(p_mutex);
+    if(0U == depth)
+    {
+        return FSP_ERR_INVALID_STATE;
+    }
+
+    if(1U == depth)
+    {
+        ULONG hold_us = (ULONG) (sf_cmd_comms_mutex_time_us() - p_mutex->hold_start_us);
+
+        p_mutex->hold_us_total += hold_us;
+        if(hold_us > p_mutex->hold_us_max)
+        {
+            p_mutex->hold_us_max = hold_us;
+        }
+    }
+
+    UINT tx_err = tx_mutex_put(&p_mutex->mutex);
+    if(TX_SUCCESS != tx_err)
+    {
+        return FSP_ERR_INTERNAL;
+    }
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_mutex_depth
+ *****************************************************************************/
+static ULONG sf_cmd_comms_mutex_depth(sf_cmd_comms_mutex_t * p_mutex)
+{
+    ULONG count = 0;
+    TX_THREAD *p_owner = TX_NULL;
+
+    /* How many times the calling thread holds the mutex, zero if it does not own it */
+    tx_mutex_info_get(&p_mutex->mutex, TX_NULL, &count, &p_owner, TX_NULL, TX_NULL, TX_NULL);
+    if(p_owner != tx_thread_identify())
+    {
+        count = 0;
+    }
+
+    return count;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_mutex_time_us
+ *****************************************************************************/
+static uint64_t sf_cmd_comms_mutex_time_us(void)
+{
+    /* Locks are mostly held for less than a tick, so use the host's monotonic clock */
+#if defined(_WIN32)
+    static LARGE_INTEGER    frequency   = { 0 };
+    LARGE_INTEGER           counter     = { 0 };
+
+    if(0 == frequency.QuadPart)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+
+    return ((uint64_t) (counter.QuadPart / frequency.QuadPart) * 1000000U) +
+           (((uint64_t) (counter.QuadPart % frequency.QuadPart) * 1000000U) / (uint64_t) frequency.QuadPart);
+#else
+    struct timespec now = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t) now.tv_sec * 1000000U) + ((uint64_t) now.tv_nsec / 1000U);
+#endif
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_rx_wait
+ *****************************************************************************/
+static fsp_err_t sf_cmd_comms_rx_wait(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl, uint32_t bytes, UINT timeout)
+{
+    fsp_err_t fsp_err = FSP_SUCCESS;
+    ULONG start_ticks = tx_time_get();
+
+    /* Whoever is waiting for input has to see everything written before it */
+    fsp_err = sf_cmd_comms_tx_flush_unlocked(p_comms_ctrl);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        return fsp_err;
+    }
+
+    while((p_comms_ctrl->rx_head - p_comms_ctrl->rx_tail) < bytes)
+    {
+        if(p_comms_ctrl->rx_error)
+        {
+            return FSP_ERR_ABORTED;
+        }
+
+        /* The flag may be left over from data that was already consumed, so keep the overall deadline */
+        UINT wait = timeout;
+        if((TX_NO_WAIT != timeout) && (TX_WAIT_FOREVER != timeout))
+        {
+            ULONG elapsed = tx_time_get() - start_ticks;
+            wait = (elapsed >= timeout) ? TX_NO_WAIT : (UINT) (timeout - elapsed);
+        }
+
+        ULONG actual_flags = 0;
+        UINT tx_err = tx_event_flags_get(&p_comms_ctrl->rx_events,
+                                         SF_CMD_COMMS_EVENT_RX_DATA,
+                                         TX_OR_CLEAR,
+                                         &actual_flags,
+                                         wait);
+        if(TX_NO_EVENTS == tx_err)
+        {
+            /* One last look, the data may have arrived as the wait expired */
+            if((p_comms_ctrl->rx_head - p_comms_ctrl->rx_tail) >= bytes)
+            {
+                break;
+            }
+            return FSP_ERR_TIMEOUT;
+        }
+        else if(TX_WAIT_ABORTED == tx_err)
+        {
+            return FSP_ERR_WAIT_ABORTED;
+        }
+        else if(TX_SUCCESS != tx_err)
+        {
+            return FSP_ERR_INTERNAL;
+        }
+    }
+
+    return fsp_err;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_rx_thread_entry
+ *****************************************************************************/
+static VOID sf_cmd_comms_rx_thread_entry(ULONG thread_input)
+{
+    sf_cmd_comms_instance_ctrl_t * p_comms_ctrl = (sf_cmd_comms_instance_ctrl_t *) thread_input;
+
+    while(1)
+    {
+        uint32_t used = p_comms_ctrl->rx_head - p_comms_ctrl->rx_tail;
+        if(SF_CMD_COMMS_RX_BUFFER_SIZE == used)
+        {
+            /* Readers are behind, wait for them to release some of the buffer */
+            ULONG actual_flags = 0;
+            tx_event_flags_get(&p_comms_ctrl->rx_events,
+                               SF_CMD_COMMS_EVENT_RX_SPACE,
+                               TX_OR_CLEAR,
+                               &actual_flags,
+                               TX_WAIT_FOREVER);
+            continue;
+        }
+
+        /* Read straight into the free part of the buffer up to its end */
+        uint32_t offset = p_comms_ctrl->rx_head & SF_CMD_COMMS_RX_MASK;
+        uint32_t free_bytes = SF_CMD_COMMS_RX_BUFFER_SIZE - used;
+        if(free_bytes > (SF_CMD_COMMS_RX_BUFFER_SIZE - offset))
+        {
+            free_bytes = SF_CMD_COMMS_RX_BUFFER_SIZE - offset;
+        }
+
+        uint32_t bytes_read = 0;
+        fsp_err_t fsp_err = sf_cmd_comms_sys_read(p_comms_ctrl, &p_comms_ctrl->rx_buffer[offset], free_bytes, &bytes_read);
+        if(FSP_SUCCESS != fsp_err)
+        {
+            /* Readers get the error once they have drained what is left */
+            p_comms_ctrl->rx_error = true;
+            tx_event_flags_set(&p_comms_ctrl->rx_events, SF_CMD_COMMS_EVENT_RX_DATA, TX_OR);
+            break;
+        }
+
+        p_comms_ctrl->rx_head += bytes_read;
+        tx_event_flags_set(&p_comms_ctrl->rx_events, SF_CMD_COMMS_EVENT_RX_DATA, TX_OR);
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_record_start
+ *****************************************************************************/
+static fsp_err_t sf_cmd_comms_record_start(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl)
+{
+    uint8_t header[SF_CMD_COMMS_RECORD_MAGIC_LENGTH + 1U];
+
+    p_comms_ctrl->record_enabled = false;
+    if((!p_comms_ctrl->p_cfg->record) || (NULL == p_comms_ctrl->p_cfg->p_time_us))
+    {
+        return FSP_SUCCESS;
+    }
+
+    memcpy(header, SF_CMD_COMMS_RECORD_MAGIC, SF_CMD_COMMS_RECORD_MAGIC_LENGTH);
+    header[SF_CMD_COMMS_RECORD_MAGIC_LENGTH] = SF_CMD_COMMS_RECORD_VERSION;
+    if(!sf_cmd_comms_record_write(p_comms_ctrl->p_cfg->record_fd, header, sizeof(header)))
+    {
+        return FSP_ERR_WRITE_FAILED;
+    }
+
+    UINT tx_err = tx_mutex_create(&p_comms_ctrl->record_mutex, SF_CMD_COMMS_RECORD_MUTEX_NAME, TX_INHERIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        return FSP_ERR_INTERNAL;
+    }
+
+    p_comms_ctrl->record_time_us = p_comms_ctrl->p_cfg->p_time_us();
+    p_comms_ctrl->record_enabled = true;
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_record
+ *****************************************************************************/
+static void sf_cmd_comms_record(sf_cmd_comms_instance_ctrl_t * p_comms_ctrl,
+                                uint8_t direction,
+                                uint8_t const * p_data,
+                                uint32_t bytes)
+{
+    uint8_t header[SF_CMD_COMMS_RECORD_HEADER_MAX];
+    uint32_t header_length = 0;
+
+    if((!p_comms_ctrl->record_enabled) || (0U == bytes))
+    {
+        return;
+    }
+
+    /* The reception thread and writers take turns, so times only go forward */
+    if(TX_SUCCESS != tx_mutex_get(&p_comms_ctrl->record_mutex, TX_WAIT_FOREVER))
+    {
+        return;
+    }
+
+    if(p_comms_ctrl->record_enabled)
+    {
+        uint64_t now_us = p_comms_ctrl->p_cfg->p_time_us();
+
+        header[header_length++] = direction;
+        header_length += sf_cmd_comms_varint_put(&header[header_length], now_us - p_comms_ctrl->record_time_us);
+        header_length += sf_cmd_comms_varint_put(&header[header_length], bytes);
+        p_comms_ctrl->record_time_us = now_us;
+
+        if((!sf_cmd_comms_record_write(p_comms_ctrl->p_cfg->record_fd, header, header_length)) ||
+           (!sf_cmd_comms_record_write(p_comms_ctrl->p_cfg->record_fd, p_data, bytes)))
+        {
+            printf("Failed sf_cmd_comms_record::write, recording stopped\r\n");
+            p_comms_ctrl->record_enabled = false;
+        }
+    }
+
+    tx_mutex_put(&p_comms_ctrl->record_mutex);
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_record_write
+ *****************************************************************************/
+static bool sf_cmd_comms_record_write(int fd, uint8_t const * p_data, uint32_t bytes)
+{
+    while(bytes > 0)
+    {
+        int result = (int) SF_CMD_COMMS_SYS_WRITE(fd, p_data, bytes);
+        if(result <= 0)
+        {
+            return false;
+        }
+
+        p_data += result;
+        bytes -= (uint32_t) result;
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_cmd_comms_varint_put
+ *****************************************************************************/
+static uint32_t sf_cmd_comms_varint_put(uint8_t * p_dest, uint64_t value)
+{
+    uint32_t length = 0;
+
+    /* 7 bits at a time, the top bit tells another byte follows */
+    do
+    {
+        uint8_t group = (uint8_t) (value & 0x7FU);
+        value >>= 7;
+        p_dest[length++] = (0U != value) ? (uint8_t) (group | 0x80U) : group;
+    }
+    while(0U != value);
+
+    return length;
+}
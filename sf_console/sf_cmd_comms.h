@@ -4,8 +4,130 @@
 /******************************************************************************
  * INCLUDES
  *****************************************************************************/
+#include <stdbool.h>
 #include "sf_comms_api.h"
 
+/******************************************************************************
+ * CONSTANTS
+ *****************************************************************************/
+/* Ring buffer sizes, both must be a power of two */
+#define SF_CMD_COMMS_RX_BUFFER_SIZE     (256U)
+#define SF_CMD_COMMS_TX_BUFFER_SIZE     (1024U)
+
+#define SF_CMD_COMMS_RX_THREAD_NAME     ("CMD Comms RX Thread")
+#define SF_CMD_COMMS_RX_MUTEX_NAME      ("CMD Comms RX Mutex")
+#define SF_CMD_COMMS_TX_MUTEX_NAME      ("CMD Comms TX Mutex")
+#define SF_CMD_COMMS_EVENT_RX_DATA      (0x00000001UL)
+#define SF_CMD_COMMS_EVENT_RX_SPACE     (0x00000002UL)
+#define SF_CMD_COMMS_RECORD_MUTEX_NAME  ("CMD Comms Record Mutex")
+
+/* A session recording is the magic and version, then a record per transfer
+ * that reached the file descriptors:
+ *
+ *   direction (1) | time (varint) | length (varint) | data (length bytes)
+ *
+ * The time is the microseconds since the previous record, or since the
+ * transport opened for the first one. Varints are LEB128, 7 bits per byte
+ * with the least significant group first */
+#define SF_CMD_COMMS_RECORD_MAGIC       ("SFCR")
+#define SF_CMD_COMMS_RECORD_MAGIC_LENGTH (4U)
+#define SF_CMD_COMMS_RECORD_VERSION     (1U)
+#define SF_CMD_COMMS_RECORD_RX          (0x01U)
+#define SF_CMD_COMMS_RECORD_TX          (0x02U)
+#define SF_CMD_COMMS_RECORD_HEADER_MAX  (1U + 10U + 5U)
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+typedef struct st_sf_cmd_comms_cfg
+{
+    /* File descriptors the transport reads from and writes to */
+    int                         rx_fd;
+    int                         tx_fd;
+
+    /* When true, transfers are staged through the ring buffers in the control
+     * block and only reach the file descriptors in blocks */
+    bool                        buffered;
+
+    /* When true, end of input means the other side hung up and reads fail
+     * with FSP_ERR_ABORTED, as for a socket. Otherwise it is polled for more
+     * input, as for a terminal */
+    bool                        hangup_on_eof;
+
+    /* Reception thread that feeds the RX ring buffer. Only used in buffered
+     * mode, and reads can only time out when a stack is provided. A blocked
+     * read does not yield on hosted ports, so RX threads of several
+     * transports sharing a priority need a time slice */
+    VOID                        *p_rx_thread_stack;
+    ULONG                       rx_thread_stack_size;
+    UINT                        rx_thread_priority;
+    ULONG                       rx_thread_time_slice;
+
+    /* When true, every transfer is appended to record_fd with the time it
+     * happened on the p_time_us clock, see SF_CMD_COMMS_RECORD_MAGIC */
+    bool                        record;
+    int                         record_fd;
+    uint64_t                    (*p_time_us)(void);
+} sf_cmd_comms_cfg_t;
+
+/* Lock statistics, times are in microseconds and only count the outermost
+ * acquisition of a nested lock */
+typedef struct st_sf_cmd_comms_lock_stats
+{
+    ULONG                       acquires;
+    ULONG                       contentions;    /* Acquisitions that had to suspend */
+    ULONG                       timeouts;
+    ULONG                       inheritances;   /* Times the owner inherited a waiter's priority */
+    uint64_t                    acquire_us_total;
+    ULONG                       acquire_us_max;
+    uint64_t                    hold_us_total;
+    ULONG                       hold_us_max;
+} sf_cmd_comms_lock_stats_t;
+
+typedef struct st_sf_cmd_comms_mutex
+{
+    TX_MUTEX                    mutex;
+    ULONG                       acquires;
+    uint64_t                    acquire_us_total;
+    ULONG                       acquire_us_max;
+    uint64_t                    hold_us_total;
+    ULONG                       hold_us_max;
+    uint64_t                    hold_start_us;
+} sf_cmd_comms_mutex_t;
+
+typedef struct st_sf_cmd_comms_instance_ctrl
+{
+    sf_cmd_comms_cfg_t const    *p_cfg;
+    bool                        open;
+
+    /* Free running indexes, masked with the buffer size on access. The RX
+     * thread only moves rx_head and readers only move rx_tail */
+    uint32_t volatile           rx_head;
+    uint32_t volatile           rx_tail;
+    uint32_t                    tx_head;
+    uint32_t                    tx_tail;
+
+    /* Reservation of each direction, taken around every transfer and by
+     * callers that need several transfers to stay together */
+    sf_cmd_comms_mutex_t        rx_lock;
+    sf_cmd_comms_mutex_t        tx_lock;
+
+    /* Reception thread */
+    bool                        rx_thread_enabled;
+    bool volatile               rx_error;
+    TX_THREAD                   rx_thread;
+    TX_EVENT_FLAGS_GROUP        rx_events;
+
+    /* Recording, shared by the reception thread and writers. A failed write
+     * ends it rather than the session */
+    bool                        record_enabled;
+    TX_MUTEX                    record_mutex;
+    uint64_t                    record_time_us;
+
+    uint8_t                     rx_buffer[SF_CMD_COMMS_RX_BUFFER_SIZE];
+    uint8_t                     tx_buffer[SF_CMD_COMMS_TX_BUFFER_SIZE];
+} sf_cmd_comms_instance_ctrl_t;
+
 /******************************************************************************
  * PROTOTYPES
  *****************************************************************************/
@@ -21,6 +143,20 @@ fsp_err_t SF_CMD_COMMS_Write(sf_comms_ctrl_t * const p_ctrl,
                         UINT const timeout);
 fsp_err_t SF_CMD_COMMS_Lock(sf_comms_ctrl_t * const p_ctrl, sf_comms_lock_t lock_type, UINT timeout);
 fsp_err_t SF_CMD_COMMS_Unlock(sf_comms_ctrl_t * const p_ctrl, sf_comms_lock_t lock_type);
+fsp_err_t SF_CMD_COMMS_ReadSpan(sf_comms_ctrl_t * const p_ctrl,
+                           uint8_t const ** const pp_span,
+                           uint32_t * const p_bytes,
+                           UINT const timeout);
+fsp_err_t SF_CMD_COMMS_ReadRelease(sf_comms_ctrl_t * const p_ctrl, uint32_t const bytes);
+fsp_err_t SF_CMD_COMMS_WriteSpan(sf_comms_ctrl_t * const p_ctrl,
+                            uint8_t ** const pp_span,
+                            uint32_t * const p_bytes,
+                            UINT const timeout);
+fsp_err_t SF_CMD_COMMS_WriteCommit(sf_comms_ctrl_t * const p_ctrl, uint32_t const bytes);
+fsp_err_t SF_CMD_COMMS_Flush(sf_comms_ctrl_t * const p_ctrl);
+fsp_err_t SF_CMD_COMMS_LockStatsGet(sf_comms_ctrl_t * const p_ctrl,
+                                    sf_comms_lock_t lock_type,
+                                    sf_cmd_comms_lock_stats_t * const p_stats);
 
 #if 0
 /******************************************************************************
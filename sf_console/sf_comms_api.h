@@ -448,7 +448,50 @@ typedef struct st_sf_comms_api
      * @param[in]  lock_type   Locking type, transmission channel or reception channel
      */
     fsp_err_t (* unlock)(sf_comms_ctrl_t * const p_ctrl,
-                         sf_comms_lock_t         lock_type);    
+                         sf_comms_lock_t         lock_type);
+
+    /** Get a contiguous span of received data without copying it out of the driver. Waits until at least one byte
+     * is available or a timeout occurs. Reception stays reserved for the caller until readRelease is called, which
+     * must follow every successful call. Optional, set to NULL if the driver does not buffer reception.
+     * @param[in]   p_ctrl     Pointer to device control block initialized in Open call for communications driver.
+     * @param[out]  pp_span    Set to the first unread byte
+     * @param[out]  p_bytes    Set to the number of contiguous bytes available at *pp_span
+     * @param[in]   timeout    ThreadX timeout. Options include TX_NO_WAIT (0x00000000), TX_WAIT_FOREVER (0xFFFFFFFF),
+     *                         and timeout value (0x00000001 through 0xFFFFFFFE) in ThreadX tick counts.
+     */
+    fsp_err_t (* readSpan)(sf_comms_ctrl_t        * const p_ctrl,
+                           uint8_t         const ** const pp_span,
+                           uint32_t               * const p_bytes,
+                           UINT                     const timeout);
+
+    /** Release bytes consumed from the span returned by readSpan. Optional, NULL when readSpan is NULL.
+     * @param[in]   p_ctrl     Pointer to device control block initialized in Open call for communications driver.
+     * @param[in]   bytes      Number of bytes consumed, must not exceed the span length
+     */
+    fsp_err_t (* readRelease)(sf_comms_ctrl_t * const p_ctrl,
+                              uint32_t          const bytes);
+
+    /** Get a contiguous span of free transmit buffer to format data into directly. Optional, set to NULL if the
+     * driver does not buffer transmission. Transmission stays reserved for the caller until writeCommit is called,
+     * which must follow every successful call.
+     * @param[in]   p_ctrl     Pointer to device control block initialized in Open call for communications driver.
+     * @param[out]  pp_span    Set to the first free byte
+     * @param[out]  p_bytes    Set to the number of contiguous bytes free at *pp_span
+     * @param[in]   timeout    ThreadX timeout. Options include TX_NO_WAIT (0x00000000), TX_WAIT_FOREVER (0xFFFFFFFF),
+     *                         and timeout value (0x00000001 through 0xFFFFFFFE) in ThreadX tick counts.
+     */
+    fsp_err_t (* writeSpan)(sf_comms_ctrl_t  * const p_ctrl,
+                            uint8_t         ** const pp_span,
+                            uint32_t         * const p_bytes,
+                            UINT               const timeout);
+
+    /** Queue bytes written into the span returned by writeSpan for transmission. Optional, NULL when writeSpan is
+     * NULL.
+     * @param[in]   p_ctrl     Pointer to device control block initialized in Open call for communications driver.
+     * @param[in]   bytes      Number of bytes written, must not exceed the span length
+     */
+    fsp_err_t (* writeCommit)(sf_comms_ctrl_t * const p_ctrl,
+                              uint32_t          const bytes);
 } sf_comms_api_t;
 
 /** This structure encompasses everything that is needed to use an instance of this interface. */
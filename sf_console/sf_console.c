@@ -25,6 +25,14 @@
 Includes
 ***********************************************************************************************************************/
 #include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include "sf_console.h"
 #include "sf_console_cfg.h"
 #include "sf_console_private_api.h"
@@ -55,8 +63,10 @@ Includes
 #define LF_CODE                 ((uint8_t) '\n')
 #define NULL_CODE               ((uint8_t) '\0')
 #define SPACE_CODE              ((uint8_t) ' ')
+#define QUOTE_CODE              ((uint8_t) '"')
 #define HELP_CODE               ((uint8_t) '?')
 #define BACKSPACE_CODE          ((uint8_t) 0x8)
+#define TAB_CODE                ((uint8_t) '\t')
 #define DELETE_CODE             ((uint8_t) 0x7f)
 
 /** Begins escape code sequence, which is used for arrow key input.  Example: Up arrow key input = "\e[A" */
@@ -71,6 +81,19 @@ Includes
 #define DOWN_ARROW_CODE         ((uint8_t) 'B')    /* Valid after ESC codes */
 #define RIGHT_ARROW_CODE        ((uint8_t) 'C')    /* Valid after ESC codes */
 #define LEFT_ARROW_CODE         ((uint8_t) 'D')    /* Valid after ESC codes */
+#define CLEAR_DOWN_CODE         ((uint8_t) 'J')    /* Valid after ESC codes, clears from the cursor to the end of the screen */
+
+/** Longest conversion specification passed to snprintf: '%', five flags, width, precision, length and conversion. */
+#define SF_CONSOLE_PRV_FORMAT_SPEC_LENGTH   (32U)
+
+/** Objects of the watch command.  Keys are polled this often between runs, so one stops the command promptly. */
+#define SF_CONSOLE_PRV_WATCH_TIMER_NAME     ("Console Watch Timer")
+#define SF_CONSOLE_PRV_WATCH_EVENTS_NAME    ("Console Watch Events")
+#define SF_CONSOLE_PRV_WATCH_EVENT          (0x00000001UL)
+#define SF_CONSOLE_PRV_WATCH_POLL           ((TX_TIMER_TICKS_PER_SECOND / 50U) + 1U)
+
+/** Lines the head filter passes when it is not given a number. */
+#define SF_CONSOLE_PRV_PIPE_HEAD_LINES      (10U)
 
 
 /***********************************************************************************************************************
@@ -79,13 +102,76 @@ Typedef definitions
 typedef enum e_sf_console_cursor_dir
 {
     SF_CONSOLE_CURSOR_DIR_LEFT,
-    SF_CONSOLE_CURSOR_DIR_RIGHT
+    SF_CONSOLE_CURSOR_DIR_RIGHT,
+    SF_CONSOLE_CURSOR_DIR_UP
 } sf_console_cursor_dir_t;
 
+/** Type an argument of a numeric conversion is widened to before it is formatted. */
+typedef enum e_sf_console_format_type
+{
+    SF_CONSOLE_FORMAT_TYPE_SIGNED,
+    SF_CONSOLE_FORMAT_TYPE_UNSIGNED,
+    SF_CONSOLE_FORMAT_TYPE_DOUBLE,
+    SF_CONSOLE_FORMAT_TYPE_LONG_DOUBLE,
+    SF_CONSOLE_FORMAT_TYPE_POINTER
+} sf_console_format_type_t;
+
+/** Argument of a numeric conversion, kept so the conversion can be repeated after the scratch buffer is written. */
+typedef struct st_sf_console_format_value
+{
+    sf_console_format_type_t type;
+    union
+    {
+        intmax_t        s;
+        uintmax_t       u;
+        double          d;
+        long double     ld;
+        void const    * p;
+    } value;
+} sf_console_format_value_t;
+
 /***********************************************************************************************************************
 Private function prototypes
 ***********************************************************************************************************************/
 static int32_t check_for_match(uint8_t const * const p_test, uint8_t const * const p_ref);
+static bool sf_console_find_command(sf_console_instance_ctrl_t const * const p_ctrl,
+                                    sf_console_menu_t          const * const p_menu,
+                                    uint8_t                    const * const p_input,
+                                    uint32_t                         * const p_command,
+                                    int32_t                          * const p_length);
+static void sf_console_index_build(sf_console_instance_ctrl_t * const p_ctrl,
+                                   sf_console_menu_t    const * const p_menu);
+static bool sf_console_index_insert(sf_console_instance_ctrl_t * const p_ctrl,
+                                    uint32_t                           root,
+                                    uint8_t              const * const p_command,
+                                    uint32_t                           command);
+static sf_console_menu_index_t const * sf_console_index_find(sf_console_instance_ctrl_t const * const p_ctrl,
+                                                             sf_console_menu_t          const * const p_menu);
+static sf_console_menu_t const * sf_console_resolve_menu(sf_console_instance_ctrl_t const * const p_ctrl,
+                                                         sf_console_menu_t          const *       p_menu,
+                                                         uint8_t                    const * const p_input,
+                                                         uint32_t                         * const p_start);
+static void sf_console_complete(sf_console_instance_ctrl_t const * const p_ctrl,
+                                sf_console_menu_t          const * const p_menu,
+                                uint8_t                    const * const p_prefix,
+                                uint32_t                           const length,
+                                sf_console_completion_t          * const p_result);
+static bool check_for_prefix(uint8_t const * const p_test, uint8_t const * const p_ref, uint32_t const length);
+static bool sf_console_argument_convert(sf_console_arg_spec_t const * const p_spec, sf_console_arg_t * const p_arg);
+static void sf_console_arguments_error(sf_console_instance_ctrl_t       * const p_ctrl,
+                                       sf_console_command_t       const * const p_command,
+                                       sf_console_arg_t           const * const p_argv,
+                                       uint32_t                           const arg,
+                                       uint32_t                           const err);
+static uint32_t sf_console_list_matches(sf_console_instance_ctrl_t       * const p_ctrl,
+                                        sf_console_menu_t          const * const p_menu,
+                                        uint8_t                    const * const p_prefix,
+                                        uint32_t                           const length,
+                                        uint32_t                           const limit,
+                                        char                       const * const p_separator);
+static uint32_t sf_console_suggest(sf_console_instance_ctrl_t       * const p_ctrl,
+                                   sf_console_menu_t          const * const p_menu,
+                                   uint8_t                    const * const p_input);
 static uint32_t check_for_overflow(sf_console_instance_ctrl_t * const p_ctrl, uint32_t * p_index, uint32_t const bytes);
 static uint32_t insert_char(sf_console_instance_ctrl_t * const p_ctrl,
                              uint8_t                    * const p_input,
@@ -94,18 +180,132 @@ static uint32_t insert_char(sf_console_instance_ctrl_t * const p_ctrl,
                              uint32_t                           last_index);
 static uint32_t delete_char(sf_console_instance_ctrl_t * p_ctrl, uint8_t * p_input, uint32_t index, uint32_t * p_last_index);
 static void move_cursor(sf_console_instance_ctrl_t * p_ctrl, sf_console_cursor_dir_t dir, uint32_t num_spaces);
+static void frame_append(sf_console_instance_ctrl_t * p_ctrl, uint8_t const * p_src, uint32_t bytes);
+static uint32_t frame_send(sf_console_instance_ctrl_t * p_ctrl);
+static uint32_t sf_console_format(sf_console_instance_ctrl_t * const p_ctrl,
+                                  char                 const *       p_format,
+                                  va_list                    * const p_args);
+static uint32_t format_conversion(sf_console_instance_ctrl_t * const p_ctrl,
+                                  char                 const **      pp_format,
+                                  va_list                    * const p_args);
+static uint32_t format_value(sf_console_instance_ctrl_t      * const p_ctrl,
+                             char                      const * const p_spec,
+                             sf_console_format_value_t const * const p_value);
+static uint32_t format_put(sf_console_instance_ctrl_t * const p_ctrl, char const * const p_src, uint32_t const bytes);
+static uint32_t format_pad(sf_console_instance_ctrl_t * const p_ctrl, uint32_t count);
+static uint32_t format_flush(sf_console_instance_ctrl_t * const p_ctrl);
 static uint32_t print_help_menu(sf_console_instance_ctrl_t * const p_ctrl,
                                  sf_console_menu_t    const * const p_menu,
                                  UINT                               timeout);
+static uint32_t help_render(sf_console_instance_ctrl_t * const p_ctrl,
+                            sf_console_menu_t    const * const p_menu,
+                            bool                               back_options,
+                            bool                               keep);
+static void help_put(sf_console_instance_ctrl_t * const p_ctrl,
+                     uint8_t              const * const p_src,
+                     bool                               keep,
+                     uint32_t                   * const p_err);
 static void sf_console_continue_parsing(sf_console_instance_ctrl_t * const p_ctrl,
                                         uint8_t              const * const p_input,
                                         uint32_t                     const bytes);
 static void sf_console_call_callback(sf_console_instance_ctrl_t * const p_ctrl,
-                                     void                      (*p_callback)(sf_console_callback_args_t * p_args),
-                                     void                 const *       p_context,
+                                     sf_console_command_t const * const p_command,
+                                     sf_console_command_stats_t * const p_stats,
                                      uint8_t              const * const p_input,
                                      uint32_t                     const bytes,
                                      int32_t                            length);
+static void sf_console_job_submit(sf_console_instance_ctrl_t * const p_ctrl,
+                                  sf_console_command_t const * const p_command,
+                                  sf_console_command_stats_t * const p_stats,
+                                  uint8_t              const * const p_remaining,
+                                  uint32_t                     const argc,
+                                  sf_console_arg_t     const * const p_argv);
+static uint32_t sf_console_jobs_list(sf_console_instance_ctrl_t * const p_ctrl);
+static void history_add(sf_console_history_t * const p_history, uint8_t const * const p_line, uint32_t const length);
+static uint32_t history_locate(sf_console_history_t const * const p_history, uint32_t back);
+static uint32_t history_copy(sf_console_history_t const * const p_history, uint32_t offset, uint8_t * const p_dest);
+static uint32_t history_wrap(sf_console_history_t const * const p_history, uint32_t offset);
+static uint32_t sf_console_history_expand(sf_console_instance_ctrl_t * const p_ctrl);
+static uint32_t sf_console_history_list(sf_console_instance_ctrl_t * const p_ctrl);
+static uint32_t sf_console_read_history_recall(sf_console_instance_ctrl_t * const p_ctrl,
+                                               uint8_t                    * const p_dest,
+                                               uint32_t                   *       p_index,
+                                               uint32_t                   *       p_length,
+                                               bool                               older);
+static uint32_t sf_console_jobs_wait(sf_console_instance_ctrl_t * const p_ctrl, uint8_t const * const p_arg);
+static sf_console_command_t const * sf_console_command_lookup(sf_console_instance_ctrl_t const * const p_ctrl,
+                                                              sf_console_menu_t          const **      pp_menu,
+                                                              uint8_t                    const **      pp_line);
+static uint32_t sf_console_watch_command(sf_console_instance_ctrl_t       * const p_ctrl,
+                                         sf_console_menu_t          const * const p_menu,
+                                         uint8_t                    const * const p_arg);
+static VOID sf_console_watch_expire(ULONG input);
+static uint32_t sf_console_source_command(sf_console_instance_ctrl_t       * const p_ctrl,
+                                          sf_console_menu_t          const * const p_menu,
+                                          uint8_t                    const * const p_arg);
+static uint32_t sf_console_output_write(sf_console_instance_ctrl_t * const p_ctrl,
+                                        uint8_t              const * const p_src,
+                                        uint32_t                     const bytes,
+                                        uint32_t                     const timeout);
+static uint8_t const * sf_console_pipe_find(uint8_t const * const p_input, uint32_t const bytes);
+static uint32_t sf_console_pipe_run(sf_console_instance_ctrl_t       * const p_ctrl,
+                                    sf_console_menu_t          const * const p_menu,
+                                    uint8_t                    const * const p_input,
+                                    uint32_t                           const bytes);
+static bool sf_console_pipe_stage_parse(sf_console_pipe_stage_t * const p_stage, uint8_t const * const p_text);
+static uint32_t sf_console_pipe_write(sf_console_instance_ctrl_t * const p_ctrl,
+                                      uint8_t              const *       p_src,
+                                      uint32_t                           bytes,
+                                      uint32_t                     const timeout);
+static uint32_t sf_console_pipe_line(sf_console_instance_ctrl_t * const p_ctrl,
+                                     uint32_t                     const stage,
+                                     uint8_t              const * const p_line,
+                                     uint32_t                     const length,
+                                     bool                         const end,
+                                     uint32_t                     const timeout);
+static uint32_t sf_console_pipe_finish(sf_console_instance_ctrl_t * const p_ctrl);
+static uint32_t sf_console_batch_run(sf_console_instance_ctrl_t       * const p_ctrl,
+                                     sf_console_menu_t          const *       p_menu,
+                                     uint8_t                          * const p_script,
+                                     uint32_t                           const bytes,
+                                     uint8_t                          * const p_memory,
+                                     uint32_t                           const memory_size,
+                                     sf_console_batch_result_t        * const p_result);
+static void sf_console_batch_error(sf_console_instance_ctrl_t       * const p_ctrl,
+                                   sf_console_batch_entry_t   const * const p_entry);
+static void sf_console_batch_report(sf_console_instance_ctrl_t       * const p_ctrl,
+                                    sf_console_batch_entry_t   const * const p_entries,
+                                    sf_console_batch_result_t  const * const p_result);
+static sf_console_command_stats_t * sf_console_command_stats(sf_console_menu_t    const * const p_menu,
+                                                             sf_console_command_t const * const p_command);
+static void sf_console_stats_record(sf_console_command_stats_t * const p_stats, uint32_t const us, uint32_t const ticks);
+static uint32_t sf_console_stats_bucket(uint32_t const us);
+static uint32_t sf_console_stats_bucket_limit(uint32_t const bucket);
+static uint32_t sf_console_stats_percentile(sf_console_command_stats_t const * const p_stats, uint32_t const percent);
+static uint32_t sf_console_perf_command(sf_console_instance_ctrl_t       * const p_ctrl,
+                                        sf_console_menu_t          const * const p_menu,
+                                        uint8_t                    const * const p_arg);
+static uint32_t sf_console_perf_menu(sf_console_instance_ctrl_t       * const p_ctrl,
+                                     sf_console_menu_t          const * const p_menu,
+                                     uint8_t                    const * const p_path,
+                                     sf_console_menu_t          const **      pp_visited,
+                                     uint32_t                         * const p_visited,
+                                     uint32_t                         * const p_rows,
+                                     bool                               const reset);
+static sf_console_menu_t const * sf_console_menu_root(sf_console_menu_t const * p_menu);
+static uint32_t sf_console_output_command(sf_console_instance_ctrl_t * const p_ctrl, uint8_t const * const p_arg);
+static uint32_t sf_console_table_heading(sf_console_instance_ctrl_t * const p_ctrl);
+static uint32_t sf_console_table_row(sf_console_instance_ctrl_t       * const p_ctrl,
+                                     sf_console_value_t         const * const p_values);
+static uint32_t sf_console_table_width(sf_console_column_t const * const p_column);
+static uint32_t sf_console_table_number(sf_console_output_t        const         output,
+                                        sf_console_column_t        const * const p_column,
+                                        sf_console_value_t         const * const p_value,
+                                        char                             * const p_dest,
+                                        uint32_t                           const size);
+static uint32_t sf_console_table_quote(sf_console_instance_ctrl_t       * const p_ctrl,
+                                       uint8_t                    const * const p_text,
+                                       uint32_t                           const length);
 static uint32_t sf_console_read_process_up_arrow(sf_console_instance_ctrl_t * const p_ctrl,
                                              uint8_t                    * const p_dest,
                                              uint32_t                   *       p_index,
@@ -114,6 +314,10 @@ static uint32_t sf_console_read_process_escape(sf_console_instance_ctrl_t * cons
                                                 uint8_t                    * const p_dest,
                                                 uint32_t                   *       p_index,
                                                 uint32_t                   *       p_length);
+static uint32_t sf_console_read_process_tab(sf_console_instance_ctrl_t * const p_ctrl,
+                                            uint8_t                    * const p_dest,
+                                            uint32_t                   *       p_index,
+                                            uint32_t                   *       p_length);
 static uint32_t sf_console_read_process_backspace(sf_console_instance_ctrl_t * const p_ctrl,
                                                    uint8_t                    * const p_dest,
                                                    uint32_t                   *       p_index,
@@ -126,6 +330,11 @@ static uint32_t sf_console_read_main(sf_console_instance_ctrl_t * const p_ctrl,
                                       uint8_t                    * const p_dest,
                                       uint32_t                     const bytes,
                                       uint32_t                     const timeout);
+static uint32_t sf_console_read_raw(sf_console_instance_ctrl_t * const p_ctrl,
+                                     uint8_t                    * const p_dest,
+                                     uint32_t                     const bytes,
+                                     uint32_t                     const timeout);
+static uint32_t sf_console_find_control(uint8_t const * const p_src, uint32_t const bytes);
 
 #if SF_CONSOLE_CFG_PARAM_CHECKING_ENABLE
 static uint32_t sf_console_parse_param_check(sf_console_instance_ctrl_t * const p_ctrl,
@@ -167,13 +376,24 @@ static const uint8_t g_white_space[] =
 /*LDRA_INSPECTED 27 D This structure must be accessible in user code. It cannot be static. */
 const sf_console_api_t g_sf_console_on_sf_console = 
 {
-    .open         = SF_CONSOLE_Open,
-    .close        = SF_CONSOLE_Close,
-    .prompt       = SF_CONSOLE_Prompt,
-    .parse        = SF_CONSOLE_Parse,
-    .read         = SF_CONSOLE_Read,
-    .write        = SF_CONSOLE_Write,
-    .argumentFind = SF_CONSOLE_ArgumentFind,
+    .open           = SF_CONSOLE_Open,
+    .close          = SF_CONSOLE_Close,
+    .prompt         = SF_CONSOLE_Prompt,
+    .parse          = SF_CONSOLE_Parse,
+    .read           = SF_CONSOLE_Read,
+    .write          = SF_CONSOLE_Write,
+    .writeN         = SF_CONSOLE_WriteN,
+    .writeFormat    = SF_CONSOLE_WriteFormat,
+    .argumentFind   = SF_CONSOLE_ArgumentFind,
+    .argumentsParse = SF_CONSOLE_ArgumentsParse,
+    .batch          = SF_CONSOLE_Batch,
+    .source         = SF_CONSOLE_Source,
+    .historyGet     = SF_CONSOLE_HistoryGet,
+    .historyAdd     = SF_CONSOLE_HistoryAdd,
+    .reply          = SF_CONSOLE_Reply,
+    .tableStart     = SF_CONSOLE_TableStart,
+    .tableRow       = SF_CONSOLE_TableRow,
+    .tableEnd       = SF_CONSOLE_TableEnd,
 };
 /*LDRA_ANALYSIS */
 
@@ -222,6 +442,51 @@ uint32_t SF_CONSOLE_Open (sf_console_ctrl_t * const p_api_ctrl, sf_console_cfg_t
     p_ctrl->echo = p_cfg->echo;
     p_ctrl->p_current_menu = p_cfg->p_initial_menu;
     p_ctrl->p_comms = p_cfg->p_comms;
+    p_ctrl->prompted = false;
+    p_ctrl->frame_length = 0U;
+    p_ctrl->format_length = 0U;
+    p_ctrl->p_jobs = p_cfg->p_jobs;
+    p_ctrl->batch.p_buffer = (uint8_t *) p_cfg->p_batch_memory;
+    p_ctrl->batch.size = (NULL != p_cfg->p_batch_memory) ? p_cfg->batch_memory_size : 0U;
+    p_ctrl->p_time_us = p_cfg->p_time_us;
+    p_ctrl->rpc.enabled = p_cfg->rpc;
+    p_ctrl->rpc.active = false;
+    p_ctrl->output = p_cfg->output;
+    p_ctrl->table.open = false;
+    p_ctrl->watch.active = false;
+    p_ctrl->pipe.active = false;
+
+    /** Help is rendered on the first request for it. */
+    p_ctrl->help.p_buffer = (uint8_t *) p_cfg->p_help_memory;
+    p_ctrl->help.size = (NULL != p_cfg->p_help_memory) ? p_cfg->help_memory_size : 0U;
+    p_ctrl->help.length = 0U;
+    p_ctrl->help.p_menu = NULL;
+
+    /** History starts out empty and the first line entered is number 1. */
+    p_ctrl->history.p_buffer = (uint8_t *) p_cfg->p_history_memory;
+    p_ctrl->history.size = (NULL != p_cfg->p_history_memory) ? p_cfg->history_memory_size : 0U;
+    p_ctrl->history.head = 0U;
+    p_ctrl->history.tail = 0U;
+    p_ctrl->history.used = 0U;
+    p_ctrl->history.count = 0U;
+    p_ctrl->history.first = 1U;
+    p_ctrl->history.browse = 0U;
+
+    /** Build the command indexes for the initial menu and every menu reachable from it.  Node numbers are 16 bits, so
+     *  memory beyond that many nodes is not used. */
+    p_ctrl->p_index_nodes = (sf_console_index_node_t *) p_cfg->p_index_memory;
+    p_ctrl->index_nodes_max = 0U;
+    if (NULL != p_cfg->p_index_memory)
+    {
+        p_ctrl->index_nodes_max = p_cfg->index_memory_size / sizeof(sf_console_index_node_t);
+        if (p_ctrl->index_nodes_max > UINT16_MAX)
+        {
+            p_ctrl->index_nodes_max = UINT16_MAX;
+        }
+    }
+    p_ctrl->index_nodes_used = 0U;
+    p_ctrl->menu_index_count = 0U;
+    sf_console_index_build(p_ctrl, p_cfg->p_initial_menu);
 
     /** Prompt for input autostart is true */
     if (p_cfg->autostart)
@@ -281,6 +546,12 @@ uint32_t SF_CONSOLE_Parse(sf_console_ctrl_t       * const p_api_ctrl,
     }
 #endif
 
+    /** Run the command before a pipe with its output going through the filters after it. */
+    if ((!p_ctrl->pipe.active) && (NULL != sf_console_pipe_find(p_input, bytes)))
+    {
+        return sf_console_pipe_run(p_ctrl, p_menu, p_input, bytes);
+    }
+
     /** Print help menu if help command is entered */
     if (check_for_match(p_input, (uint8_t *) SF_CONSOLE_HELP_COMMAND))
     {
@@ -314,16 +585,79 @@ uint32_t SF_CONSOLE_Parse(sf_console_ctrl_t       * const p_api_ctrl,
         return FSP_SUCCESS;
     }
 
-    /** Look for matching commands, call callback if command found. */
-    for (uint32_t i = 0U; i < p_menu->num_commands; i++)
+    /** Look for matching commands, call callback if command found.  Menu commands are looked for before the word
+     *  builtins below, so a menu command starting with one of their words, such as "output stats", stays reachable.
+     *  A menu command named exactly like a builtin hides it. */
+    uint32_t command = 0U;
+    int32_t command_length = 0;
+    if (sf_console_find_command(p_ctrl, p_menu, p_input, &command, &command_length))
+    {
+        /* Match found, call callback if its not null, then return success. */
+        sf_console_call_callback(p_ctrl, &p_menu->command_list[command],
+                                 sf_console_command_stats(p_menu, &p_menu->command_list[command]),
+                                 p_input, bytes, command_length);
+        return FSP_SUCCESS;
+    }
+
+    /** List the command history if it is kept. */
+    if ((NULL != p_ctrl->history.p_buffer) && check_for_match(p_input, SF_CONSOLE_HISTORY_COMMAND))
+    {
+        return sf_console_history_list(p_ctrl);
+    }
+
+    /** Run a script file if there is batch memory to compile it into. */
+    if (NULL != p_ctrl->batch.p_buffer)
     {
-        int32_t length = check_for_match(p_input, p_menu->command_list[i].command);
+        int32_t length = check_for_match(p_input, SF_CONSOLE_SOURCE_COMMAND);
         if (length > 0)
         {
-            /* Match found, call callback if its not null, then return success. */
-            sf_console_call_callback(p_ctrl, p_menu->command_list[i].callback, p_menu->command_list[i].context,
-                    p_input, bytes, length);
-            return FSP_SUCCESS;
+            return sf_console_source_command(p_ctrl, p_menu, &p_input[length]);
+        }
+    }
+
+    /** Switch to binary frames for host tools if allowed. */
+    if (p_ctrl->rpc.enabled && check_for_match(p_input, SF_CONSOLE_RPC_COMMAND))
+    {
+        return SF_CONSOLE_RpcStart(p_ctrl);
+    }
+
+    /** Show or choose how tables are rendered. */
+    int32_t output_length = check_for_match(p_input, SF_CONSOLE_OUTPUT_COMMAND);
+    if (output_length > 0)
+    {
+        return sf_console_output_command(p_ctrl, &p_input[output_length]);
+    }
+
+    /** Run a command again and again until a key is pressed. */
+    int32_t watch_length = check_for_match(p_input, SF_CONSOLE_WATCH_COMMAND);
+    if (watch_length > 0)
+    {
+        return sf_console_watch_command(p_ctrl, p_menu, &p_input[watch_length]);
+    }
+
+    /** Show how long commands took if the menus keep statistics. */
+    if (NULL != sf_console_menu_root(p_menu)->p_stats)
+    {
+        int32_t length = check_for_match(p_input, SF_CONSOLE_PERF_COMMAND);
+        if (length > 0)
+        {
+            return sf_console_perf_command(p_ctrl, p_menu, &p_input[length]);
+        }
+    }
+
+    /** List or wait for asynchronous commands if there is a worker pool to run them. */
+    if (NULL != p_ctrl->p_jobs)
+    {
+        int32_t length = check_for_match(p_input, SF_CONSOLE_JOBS_COMMAND);
+        if (length > 0)
+        {
+            return sf_console_jobs_list(p_ctrl);
+        }
+
+        length = check_for_match(p_input, SF_CONSOLE_WAIT_COMMAND);
+        if (length > 0)
+        {
+            return sf_console_jobs_wait(p_ctrl, &p_input[length]);
         }
     }
 
@@ -339,6 +673,8 @@ uint32_t SF_CONSOLE_Parse(sf_console_ctrl_t       * const p_api_ctrl,
  * @retval FSP_SUCCESS           Received valid command and called callback
  * @retval FSP_ERR_ASSERTION     p_ctrl is NULL
  * @retval FSP_ERR_UNSUPPORTED   Command not found in the current menu.
+ * @retval FSP_ERR_TIMEOUT       No input was started before the timeout expired. Call again to keep waiting on the
+ *                               same line.
  * @return                       See @ref Common_Error_Codes or lower level drivers for other possible return codes.
  * @note This function is reentrant for any channel.
 ***********************************************************************************************************************/
@@ -358,9 +694,20 @@ uint32_t SF_CONSOLE_Prompt(   sf_console_ctrl_t        * const p_api_ctrl,
         p_ctrl->p_current_menu = p_menu;
     }
 
-    /** Print menu name followed by ">" to prompt for user input. */
-    SF_CONSOLE_Write(p_ctrl, p_ctrl->p_current_menu->menu_name, SF_CONSOLE_PRV_TIMEOUT);
-    SF_CONSOLE_Write(p_ctrl, (uint8_t *) ">", SF_CONSOLE_PRV_TIMEOUT);
+    /** Once the rpc command switched to binary frames, serve requests instead of reading lines until the host
+     *  switches back. */
+    if (p_ctrl->rpc.active)
+    {
+        return SF_CONSOLE_RpcServe(p_ctrl, p_ctrl->p_current_menu, timeout);
+    }
+
+    /** Print menu name followed by ">" to prompt for user input.  The prompt is not repeated when the previous call
+     *  timed out waiting on the same line. */
+    if (!p_ctrl->prompted)
+    {
+        SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "%s>", (char const *) p_ctrl->p_current_menu->menu_name);
+        p_ctrl->prompted = true;
+    }
 
     /** Lock the console UART framework to reserve exclusive access until the command completes.
      *  @note Transmission is only locked while the menu name is printed and while the input command is non-zero in length.
@@ -378,15 +725,39 @@ uint32_t SF_CONSOLE_Prompt(   sf_console_ctrl_t        * const p_api_ctrl,
     }
     SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
 
+    /** A line was received, the next call prompts again. */
+    p_ctrl->prompted = false;
+
+    /** Replace a history reference with the line it refers to, then keep the line in the history. */
+    if ((NULL != p_ctrl->history.p_buffer) && (0U != p_ctrl->input[0]))
+    {
+        if ((uint8_t) SF_CONSOLE_HISTORY_RECALL_CHAR == p_ctrl->input[0])
+        {
+            err = sf_console_history_expand(p_ctrl);
+            if (FSP_SUCCESS != err)
+            {
+                SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "No such history entry %s\r\n",
+                                       (char const *) p_ctrl->input);
+                p_ctrl->input[0] = NULL_CODE;
+                err = FSP_SUCCESS;
+            }
+        }
+
+        history_add(&p_ctrl->history, p_ctrl->input, (uint32_t) strlen((char const *) p_ctrl->input));
+    }
+
     /** Parse input and call associated user callback. */
     if (0U != p_ctrl->input[0])
     {
-        err = SF_CONSOLE_Parse(p_ctrl, p_ctrl->p_current_menu, &p_ctrl->input[0], SF_CONSOLE_MAX_INPUT_LENGTH);
+        sf_console_menu_t const * p_parse_menu = p_ctrl->p_current_menu;
+        err = SF_CONSOLE_Parse(p_ctrl, p_parse_menu, &p_ctrl->input[0], SF_CONSOLE_MAX_INPUT_LENGTH);
         if (FSP_ERR_UNSUPPORTED == err)
         {
-            SF_CONSOLE_Write(p_ctrl, (uint8_t *) "Unsupported ", SF_CONSOLE_PRV_TIMEOUT);
-            SF_CONSOLE_Write(p_ctrl, p_ctrl->p_current_menu->menu_name, SF_CONSOLE_PRV_TIMEOUT);
-            SF_CONSOLE_Write(p_ctrl, (uint8_t *) " Command\r\n", SF_CONSOLE_PRV_TIMEOUT);
+            SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "Unsupported %s Command\r\n",
+                                   (char const *) p_ctrl->p_current_menu->menu_name);
+
+            /** Point out the commands the line was closest to. */
+            sf_console_suggest(p_ctrl, p_parse_menu, &p_ctrl->input[0]);
         }
     }
 
@@ -399,7 +770,11 @@ uint32_t SF_CONSOLE_Prompt(   sf_console_ctrl_t        * const p_api_ctrl,
 /******************************************************************************************************************//**
  * @brief Reads data into the destination byte by byte and echos input to the console.
  *
+ * When echo is off and the communications driver hands out spans, plain text is copied a chunk at a time and only
+ * control characters go through the line editor.
+ *
  * @retval FSP_SUCCESS           Data read completed successfully
+ * @retval FSP_ERR_TIMEOUT       Line was still empty when the timeout expired.
  * @retval FSP_ERR_ASSERTION     Parameter check failed for one of the following :
  * @retval                       -Pointer p_dest is NULL
  * @retval                       -Pointer to the control block is NULL
@@ -431,8 +806,19 @@ uint32_t SF_CONSOLE_Read ( sf_console_ctrl_t * const p_api_ctrl,
     err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_RX, timeout);
     SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
 
-    /** Read one byte at a time, checking for carriage returns, backspace, delete, and escape codes. */
-    err = sf_console_read_main(p_ctrl, p_dest, bytes, timeout);
+    /** The arrow keys start from the newest history line on every line. */
+    p_ctrl->history.browse = 0U;
+
+    /** Without echo nothing is drawn, so whole chunks can be taken from the driver.  Otherwise read one byte at a time,
+     *  checking for carriage returns, backspace, delete, and escape codes. */
+    if ((!p_ctrl->echo) && (NULL != p_ctrl->p_comms->p_api->readSpan) && (NULL != p_ctrl->p_comms->p_api->readRelease))
+    {
+        err = sf_console_read_raw(p_ctrl, p_dest, bytes, timeout);
+    }
+    else
+    {
+        err = sf_console_read_main(p_ctrl, p_dest, bytes, timeout);
+    }
 
     /** Unlock the communications framework reception */
     p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_RX);
@@ -441,34 +827,113 @@ uint32_t SF_CONSOLE_Read ( sf_console_ctrl_t * const p_api_ctrl,
 }  /* End of function SF_CONSOLE_Read() */
 
 /******************************************************************************************************************//**
- * @brief Write a NULL terminated string to the console.
+ * @brief Write a NULL terminated string of any length to the console.
  *
  * @retval FSP_SUCCESS           Data write completed successfully
- * @retval FSP_ERR_ASSERTION     Pointer to the control block is NULL
- * @retval FSP_ERR_INVALID_SIZE  If length passed is zero or length passed is greater than 128U (max value).
+ * @retval FSP_ERR_ASSERTION     Pointer to the control block or p_src is NULL
+ * @retval FSP_ERR_INVALID_SIZE  The string is empty.
  * @return                       See @ref Common_Error_Codes or lower level drivers for other possible return codes.
  * @note This function is reentrant for any channel.
 ***********************************************************************************************************************/
 uint32_t SF_CONSOLE_Write (  sf_console_ctrl_t * const p_api_ctrl,
                             uint8_t const *  const p_src,
                             uint32_t         const timeout)
+{
+#if SF_CONSOLE_CFG_PARAM_CHECKING_ENABLE
+    FSP_ASSERT(NULL != p_api_ctrl);
+    FSP_ASSERT(NULL != p_src);
+#endif
+
+    /** Write null terminated string.  Calculate the length, then write the entire string to the console. */
+    uint32_t length = strlen((char *) p_src);
+    SF_CONSOLE_ERROR_RETURN(0U != length, FSP_ERR_INVALID_SIZE);
+
+    return SF_CONSOLE_WriteN(p_api_ctrl, p_src, length, timeout);
+}  /* End of function SF_CONSOLE_Write() */
+
+/******************************************************************************************************************//**
+ * @brief Write a number of bytes to the console.
+ *
+ * @retval FSP_SUCCESS           Data write completed successfully, or there was nothing to write.
+ * @retval FSP_ERR_ASSERTION     Pointer to the control block or p_src is NULL
+ * @return                       See @ref Common_Error_Codes or lower level drivers for other possible return codes.
+ * @note This function is reentrant for any channel.
+***********************************************************************************************************************/
+uint32_t SF_CONSOLE_WriteN (  sf_console_ctrl_t * const p_api_ctrl,
+                             uint8_t const *  const p_src,
+                             uint32_t         const bytes,
+                             uint32_t         const timeout)
 {
     sf_console_instance_ctrl_t * p_ctrl = (sf_console_instance_ctrl_t *) p_api_ctrl;
 
 #if SF_CONSOLE_CFG_PARAM_CHECKING_ENABLE
     FSP_ASSERT(NULL != p_ctrl);
+    FSP_ASSERT(NULL != p_src);
 #endif
 
-    /** Write null terminated string.  Calculate the length.  If it isn't longer than the maximum, write the entire
-     *  string to the console. */
-    uint32_t length = strlen((char *) p_src);
-    SF_CONSOLE_ERROR_RETURN(0U != length, FSP_ERR_INVALID_SIZE);
-    SF_CONSOLE_ERROR_RETURN(length < SF_CONSOLE_MAX_WRITE_LENGTH, FSP_ERR_INVALID_SIZE);
-    uint32_t err = p_ctrl->p_comms->p_api->write(p_ctrl->p_comms->p_ctrl, p_src, length, timeout);
+    /** Nothing is sent for an empty write. */
+    if (0U == bytes)
+    {
+        return FSP_SUCCESS;
+    }
+
+    /** Output of a piped command goes through its filters first.  Other threads writing meanwhile are not filtered. */
+    if (p_ctrl->pipe.active && (tx_thread_identify() == p_ctrl->pipe.p_thread))
+    {
+        return sf_console_pipe_write(p_ctrl, p_src, bytes, timeout);
+    }
+
+    return sf_console_output_write(p_ctrl, p_src, bytes, timeout);
+}  /* End of function SF_CONSOLE_WriteN() */
+
+/******************************************************************************************************************//**
+ * @brief Write printf style formatted output to the console.
+ *
+ * Output is built in the scratch buffer of the control block and written each time the buffer fills, so the length of
+ * the output is not limited by the buffer.  Transmission is locked for the whole call, which keeps the output of one
+ * call together and protects the scratch buffer.
+ *
+ * @retval FSP_SUCCESS           Data write completed successfully
+ * @retval FSP_ERR_ASSERTION     Pointer to the control block or p_format is NULL
+ * @retval FSP_ERR_INVALID_SIZE  A numeric conversion did not fit in the scratch buffer and was truncated.
+ * @retval FSP_ERR_INVALID_ARGUMENT  A conversion could not be formatted.
+ * @return                       See @ref Common_Error_Codes or lower level drivers for other possible return codes.
+ * @note This function is reentrant for any channel.
+***********************************************************************************************************************/
+uint32_t SF_CONSOLE_WriteFormat (  sf_console_ctrl_t * const p_api_ctrl,
+                                  uint32_t         const timeout,
+                                  char const *     const p_format,
+                                  ...)
+{
+    sf_console_instance_ctrl_t * p_ctrl = (sf_console_instance_ctrl_t *) p_api_ctrl;
+
+#if SF_CONSOLE_CFG_PARAM_CHECKING_ENABLE
+    FSP_ASSERT(NULL != p_ctrl);
+    FSP_ASSERT(NULL != p_format);
+#endif
+
+    /** Lock transmission so the scratch buffer is not shared and the output is not interleaved.  Rows of a table this
+     *  thread has open may be waiting in the buffer, the output follows them. */
+    uint32_t err;
+    err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, timeout);
     SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
 
-    return FSP_SUCCESS;
-}  /* End of function SF_CONSOLE_Write() */
+    va_list args;
+    va_start(args, p_format);
+    err = sf_console_format(p_ctrl, p_format, &args);
+    va_end(args);
+
+    /** Write what is left in the scratch buffer, even after an error, then unlock transmission. */
+    uint32_t flush_err = format_flush(p_ctrl);
+    if (FSP_SUCCESS == err)
+    {
+        err = flush_err;
+    }
+
+    p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+
+    return err;
+}  /* End of function SF_CONSOLE_WriteFormat() */
 
 /******************************************************************************************************************//**
  * @brief Finds a command line argument in an input string and returns the index of the character immediately
@@ -527,328 +992,3850 @@ uint32_t SF_CONSOLE_ArgumentFind (uint8_t const *        const p_arg,
 }  /* End of function SF_CONSOLE_ArgumentFind() */
 
 /******************************************************************************************************************//**
- * @brief Callback provided to continue parsing the next menu down.
+ * @brief Splits a string into words in one pass and checks them against argument specs.
  *
- * @param[in] p_args  Pointer to callback arguments to use in the next menu.
+ * @retval FSP_SUCCESS                The string was split and all words match their specs.
+ * @retval FSP_ERR_ASSERTION          A pointer parameter is NULL.
+ * @retval FSP_ERR_INVALID_ARGUMENT   A word does not match its spec, *p_argc is its index.
+ * @retval FSP_ERR_INSUFFICIENT_DATA  A required argument is missing.
+ * @retval FSP_ERR_INVALID_SIZE       There are more words than argument specs, or than entries in p_argv.
+ * @note   This function is reentrant.
 ***********************************************************************************************************************/
-void SF_CONSOLE_CallbackNextMenu(sf_console_callback_args_t * p_args)
+uint32_t SF_CONSOLE_ArgumentsParse (uint8_t               const * const p_str,
+                                    sf_console_arg_spec_t const * const p_specs,
+                                    uint32_t                      const num_specs,
+                                    sf_console_arg_t            * const p_argv,
+                                    uint32_t                      const max_args,
+                                    uint32_t                    * const p_argc)
 {
-    /** Next level menu is passed in as the user context parameter */
-    sf_console_menu_t * p_menu = (sf_console_menu_t *) p_args->context;
-
-    /** Update current menu. */
-    sf_console_instance_ctrl_t * p_ctrl = (sf_console_instance_ctrl_t *) p_args->p_ctrl;
-    p_ctrl->p_current_menu = p_menu;
+#if SF_CONSOLE_CFG_PARAM_CHECKING_ENABLE
+    FSP_ASSERT(NULL != p_str);
+    FSP_ASSERT(NULL != p_argv);
+    FSP_ASSERT(NULL != p_argc);
+#endif
 
-    /** Check to see if the next menu command was input in the remaining string. */
-    if (NULL_CODE != p_args->p_remaining_string[0])
+    /** Split the string, remembering where each word starts and how long it is. */
+    uint32_t argc = 0U;
+    uint32_t i = 0U;
+    while (true)
     {
-        SF_CONSOLE_Parse(p_args->p_ctrl, p_menu, p_args->p_remaining_string, p_args->bytes);
-    }
-}
+        while (SPACE_CODE == p_str[i])
+        {
+            i++;
+        }
+        if (NULL_CODE == p_str[i])
+        {
+            break;
+        }
+        if (argc >= max_args)
+        {
+            *p_argc = argc;
+            return FSP_ERR_INVALID_SIZE;
+        }
 
-/** @} (end addtogroup Console) */
+        uint32_t start = i;
+        uint32_t end;
+        if (QUOTE_CODE == p_str[i])
+        {
+            /** A quoted word runs to the closing quote, or to the end of the string if there is none. */
+            start++;
+            end = start;
+            while ((NULL_CODE != p_str[end]) && (QUOTE_CODE != p_str[end]))
+            {
+                end++;
+            }
+            i = (QUOTE_CODE == p_str[end]) ? (end + 1U) : end;
+        }
+        else
+        {
+            end = start;
+            while ((NULL_CODE != p_str[end]) && (SPACE_CODE != p_str[end]))
+            {
+                end++;
+            }
+            i = end;
+        }
 
-/***********************************************************************************************************************
-Private Functions
-***********************************************************************************************************************/
-/******************************************************************************************************************//**
-* @brief  Checks to see if a test string matches a reference string.
-* @note   This function is insensitive to case.
-* @param[in]  p_test    String to look for
-* @param[in]  p_ref     Reference string
-* @return  Length of reference string if there is a match
-***********************************************************************************************************************/
-static int32_t check_for_match(uint8_t const * const p_test, uint8_t const * const p_ref)
-{
-    int32_t i = 0;
+        p_argv[argc].p_text = &p_str[start];
+        p_argv[argc].length = end - start;
+        p_argv[argc].value.integer = 0;
+        argc++;
+    }
+    *p_argc = argc;
 
-    /** Compare characters until they don't match or end of the reference string is reached. */
-    while (NULL_CODE != (p_ref[i]))
+    if ((NULL == p_specs) || (0U == num_specs))
     {
-        /** Convert to upper case.  This console is not case sensitive. */
-        int32_t temp1 = toupper((int32_t) p_test[i]);
-        int32_t temp2 = toupper((int32_t) p_ref[i]);
-        if (temp1 != temp2)
+        return FSP_SUCCESS;
+    }
+
+    /** Check and convert each word according to its spec. */
+    if (argc > num_specs)
+    {
+        return FSP_ERR_INVALID_SIZE;
+    }
+    for (uint32_t arg = 0U; arg < argc; arg++)
+    {
+        if (!sf_console_argument_convert(&p_specs[arg], &p_argv[arg]))
         {
-            return 0;
+            *p_argc = arg;
+            return FSP_ERR_INVALID_ARGUMENT;
         }
-
-        i++;
     }
-
-    /** Check for the end of input string and a non-space character */
-    if((NULL_CODE != p_test[i]) && (SPACE_CODE != p_test[i]))
+    if ((argc < num_specs) && !p_specs[argc].optional)
     {
-        return 0;
+        return FSP_ERR_INSUFFICIENT_DATA;
     }
 
-    return i;
-}  /* End of function check_for_match */
+    return FSP_SUCCESS;
+}  /* End of function SF_CONSOLE_ArgumentsParse() */
 
 /******************************************************************************************************************//**
-* @brief  Deletes character at input index and shifts the rest of the string left.
-* @pre    Lock the UART framework before calling this function.
-* @param[in]      p_ctrl        Console control block, used to print to the console if echo mode is on.
-* @param[in,out]  p_input       Input string to remove character from.
-* @param[in]      index         Index of character to remove
-* @param[in,out]  p_last_index  Index after the last valid character in the input string.
-* @retval         FSP_SUCCESS   Deleting characters from console is processed successfully.
-* @return                       See @ref Common_Error_Codes or lower level drivers for other possible return codes
+ * @brief Copies a line out of the command history.
+ *
+ * @retval FSP_SUCCESS           The line was copied.
+ * @retval FSP_ERR_ASSERTION     Pointer to the control block or p_dest is NULL
+ * @retval FSP_ERR_NOT_ENABLED   No history memory was configured.
+ * @retval FSP_ERR_NOT_FOUND     There are no more than index lines in the history.
+ * @retval FSP_ERR_INVALID_SIZE  The line does not fit in p_dest.
+ * @note Call from the thread that prompts.
 ***********************************************************************************************************************/
-static uint32_t delete_char(sf_console_instance_ctrl_t * p_ctrl, uint8_t * p_input, uint32_t index, uint32_t * p_last_index)
+uint32_t SF_CONSOLE_HistoryGet (sf_console_ctrl_t * const p_api_ctrl,
+                                uint32_t            const index,
+                                uint8_t           * const p_dest,
+                                uint32_t            const bytes)
 {
-    /** Character can only be deleted if it is not the last character (index < last_index) */
-    uint32_t last_index = *p_last_index;
-    if (index < last_index)
-    {
-        /* Save start pointer to print it later. */
-        uint8_t * p_start = &p_input[index];
+    sf_console_instance_ctrl_t * p_ctrl = (sf_console_instance_ctrl_t *) p_api_ctrl;
 
-        /** Shift characters left in input string */
-        while (index < (last_index - 1))
-        {
-            p_input[index] = p_input[index + 1];
-            index++;
-        }
+#if SF_CONSOLE_CFG_PARAM_CHECKING_ENABLE
+    FSP_ASSERT(NULL != p_ctrl);
+    FSP_ASSERT(NULL != p_dest);
+#endif
 
-        /** Store a space at the end to erase the last character on the terminal */
-        p_input[index] = SPACE_CODE;
-        p_input[last_index] = NULL_CODE;
-        if (p_ctrl->echo)
-        {
-            /* Print shifted string, then move cursor back to start index. */
-            uint32_t err;
-            err = SF_CONSOLE_Write(p_ctrl, p_start, SF_CONSOLE_PRV_TIMEOUT);
-            if (FSP_SUCCESS == err)
-            {
-                move_cursor(p_ctrl, SF_CONSOLE_CURSOR_DIR_LEFT, strlen((char *) p_start));
-            }
-        }
-        p_input[index] = NULL_CODE;
-        last_index--;
-        *p_last_index = last_index;
-        if ((0U == last_index) && (p_ctrl->echo))
-        {
-            /** Unlock transmission to allow debug messages if there is no input.  Only needed when echo is on. */
-            uint32_t err = p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
-            SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
-        }
-    }
+    sf_console_history_t * p_history = &p_ctrl->history;
+    SF_CONSOLE_ERROR_RETURN(NULL != p_history->p_buffer, FSP_ERR_NOT_ENABLED);
+    SF_CONSOLE_ERROR_RETURN(index < p_history->count, FSP_ERR_NOT_FOUND);
+
+    uint32_t offset = history_locate(p_history, p_history->count - index);
+    SF_CONSOLE_ERROR_RETURN((uint32_t) p_history->p_buffer[offset] < bytes, FSP_ERR_INVALID_SIZE);
+    history_copy(p_history, offset, p_dest);
 
     return FSP_SUCCESS;
-} /* End of function delete_char */
+}  /* End of function SF_CONSOLE_HistoryGet() */
 
 /******************************************************************************************************************//**
-* @brief  Inserts character at input index and shifts the rest of the string right.
-* @pre    Lock the UART framework before calling this function.
-* @param[in]  p_ctrl       Console control block, used to print to the console if echo mode is on.
-* @param[in]  p_input      Input string to insert character into.
-* @param[in]  ch           Character to insert
-* @param[in]  index        Index to insert character
-* @param[in]  last_index   Index after the last valid character in the input string.  This will be the index of the last
-*                          valid character in the string after this function is complete.
-* @retval     FSP_SUCCESS  Character has been inserted or processed successfully.
-* @return                  See @ref Common_Error_Codes or lower level drivers for other possible return codes
+ * @brief Adds a line to the command history as if it had been entered at the prompt.
+ *
+ * @retval FSP_SUCCESS           The line was added, or it was empty or the same as the last line and nothing was added.
+ * @retval FSP_ERR_ASSERTION     Pointer to the control block or p_line is NULL
+ * @retval FSP_ERR_NOT_ENABLED   No history memory was configured.
+ * @retval FSP_ERR_INVALID_SIZE  The line is too long to have been entered at the prompt, or to fit in history memory.
+ * @note Call from the thread that prompts.
 ***********************************************************************************************************************/
-static uint32_t insert_char(sf_console_instance_ctrl_t * const p_ctrl,
+uint32_t SF_CONSOLE_HistoryAdd (sf_console_ctrl_t * const p_api_ctrl, uint8_t const * const p_line)
+{
+    sf_console_instance_ctrl_t * p_ctrl = (sf_console_instance_ctrl_t *) p_api_ctrl;
+
+#if SF_CONSOLE_CFG_PARAM_CHECKING_ENABLE
+    FSP_ASSERT(NULL != p_ctrl);
+    FSP_ASSERT(NULL != p_line);
+#endif
+
+    sf_console_history_t * p_history = &p_ctrl->history;
+    SF_CONSOLE_ERROR_RETURN(NULL != p_history->p_buffer, FSP_ERR_NOT_ENABLED);
+
+    uint32_t length = (uint32_t) strlen((char const *) p_line);
+    SF_CONSOLE_ERROR_RETURN(length < SF_CONSOLE_MAX_INPUT_LENGTH, FSP_ERR_INVALID_SIZE);
+    SF_CONSOLE_ERROR_RETURN((length + 2U) <= p_history->size, FSP_ERR_INVALID_SIZE);
+
+    history_add(p_history, p_line, length);
+
+    return FSP_SUCCESS;
+}  /* End of function SF_CONSOLE_HistoryAdd() */
+
+/******************************************************************************************************************//**
+ * @brief Runs a script without echo or prompts, looking up every line before running any command.
+ *
+ * @retval FSP_SUCCESS            The script ran, p_result tells whether all of it passed.
+ * @retval FSP_ERR_ASSERTION      p_ctrl or p_script is NULL.
+ * @retval FSP_ERR_NOT_ENABLED    No batch memory is configured.
+ * @retval FSP_ERR_OUT_OF_MEMORY  The compiled script does not fit the batch memory, nothing was run.
+ * @note   Call from the thread that prompts.
+***********************************************************************************************************************/
+uint32_t SF_CONSOLE_Batch (sf_console_ctrl_t               * const p_api_ctrl,
+                           sf_console_menu_t         const * const p_menu,
+                           uint8_t                         * const p_script,
+                           uint32_t                          const bytes,
+                           sf_console_batch_result_t       * const p_result)
+{
+    sf_console_instance_ctrl_t * p_ctrl = (sf_console_instance_ctrl_t *) p_api_ctrl;
+
+#if SF_CONSOLE_CFG_PARAM_CHECKING_ENABLE
+    FSP_ASSERT(NULL != p_ctrl);
+    FSP_ASSERT(NULL != p_script);
+#endif
+    SF_CONSOLE_ERROR_RETURN(NULL != p_ctrl->batch.p_buffer, FSP_ERR_NOT_ENABLED);
+
+    return sf_console_batch_run(p_ctrl, p_menu, p_script, bytes, p_ctrl->batch.p_buffer, p_ctrl->batch.size,
+                                p_result);
+}  /* End of function SF_CONSOLE_Batch() */
+
+/******************************************************************************************************************//**
+ * @brief Reads a script file into the batch memory and runs it as SF_CONSOLE_Batch does.
+ *
+ * @retval FSP_SUCCESS            The script ran, p_result tells whether all of it passed.
+ * @retval FSP_ERR_ASSERTION      p_ctrl or p_path is NULL.
+ * @retval FSP_ERR_NOT_ENABLED    No batch memory is configured.
+ * @retval FSP_ERR_NOT_FOUND      The file could not be opened.
+ * @retval FSP_ERR_OUT_OF_MEMORY  The file or the compiled script does not fit the batch memory, nothing was run.
+ * @note   Call from the thread that prompts.
+***********************************************************************************************************************/
+uint32_t SF_CONSOLE_Source (sf_console_ctrl_t               * const p_api_ctrl,
+                            sf_console_menu_t         const * const p_menu,
+                            char                      const * const p_path,
+                            sf_console_batch_result_t       * const p_result)
+{
+    sf_console_instance_ctrl_t * p_ctrl = (sf_console_instance_ctrl_t *) p_api_ctrl;
+
+#if SF_CONSOLE_CFG_PARAM_CHECKING_ENABLE
+    FSP_ASSERT(NULL != p_ctrl);
+    FSP_ASSERT(NULL != p_path);
+#endif
+    SF_CONSOLE_ERROR_RETURN(NULL != p_ctrl->batch.p_buffer, FSP_ERR_NOT_ENABLED);
+
+    bool from_stdin = (0 == strcmp(p_path, SF_CONSOLE_SOURCE_STDIN));
+    FILE * p_file = from_stdin ? stdin : fopen(p_path, "rb");
+    SF_CONSOLE_ERROR_RETURN(NULL != p_file, FSP_ERR_NOT_FOUND);
+
+    /** Read the whole file into the start of the batch memory.  Filling it means the file did not fit. */
+    uint8_t * p_buffer = p_ctrl->batch.p_buffer;
+    uint32_t size = p_ctrl->batch.size;
+    uint32_t length = (uint32_t) fread(p_buffer, 1U, size, p_file);
+    if (!from_stdin)
+    {
+        fclose(p_file);
+    }
+    SF_CONSOLE_ERROR_RETURN(length < size, FSP_ERR_OUT_OF_MEMORY);
+    p_buffer[length] = NULL_CODE;
+
+    /** The command list goes after the script and its terminating NULL, aligned for pointers. */
+    uint32_t offset = (length + sizeof(void *)) & ~((uint32_t) sizeof(void *) - 1U);
+    SF_CONSOLE_ERROR_RETURN(offset < size, FSP_ERR_OUT_OF_MEMORY);
+
+    return sf_console_batch_run(p_ctrl, p_menu, p_buffer, length, &p_buffer[offset], size - offset, p_result);
+}  /* End of function SF_CONSOLE_Source() */
+
+/******************************************************************************************************************//**
+ * @brief Sends values as the structured reply of a command that came in an RPC frame.
+ *
+ * @retval FSP_SUCCESS           The frame was sent.
+ * @retval FSP_ERR_ASSERTION     Pointer to the control block or p_values is NULL
+ * @retval FSP_ERR_INVALID_MODE  The console is not exchanging RPC frames.
+ * @retval FSP_ERR_INVALID_SIZE  The values do not fit in a frame.
+ * @return                       See @ref Common_Error_Codes or lower level drivers for other possible return codes.
+***********************************************************************************************************************/
+uint32_t SF_CONSOLE_Reply (sf_console_ctrl_t          * const p_api_ctrl,
+                           sf_console_value_t   const * const p_values,
+                           uint32_t                     const count)
+{
+    sf_console_instance_ctrl_t * p_ctrl = (sf_console_instance_ctrl_t *) p_api_ctrl;
+
+#if SF_CONSOLE_CFG_PARAM_CHECKING_ENABLE
+    FSP_ASSERT(NULL != p_ctrl);
+    FSP_ASSERT(NULL != p_values);
+#endif
+
+    /** Text consoles have no frames to reply in, the command prints its results instead. */
+    SF_CONSOLE_ERROR_RETURN(p_ctrl->rpc.active, FSP_ERR_INVALID_MODE);
+
+    uint32_t err = SF_CONSOLE_RpcValues(p_ctrl, p_values, count);
+    SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+    return FSP_SUCCESS;
+}  /* End of function SF_CONSOLE_Reply() */
+
+/******************************************************************************************************************//**
+ * @brief Starts a table and writes its heading in the output chosen for the console.
+ *
+ * Transmission stays locked until SF_CONSOLE_TableEnd, and the rows are built in the scratch buffer, so the table is
+ * written in as few transfers as the buffer allows.
+ *
+ * @retval FSP_SUCCESS           The table was started.
+ * @retval FSP_ERR_ASSERTION     Pointer to the control block or p_columns is NULL
+ * @retval FSP_ERR_IN_USE        A table is already open on this console.
+ * @return                       See @ref Common_Error_Codes or lower level drivers for other possible return codes.
+ * @note This function is reentrant for any channel.
+***********************************************************************************************************************/
+uint32_t SF_CONSOLE_TableStart (sf_console_ctrl_t           * const p_api_ctrl,
+                                sf_console_column_t   const * const p_columns,
+                                uint32_t                      const count)
+{
+    sf_console_instance_ctrl_t * p_ctrl = (sf_console_instance_ctrl_t *) p_api_ctrl;
+
+#if SF_CONSOLE_CFG_PARAM_CHECKING_ENABLE
+    FSP_ASSERT(NULL != p_ctrl);
+    FSP_ASSERT(NULL != p_columns);
+#endif
+
+    /** Tables of other threads wait here for the open one to end. */
+    uint32_t err;
+    err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
+    SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+    /** The lock is recursive, so a second table of the thread with the open one gets this far. */
+    if (p_ctrl->table.open)
+    {
+        p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+        SF_CONSOLE_ERROR_RETURN(false, FSP_ERR_IN_USE);
+    }
+
+    p_ctrl->table.p_columns = p_columns;
+    p_ctrl->table.count = count;
+    p_ctrl->table.open = true;
+
+    /** The lock is kept until the table ends, even if the heading could not be written. */
+    err = sf_console_table_heading(p_ctrl);
+    SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+    return FSP_SUCCESS;
+}  /* End of function SF_CONSOLE_TableStart() */
+
+/******************************************************************************************************************//**
+ * @brief Writes a row of the open table.
+ *
+ * @retval FSP_SUCCESS           The row was written, or buffered with the rows that follow.
+ * @retval FSP_ERR_ASSERTION     Pointer to the control block or p_values is NULL
+ * @retval FSP_ERR_NOT_OPEN      No table is open on this console.
+ * @return                       See @ref Common_Error_Codes or lower level drivers for other possible return codes.
+ * @note This function is reentrant for any channel.
+***********************************************************************************************************************/
+uint32_t SF_CONSOLE_TableRow (sf_console_ctrl_t          * const p_api_ctrl,
+                              sf_console_value_t   const * const p_values)
+{
+    sf_console_instance_ctrl_t * p_ctrl = (sf_console_instance_ctrl_t *) p_api_ctrl;
+
+#if SF_CONSOLE_CFG_PARAM_CHECKING_ENABLE
+    FSP_ASSERT(NULL != p_ctrl);
+    FSP_ASSERT(NULL != p_values);
+#endif
+
+    /** Other threads wait for the table to end, then find it closed. */
+    uint32_t err;
+    err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
+    SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+    err = p_ctrl->table.open ? sf_console_table_row(p_ctrl, p_values) : FSP_ERR_NOT_OPEN;
+
+    p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+    SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+    return FSP_SUCCESS;
+}  /* End of function SF_CONSOLE_TableRow() */
+
+/******************************************************************************************************************//**
+ * @brief Ends the open table, writing the rows still in the scratch buffer and unlocking transmission.
+ *
+ * @retval FSP_SUCCESS           The table was ended.
+ * @retval FSP_ERR_ASSERTION     Pointer to the control block is NULL
+ * @retval FSP_ERR_NOT_OPEN      No table is open on this console.
+ * @return                       See @ref Common_Error_Codes or lower level drivers for other possible return codes.
+ * @note This function is reentrant for any channel.
+***********************************************************************************************************************/
+uint32_t SF_CONSOLE_TableEnd (sf_console_ctrl_t * const p_api_ctrl)
+{
+    sf_console_instance_ctrl_t * p_ctrl = (sf_console_instance_ctrl_t *) p_api_ctrl;
+
+#if SF_CONSOLE_CFG_PARAM_CHECKING_ENABLE
+    FSP_ASSERT(NULL != p_ctrl);
+#endif
+
+    uint32_t err;
+    err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
+    SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+    if (!p_ctrl->table.open)
+    {
+        p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+        SF_CONSOLE_ERROR_RETURN(false, FSP_ERR_NOT_OPEN);
+    }
+
+    p_ctrl->table.open = false;
+    err = format_flush(p_ctrl);
+
+    /** Release this call's lock and the one SF_CONSOLE_TableStart kept. */
+    p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+    p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+    SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+    return FSP_SUCCESS;
+}  /* End of function SF_CONSOLE_TableEnd() */
+
+/******************************************************************************************************************//**
+ * @brief Callback provided to continue parsing the next menu down.
+ *
+ * @param[in] p_args  Pointer to callback arguments to use in the next menu.
+***********************************************************************************************************************/
+void SF_CONSOLE_CallbackNextMenu(sf_console_callback_args_t * p_args)
+{
+    /** Next level menu is passed in as the user context parameter */
+    sf_console_menu_t * p_menu = (sf_console_menu_t *) p_args->context;
+
+    /** Update current menu. */
+    sf_console_instance_ctrl_t * p_ctrl = (sf_console_instance_ctrl_t *) p_args->p_ctrl;
+    p_ctrl->p_current_menu = p_menu;
+
+    /** Check to see if the next menu command was input in the remaining string. */
+    if (NULL_CODE != p_args->p_remaining_string[0])
+    {
+        SF_CONSOLE_Parse(p_args->p_ctrl, p_menu, p_args->p_remaining_string, p_args->bytes);
+    }
+}
+
+/******************************************************************************************************************//**
+ * @brief Calls the callback of a command, timing the call into the statistics of the command.
+ *
+ * @param[in]     p_command  Command whose callback to call
+ * @param[in,out] p_stats    Statistics of the command, NULL to call it without timing
+ * @param[in]     p_args     Arguments to call the callback with.  The call is timed with the clock of their console.
+***********************************************************************************************************************/
+void SF_CONSOLE_CommandRun(sf_console_command_t const * const p_command,
+                           sf_console_command_stats_t * const p_stats,
+                           sf_console_callback_args_t * const p_args)
+{
+    sf_console_instance_ctrl_t * p_ctrl = (sf_console_instance_ctrl_t *) p_args->p_ctrl;
+    uint64_t (* p_time_us)(void) = p_ctrl->p_time_us;
+
+    ULONG start_ticks = tx_time_get();
+    uint64_t start_us = ((NULL != p_stats) && (NULL != p_time_us)) ? p_time_us() : 0U;
+    p_command->callback(p_args);
+    uint64_t us = ((NULL != p_stats) && (NULL != p_time_us)) ? (p_time_us() - start_us) : 0U;
+    ULONG ticks = tx_time_get() - start_ticks;
+
+    /** A table the callback left open would keep transmission locked, so it ends with the callback.  Only the thread
+     *  holding the table gets past the lock. */
+    if (p_ctrl->table.open &&
+        (FSP_SUCCESS == p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, TX_NO_WAIT)))
+    {
+        if (p_ctrl->table.open)
+        {
+            SF_CONSOLE_TableEnd(p_ctrl);
+        }
+        p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+    }
+
+    if (NULL == p_stats)
+    {
+        return;
+    }
+
+    /** Without a clock the ticks are all there is, so they are counted as the microseconds they stand for. */
+    if (NULL == p_time_us)
+    {
+        us = (uint64_t) ticks * (1000000U / TX_TIMER_TICKS_PER_SECOND);
+    }
+
+    sf_console_stats_record(p_stats, (us > UINT32_MAX) ? UINT32_MAX : (uint32_t) us, (uint32_t) ticks);
+}
+
+/** @} (end addtogroup Console) */
+
+/***********************************************************************************************************************
+Private Functions
+***********************************************************************************************************************/
+/******************************************************************************************************************//**
+* @brief  Checks to see if a test string starts with a reference string as whole words.
+* @note   This function is insensitive to case.  The reference must be followed by a space or the end of the test
+*         string, so "perf" does not match "performance".
+* @param[in]  p_test    String to look for
+* @param[in]  p_ref     Reference string
+* @return  Length of reference string if there is a match
+***********************************************************************************************************************/
+static int32_t check_for_match(uint8_t const * const p_test, uint8_t const * const p_ref)
+{
+    int32_t i = 0;
+
+    /** Compare characters until they don't match or end of the reference string is reached. */
+    while (NULL_CODE != (p_ref[i]))
+    {
+        /** Convert to upper case.  This console is not case sensitive. */
+        int32_t temp1 = toupper((int32_t) p_test[i]);
+        int32_t temp2 = toupper((int32_t) p_ref[i]);
+        if (temp1 != temp2)
+        {
+            return 0;
+        }
+
+        i++;
+    }
+
+    /** Check for the end of input string and a non-space character */
+    if((NULL_CODE != p_test[i]) && (SPACE_CODE != p_test[i]))
+    {
+        return 0;
+    }
+
+    return i;
+}  /* End of function check_for_match */
+
+/******************************************************************************************************************//**
+* @brief  Finds the command in a menu that matches the start of the input string.
+* @note   Uses the command index of the menu if Open built one, otherwise compares each command in turn.  Either way the
+*         first matching command in the command list is found.
+* @param[in]   p_ctrl     Console control block holding the command indexes
+* @param[in]   p_menu     Menu to search
+* @param[in]   p_input    Input string
+* @param[out]  p_command  Index of the matching command in the command list
+* @param[out]  p_length   Length of the matching command
+* @return  true if a command matches
+***********************************************************************************************************************/
+static bool sf_console_find_command(sf_console_instance_ctrl_t const * const p_ctrl,
+                                    sf_console_menu_t          const * const p_menu,
+                                    uint8_t                    const * const p_input,
+                                    uint32_t                         * const p_command,
+                                    int32_t                          * const p_length)
+{
+    sf_console_menu_index_t const * p_index = sf_console_index_find(p_ctrl, p_menu);
+    if (NULL == p_index)
+    {
+        for (uint32_t i = 0U; i < p_menu->num_commands; i++)
+        {
+            int32_t length = check_for_match(p_input, p_menu->command_list[i].command);
+            if (length > 0)
+            {
+                *p_command = i;
+                *p_length = length;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Walk the trie along the input.  Every command ending where a word of the input ends is a match, and the one
+     *  that is first in the command list wins. */
+    sf_console_index_node_t const * p_nodes = p_ctrl->p_index_nodes;
+    uint32_t node = p_index->root;
+    uint32_t best = 0U;
+    int32_t best_length = 0;
+    for (uint32_t i = 0U; NULL_CODE != p_input[i]; i++)
+    {
+        uint8_t ch = (uint8_t) toupper((int32_t) p_input[i]);
+        uint32_t child = p_nodes[node].child;
+        while ((0U != child) && (ch != p_nodes[child].ch))
+        {
+            child = p_nodes[child].sibling;
+        }
+        if (0U == child)
+        {
+            break;
+        }
+        node = child;
+
+        uint32_t command = p_nodes[node].command;
+        if ((0U != command) && ((0U == best) || (command < best)) &&
+            ((NULL_CODE == p_input[i + 1U]) || (SPACE_CODE == p_input[i + 1U])))
+        {
+            best = command;
+            best_length = (int32_t) (i + 1U);
+        }
+    }
+
+    if (0U == best)
+    {
+        return false;
+    }
+
+    *p_command = best - 1U;
+    *p_length = best_length;
+    return true;
+}  /* End of function sf_console_find_command */
+
+/******************************************************************************************************************//**
+* @brief  Builds the command index of a menu, then of the menus it leads to.
+* @note   Menus are left without an index, and searched linearly, if the node memory or the menu table runs out.
+* @param[in,out]  p_ctrl  Console control block holding the command indexes
+* @param[in]      p_menu  Menu to index, may be NULL
+***********************************************************************************************************************/
+static void sf_console_index_build(sf_console_instance_ctrl_t * const p_ctrl,
+                                   sf_console_menu_t    const * const p_menu)
+{
+    if ((NULL == p_menu) || (NULL != sf_console_index_find(p_ctrl, p_menu)))
+    {
+        return;
+    }
+
+    if ((p_ctrl->menu_index_count >= SF_CONSOLE_CFG_MAX_INDEXED_MENUS) ||
+        (p_ctrl->index_nodes_used >= p_ctrl->index_nodes_max) ||
+        (p_menu->num_commands >= UINT16_MAX))
+    {
+        return;
+    }
+
+    /** Allocate the root, then one node for every new prefix of each command.  Give the nodes back if they run out. */
+    uint32_t root = p_ctrl->index_nodes_used;
+    p_ctrl->p_index_nodes[root].child = 0U;
+    p_ctrl->p_index_nodes[root].sibling = 0U;
+    p_ctrl->p_index_nodes[root].command = 0U;
+    p_ctrl->p_index_nodes[root].ch = NULL_CODE;
+    p_ctrl->index_nodes_used++;
+
+    for (uint32_t i = 0U; i < p_menu->num_commands; i++)
+    {
+        if (!sf_console_index_insert(p_ctrl, root, p_menu->command_list[i].command, i))
+        {
+            p_ctrl->index_nodes_used = root;
+            return;
+        }
+    }
+
+    p_ctrl->menu_index[p_ctrl->menu_index_count].p_menu = p_menu;
+    p_ctrl->menu_index[p_ctrl->menu_index_count].root = (uint16_t) root;
+    p_ctrl->menu_index_count++;
+
+    /** Index the menus this one leads to.  Menus already indexed end the recursion. */
+    sf_console_index_build(p_ctrl, p_menu->menu_prev);
+    for (uint32_t i = 0U; i < p_menu->num_commands; i++)
+    {
+        if (SF_CONSOLE_CALLBACK_NEXT_FUNCTION == p_menu->command_list[i].callback)
+        {
+            sf_console_index_build(p_ctrl, (sf_console_menu_t const *) p_menu->command_list[i].context);
+        }
+    }
+}  /* End of function sf_console_index_build */
+
+/******************************************************************************************************************//**
+* @brief  Adds a command to a trie.
+* @param[in,out]  p_ctrl     Console control block holding the command indexes
+* @param[in]      root       Root node of the trie
+* @param[in]      p_command  Command string
+* @param[in]      command    Index of the command in the command list
+* @return  false if the node memory ran out
+***********************************************************************************************************************/
+static bool sf_console_index_insert(sf_console_instance_ctrl_t * const p_ctrl,
+                                    uint32_t                           root,
+                                    uint8_t              const * const p_command,
+                                    uint32_t                           command)
+{
+    /** Empty commands never match, so they are left out. */
+    if ((NULL == p_command) || (NULL_CODE == p_command[0]))
+    {
+        return true;
+    }
+
+    sf_console_index_node_t * p_nodes = p_ctrl->p_index_nodes;
+    uint32_t node = root;
+    for (uint32_t i = 0U; NULL_CODE != p_command[i]; i++)
+    {
+        /** Commands are stored in upper case.  This console is not case sensitive. */
+        uint8_t ch = (uint8_t) toupper((int32_t) p_command[i]);
+        uint32_t child = p_nodes[node].child;
+        while ((0U != child) && (ch != p_nodes[child].ch))
+        {
+            child = p_nodes[child].sibling;
+        }
+
+        if (0U == child)
+        {
+            if (p_ctrl->index_nodes_used >= p_ctrl->index_nodes_max)
+            {
+                return false;
+            }
+            child = p_ctrl->index_nodes_used++;
+            p_nodes[child].child = 0U;
+            p_nodes[child].sibling = p_nodes[node].child;
+            p_nodes[child].command = 0U;
+            p_nodes[child].ch = ch;
+            p_nodes[node].child = (uint16_t) child;
+        }
+        node = child;
+    }
+
+    /** Keep the first of duplicate commands, as the linear search would find it first. */
+    if (0U == p_nodes[node].command)
+    {
+        p_nodes[node].command = (uint16_t) (command + 1U);
+    }
+
+    return true;
+}  /* End of function sf_console_index_insert */
+
+/******************************************************************************************************************//**
+* @brief  Looks up the command index built for a menu.
+* @param[in]  p_ctrl  Console control block holding the command indexes
+* @param[in]  p_menu  Menu to look for
+* @return  The command index, or NULL if the menu is not indexed
+***********************************************************************************************************************/
+static sf_console_menu_index_t const * sf_console_index_find(sf_console_instance_ctrl_t const * const p_ctrl,
+                                                             sf_console_menu_t          const * const p_menu)
+{
+    for (uint32_t i = 0U; i < p_ctrl->menu_index_count; i++)
+    {
+        if (p_menu == p_ctrl->menu_index[i].p_menu)
+        {
+            return &p_ctrl->menu_index[i];
+        }
+    }
+
+    return NULL;
+}  /* End of function sf_console_index_find */
+
+/******************************************************************************************************************//**
+* @brief  Finds the menu the last part of an input line is parsed in.
+* @note   Commands at the start of the line that lead to other menus are followed, as Parse follows them.
+* @param[in]   p_ctrl   Console control block holding the command indexes
+* @param[in]   p_menu   Menu the line is parsed in
+* @param[in]   p_input  Input line, NULL terminated
+* @param[out]  p_start  Index in p_input of the part parsed in the returned menu
+* @return  Menu the part of the line from p_start is parsed in
+***********************************************************************************************************************/
+static sf_console_menu_t const * sf_console_resolve_menu(sf_console_instance_ctrl_t const * const p_ctrl,
+                                                         sf_console_menu_t          const *       p_menu,
+                                                         uint8_t                    const * const p_input,
+                                                         uint32_t                         * const p_start)
+{
+    uint32_t start = 0U;
+    uint32_t command;
+    int32_t length;
+    while (sf_console_find_command(p_ctrl, p_menu, &p_input[start], &command, &length))
+    {
+        /** Only a command followed by a space leads on, the line may still end in a longer command. */
+        sf_console_command_t const * p_command = &p_menu->command_list[command];
+        if ((SF_CONSOLE_CALLBACK_NEXT_FUNCTION != p_command->callback) ||
+            (SPACE_CODE != p_input[start + (uint32_t) length]) || (NULL == p_command->context))
+        {
+            break;
+        }
+
+        p_menu = (sf_console_menu_t const *) p_command->context;
+        start += (uint32_t) length;
+        while (SPACE_CODE == p_input[start])
+        {
+            start++;
+        }
+    }
+
+    *p_start = start;
+    return p_menu;
+}  /* End of function sf_console_resolve_menu */
+
+/******************************************************************************************************************//**
+* @brief  Looks up the commands of a menu that start with a partly typed command.
+* @note   With a command index this takes one step per character of the prefix and of the completion, however many
+*         commands the menu has.  Without one each command is compared in turn.
+* @param[in]   p_ctrl    Console control block holding the command indexes
+* @param[in]   p_menu    Menu to search
+* @param[in]   p_prefix  Partly typed command
+* @param[in]   length    Length of the partly typed command
+* @param[out]  p_result  Longest match, and how far the prefix can be completed if all of it matched
+***********************************************************************************************************************/
+static void sf_console_complete(sf_console_instance_ctrl_t const * const p_ctrl,
+                                sf_console_menu_t          const * const p_menu,
+                                uint8_t                    const * const p_prefix,
+                                uint32_t                           const length,
+                                sf_console_completion_t          * const p_result)
+{
+    p_result->matched = 0U;
+    p_result->command = 0U;
+    p_result->extend = 0U;
+    p_result->unique = false;
+
+    sf_console_menu_index_t const * p_index = sf_console_index_find(p_ctrl, p_menu);
+    if (NULL == p_index)
+    {
+        bool found = false;
+        for (uint32_t i = 0U; i < p_menu->num_commands; i++)
+        {
+            uint8_t const * p_command = p_menu->command_list[i].command;
+            if (NULL == p_command)
+            {
+                continue;
+            }
+
+            /** Keep the first command sharing the most characters with the prefix. */
+            uint32_t matched = 0U;
+            while ((matched < length) && (NULL_CODE != p_command[matched]) &&
+                   (toupper((int32_t) p_prefix[matched]) == toupper((int32_t) p_command[matched])))
+            {
+                matched++;
+            }
+            if ((0U == matched) || (matched < p_result->matched))
+            {
+                continue;
+            }
+            if (matched > p_result->matched)
+            {
+                p_result->matched = matched;
+                p_result->command = i;
+                found = false;
+            }
+            if (matched < length)
+            {
+                continue;
+            }
+
+            /** Narrow the completion down to what every command starting with the whole prefix has in common. */
+            uint32_t rest = (uint32_t) strlen((char const *) &p_command[length]);
+            if (!found)
+            {
+                p_result->command = i;
+                p_result->extend = rest;
+                p_result->unique = true;
+                found = true;
+            }
+            else
+            {
+                uint8_t const * p_first = &p_menu->command_list[p_result->command].command[length];
+                uint32_t common = 0U;
+                while ((common < p_result->extend) &&
+                       (toupper((int32_t) p_first[common]) == toupper((int32_t) p_command[length + common])))
+                {
+                    common++;
+                }
+                if ((common != p_result->extend) || (common != rest))
+                {
+                    p_result->unique = false;
+                }
+                p_result->extend = common;
+            }
+        }
+
+        return;
+    }
+
+    /** Walk the trie along the prefix as far as it goes. */
+    sf_console_index_node_t const * p_nodes = p_ctrl->p_index_nodes;
+    uint32_t node = p_index->root;
+    while (p_result->matched < length)
+    {
+        uint8_t ch = (uint8_t) toupper((int32_t) p_prefix[p_result->matched]);
+        uint32_t child = p_nodes[node].child;
+        while ((0U != child) && (ch != p_nodes[child].ch))
+        {
+            child = p_nodes[child].sibling;
+        }
+        if (0U == child)
+        {
+            break;
+        }
+        node = child;
+        p_result->matched++;
+    }
+
+    /** All of the prefix matched, so follow the nodes every command below it passes through. */
+    if (p_result->matched == length)
+    {
+        uint32_t child = p_nodes[node].child;
+        while ((0U == p_nodes[node].command) && (0U != child) && (0U == p_nodes[child].sibling))
+        {
+            node = child;
+            child = p_nodes[node].child;
+            p_result->extend++;
+        }
+        p_result->unique = (0U != p_nodes[node].command) && (0U == child);
+    }
+
+    /** Any command below the node will do to spell out the completion.  Every leaf ends a command. */
+    while ((0U == p_nodes[node].command) && (0U != p_nodes[node].child))
+    {
+        node = p_nodes[node].child;
+    }
+    if (0U != p_nodes[node].command)
+    {
+        p_result->command = p_nodes[node].command - 1U;
+    }
+}  /* End of function sf_console_complete */
+
+/******************************************************************************************************************//**
+* @brief  Checks to see if a reference string starts with the first characters of a test string.
+* @note   This function is insensitive to case.
+* @param[in]  p_test    String to look for
+* @param[in]  p_ref     Reference string
+* @param[in]  length    Number of characters of the test string to compare
+* @return  true if the reference string starts with them
+***********************************************************************************************************************/
+static bool check_for_prefix(uint8_t const * const p_test, uint8_t const * const p_ref, uint32_t const length)
+{
+    for (uint32_t i = 0U; i < length; i++)
+    {
+        if ((NULL_CODE == p_ref[i]) || (toupper((int32_t) p_test[i]) != toupper((int32_t) p_ref[i])))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}  /* End of function check_for_prefix */
+
+/******************************************************************************************************************//**
+* @brief  Converts a command line argument according to its spec.
+* @note   The number conversions stop at the space or quote following the argument, or at the end of the line.  An
+*         argument is only accepted if the whole of it was converted.
+* @param[in]      p_spec  Argument spec
+* @param[in,out]  p_arg   Argument, value is set if it matches the spec
+* @return  true if the argument matches the spec
+***********************************************************************************************************************/
+static bool sf_console_argument_convert(sf_console_arg_spec_t const * const p_spec, sf_console_arg_t * const p_arg)
+{
+    char const * p_text = (char const *) p_arg->p_text;
+    char const * p_end = p_text + p_arg->length;
+    char * p_converted = NULL;
+    errno = 0;
+
+    if ((0U == p_arg->length) && (SF_CONSOLE_ARG_TYPE_STRING != p_spec->type))
+    {
+        return false;
+    }
+
+    switch (p_spec->type)
+    {
+    case SF_CONSOLE_ARG_TYPE_INT:
+    {
+        long value = strtol(p_text, &p_converted, 10);
+        if ((p_converted != p_end) || (value < INT32_MIN) || (value > INT32_MAX) ||
+            (((LONG_MIN == value) || (LONG_MAX == value)) && (ERANGE == errno)))
+        {
+            return false;
+        }
+        p_arg->value.integer = (int32_t) value;
+        break;
+    }
+    case SF_CONSOLE_ARG_TYPE_FLOAT:
+    {
+        p_arg->value.real = strtof(p_text, &p_converted);
+        if (p_converted != p_end)
+        {
+            return false;
+        }
+        break;
+    }
+    case SF_CONSOLE_ARG_TYPE_HEX:
+    {
+        /** strtoul would take a sign, so the argument has to start with a digit. */
+        if (!isxdigit((int32_t) p_arg->p_text[0]))
+        {
+            return false;
+        }
+        unsigned long value = strtoul(p_text, &p_converted, 16);
+        if ((p_converted != p_end) || (value > UINT32_MAX) || ((ULONG_MAX == value) && (ERANGE == errno)))
+        {
+            return false;
+        }
+        p_arg->value.hex = (uint32_t) value;
+        break;
+    }
+    case SF_CONSOLE_ARG_TYPE_ENUM:
+    {
+        for (uint32_t i = 0U; i < p_spec->num_choices; i++)
+        {
+            uint8_t const * p_choice = p_spec->p_choices[i];
+            if ((strlen((char const *) p_choice) == p_arg->length) &&
+                check_for_prefix(p_arg->p_text, p_choice, p_arg->length))
+            {
+                p_arg->value.choice = i;
+                return true;
+            }
+        }
+        return false;
+    }
+    case SF_CONSOLE_ARG_TYPE_STRING:
+    default:
+    {
+        /* Any text will do. */
+        break;
+    }
+    }
+
+    return true;
+}  /* End of function sf_console_argument_convert */
+
+/******************************************************************************************************************//**
+* @brief  Reports command line arguments that do not match the argument specs of a command, followed by its usage.
+* @param[in]  p_ctrl     Console control block
+* @param[in]  p_command  Command the arguments were given to
+* @param[in]  p_argv     Arguments as split by SF_CONSOLE_ArgumentsParse
+* @param[in]  arg        Index SF_CONSOLE_ArgumentsParse returned in p_argc
+* @param[in]  err        Error SF_CONSOLE_ArgumentsParse returned
+***********************************************************************************************************************/
+static void sf_console_arguments_error(sf_console_instance_ctrl_t       * const p_ctrl,
+                                       sf_console_command_t       const * const p_command,
+                                       sf_console_arg_t           const * const p_argv,
+                                       uint32_t                           const arg,
+                                       uint32_t                           const err)
+{
+    sf_console_arg_spec_t const * p_specs = p_command->p_arg_specs;
+
+    /** Keep the message and the usage together on the terminal. */
+    if (FSP_SUCCESS != p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT))
+    {
+        return;
+    }
+
+    if (FSP_ERR_INVALID_ARGUMENT == err)
+    {
+        static char const * const type_names[] =
+        {
+            [SF_CONSOLE_ARG_TYPE_INT]    = "an integer",
+            [SF_CONSOLE_ARG_TYPE_FLOAT]  = "a number",
+            [SF_CONSOLE_ARG_TYPE_HEX]    = "a hex number",
+            [SF_CONSOLE_ARG_TYPE_STRING] = "text",
+            [SF_CONSOLE_ARG_TYPE_ENUM]   = "one of",
+        };
+        SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "Invalid %s \"%.*s\", expected %s",
+                               (char const *) p_specs[arg].name, (int) p_argv[arg].length,
+                               (char const *) p_argv[arg].p_text, type_names[p_specs[arg].type]);
+        if (SF_CONSOLE_ARG_TYPE_ENUM == p_specs[arg].type)
+        {
+            for (uint32_t i = 0U; i < p_specs[arg].num_choices; i++)
+            {
+                SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "%s %s", (0U == i) ? "" : ",",
+                                       (char const *) p_specs[arg].p_choices[i]);
+            }
+        }
+        SF_CONSOLE_Write(p_ctrl, (uint8_t const *) "\r\n", SF_CONSOLE_PRV_TIMEOUT);
+    }
+    else if (FSP_ERR_INSUFFICIENT_DATA == err)
+    {
+        SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "Missing %s\r\n", (char const *) p_specs[arg].name);
+    }
+    else
+    {
+        SF_CONSOLE_Write(p_ctrl, (uint8_t const *) "Too many arguments\r\n", SF_CONSOLE_PRV_TIMEOUT);
+    }
+
+    SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "USAGE: %s", (char const *) p_command->command);
+    for (uint32_t i = 0U; i < p_command->num_arg_specs; i++)
+    {
+        SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, p_specs[i].optional ? " [%s]" : " <%s>",
+                               (char const *) p_specs[i].name);
+    }
+    SF_CONSOLE_Write(p_ctrl, (uint8_t const *) "\r\n", SF_CONSOLE_PRV_TIMEOUT);
+
+    p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+}  /* End of function sf_console_arguments_error */
+
+/******************************************************************************************************************//**
+* @brief  Adds the commands of a menu that start with a prefix to the echo frame, in command list order.
+* @param[in]  p_ctrl       Console control block holding the frame
+* @param[in]  p_menu       Menu to search
+* @param[in]  p_prefix     Prefix the commands start with
+* @param[in]  length       Length of the prefix
+* @param[in]  limit        Most commands to add
+* @param[in]  p_separator  String added between commands
+* @return  Number of commands added
+***********************************************************************************************************************/
+static uint32_t sf_console_list_matches(sf_console_instance_ctrl_t       * const p_ctrl,
+                                        sf_console_menu_t          const * const p_menu,
+                                        uint8_t                    const * const p_prefix,
+                                        uint32_t                           const length,
+                                        uint32_t                           const limit,
+                                        char                       const * const p_separator)
+{
+    uint32_t count = 0U;
+    for (uint32_t i = 0U; (i < p_menu->num_commands) && (count < limit); i++)
+    {
+        uint8_t const * p_command = p_menu->command_list[i].command;
+        if ((NULL == p_command) || (NULL_CODE == p_command[0]) || !check_for_prefix(p_prefix, p_command, length))
+        {
+            continue;
+        }
+
+        if (count > 0U)
+        {
+            frame_append(p_ctrl, (uint8_t const *) p_separator, (uint32_t) strlen(p_separator));
+        }
+        frame_append(p_ctrl, p_command, (uint32_t) strlen((char const *) p_command));
+        count++;
+    }
+
+    return count;
+}  /* End of function sf_console_list_matches */
+
+/******************************************************************************************************************//**
+* @brief  Suggests commands for an unsupported input line, those sharing the longest start with it.
+* @param[in]  p_ctrl       Console control block
+* @param[in]  p_menu       Menu the line was parsed in
+* @param[in]  p_input      Input line, NULL terminated
+* @retval     FSP_SUCCESS  Suggestions were written, or there were none.
+* @return                  See @ref Common_Error_Codes or lower level drivers for other possible return codes.
+***********************************************************************************************************************/
+static uint32_t sf_console_suggest(sf_console_instance_ctrl_t       * const p_ctrl,
+                                   sf_console_menu_t          const * const p_menu,
+                                   uint8_t                    const * const p_input)
+{
+    uint32_t start;
+    sf_console_menu_t const * p_last = sf_console_resolve_menu(p_ctrl, p_menu, p_input, &start);
+
+    sf_console_completion_t completion;
+    sf_console_complete(p_ctrl, p_last, &p_input[start], (uint32_t) strlen((char const *) &p_input[start]),
+                        &completion);
+    if (0U == completion.matched)
+    {
+        return FSP_SUCCESS;
+    }
+
+    /** Keep the suggestions together on the terminal. */
+    uint32_t err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
+    SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+    static const char did_you_mean[] = "Did you mean ";
+    frame_append(p_ctrl, (uint8_t const *) did_you_mean, sizeof(did_you_mean) - 1U);
+    sf_console_list_matches(p_ctrl, p_last, &p_input[start], completion.matched, SF_CONSOLE_CFG_MAX_SUGGESTIONS, ", ");
+    frame_append(p_ctrl, (uint8_t const *) "?\r\n", 3U);
+    err = frame_send(p_ctrl);
+
+    p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+
+    return err;
+}  /* End of function sf_console_suggest */
+
+/******************************************************************************************************************//**
+* @brief  Deletes character at input index and shifts the rest of the string left.
+* @pre    Lock the UART framework before calling this function.
+* @param[in]      p_ctrl        Console control block, used to print to the console if echo mode is on.
+* @param[in,out]  p_input       Input string to remove character from.
+* @param[in]      index         Index of character to remove
+* @param[in,out]  p_last_index  Index after the last valid character in the input string.
+* @retval         FSP_SUCCESS   Deleting characters from console is processed successfully.
+* @return                       See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t delete_char(sf_console_instance_ctrl_t * p_ctrl, uint8_t * p_input, uint32_t index, uint32_t * p_last_index)
+{
+    /** Character can only be deleted if it is not the last character (index < last_index) */
+    uint32_t last_index = *p_last_index;
+    if (index < last_index)
+    {
+        /* Save start pointer to print it later. */
+        uint8_t * p_start = &p_input[index];
+
+        /** Shift characters left in input string */
+        while (index < (last_index - 1))
+        {
+            p_input[index] = p_input[index + 1];
+            index++;
+        }
+
+        /** Store a space at the end to erase the last character on the terminal */
+        p_input[index] = SPACE_CODE;
+        p_input[last_index] = NULL_CODE;
+        if (p_ctrl->echo)
+        {
+            /* Print shifted string, then move cursor back to start index. */
+            uint32_t length = strlen((char *) p_start);
+            frame_append(p_ctrl, p_start, length);
+            move_cursor(p_ctrl, SF_CONSOLE_CURSOR_DIR_LEFT, length);
+        }
+        p_input[index] = NULL_CODE;
+        last_index--;
+        *p_last_index = last_index;
+        if ((0U == last_index) && (p_ctrl->echo))
+        {
+            /** Unlock transmission to allow debug messages if there is no input.  Only needed when echo is on.  The
+             *  redraw goes out first, while transmission is still held. */
+            frame_send(p_ctrl);
+            uint32_t err = p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+            SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+        }
+    }
+
+    return FSP_SUCCESS;
+} /* End of function delete_char */
+
+/******************************************************************************************************************//**
+* @brief  Inserts character at input index and shifts the rest of the string right.
+* @pre    Lock the UART framework before calling this function.
+* @param[in]  p_ctrl       Console control block, used to print to the console if echo mode is on.
+* @param[in]  p_input      Input string to insert character into.
+* @param[in]  ch           Character to insert
+* @param[in]  index        Index to insert character
+* @param[in]  last_index   Index after the last valid character in the input string.  This will be the index of the last
+*                          valid character in the string after this function is complete.
+* @retval     FSP_SUCCESS  Character has been inserted or processed successfully.
+* @return                  See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t insert_char(sf_console_instance_ctrl_t * const p_ctrl,
                              uint8_t                    * const p_input,
                              uint8_t                            ch,
                              uint32_t                           index,
                              uint32_t                           last_index)
 {
-    /* Save start pointer to print it later. */
-    uint8_t * p_start = &p_input[index];
+    /* Save start pointer to print it later. */
+    uint8_t * p_start = &p_input[index];
+
+    /** Shift characters right in input string */
+    uint32_t temp = last_index;
+    while (temp > index)
+    {
+        p_input[temp] = p_input[temp - 1];
+        temp--;
+    }
+
+    /** Insert character */
+    p_input[index] = ch;
+
+    /** Add a null character to terminate the string. */
+    p_input[last_index + 1] = NULL_CODE;
+    if (p_ctrl->echo)
+    {
+        /* Print shifted string, then move cursor back to index after inserted character. */
+        uint32_t err;
+        if (0U == last_index)
+        {
+            /** When the first byte is received, lock transmission if echo is on. */
+            err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
+            SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+        }
+        uint32_t length = strlen((char *) p_start);
+        frame_append(p_ctrl, p_start, length);
+        move_cursor(p_ctrl, SF_CONSOLE_CURSOR_DIR_LEFT, length - 1U);
+    }
+
+    return FSP_SUCCESS;
+} /* End of function insert_char */
+
+/******************************************************************************************************************//**
+* @brief  Moves cursor in the direction specified by the number of spaces specified.
+* @note   Adds a single escape code with a count to the echo frame, which frame_send writes out.
+* @pre    Lock the UART framework before calling this function.
+* @param[in]  p_ctrl       Console control block, used to print to the console if echo mode is on.
+* @param[in]  dir         Select to move cursor right, left, or up by lines.
+* @param[in]  num_spaces  Number of spaces or lines to move cursor.
+***********************************************************************************************************************/
+static void move_cursor(sf_console_instance_ctrl_t * p_ctrl, sf_console_cursor_dir_t dir, uint32_t num_spaces)
+{
+    if ((p_ctrl->echo) && (num_spaces > 0U))
+    {
+        /** Prepare escape code to send, "ESC [ n D".  The count is left out for a single space. */
+        uint8_t buf[16];
+        uint32_t length = 0U;
+        buf[length++] = ESC_CODE_1;
+        buf[length++] = ESC_CODE_2;
+        if (num_spaces > 1U)
+        {
+            uint8_t digits[10];
+            uint32_t num_digits = 0U;
+            do
+            {
+                digits[num_digits++] = (uint8_t) ('0' + (num_spaces % 10U));
+                num_spaces /= 10U;
+            } while (num_spaces > 0U);
+
+            while (num_digits > 0U)
+            {
+                buf[length++] = digits[--num_digits];
+            }
+        }
+        if (SF_CONSOLE_CURSOR_DIR_LEFT == dir)
+        {
+            buf[length++] = LEFT_ARROW_CODE;
+        }
+        else if (SF_CONSOLE_CURSOR_DIR_UP == dir)
+        {
+            buf[length++] = UP_ARROW_CODE;
+        }
+        else
+        {
+            /* SF_CONSOLE_CURSOR_DIR_RIGHT == dir */
+            buf[length++] = RIGHT_ARROW_CODE;
+        }
+
+        frame_append(p_ctrl, &buf[0], length);
+    }
+} /* End of function move_cursor */
+
+/******************************************************************************************************************//**
+* @brief  Adds echo output to the frame for the current keystroke.
+* @note   If the frame is full it is written out early, so output is never lost.
+* @param[in]  p_ctrl      Console control block holding the frame
+* @param[in]  p_src       Bytes to add
+* @param[in]  bytes       Number of bytes to add
+***********************************************************************************************************************/
+static void frame_append(sf_console_instance_ctrl_t * p_ctrl, uint8_t const * p_src, uint32_t bytes)
+{
+    while (bytes > 0U)
+    {
+        if (SF_CONSOLE_FRAME_LENGTH == p_ctrl->frame_length)
+        {
+            frame_send(p_ctrl);
+        }
+
+        uint32_t chunk = SF_CONSOLE_FRAME_LENGTH - p_ctrl->frame_length;
+        if (chunk > bytes)
+        {
+            chunk = bytes;
+        }
+
+        memcpy(&p_ctrl->frame[p_ctrl->frame_length], p_src, chunk);
+        p_ctrl->frame_length += chunk;
+        p_src += chunk;
+        bytes -= chunk;
+    }
+} /* End of function frame_append */
+
+/******************************************************************************************************************//**
+* @brief  Writes the echo frame to the console in one transfer and empties it.
+* @param[in]  p_ctrl      Console control block holding the frame
+* @retval     FSP_SUCCESS The frame was written or was empty.
+* @return                 See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t frame_send(sf_console_instance_ctrl_t * p_ctrl)
+{
+    uint32_t err = FSP_SUCCESS;
+
+    if (p_ctrl->frame_length > 0U)
+    {
+        err = p_ctrl->p_comms->p_api->write(p_ctrl->p_comms->p_ctrl, &p_ctrl->frame[0], p_ctrl->frame_length,
+                                            SF_CONSOLE_PRV_TIMEOUT);
+        p_ctrl->frame_length = 0U;
+    }
+
+    return err;
+} /* End of function frame_send */
+
+/******************************************************************************************************************//**
+* @brief  Formats a printf style format string into the scratch buffer, writing the buffer out as it fills.
+* @param[in]  p_ctrl      Console control block holding the scratch buffer
+* @param[in]  p_format    Format string
+* @param[in]  p_args      Arguments of the format string
+* @retval     FSP_SUCCESS The output was formatted.
+* @return                 See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t sf_console_format(sf_console_instance_ctrl_t * const p_ctrl,
+                                  char                 const *       p_format,
+                                  va_list                    * const p_args)
+{
+    uint32_t err = FSP_SUCCESS;
+
+    while (NULL_CODE != (uint8_t) *p_format)
+    {
+        /** Text up to the next conversion is copied as is. */
+        char const * p_percent = strchr(p_format, '%');
+        uint32_t literal = (NULL == p_percent) ? (uint32_t) strlen(p_format) : (uint32_t) (p_percent - p_format);
+        uint32_t put_err = format_put(p_ctrl, p_format, literal);
+        SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == put_err, put_err);
+        p_format += literal;
+
+        if (NULL != p_percent)
+        {
+            /** A conversion that cannot be formatted is remembered, and the rest of the output is still written. */
+            uint32_t conversion_err = format_conversion(p_ctrl, &p_format, p_args);
+            if (FSP_SUCCESS == err)
+            {
+                err = conversion_err;
+            }
+        }
+    }
+
+    return err;
+} /* End of function sf_console_format */
+
+/******************************************************************************************************************//**
+* @brief  Formats one conversion specification and the argument it consumes.
+* @note   Strings and characters are padded here so they can be longer than the scratch buffer.  Integer arguments are
+*         widened to intmax_t or uintmax_t, and the specification is rebuilt with the matching length modifier and
+*         any '*' width or precision filled in, so a single snprintf call formats each numeric conversion.
+* @param[in]     p_ctrl      Console control block holding the scratch buffer
+* @param[in,out] pp_format   Points to the '%' starting the specification, moved past the end of it
+* @param[in]     p_args      Arguments of the format string
+* @retval        FSP_SUCCESS The conversion was formatted.
+* @return                    See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t format_conversion(sf_console_instance_ctrl_t * const p_ctrl,
+                                  char                 const **      pp_format,
+                                  va_list                    * const p_args)
+{
+    char const * p_start    = *pp_format;
+    char const * p_format   = p_start + 1;
+    char         spec[SF_CONSOLE_PRV_FORMAT_SPEC_LENGTH];
+    uint32_t     spec_length = 0U;
+    bool         left       = false;
+    int          width      = -1;
+    int          precision  = -1;
+    char         modifier[3] = { 0 };
+
+    spec[spec_length++] = '%';
+
+    /** Flags, each one is kept once. */
+    while ((NULL_CODE != (uint8_t) *p_format) && (NULL != strchr("-+ #0", *p_format)))
+    {
+        if (NULL == memchr(&spec[1], *p_format, spec_length - 1U))
+        {
+            spec[spec_length++] = *p_format;
+        }
+        left = left || ('-' == *p_format);
+        p_format++;
+    }
+
+    /** Width.  A negative '*' width is a '-' flag followed by a positive width. */
+    if ('*' == *p_format)
+    {
+        width = va_arg(*p_args, int);
+        if (width < 0)
+        {
+            left = true;
+            width = (width < -0xFFFF) ? 0xFFFF : -width;
+            spec[spec_length++] = '-';
+        }
+        width = (width > 0xFFFF) ? 0xFFFF : width;
+        p_format++;
+    }
+    else
+    {
+        while (isdigit((uint8_t) *p_format))
+        {
+            width = ((width < 0) ? 0 : (width * 10)) + (*p_format - '0');
+            width = (width > 0xFFFF) ? 0xFFFF : width;
+            p_format++;
+        }
+    }
+
+    /** Precision.  A negative '*' precision is treated as if no precision was given. */
+    if ('.' == *p_format)
+    {
+        p_format++;
+        precision = 0;
+        if ('*' == *p_format)
+        {
+            precision = va_arg(*p_args, int);
+            precision = (precision > 0xFFFF) ? 0xFFFF : precision;
+            p_format++;
+        }
+        else
+        {
+            while (isdigit((uint8_t) *p_format))
+            {
+                precision = (precision * 10) + (*p_format - '0');
+                precision = (precision > 0xFFFF) ? 0xFFFF : precision;
+                p_format++;
+            }
+        }
+    }
+
+    /** Length modifier. */
+    for (uint32_t i = 0U; (i < 2U) && (NULL_CODE != (uint8_t) *p_format) && (NULL != strchr("hljztL", *p_format)); i++)
+    {
+        modifier[i] = *p_format;
+        p_format++;
+    }
+
+    char conversion = *p_format;
+    if (NULL_CODE != (uint8_t) conversion)
+    {
+        p_format++;
+    }
+    *pp_format = p_format;
+
+    if (width >= 0)
+    {
+        spec_length += (uint32_t) snprintf(&spec[spec_length], sizeof(spec) - spec_length, "%d", width);
+    }
+    if (precision >= 0)
+    {
+        spec_length += (uint32_t) snprintf(&spec[spec_length], sizeof(spec) - spec_length, ".%d", precision);
+    }
+
+    /** Strings and characters are written directly, padded to the width. */
+    if (('s' == conversion) || ('c' == conversion))
+    {
+        char         ch = 0;
+        char const * p_str = &ch;
+        uint32_t     length = 1U;
+
+        if ('s' == conversion)
+        {
+            p_str = va_arg(*p_args, char const *);
+            if (NULL == p_str)
+            {
+                p_str = "(null)";
+            }
+            char const * p_end = (precision >= 0) ? memchr(p_str, NULL_CODE, (size_t) precision) : NULL;
+            length = (precision < 0) ? (uint32_t) strlen(p_str) :
+                     ((NULL == p_end) ? (uint32_t) precision : (uint32_t) (p_end - p_str));
+        }
+        else
+        {
+            ch = (char) va_arg(*p_args, int);
+        }
+
+        uint32_t padding = ((width > 0) && ((uint32_t) width > length)) ? ((uint32_t) width - length) : 0U;
+        uint32_t err = FSP_SUCCESS;
+        if (!left)
+        {
+            err = format_pad(p_ctrl, padding);
+        }
+        if (FSP_SUCCESS == err)
+        {
+            err = format_put(p_ctrl, p_str, length);
+        }
+        if ((FSP_SUCCESS == err) && left)
+        {
+            err = format_pad(p_ctrl, padding);
+        }
+        return err;
+    }
+
+    /** Numeric conversions take the argument type given by the length modifier. */
+    sf_console_format_value_t value;
+    bool     longlong = ('l' == modifier[0]) && ('l' == modifier[1]);
+    bool     shortshort = ('h' == modifier[0]) && ('h' == modifier[1]);
+    switch (conversion)
+    {
+        case 'd':
+        case 'i':
+            value.type = SF_CONSOLE_FORMAT_TYPE_SIGNED;
+            switch (modifier[0])
+            {
+                case 'l': value.value.s = longlong ? va_arg(*p_args, long long) : va_arg(*p_args, long); break;
+                case 'j': value.value.s = va_arg(*p_args, intmax_t); break;
+                case 'z': value.value.s = (intmax_t) (ptrdiff_t) va_arg(*p_args, size_t); break;
+                case 't': value.value.s = va_arg(*p_args, ptrdiff_t); break;
+                case 'h': value.value.s = shortshort ? (signed char) va_arg(*p_args, int) :
+                                                       (short) va_arg(*p_args, int); break;
+                default:  value.value.s = va_arg(*p_args, int); break;
+            }
+            break;
+
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            value.type = SF_CONSOLE_FORMAT_TYPE_UNSIGNED;
+            switch (modifier[0])
+            {
+                case 'l': value.value.u = longlong ? va_arg(*p_args, unsigned long long) :
+                                                     va_arg(*p_args, unsigned long); break;
+                case 'j': value.value.u = va_arg(*p_args, uintmax_t); break;
+                case 'z': value.value.u = va_arg(*p_args, size_t); break;
+                case 't': value.value.u = (uintmax_t) (size_t) va_arg(*p_args, ptrdiff_t); break;
+                case 'h': value.value.u = shortshort ? (unsigned char) va_arg(*p_args, unsigned int) :
+                                                       (unsigned short) va_arg(*p_args, unsigned int); break;
+                default:  value.value.u = va_arg(*p_args, unsigned int); break;
+            }
+            break;
+
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if ('L' == modifier[0])
+            {
+                value.type = SF_CONSOLE_FORMAT_TYPE_LONG_DOUBLE;
+                value.value.ld = va_arg(*p_args, long double);
+            }
+            else
+            {
+                value.type = SF_CONSOLE_FORMAT_TYPE_DOUBLE;
+                value.value.d = va_arg(*p_args, double);
+            }
+            break;
+
+        case 'p':
+            value.type = SF_CONSOLE_FORMAT_TYPE_POINTER;
+            value.value.p = va_arg(*p_args, void *);
+            break;
+
+        case '%':
+            return format_put(p_ctrl, "%", 1U);
+
+        case 'n':
+            /** Storing the number of characters written is not supported, the pointer is skipped. */
+            (void) va_arg(*p_args, void *);
+            return FSP_ERR_INVALID_ARGUMENT;
+
+        default:
+            /** Unknown conversions are written out unchanged. */
+            format_put(p_ctrl, p_start, (uint32_t) (p_format - p_start));
+            return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    if (SF_CONSOLE_FORMAT_TYPE_LONG_DOUBLE == value.type)
+    {
+        spec[spec_length++] = 'L';
+    }
+    else if ((SF_CONSOLE_FORMAT_TYPE_SIGNED == value.type) || (SF_CONSOLE_FORMAT_TYPE_UNSIGNED == value.type))
+    {
+        spec[spec_length++] = 'j';
+    }
+    spec[spec_length++] = conversion;
+    spec[spec_length] = '\0';
+
+    return format_value(p_ctrl, &spec[0], &value);
+} /* End of function format_conversion */
+
+/******************************************************************************************************************//**
+* @brief  Formats a numeric argument into the scratch buffer.  When it does not fit in the space left, the buffer is
+*         written out and the argument is formatted again at the start of the buffer.
+* @param[in]  p_ctrl      Console control block holding the scratch buffer
+* @param[in]  p_spec      Conversion specification with a length modifier matching the type of p_value
+* @param[in]  p_value     Argument to format
+* @retval     FSP_SUCCESS           The argument was formatted.
+* @retval     FSP_ERR_INVALID_SIZE  The formatted argument is longer than the whole buffer, the start of it was kept.
+* @return                 See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t format_value(sf_console_instance_ctrl_t      * const p_ctrl,
+                             char                      const * const p_spec,
+                             sf_console_format_value_t const * const p_value)
+{
+    while (true)
+    {
+        char   * p_dest = (char *) &p_ctrl->format_buffer[p_ctrl->format_length];
+        uint32_t space  = SF_CONSOLE_CFG_FORMAT_BUFFER_LENGTH - p_ctrl->format_length;
+        int      length = -1;
+
+        switch (p_value->type)
+        {
+            case SF_CONSOLE_FORMAT_TYPE_SIGNED:   length = snprintf(p_dest, space, p_spec, p_value->value.s); break;
+            case SF_CONSOLE_FORMAT_TYPE_UNSIGNED: length = snprintf(p_dest, space, p_spec, p_value->value.u); break;
+            case SF_CONSOLE_FORMAT_TYPE_DOUBLE:   length = snprintf(p_dest, space, p_spec, p_value->value.d); break;
+            case SF_CONSOLE_FORMAT_TYPE_LONG_DOUBLE:
+                                                  length = snprintf(p_dest, space, p_spec, p_value->value.ld); break;
+            default:                              length = snprintf(p_dest, space, p_spec, p_value->value.p); break;
+        }
+        SF_CONSOLE_ERROR_RETURN(length >= 0, FSP_ERR_INVALID_ARGUMENT);
+
+        /** snprintf also stores a terminator, so the output only fits when it is shorter than the space. */
+        if ((uint32_t) length < space)
+        {
+            p_ctrl->format_length += (uint32_t) length;
+            return FSP_SUCCESS;
+        }
+
+        if (0U == p_ctrl->format_length)
+        {
+            p_ctrl->format_length = space - 1U;
+            SF_CONSOLE_ERROR_RETURN(false, FSP_ERR_INVALID_SIZE);
+        }
+
+        uint32_t err = format_flush(p_ctrl);
+        SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+    }
+} /* End of function format_value */
+
+/******************************************************************************************************************//**
+* @brief  Adds bytes to the scratch buffer.  If they do not fit, the buffer is written out first, and data longer than
+*         the whole buffer is written directly without being copied.
+* @param[in]  p_ctrl      Console control block holding the scratch buffer
+* @param[in]  p_src       Bytes to add
+* @param[in]  bytes       Number of bytes to add
+* @retval     FSP_SUCCESS The bytes were added or written.
+* @return                 See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t format_put(sf_console_instance_ctrl_t * const p_ctrl, char const * const p_src, uint32_t const bytes)
+{
+    uint32_t err = FSP_SUCCESS;
+
+    if (bytes > (SF_CONSOLE_CFG_FORMAT_BUFFER_LENGTH - p_ctrl->format_length))
+    {
+        err = format_flush(p_ctrl);
+        SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+        if (bytes > SF_CONSOLE_CFG_FORMAT_BUFFER_LENGTH)
+        {
+            return SF_CONSOLE_WriteN(p_ctrl, (uint8_t const *) p_src, bytes, SF_CONSOLE_PRV_TIMEOUT);
+        }
+    }
+
+    memcpy(&p_ctrl->format_buffer[p_ctrl->format_length], p_src, bytes);
+    p_ctrl->format_length += bytes;
+
+    return err;
+} /* End of function format_put */
+
+/******************************************************************************************************************//**
+* @brief  Adds spaces to the scratch buffer.
+* @param[in]  p_ctrl      Console control block holding the scratch buffer
+* @param[in]  count       Number of spaces to add
+* @retval     FSP_SUCCESS The spaces were added.
+* @return                 See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t format_pad(sf_console_instance_ctrl_t * const p_ctrl, uint32_t count)
+{
+    while (count > 0U)
+    {
+        uint32_t chunk = (count > sizeof(g_white_space)) ? sizeof(g_white_space) : count;
+        uint32_t err = format_put(p_ctrl, (char const *) &g_white_space[0], chunk);
+        SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+        count -= chunk;
+    }
+
+    return FSP_SUCCESS;
+} /* End of function format_pad */
+
+/******************************************************************************************************************//**
+* @brief  Writes the scratch buffer to the console in one transfer and empties it.
+* @param[in]  p_ctrl      Console control block holding the scratch buffer
+* @retval     FSP_SUCCESS The buffer was written or was empty.
+* @return                 See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t format_flush(sf_console_instance_ctrl_t * const p_ctrl)
+{
+    uint32_t err = FSP_SUCCESS;
+
+    if (p_ctrl->format_length > 0U)
+    {
+        err = SF_CONSOLE_WriteN(p_ctrl, &p_ctrl->format_buffer[0], p_ctrl->format_length, SF_CONSOLE_PRV_TIMEOUT);
+        p_ctrl->format_length = 0U;
+    }
+
+    return err;
+} /* End of function format_flush */
+
+/******************************************************************************************************************//**
+* @brief  Prints help menu to console.
+* @note   When the control block has help memory, the help is rendered into it on the first request for a menu and
+*         later requests for the same menu are a single write.  Help that does not fit is streamed instead.
+* @param[in]  p_ctrl      Console control block, used to print to the console if echo mode is on.
+* @param[in]  p_menu      Menu to print help for.
+* @param[in]  timeout     Timeout value
+* @retval FSP_SUCCESS     Prints help menu to console successfully.
+* @return                 See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t print_help_menu(sf_console_instance_ctrl_t * const p_ctrl, sf_console_menu_t const * const p_menu,
+        UINT timeout)
+{
+    /** Lock console UART channel to reserve exclusive access for multiple writes */
+    uint32_t err;
+    err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, timeout);
+    SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+    sf_console_help_cache_t * p_help = &p_ctrl->help;
+    bool back_options = (NULL != p_ctrl->p_current_menu->menu_prev);
+
+    /** Render the help again if the kept help is for another menu or the command list of the menu changed. */
+    if ((NULL != p_help->p_buffer) &&
+        ((p_help->p_menu != p_menu) || (p_help->p_command_list != p_menu->command_list) ||
+         (p_help->num_commands != p_menu->num_commands) || (p_help->back_options != back_options)))
+    {
+        p_help->p_menu = p_menu;
+        p_help->p_command_list = p_menu->command_list;
+        p_help->num_commands = p_menu->num_commands;
+        p_help->back_options = back_options;
+        p_help->length = 0U;
+        if (FSP_SUCCESS != help_render(p_ctrl, p_menu, back_options, true))
+        {
+            p_help->length = 0U;
+        }
+    }
+
+    if ((NULL != p_help->p_buffer) && (p_help->length > 0U))
+    {
+        err = SF_CONSOLE_WriteN(p_ctrl, p_help->p_buffer, p_help->length, SF_CONSOLE_PRV_TIMEOUT);
+    }
+    else
+    {
+        /** Without help memory, or if the help does not fit in it, stream it through the scratch buffer. */
+        p_ctrl->format_length = 0U;
+        err = help_render(p_ctrl, p_menu, back_options, false);
+        uint32_t flush_err = format_flush(p_ctrl);
+        if (FSP_SUCCESS == err)
+        {
+            err = flush_err;
+        }
+    }
+
+    /** Unlock console UART channel after all writes are complete. */
+    p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+
+    return err;
+} /* End of function print_help_menu */
+
+/******************************************************************************************************************//**
+* @brief  Renders the help menu, either into the help memory of the control block or through the scratch buffer.
+* @param[in]  p_ctrl        Console control block
+* @param[in]  p_menu        Menu to render help for.
+* @param[in]  back_options  Whether to include the root and previous menu options.
+* @param[in]  keep          true to render into the help memory, false to write the help to the console.
+* @retval FSP_SUCCESS                  The help was rendered.
+* @retval FSP_ERR_INSUFFICIENT_SPACE   The help does not fit in the help memory.
+* @return                 See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t help_render(sf_console_instance_ctrl_t * const p_ctrl,
+                            sf_console_menu_t    const * const p_menu,
+                            bool                               back_options,
+                            bool                               keep)
+{
+    uint32_t err = FSP_SUCCESS;
+
+    /** Print "<MENU_NAME> Help Menu" indented by 2 spaces. */
+    help_put(p_ctrl, (uint8_t const *) "  ", keep, &err);
+    help_put(p_ctrl, p_menu->menu_name, keep, &err);
+    help_put(p_ctrl, (uint8_t const *) " Help Menu\r\n", keep, &err);
+
+    /** If it is possible to go back one menu, print this option and the home option. */
+    if (back_options)
+    {
+        help_put(p_ctrl, (uint8_t const *) "    ", keep, &err);
+        help_put(p_ctrl, SF_CONSOLE_ROOT_MENU_COMMAND, keep, &err);
+        help_put(p_ctrl, (uint8_t const *) " : Back to root menu\r\n    ", keep, &err);
+        help_put(p_ctrl, SF_CONSOLE_MENU_PREVIOUS_COMMAND, keep, &err);
+        help_put(p_ctrl, (uint8_t const *) " : Up one menu level\r\n", keep, &err);
+    }
+
+    /** Previous lines can be listed and recalled if history is kept. */
+    if (NULL != p_ctrl->history.p_buffer)
+    {
+        help_put(p_ctrl, (uint8_t const *) "    ", keep, &err);
+        help_put(p_ctrl, SF_CONSOLE_HISTORY_COMMAND, keep, &err);
+        help_put(p_ctrl, (uint8_t const *) " : List previous commands. Recall one with !<number>, or !! for the last\r\n",
+                 keep, &err);
+    }
+
+    /** Scripts can be run if there is batch memory. */
+    if (NULL != p_ctrl->batch.p_buffer)
+    {
+        help_put(p_ctrl, (uint8_t const *) "    ", keep, &err);
+        help_put(p_ctrl, SF_CONSOLE_SOURCE_COMMAND, keep, &err);
+        help_put(p_ctrl, (uint8_t const *) " : Run the commands in a file and report how each did. USAGE: source <file>\r\n",
+                 keep, &err);
+    }
+
+    /** Commands are timed if the menus keep statistics. */
+    if (NULL != sf_console_menu_root(p_menu)->p_stats)
+    {
+        help_put(p_ctrl, (uint8_t const *) "    ", keep, &err);
+        help_put(p_ctrl, SF_CONSOLE_PERF_COMMAND, keep, &err);
+        help_put(p_ctrl, (uint8_t const *) " : Show how long each command took. USAGE: perf [reset]\r\n", keep, &err);
+    }
+
+    /** Tables can be rendered for scripts as well as for people. */
+    help_put(p_ctrl, (uint8_t const *) "    ", keep, &err);
+    help_put(p_ctrl, SF_CONSOLE_OUTPUT_COMMAND, keep, &err);
+    help_put(p_ctrl, (uint8_t const *) " : Show or choose how tables are rendered. USAGE: output [text|csv|json]\r\n",
+             keep, &err);
+
+    /** Commands can be run again every interval. */
+    help_put(p_ctrl, (uint8_t const *) "    ", keep, &err);
+    help_put(p_ctrl, SF_CONSOLE_WATCH_COMMAND, keep, &err);
+    help_put(p_ctrl, (uint8_t const *) " : Run a command every interval until a key is pressed. USAGE: watch <seconds> <command>\r\n",
+             keep, &err);
+
+    /** Output can be filtered. */
+    help_put(p_ctrl, (uint8_t const *) "    <command> | ", keep, &err);
+    help_put(p_ctrl, SF_CONSOLE_PIPE_GREP, keep, &err);
+    help_put(p_ctrl, (uint8_t const *) " [-v] <text>, ", keep, &err);
+    help_put(p_ctrl, SF_CONSOLE_PIPE_HEAD, keep, &err);
+    help_put(p_ctrl, (uint8_t const *) " <lines>, ", keep, &err);
+    help_put(p_ctrl, SF_CONSOLE_PIPE_COUNT, keep, &err);
+    help_put(p_ctrl, (uint8_t const *) " : Filter the output of a command, filters can be chained\r\n", keep, &err);
+
+    /** Host tools can switch to binary frames if allowed. */
+    if (p_ctrl->rpc.enabled)
+    {
+        help_put(p_ctrl, (uint8_t const *) "    ", keep, &err);
+        help_put(p_ctrl, SF_CONSOLE_RPC_COMMAND, keep, &err);
+        help_put(p_ctrl, (uint8_t const *) " : Switch to binary request frames for host tools\r\n", keep, &err);
+    }
+
+    /** Commands flagged asynchronous run on the worker pool, which can be listed and waited for. */
+    if (NULL != p_ctrl->p_jobs)
+    {
+        help_put(p_ctrl, (uint8_t const *) "    ", keep, &err);
+        help_put(p_ctrl, SF_CONSOLE_JOBS_COMMAND, keep, &err);
+        help_put(p_ctrl, (uint8_t const *) " : List commands running in the background\r\n    ", keep, &err);
+        help_put(p_ctrl, SF_CONSOLE_WAIT_COMMAND, keep, &err);
+        help_put(p_ctrl, (uint8_t const *) " : Wait for a background command. USAGE: wait <id>\r\n", keep, &err);
+    }
+
+    /** Print each command followed by the associated help string if one is provided. Commands are
+     *  indented by 4 spaces and followed by carriage return and newline characters. */
+    for (uint32_t i = 0U; i < p_menu->num_commands; i++)
+    {
+        help_put(p_ctrl, (uint8_t const *) "    ", keep, &err);
+        help_put(p_ctrl, p_menu->command_list[i].command, keep, &err);
+        for (uint32_t arg = 0U; (NULL != p_menu->command_list[i].p_arg_specs) &&
+                                (arg < p_menu->command_list[i].num_arg_specs); arg++)
+        {
+            sf_console_arg_spec_t const * p_spec = &p_menu->command_list[i].p_arg_specs[arg];
+            help_put(p_ctrl, (uint8_t const *) (p_spec->optional ? " [" : " <"), keep, &err);
+            help_put(p_ctrl, p_spec->name, keep, &err);
+            help_put(p_ctrl, (uint8_t const *) (p_spec->optional ? "]" : ">"), keep, &err);
+        }
+        if (NULL != p_menu->command_list[i].help)
+        {
+            help_put(p_ctrl, (uint8_t const *) " : ", keep, &err);
+            help_put(p_ctrl, p_menu->command_list[i].help, keep, &err);
+        }
+        help_put(p_ctrl, (uint8_t const *) "\r\n", keep, &err);
+    }
+    help_put(p_ctrl, (uint8_t const *) "\r\n", keep, &err);
+
+    return err;
+} /* End of function help_render */
+
+/******************************************************************************************************************//**
+* @brief  Adds a string to the help being rendered.  Does nothing once an error has been recorded.
+* @param[in]     p_ctrl      Console control block
+* @param[in]     p_src       NULL terminated string to add
+* @param[in]     keep        true to add the string to the help memory, false to write it through the scratch buffer.
+* @param[in,out] p_err       Result of rendering so far, set to the error if the string cannot be added.
+***********************************************************************************************************************/
+static void help_put(sf_console_instance_ctrl_t * const p_ctrl,
+                     uint8_t              const * const p_src,
+                     bool                               keep,
+                     uint32_t                   * const p_err)
+{
+    if (FSP_SUCCESS != *p_err)
+    {
+        return;
+    }
+
+    uint32_t bytes = (uint32_t) strlen((char const *) p_src);
+    if (!keep)
+    {
+        *p_err = format_put(p_ctrl, (char const *) p_src, bytes);
+    }
+    else if (bytes > (p_ctrl->help.size - p_ctrl->help.length))
+    {
+        *p_err = FSP_ERR_INSUFFICIENT_SPACE;
+    }
+    else
+    {
+        memcpy(&p_ctrl->help.p_buffer[p_ctrl->help.length], p_src, bytes);
+        p_ctrl->help.length += bytes;
+    }
+} /* End of function help_put */
+
+
+/******************************************************************************************************************//**
+* @brief  Finds the end of the current string, then parses the remaining string.
+* @param[in]  p_ctrl      Console control block, passed to the parse command to parse the remaining string.
+* @param[in]  p_input     Used to search for the end of the current command, which marks the beginning of the remaining
+*                         string.
+* @param[in]  bytes       The total number of bytes in the input string p_input
+***********************************************************************************************************************/
+static void sf_console_continue_parsing(sf_console_instance_ctrl_t * const p_ctrl,
+                                        uint8_t              const * const p_input,
+                                        uint32_t                     const bytes)
+{
+
+    if ((bytes > 0U) && (NULL_CODE != p_input[0]))
+    {
+        uint32_t length = 1U;
+        /* Find the end of the string or the beginning of the next word to pass to the callback. */
+        while (((NULL_CODE != p_input[length]) && (SPACE_CODE != p_input[length - 1])) && (length < bytes))
+        {
+            length++;
+        }
+        if (NULL_CODE != p_input[length])
+        {
+            SF_CONSOLE_Parse(p_ctrl, p_ctrl->p_current_menu, &p_input[length], bytes - length);
+        }
+    }
+}
+
+/******************************************************************************************************************//**
+* @brief  Finds the end of the current string, then passes the remaining string to the callback.
+* @note   Commands flagged SF_CONSOLE_COMMAND_FLAG_ASYNC are handed to the worker pool when there is one.
+* @param[in]  p_ctrl      Console control block, passed in the callback arguments
+* @param[in]  p_command   The command whose callback to call, along with its user context
+* @param[in]  p_stats     Statistics the call is timed into, NULL to not time it
+* @param[in]  p_input     Used to search for the end of the current command, which marks the beginning of the remaining
+*                         string.
+* @param[in]  bytes       The total number of bytes in the input string p_input
+* @param[in]  length      The starting index to search for the end of the current argument
+***********************************************************************************************************************/
+static void sf_console_call_callback(sf_console_instance_ctrl_t * const p_ctrl,
+                                     sf_console_command_t const * const p_command,
+                                     sf_console_command_stats_t * const p_stats,
+                                     uint8_t              const * const p_input,
+                                     uint32_t                     const bytes,
+                                     int32_t                            length)
+{
+    void (* p_callback)(sf_console_callback_args_t * p_args) = p_command->callback;
+
+    if (NULL != p_callback)
+    {
+        /* Find the end of the string or the beginning of the next word to pass to the callback. */
+        while (((NULL_CODE != p_input[length]) && (SPACE_CODE != p_input[length - 1])) && ((uint32_t) length < SF_CONSOLE_MAX_INPUT_LENGTH))
+        {
+            length++;
+        }
+
+        /* Split the rest of the line into arguments once, and check them before the callback sees them.  Commands
+         * without argument specs get the words they were given, up to SF_CONSOLE_CFG_MAX_ARGS of them.  A menu
+         * change parses the rest of the line as commands instead. */
+        sf_console_arg_t argv[SF_CONSOLE_CFG_MAX_ARGS];
+        uint32_t argc = 0U;
+        if (SF_CONSOLE_CALLBACK_NEXT_FUNCTION != p_callback)
+        {
+            uint32_t err = SF_CONSOLE_ArgumentsParse(&p_input[length], p_command->p_arg_specs,
+                                                     p_command->num_arg_specs, &argv[0], SF_CONSOLE_CFG_MAX_ARGS, &argc);
+            if ((FSP_SUCCESS != err) && (NULL != p_command->p_arg_specs) && (0U != p_command->num_arg_specs))
+            {
+                sf_console_arguments_error(p_ctrl, p_command, &argv[0], argc, err);
+                return;
+            }
+        }
+
+        /* Menu changes always happen on the console thread, since the next line is parsed in the new menu.  So do
+         * piped commands, since only the output of the console thread is filtered. */
+        if ((NULL != p_ctrl->p_jobs) && (0U != (p_command->flags & SF_CONSOLE_COMMAND_FLAG_ASYNC)) &&
+            (SF_CONSOLE_CALLBACK_NEXT_FUNCTION != p_callback) && (!p_ctrl->pipe.active))
+        {
+            sf_console_job_submit(p_ctrl, p_command, p_stats, &p_input[length], argc, &argv[0]);
+            return;
+        }
+
+        /* Call user provided callback */
+        sf_console_cb_args_t args;
+        args.p_ctrl = p_ctrl;
+        args.context = p_command->context;
+        args.p_remaining_string = &p_input[length];
+        args.bytes = bytes - (uint32_t) length;
+        args.argc = argc;
+        args.p_argv = &argv[0];
+        args.rpc = false;
+
+        if (SF_CONSOLE_CALLBACK_NEXT_FUNCTION == p_callback)
+        {
+            SF_CONSOLE_CallbackNextMenu(&args);
+        }
+        else
+        {
+            SF_CONSOLE_CommandRun(p_command, p_stats, &args);
+        }
+    }
+}
+
+/******************************************************************************************************************//**
+* @brief  Queues a command on the worker pool and reports the job id it was given.
+* @param[in]  p_ctrl       Console control block, the callback writes to it
+* @param[in]  p_command    The command whose callback to run
+* @param[in]  p_stats      Statistics the run is timed into, NULL to not time it
+* @param[in]  p_remaining  The string remaining after the command, copied into the job
+* @param[in]  argc         Number of arguments in p_argv
+* @param[in]  p_argv       Arguments split out of p_remaining, moved to the copy
+***********************************************************************************************************************/
+static void sf_console_job_submit(sf_console_instance_ctrl_t * const p_ctrl,
+                                  sf_console_command_t const * const p_command,
+                                  sf_console_command_stats_t * const p_stats,
+                                  uint8_t              const * const p_remaining,
+                                  uint32_t                     const argc,
+                                  sf_console_arg_t     const * const p_argv)
+{
+    /** Hold the console channel until the job id is reported, so it comes before any output of the job. */
+    uint32_t err;
+    err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
+    if (FSP_SUCCESS != err)
+    {
+        return;
+    }
+
+    ULONG id = 0U;
+    err = SF_CONSOLE_JobsSubmit(p_ctrl->p_jobs, p_ctrl, p_command, p_stats, p_remaining, argc, p_argv, &id);
+    if (FSP_SUCCESS == err)
+    {
+        SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "[%lu] %s\r\n", (unsigned long) id,
+                               (char const *) p_command->command);
+    }
+    else
+    {
+        /** Every job slot is queued or running. */
+        SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "Too many jobs, %s not started\r\n",
+                               (char const *) p_command->command);
+    }
+
+    p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+}
+
+/******************************************************************************************************************//**
+* @brief  Lists the jobs this console submitted that are still kept by the worker pool.
+* @param[in]  p_ctrl      Console control block
+* @retval FSP_SUCCESS     The list was written.
+* @return                 See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t sf_console_jobs_list(sf_console_instance_ctrl_t * const p_ctrl)
+{
+    static char const * const states[] = { "free", "queued", "running", "done" };
+
+    /** Lock the console channel so the list is not split by output of the jobs it lists. */
+    uint32_t err;
+    err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
+    SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+    uint32_t count = 0U;
+    ULONG now = tx_time_get();
+    for (ULONG slot = 0U; (slot < SF_CONSOLE_JOBS_MAX) && (FSP_SUCCESS == err); slot++)
+    {
+        sf_console_job_t job;
+        err = SF_CONSOLE_JobsGet(p_ctrl->p_jobs, slot, &job);
+        if ((FSP_SUCCESS != err) || (SF_CONSOLE_JOB_STATE_FREE == job.state) || ((void *) p_ctrl != job.p_console))
+        {
+            continue;
+        }
+
+        if (0U == count)
+        {
+            err = SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT,
+                                         "|   Id | State   |    Ticks | Command\r\n"
+                                         "|------|---------|----------|--------\r\n");
+        }
+        count++;
+
+        /** Queued jobs count from submission, the others from when a worker took them. */
+        ULONG ticks = (SF_CONSOLE_JOB_STATE_QUEUED == job.state) ? (now - job.submit_ticks) :
+                      (SF_CONSOLE_JOB_STATE_RUNNING == job.state) ? (now - job.start_ticks) :
+                      (job.end_ticks - job.start_ticks);
+        if (FSP_SUCCESS == err)
+        {
+            err = SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "| %4lu | %-7s | %8lu | %s%s%s\r\n",
+                                         (unsigned long) job.id, states[job.state], (unsigned long) ticks,
+                                         (char const *) job.p_command->command,
+                                         (NULL_CODE != job.input[0]) ? " " : "", (char const *) job.input);
+        }
+    }
+
+    if ((FSP_SUCCESS == err) && (0U == count))
+    {
+        err = SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "No jobs\r\n");
+    }
+
+    p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+
+    return err;
+}
+
+/******************************************************************************************************************//**
+* @brief  Blocks the console until a job finishes.  Output of the job, including the line reporting that it is done,
+*         keeps going to its console meanwhile.
+* @param[in]  p_ctrl      Console control block
+* @param[in]  p_arg       The string after the wait command, holding the job id
+* @retval FSP_SUCCESS     The job finished, or the id was not valid and usage was printed.
+* @return                 See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t sf_console_jobs_wait(sf_console_instance_ctrl_t * const p_ctrl, uint8_t const * const p_arg)
+{
+    char * p_end = NULL;
+    unsigned long id = strtoul((char const *) p_arg, &p_end, 10);
+    while (SPACE_CODE == (uint8_t) *p_end)
+    {
+        p_end++;
+    }
+
+    sf_console_job_t job;
+    uint32_t err = FSP_ERR_NOT_FOUND;
+    if (((char const *) p_arg != p_end) && (NULL_CODE == (uint8_t) *p_end))
+    {
+        err = SF_CONSOLE_JobsWait(p_ctrl->p_jobs, (ULONG) id, SF_CONSOLE_PRV_TIMEOUT, &job);
+    }
+
+    if (FSP_ERR_NOT_FOUND == err)
+    {
+        return SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "No such job. USAGE: wait <id>\r\n");
+    }
+    SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************************************************//**
+* @brief  Looks up the command a line starts with, as Parse would look it up.
+* @note   Menu commands and the ^ and ~ commands at the start of the line are followed.  Other built-in commands are not
+*         looked up.
+* @param[in]      p_ctrl   Console control block holding the command indexes
+* @param[in,out]  pp_menu  Menu the line is looked up in, updated to the menu the command was found in
+* @param[in,out]  pp_line  Line to look up, moved past the command and the menu changes before it
+* @return  The command, NULL if the line only changes menus or does not start with a command
+***********************************************************************************************************************/
+static sf_console_command_t const * sf_console_command_lookup(sf_console_instance_ctrl_t const * const p_ctrl,
+                                                              sf_console_menu_t          const **      pp_menu,
+                                                              uint8_t                    const **      pp_line)
+{
+    sf_console_menu_t const * p_menu = *pp_menu;
+    uint8_t const * p_line = *pp_line;
+    sf_console_command_t const * p_command = NULL;
+
+    while (NULL_CODE != *p_line)
+    {
+        uint32_t command;
+        int32_t previous = check_for_match(p_line, SF_CONSOLE_MENU_PREVIOUS_COMMAND);
+        int32_t root = check_for_match(p_line, SF_CONSOLE_ROOT_MENU_COMMAND);
+        int32_t length = (previous > 0) ? previous : root;
+        if (previous > 0)
+        {
+            p_menu = (NULL != p_menu->menu_prev) ? p_menu->menu_prev : p_menu;
+        }
+        else if (root > 0)
+        {
+            while (NULL != p_menu->menu_prev)
+            {
+                p_menu = p_menu->menu_prev;
+            }
+        }
+        else if (sf_console_find_command(p_ctrl, p_menu, p_line, &command, &length))
+        {
+            p_command = &p_menu->command_list[command];
+            if ((SF_CONSOLE_CALLBACK_NEXT_FUNCTION != p_command->callback) || (NULL == p_command->context))
+            {
+                p_line += length;
+                break;
+            }
+            p_menu = (sf_console_menu_t const *) p_command->context;
+            p_command = NULL;
+        }
+        else
+        {
+            break;
+        }
+
+        p_line += length;
+        while (SPACE_CODE == *p_line)
+        {
+            p_line++;
+        }
+    }
+
+    *pp_menu = p_menu;
+    *pp_line = p_line;
+    return p_command;
+}  /* End of function sf_console_command_lookup */
+
+/******************************************************************************************************************//**
+* @brief  Runs the watch command, which runs a command every interval until a key is pressed.
+* @note   The command is looked up and its arguments split once, every run gets the same ones.  It runs on this thread
+*         even if it is asynchronous, so each run is drawn over the previous one.  A run that takes longer than the
+*         interval delays the next one rather than queueing more.
+* @param[in]  p_ctrl       Console control block
+* @param[in]  p_menu       Menu the command is looked up in
+* @param[in]  p_arg        Input following the watch command, the interval in seconds and the command
+* @retval     FSP_SUCCESS  A key stopped the command, or the reason it did not run was printed.
+* @return                  See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t sf_console_watch_command(sf_console_instance_ctrl_t       * const p_ctrl,
+                                         sf_console_menu_t          const * const p_menu,
+                                         uint8_t                    const * const p_arg)
+{
+    /** The interval comes first, at least a tick. */
+    char * p_end = NULL;
+    float seconds = strtof((char const *) p_arg, &p_end);
+    ULONG ticks = (ULONG) ((seconds * (float) TX_TIMER_TICKS_PER_SECOND) + 0.5f);
+    ticks = (0U == ticks) ? 1U : ticks;
+
+    sf_console_menu_t const * p_watch_menu = p_menu;
+    uint8_t const * p_line = (uint8_t const *) p_end;
+    sf_console_command_t const * p_command = NULL;
+    if (((char const *) p_arg != p_end) && (seconds > 0.0f) && (SPACE_CODE == *p_line))
+    {
+        while (SPACE_CODE == *p_line)
+        {
+            p_line++;
+        }
+        p_command = sf_console_command_lookup(p_ctrl, &p_watch_menu, &p_line);
+    }
+
+    if ((NULL == p_command) || (NULL == p_command->callback))
+    {
+        return SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT,
+                                      "Nothing to watch. USAGE: %s <seconds> <command>\r\n",
+                                      (char const *) SF_CONSOLE_WATCH_COMMAND);
+    }
+
+    /** Split the arguments once, a command given bad ones is reported as the prompt would report it. */
+    while (SPACE_CODE == *p_line)
+    {
+        p_line++;
+    }
+    sf_console_arg_t argv[SF_CONSOLE_CFG_MAX_ARGS];
+    uint32_t argc = 0U;
+    uint32_t err = SF_CONSOLE_ArgumentsParse(p_line, p_command->p_arg_specs, p_command->num_arg_specs, &argv[0],
+                                             SF_CONSOLE_CFG_MAX_ARGS, &argc);
+    if ((FSP_SUCCESS != err) && (NULL != p_command->p_arg_specs) && (0U != p_command->num_arg_specs))
+    {
+        sf_console_arguments_error(p_ctrl, p_command, &argv[0], argc, err);
+        return FSP_SUCCESS;
+    }
+
+    /** The timer only marks each interval.  Commands write and may block, which a timer callback must not. */
+    SF_CONSOLE_ERROR_RETURN(TX_SUCCESS == tx_event_flags_create(&p_ctrl->watch.events,
+                                                                (CHAR *) SF_CONSOLE_PRV_WATCH_EVENTS_NAME),
+                            FSP_ERR_INTERNAL);
+    if (TX_SUCCESS != tx_timer_create(&p_ctrl->watch.timer, (CHAR *) SF_CONSOLE_PRV_WATCH_TIMER_NAME,
+                                      sf_console_watch_expire, (ULONG) p_ctrl, ticks, ticks, TX_AUTO_ACTIVATE))
+    {
+        tx_event_flags_delete(&p_ctrl->watch.events);
+        FSP_ERROR_LOG(FSP_ERR_INTERNAL);
+        return FSP_ERR_INTERNAL;
+    }
+
+    sf_console_callback_args_t args;
+    args.p_ctrl = p_ctrl;
+    args.context = p_command->context;
+    args.p_remaining_string = p_line;
+    args.bytes = (uint32_t) strlen((char const *) p_line) + 1U;
+    args.argc = argc;
+    args.p_argv = &argv[0];
+    args.rpc = false;
+
+    p_ctrl->watch.lines = 0U;
+    p_ctrl->watch.active = true;
+
+    ULONG runs = 0U;
+    bool stop = false;
+    err = FSP_SUCCESS;
+    while (!stop)
+    {
+        /** Go back to where the previous run started and clear everything below it, then draw this run. */
+        err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
+        if (FSP_SUCCESS != err)
+        {
+            break;
+        }
+        if (runs > 0U)
+        {
+            uint8_t const clear[] = { CR_CODE, ESC_CODE_1, ESC_CODE_2, CLEAR_DOWN_CODE };
+            move_cursor(p_ctrl, SF_CONSOLE_CURSOR_DIR_UP, p_ctrl->watch.lines);
+            if (p_ctrl->echo)
+            {
+                frame_append(p_ctrl, &clear[0], sizeof(clear));
+            }
+            frame_send(p_ctrl);
+        }
+        p_ctrl->watch.lines = 0U;
+        runs++;
+
+        /** A pipe after the watch command filters the output of each run, not the heading. */
+        bool piped = p_ctrl->pipe.active;
+        p_ctrl->pipe.active = false;
+        SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "Every %.2fs: %s %s  (run %lu, any key stops)\r\n",
+                               (double) ticks / (double) TX_TIMER_TICKS_PER_SECOND, (char const *) p_command->command,
+                               (char const *) p_line, (unsigned long) runs);
+        p_ctrl->pipe.active = piped;
+        p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+
+        SF_CONSOLE_CommandRun(p_command, sf_console_command_stats(p_watch_menu, p_command), &args);
+        if (piped)
+        {
+            sf_console_pipe_finish(p_ctrl);
+        }
+
+        /** Wait for the next interval.  Any key stops the command, and so does losing the transport. */
+        ULONG events = 0U;
+        while (TX_SUCCESS != tx_event_flags_get(&p_ctrl->watch.events, SF_CONSOLE_PRV_WATCH_EVENT, TX_OR_CLEAR,
+                                                &events, TX_NO_WAIT))
+        {
+            uint8_t key;
+            err = p_ctrl->p_comms->p_api->read(p_ctrl->p_comms->p_ctrl, &key, 1U, SF_CONSOLE_PRV_WATCH_POLL);
+            if (FSP_ERR_TIMEOUT != err)
+            {
+                stop = true;
+                break;
+            }
+            err = FSP_SUCCESS;
+        }
+    }
+
+    p_ctrl->watch.active = false;
+    tx_timer_deactivate(&p_ctrl->watch.timer);
+    tx_timer_delete(&p_ctrl->watch.timer);
+    tx_event_flags_delete(&p_ctrl->watch.events);
+
+    /** A key is how the command is meant to stop, only a failed transport is an error. */
+    if (FSP_SUCCESS == err)
+    {
+        err = SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "\r\n");
+    }
+
+    return err;
+}  /* End of function sf_console_watch_command */
+
+/******************************************************************************************************************//**
+* @brief  Marks an interval of the watch command.  Runs in timer context, so it only sets the event the console thread
+*         waits for.
+* @param[in]  input  Console control block running the watch command
+***********************************************************************************************************************/
+static VOID sf_console_watch_expire(ULONG input)
+{
+    sf_console_instance_ctrl_t * p_ctrl = (sf_console_instance_ctrl_t *) input;
+
+    tx_event_flags_set(&p_ctrl->watch.events, SF_CONSOLE_PRV_WATCH_EVENT, TX_OR);
+}  /* End of function sf_console_watch_expire */
+
+/******************************************************************************************************************//**
+* @brief  Writes output to the transport, or in output frames while binary frames are exchanged.
+* @param[in]  p_ctrl       Console control block
+* @param[in]  p_src        Bytes to write
+* @param[in]  bytes        Number of bytes in p_src
+* @param[in]  timeout      Timeout of the write
+* @retval     FSP_SUCCESS  The bytes were written.
+* @return                  See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t sf_console_output_write(sf_console_instance_ctrl_t * const p_ctrl,
+                                        uint8_t              const * const p_src,
+                                        uint32_t                     const bytes,
+                                        uint32_t                     const timeout)
+{
+    /** Text written while binary frames are exchanged goes in output frames. */
+    uint32_t err;
+    if (p_ctrl->rpc.active)
+    {
+        err = SF_CONSOLE_RpcOutput(p_ctrl, p_src, bytes, timeout);
+    }
+    else
+    {
+        err = p_ctrl->p_comms->p_api->write(p_ctrl->p_comms->p_ctrl, p_src, bytes, timeout);
+    }
+    SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+    /** While a command is watched its lines are counted, so the next run can be drawn over them. */
+    if (p_ctrl->watch.active)
+    {
+        for (uint32_t i = 0U; i < bytes; i++)
+        {
+            p_ctrl->watch.lines += (LF_CODE == p_src[i]) ? 1U : 0U;
+        }
+    }
+
+    return FSP_SUCCESS;
+}  /* End of function sf_console_output_write */
+
+/******************************************************************************************************************//**
+* @brief  Finds the first pipe in a line.  Pipes inside quotes are part of an argument.
+* @param[in]  p_input  Line to search
+* @param[in]  bytes    Size of p_input, the search also stops at the end of the string
+* @return  The pipe, NULL if there is none
+***********************************************************************************************************************/
+static uint8_t const * sf_console_pipe_find(uint8_t const * const p_input, uint32_t const bytes)
+{
+    bool quoted = false;
+
+    for (uint32_t i = 0U; (i < bytes) && (NULL_CODE != p_input[i]); i++)
+    {
+        if (QUOTE_CODE == p_input[i])
+        {
+            quoted = !quoted;
+        }
+        else if ((SF_CONSOLE_PIPE_CHAR == p_input[i]) && (!quoted))
+        {
+            return &p_input[i];
+        }
+    }
+
+    return NULL;
+}  /* End of function sf_console_pipe_find */
+
+/******************************************************************************************************************//**
+* @brief  Runs the command before the first pipe of a line, with its output going through the filters after it.
+* @note   The command runs on this thread even if it is asynchronous.  Only output this thread writes is filtered.
+* @param[in]  p_ctrl       Console control block
+* @param[in]  p_menu       Menu the command is looked up in
+* @param[in]  p_input      Line holding the command and its filters
+* @param[in]  bytes        Size of p_input
+* @retval     FSP_SUCCESS  The command ran, or the reason it did not was printed.
+* @return                  See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t sf_console_pipe_run(sf_console_instance_ctrl_t       * const p_ctrl,
+                                    sf_console_menu_t          const * const p_menu,
+                                    uint8_t                    const * const p_input,
+                                    uint32_t                           const bytes)
+{
+    sf_console_pipe_t * p_pipe = &p_ctrl->pipe;
+
+    /** Copy the line, so it can be ended at each pipe.  The filters point into the copy. */
+    uint32_t length = 0U;
+    while ((length < bytes) && (length < (SF_CONSOLE_MAX_INPUT_LENGTH - 1U)) && (NULL_CODE != p_input[length]))
+    {
+        length++;
+    }
+    memcpy(&p_pipe->command[0], p_input, length);
+    p_pipe->command[length] = NULL_CODE;
+
+    /** Each filter runs from one pipe to the next. */
+    bool valid = true;
+    p_pipe->count = 0U;
+    uint8_t * p_stage = (uint8_t *) sf_console_pipe_find(&p_pipe->command[0], length);
+    while (valid && (NULL != p_stage))
+    {
+        *p_stage++ = NULL_CODE;
+        uint8_t * p_next = (uint8_t *) sf_console_pipe_find(p_stage, length - (uint32_t) (p_stage - &p_pipe->command[0]));
+        if (NULL != p_next)
+        {
+            *p_next = NULL_CODE;
+        }
+
+        valid = (p_pipe->count < SF_CONSOLE_CFG_PIPE_STAGES) &&
+                sf_console_pipe_stage_parse(&p_pipe->stages[p_pipe->count], p_stage);
+        p_pipe->count++;
+        p_stage = p_next;
+    }
+
+    if (!valid)
+    {
+        return SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT,
+                                      "Invalid filter. USAGE: <command> | %s [%s] <text> | %s [lines] | %s, at most %u\r\n",
+                                      (char const *) SF_CONSOLE_PIPE_GREP, (char const *) SF_CONSOLE_PIPE_GREP_INVERT,
+                                      (char const *) SF_CONSOLE_PIPE_HEAD, (char const *) SF_CONSOLE_PIPE_COUNT,
+                                      (unsigned) SF_CONSOLE_CFG_PIPE_STAGES);
+    }
+
+    /** Run the command as if it had been entered alone, then write what is left in the filters. */
+    p_pipe->line_length = 0U;
+    p_pipe->p_thread = tx_thread_identify();
+    p_pipe->active = true;
+
+    uint32_t err = SF_CONSOLE_Parse(p_ctrl, p_menu, &p_pipe->command[0],
+                                    (uint32_t) strlen((char const *) &p_pipe->command[0]) + 1U);
+    uint32_t finish_err = sf_console_pipe_finish(p_ctrl);
+
+    p_pipe->active = false;
+
+    return (FSP_SUCCESS != err) ? err : finish_err;
+}  /* End of function sf_console_pipe_run */
+
+/******************************************************************************************************************//**
+* @brief  Reads a filter from the text between two pipes.
+* @param[out]  p_stage  Filter read
+* @param[in]   p_text   NULL terminated text of the filter, kept for as long as the filter is used
+* @return  true if the text is a valid filter
+***********************************************************************************************************************/
+static bool sf_console_pipe_stage_parse(sf_console_pipe_stage_t * const p_stage, uint8_t const * const p_text)
+{
+    sf_console_arg_t argv[3];
+    uint32_t argc = 0U;
+    if ((FSP_SUCCESS != SF_CONSOLE_ArgumentsParse(p_text, NULL, 0U, &argv[0], 3U, &argc)) || (0U == argc))
+    {
+        return false;
+    }
+
+    p_stage->p_text = NULL;
+    p_stage->length = 0U;
+    p_stage->invert = false;
+    p_stage->limit = 0U;
+    p_stage->lines = 0U;
+
+    /** grep [-v] <text>, the text may be quoted to hold spaces or pipes. */
+    if (check_for_match(argv[0].p_text, SF_CONSOLE_PIPE_GREP) > 0)
+    {
+        uint32_t text = 1U;
+        if ((3U == argc) && (check_for_match(argv[1].p_text, SF_CONSOLE_PIPE_GREP_INVERT) > 0))
+        {
+            p_stage->invert = true;
+            text = 2U;
+        }
+        p_stage->filter = SF_CONSOLE_PIPE_FILTER_GREP;
+        p_stage->p_text = (text < argc) ? argv[text].p_text : NULL;
+        p_stage->length = (text < argc) ? argv[text].length : 0U;
+
+        return ((text + 1U) == argc);
+    }
+
+    /** head [lines], ten lines if not given. */
+    if (check_for_match(argv[0].p_text, SF_CONSOLE_PIPE_HEAD) > 0)
+    {
+        p_stage->filter = SF_CONSOLE_PIPE_FILTER_HEAD;
+        p_stage->limit = SF_CONSOLE_PRV_PIPE_HEAD_LINES;
+        if (2U == argc)
+        {
+            char * p_end = NULL;
+            p_stage->limit = (uint32_t) strtoul((char const *) argv[1].p_text, &p_end, 10);
+
+            return ((uint8_t const *) p_end == &argv[1].p_text[argv[1].length]) && (0U != argv[1].length);
+        }
+
+        return (1U == argc);
+    }
+
+    /** count */
+    if (check_for_match(argv[0].p_text, SF_CONSOLE_PIPE_COUNT) > 0)
+    {
+        p_stage->filter = SF_CONSOLE_PIPE_FILTER_COUNT;
+
+        return (1U == argc);
+    }
+
+    return false;
+}  /* End of function sf_console_pipe_stage_parse */
+
+/******************************************************************************************************************//**
+* @brief  Collects the output of a piped command into lines and sends each line through the filters.
+* @note   A line longer than the line buffer is filtered in pieces.  grep looks for its text in each piece, and head and
+*         count count the line once.
+* @param[in]  p_ctrl       Console control block
+* @param[in]  p_src        Output of the command
+* @param[in]  bytes        Number of bytes in p_src
+* @param[in]  timeout      Timeout of writing the lines that pass
+* @retval     FSP_SUCCESS  The output was filtered, and what passed was written.
+* @return                  See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t sf_console_pipe_write(sf_console_instance_ctrl_t * const p_ctrl,
+                                      uint8_t              const *       p_src,
+                                      uint32_t                           bytes,
+                                      uint32_t                     const timeout)
+{
+    sf_console_pipe_t * p_pipe = &p_ctrl->pipe;
+    uint32_t err = FSP_SUCCESS;
+
+    while ((bytes > 0U) && (FSP_SUCCESS == err))
+    {
+        uint8_t const * p_end = (uint8_t const *) memchr(p_src, LF_CODE, bytes);
+        uint32_t chunk = (NULL != p_end) ? ((uint32_t) (p_end - p_src) + 1U) : bytes;
+
+        /** Whole lines are filtered where they are, without copying them. */
+        if ((NULL != p_end) && (0U == p_pipe->line_length))
+        {
+            err = sf_console_pipe_line(p_ctrl, 0U, p_src, chunk, true, timeout);
+            p_src += chunk;
+            bytes -= chunk;
+            continue;
+        }
+
+        /** Collect the rest, filtering when the line ends or the buffer fills. */
+        uint32_t space = SF_CONSOLE_CFG_PIPE_LINE_LENGTH - p_pipe->line_length;
+        if (chunk > space)
+        {
+            chunk = space;
+        }
+        memcpy(&p_pipe->line[p_pipe->line_length], p_src, chunk);
+        p_pipe->line_length += chunk;
+        p_src += chunk;
+        bytes -= chunk;
+
+        bool end = (LF_CODE == p_pipe->line[p_pipe->line_length - 1U]);
+        if (end || (SF_CONSOLE_CFG_PIPE_LINE_LENGTH == p_pipe->line_length))
+        {
+            err = sf_console_pipe_line(p_ctrl, 0U, &p_pipe->line[0], p_pipe->line_length, end, timeout);
+            p_pipe->line_length = 0U;
+        }
+    }
+
+    return err;
+}  /* End of function sf_console_pipe_write */
+
+/******************************************************************************************************************//**
+* @brief  Sends a line through the filters from a stage on, and writes it if it passes all of them.
+* @param[in]  p_ctrl       Console control block
+* @param[in]  stage        First stage the line goes through
+* @param[in]  p_line       Line, or piece of a line, with its line ending if it has one
+* @param[in]  length       Number of bytes in p_line
+* @param[in]  end          Whether p_line ends the line, only then head and count count it
+* @param[in]  timeout      Timeout of writing the line
+* @retval     FSP_SUCCESS  The line was dropped or written.
+* @return                  See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t sf_console_pipe_line(sf_console_instance_ctrl_t * const p_ctrl,
+                                     uint32_t                     const stage,
+                                     uint8_t              const * const p_line,
+                                     uint32_t                     const length,
+                                     bool                         const end,
+                                     uint32_t                     const timeout)
+{
+    sf_console_pipe_t * p_pipe = &p_ctrl->pipe;
+
+    for (uint32_t i = stage; i < p_pipe->count; i++)
+    {
+        sf_console_pipe_stage_t * p_stage = &p_pipe->stages[i];
+
+        if (SF_CONSOLE_PIPE_FILTER_GREP == p_stage->filter)
+        {
+            /** Look for the text in the line without its line ending.  Unlike commands, the text is case sensitive. */
+            uint32_t text_length = length;
+            while ((text_length > 0U) && ((LF_CODE == p_line[text_length - 1U]) || (CR_CODE == p_line[text_length - 1U])))
+            {
+                text_length--;
+            }
+
+            bool found = false;
+            for (uint32_t at = 0U; (!found) && ((at + p_stage->length) <= text_length); at++)
+            {
+                found = (0 == memcmp(&p_line[at], p_stage->p_text, p_stage->length));
+            }
+            if (found == p_stage->invert)
+            {
+                return FSP_SUCCESS;
+            }
+        }
+        else if (SF_CONSOLE_PIPE_FILTER_HEAD == p_stage->filter)
+        {
+            if (p_stage->lines >= p_stage->limit)
+            {
+                return FSP_SUCCESS;
+            }
+            p_stage->lines += end ? 1U : 0U;
+        }
+        else
+        {
+            /** Counted lines are only written as a number when the command is done. */
+            p_stage->lines += end ? 1U : 0U;
+
+            return FSP_SUCCESS;
+        }
+    }
+
+    return sf_console_output_write(p_ctrl, p_line, length, timeout);
+}  /* End of function sf_console_pipe_line */
+
+/******************************************************************************************************************//**
+* @brief  Filters what is left of the output of a piped command once it is done, writes the counts and starts the
+*         filters over.
+* @param[in]  p_ctrl       Console control block
+* @retval     FSP_SUCCESS  The rest of the output was filtered, and what passed was written.
+* @return                  See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t sf_console_pipe_finish(sf_console_instance_ctrl_t * const p_ctrl)
+{
+    sf_console_pipe_t * p_pipe = &p_ctrl->pipe;
+    uint32_t err = FSP_SUCCESS;
+
+    /** A last line without a line ending is still a line. */
+    if (p_pipe->line_length > 0U)
+    {
+        err = sf_console_pipe_line(p_ctrl, 0U, &p_pipe->line[0], p_pipe->line_length, true, SF_CONSOLE_PRV_TIMEOUT);
+        p_pipe->line_length = 0U;
+    }
+
+    /** A count goes through the filters after it, as a line of its own. */
+    for (uint32_t i = 0U; i < p_pipe->count; i++)
+    {
+        sf_console_pipe_stage_t * p_stage = &p_pipe->stages[i];
+        if (SF_CONSOLE_PIPE_FILTER_COUNT == p_stage->filter)
+        {
+            char text[16];
+            int length = snprintf(&text[0], sizeof(text), "%lu\r\n", (unsigned long) p_stage->lines);
+            uint32_t count_err = sf_console_pipe_line(p_ctrl, i + 1U, (uint8_t const *) &text[0], (uint32_t) length,
+                                                      true, SF_CONSOLE_PRV_TIMEOUT);
+            err = (FSP_SUCCESS == err) ? count_err : err;
+        }
+        p_stage->lines = 0U;
+    }
+
+    return err;
+}  /* End of function sf_console_pipe_finish */
+
+/******************************************************************************************************************//**
+* @brief  Runs the source command, which runs the commands in a file.
+* @param[in]  p_ctrl       Console control block
+* @param[in]  p_menu       Menu the first line of the file is looked up in
+* @param[in]  p_arg        Input following the source command
+* @retval     FSP_SUCCESS  The file ran, or the reason it did not was printed.
+***********************************************************************************************************************/
+static uint32_t sf_console_source_command(sf_console_instance_ctrl_t       * const p_ctrl,
+                                          sf_console_menu_t          const * const p_menu,
+                                          uint8_t                    const * const p_arg)
+{
+    /** Take the path as one word, which may be quoted to contain spaces. */
+    static sf_console_arg_spec_t const path_spec =
+    {
+        .name = (uint8_t const *) "file",
+        .type = SF_CONSOLE_ARG_TYPE_STRING,
+    };
+    sf_console_arg_t path_arg;
+    uint32_t argc = 0U;
+    uint32_t err = SF_CONSOLE_ArgumentsParse(p_arg, &path_spec, 1U, &path_arg, 1U, &argc);
+    if (FSP_SUCCESS != err)
+    {
+        SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "USAGE: %s <file>\r\n",
+                               (char const *) SF_CONSOLE_SOURCE_COMMAND);
+        return FSP_SUCCESS;
+    }
+
+    char path[SF_CONSOLE_MAX_INPUT_LENGTH];
+    memcpy(&path[0], path_arg.p_text, path_arg.length);
+    path[path_arg.length] = '\0';
+
+    /** Standard input may be what the session itself reads, only batch mode hands it to the source API. */
+    if (0 == strcmp(&path[0], SF_CONSOLE_SOURCE_STDIN))
+    {
+        SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "Standard input is only read in batch mode\r\n");
+        return FSP_SUCCESS;
+    }
+
+    err = SF_CONSOLE_Source(p_ctrl, p_menu, &path[0], NULL);
+    if (FSP_ERR_NOT_FOUND == err)
+    {
+        SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "Cannot open %s\r\n", &path[0]);
+    }
+    else if (FSP_ERR_OUT_OF_MEMORY == err)
+    {
+        SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "%s does not fit the batch memory\r\n", &path[0]);
+    }
+    else
+    {
+        /* Ran, the results were printed. */
+    }
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************************************************//**
+* @brief  Looks up every line of a script, then runs the commands back to back and reports how each one did.
+* @note   Lines are looked up as Parse would look them up, following menu commands and the ^ and ~ commands.  Other
+*         built-in commands are not available in scripts.  The command list grows from the start of the memory and the
+*         arguments of the commands from its end.
+* @param[in]      p_ctrl       Console control block
+* @param[in]      p_menu       Menu the first line is looked up in, NULL for the current menu
+* @param[in,out]  p_script     NULL terminated script, line endings are replaced with NULL characters
+* @param[in]      bytes        Length of the script
+* @param[in]      p_memory     Memory for the command list, aligned for pointers
+* @param[in]      memory_size  Size of p_memory in bytes
+* @param[out]     p_result     Counts of passed and failed commands, may be NULL
+* @retval         FSP_SUCCESS            The script ran.
+* @retval         FSP_ERR_OUT_OF_MEMORY  The command list does not fit, nothing was run.
+***********************************************************************************************************************/
+static uint32_t sf_console_batch_run(sf_console_instance_ctrl_t       * const p_ctrl,
+                                     sf_console_menu_t          const *       p_menu,
+                                     uint8_t                          * const p_script,
+                                     uint32_t                           const bytes,
+                                     uint8_t                          * const p_memory,
+                                     uint32_t                           const memory_size,
+                                     sf_console_batch_result_t        * const p_result)
+{
+    sf_console_batch_entry_t * p_entries = (sf_console_batch_entry_t *) p_memory;
+    sf_console_arg_t * p_args_start = (sf_console_arg_t *) p_memory + (memory_size / sizeof(sf_console_arg_t));
+    uint32_t count = 0U;
+    uint32_t line = 0U;
+
+    if (NULL == p_menu)
+    {
+        p_menu = p_ctrl->p_current_menu;
+    }
+
+    /** Look up every line first, so nothing runs if the script does not fit. */
+    uint32_t start = 0U;
+    while (start < bytes)
+    {
+        uint32_t end = start;
+        while ((end < bytes) && (LF_CODE != p_script[end]))
+        {
+            end++;
+        }
+        p_script[end] = NULL_CODE;
+        if ((end > start) && (CR_CODE == p_script[end - 1U]))
+        {
+            p_script[end - 1U] = NULL_CODE;
+        }
+        uint8_t const * p_line = &p_script[start];
+        start = end + 1U;
+        line++;
+
+        while (SPACE_CODE == *p_line)
+        {
+            p_line++;
+        }
+        if ((NULL_CODE == *p_line) || ((uint8_t) SF_CONSOLE_COMMENT_CHAR == *p_line))
+        {
+            continue;
+        }
+
+        /** A line holding only menu changes changes the menu the lines after it are looked up in. */
+        sf_console_command_t const * p_command = sf_console_command_lookup(p_ctrl, &p_menu, &p_line);
+        if ((NULL == p_command) && (NULL_CODE == *p_line))
+        {
+            continue;
+        }
+
+        if ((uint8_t *) &p_entries[count + 1U] > (uint8_t *) p_args_start)
+        {
+            return FSP_ERR_OUT_OF_MEMORY;
+        }
+        sf_console_batch_entry_t * p_entry = &p_entries[count++];
+        p_entry->p_menu = p_menu;
+        p_entry->p_command = p_command;
+        p_entry->p_args = p_line;
+        p_entry->p_argv = NULL;
+        p_entry->argc = 0U;
+        p_entry->line = line;
+        p_entry->err = (NULL != p_command) ? FSP_SUCCESS : FSP_ERR_UNSUPPORTED;
+        p_entry->ticks = 0U;
+        if ((NULL == p_command) || (NULL == p_command->callback))
+        {
+            continue;
+        }
+
+        /** Split the arguments now, so running the script does no more parsing. */
+        while (SPACE_CODE == *p_line)
+        {
+            p_line++;
+        }
+        p_entry->p_args = p_line;
+
+        sf_console_arg_t argv[SF_CONSOLE_CFG_MAX_ARGS];
+        uint32_t argc = 0U;
+        p_entry->err = SF_CONSOLE_ArgumentsParse(p_line, p_command->p_arg_specs, p_command->num_arg_specs, &argv[0],
+                                                 SF_CONSOLE_CFG_MAX_ARGS, &argc);
+        if ((NULL == p_command->p_arg_specs) || (0U == p_command->num_arg_specs))
+        {
+            p_entry->err = FSP_SUCCESS;
+        }
+        if (FSP_SUCCESS == p_entry->err)
+        {
+            if ((uint8_t *) (p_args_start - argc) < (uint8_t *) &p_entries[count])
+            {
+                return FSP_ERR_OUT_OF_MEMORY;
+            }
+            p_args_start -= argc;
+            memcpy(p_args_start, &argv[0], argc * sizeof(sf_console_arg_t));
+            p_entry->p_argv = p_args_start;
+            p_entry->argc = argc;
+        }
+    }
+
+    /** Run the commands back to back, on this thread even if they are asynchronous, so each one can be timed. */
+    sf_console_batch_result_t result = { .commands = count };
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        sf_console_batch_entry_t * p_entry = &p_entries[i];
+        if (FSP_SUCCESS != p_entry->err)
+        {
+            sf_console_batch_error(p_ctrl, p_entry);
+            result.failed++;
+            continue;
+        }
+
+        sf_console_callback_args_t args;
+        args.p_ctrl = p_ctrl;
+        args.context = p_entry->p_command->context;
+        args.p_remaining_string = p_entry->p_args;
+        args.bytes = (uint32_t) strlen((char const *) p_entry->p_args) + 1U;
+        args.argc = p_entry->argc;
+        args.p_argv = p_entry->p_argv;
+        args.rpc = false;
+
+        ULONG start_ticks = tx_time_get();
+        if (NULL != p_entry->p_command->callback)
+        {
+            SF_CONSOLE_CommandRun(p_entry->p_command, sf_console_command_stats(p_entry->p_menu, p_entry->p_command),
+                                  &args);
+        }
+        p_entry->ticks = (uint32_t) (tx_time_get() - start_ticks);
+
+        result.ticks += p_entry->ticks;
+        result.passed++;
+    }
+
+    sf_console_batch_report(p_ctrl, p_entries, &result);
+
+    if (NULL != p_result)
+    {
+        *p_result = result;
+    }
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************************************************//**
+* @brief  Reports why a line of a script cannot run, as the prompt would report it.
+* @param[in]  p_ctrl   Console control block
+* @param[in]  p_entry  The line that failed to compile
+***********************************************************************************************************************/
+static void sf_console_batch_error(sf_console_instance_ctrl_t       * const p_ctrl,
+                                   sf_console_batch_entry_t   const * const p_entry)
+{
+    if (FSP_SUCCESS != p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT))
+    {
+        return;
+    }
+
+    SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "Line %lu: ", (unsigned long) p_entry->line);
+    if (FSP_ERR_UNSUPPORTED == p_entry->err)
+    {
+        SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "Unsupported %s Command: %s\r\n",
+                               (char const *) p_entry->p_menu->menu_name, (char const *) p_entry->p_args);
+    }
+    else
+    {
+        /** Arguments that failed are split again, which only costs anything on this path. */
+        sf_console_command_t const * p_command = p_entry->p_command;
+        sf_console_arg_t argv[SF_CONSOLE_CFG_MAX_ARGS];
+        uint32_t argc = 0U;
+        uint32_t err = SF_CONSOLE_ArgumentsParse(p_entry->p_args, p_command->p_arg_specs, p_command->num_arg_specs,
+                                                 &argv[0], SF_CONSOLE_CFG_MAX_ARGS, &argc);
+        sf_console_arguments_error(p_ctrl, p_command, &argv[0], argc, err);
+    }
+
+    p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+}
+
+/******************************************************************************************************************//**
+* @brief  Prints the time each command of a script took and a summary of the run.
+* @param[in]  p_ctrl     Console control block
+* @param[in]  p_entries  Compiled script
+* @param[in]  p_result   Counts of the run
+***********************************************************************************************************************/
+static void sf_console_batch_report(sf_console_instance_ctrl_t       * const p_ctrl,
+                                    sf_console_batch_entry_t   const * const p_entries,
+                                    sf_console_batch_result_t  const * const p_result)
+{
+    if (FSP_SUCCESS != p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT))
+    {
+        return;
+    }
+
+    SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "\r\n| Line | Result |    Ticks | Command\r\n"
+                                                           "|------|--------|----------|--------\r\n");
+    for (uint32_t i = 0U; i < p_result->commands; i++)
+    {
+        sf_console_batch_entry_t const * p_entry = &p_entries[i];
+        bool passed = (FSP_SUCCESS == p_entry->err);
+        char const * p_command = (NULL != p_entry->p_command) ? (char const *) p_entry->p_command->command : "";
+        char const * p_args = (char const *) p_entry->p_args;
+        SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "| %4lu | %6s | %8lu | %s%s%s\r\n",
+                               (unsigned long) p_entry->line, passed ? "pass" : "FAIL",
+                               (unsigned long) p_entry->ticks, p_command,
+                               (('\0' != p_command[0]) && ('\0' != p_args[0])) ? " " : "", p_args);
+    }
+    SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "%lu passed, %lu failed, %lu ticks\r\n",
+                           (unsigned long) p_result->passed, (unsigned long) p_result->failed,
+                           (unsigned long) p_result->ticks);
+
+    p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+}
+
+/******************************************************************************************************************//**
+* @brief  Finds the statistics kept for a command of a menu.
+* @param[in]  p_menu     Menu holding the command
+* @param[in]  p_command  Entry of the command list of p_menu
+* @return  The statistics of the command, NULL if the menu keeps none
+***********************************************************************************************************************/
+static sf_console_command_stats_t * sf_console_command_stats(sf_console_menu_t    const * const p_menu,
+                                                             sf_console_command_t const * const p_command)
+{
+    if ((NULL == p_menu) || (NULL == p_menu->p_stats))
+    {
+        return NULL;
+    }
+
+    return &p_menu->p_stats[p_command - p_menu->command_list];
+}  /* End of function sf_console_command_stats */
+
+/******************************************************************************************************************//**
+* @brief  Adds one call of a command to its statistics.
+* @param[in,out]  p_stats  Statistics of the command
+* @param[in]      us       Microseconds the call took
+* @param[in]      ticks    ThreadX ticks the call took
+***********************************************************************************************************************/
+static void sf_console_stats_record(sf_console_command_stats_t * const p_stats, uint32_t const us, uint32_t const ticks)
+{
+    uint32_t bucket = sf_console_stats_bucket(us);
+
+    /** Every console sharing the menu, and every worker, records into the same statistics.  The update is only a few
+     *  stores, so interrupts are kept off for it rather than taking a mutex on each call. */
+    TX_INTERRUPT_SAVE_AREA
+    TX_DISABLE
+    if ((0U == p_stats->count) || (us < p_stats->min_us))
+    {
+        p_stats->min_us = us;
+    }
+    if (us > p_stats->max_us)
+    {
+        p_stats->max_us = us;
+    }
+    if (ticks > p_stats->max_ticks)
+    {
+        p_stats->max_ticks = ticks;
+    }
+    p_stats->count++;
+    p_stats->total_us += us;
+    p_stats->total_ticks += ticks;
+    p_stats->buckets[bucket]++;
+    TX_RESTORE
+}  /* End of function sf_console_stats_record */
+
+/******************************************************************************************************************//**
+* @brief  Finds the histogram bucket a time is counted in.  Times under 4 us have a bucket each, then every power of two
+*         is split in four by the two bits below the highest set bit.
+* @param[in]  us  Time in microseconds
+* @return  Bucket index, the last bucket for times past the histogram
+***********************************************************************************************************************/
+static uint32_t sf_console_stats_bucket(uint32_t const us)
+{
+    if (us < 4U)
+    {
+        return us;
+    }
+
+    uint32_t octave = 2U;
+    while ((octave < 31U) && (0U != (us >> (octave + 1U))))
+    {
+        octave++;
+    }
+
+    uint32_t bucket = (4U * (octave - 1U)) + ((us >> (octave - 2U)) & 3U);
+
+    return (bucket < SF_CONSOLE_STATS_BUCKETS) ? bucket : (SF_CONSOLE_STATS_BUCKETS - 1U);
+}  /* End of function sf_console_stats_bucket */
+
+/******************************************************************************************************************//**
+* @brief  Finds the longest time counted in a histogram bucket.
+* @param[in]  bucket  Bucket index
+* @return  Time in microseconds
+***********************************************************************************************************************/
+static uint32_t sf_console_stats_bucket_limit(uint32_t const bucket)
+{
+    if (bucket < 4U)
+    {
+        return bucket;
+    }
 
-    /** Shift characters right in input string */
-    uint32_t temp = last_index;
-    while (temp > index)
+    uint32_t octave = (bucket / 4U) + 1U;
+
+    return ((5U + (bucket % 4U)) << (octave - 2U)) - 1U;
+}  /* End of function sf_console_stats_bucket_limit */
+
+/******************************************************************************************************************//**
+* @brief  Estimates a percentile of the times of a command from its histogram.
+* @param[in]  p_stats  Statistics of the command, with at least one call
+* @param[in]  percent  Percentile to find
+* @return  Longest time of the bucket holding the percentile, kept within the shortest and longest call
+***********************************************************************************************************************/
+static uint32_t sf_console_stats_percentile(sf_console_command_stats_t const * const p_stats, uint32_t const percent)
+{
+    /** The percentile is the call that at least percent of the calls are no slower than. */
+    uint32_t rank = (uint32_t) ((((uint64_t) p_stats->count * percent) + 99U) / 100U);
+    uint32_t seen = 0U;
+    for (uint32_t bucket = 0U; bucket < SF_CONSOLE_STATS_BUCKETS; bucket++)
     {
-        p_input[temp] = p_input[temp - 1];
-        temp--;
+        seen += p_stats->buckets[bucket];
+        if (seen >= rank)
+        {
+            uint32_t limit = sf_console_stats_bucket_limit(bucket);
+            limit = (limit > p_stats->max_us) ? p_stats->max_us : limit;
+            return (limit < p_stats->min_us) ? p_stats->min_us : limit;
+        }
     }
 
-    /** Insert character */
-    p_input[index] = ch;
+    return p_stats->max_us;
+}  /* End of function sf_console_stats_percentile */
 
-    /** Add a null character to terminate the string. */
-    p_input[last_index + 1] = NULL_CODE;
-    if (p_ctrl->echo)
+/******************************************************************************************************************//**
+* @brief  Runs the perf command, which lists the statistics of the commands that ran or clears them.
+* @param[in]  p_ctrl       Console control block
+* @param[in]  p_menu       Menu the command was entered in, the statistics of its whole menu tree are used
+* @param[in]  p_arg        Input following the perf command
+* @retval     FSP_SUCCESS  The statistics were listed or cleared, or usage was printed.
+* @return                  See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t sf_console_perf_command(sf_console_instance_ctrl_t       * const p_ctrl,
+                                        sf_console_menu_t          const * const p_menu,
+                                        uint8_t                    const * const p_arg)
+{
+    uint8_t const * p_word = p_arg;
+    while (SPACE_CODE == *p_word)
+    {
+        p_word++;
+    }
+
+    bool reset = (check_for_match(p_word, SF_CONSOLE_PERF_RESET) > 0);
+    if ((NULL_CODE != *p_word) && !reset)
+    {
+        return SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "USAGE: %s [%s]\r\n",
+                                      (char const *) SF_CONSOLE_PERF_COMMAND, (char const *) SF_CONSOLE_PERF_RESET);
+    }
+
+    /** Lock the console channel so the table is not split by output of asynchronous commands. */
+    uint32_t err;
+    err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
+    SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+    sf_console_menu_t const * visited[SF_CONSOLE_CFG_MAX_INDEXED_MENUS];
+    uint32_t visited_count = 0U;
+    uint32_t rows = 0U;
+    err = sf_console_perf_menu(p_ctrl, sf_console_menu_root(p_menu), NULL, &visited[0], &visited_count, &rows, reset);
+
+    if ((FSP_SUCCESS == err) && reset)
+    {
+        err = SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "Statistics cleared\r\n");
+    }
+    else if ((FSP_SUCCESS == err) && (0U == rows))
+    {
+        err = SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "No commands timed\r\n");
+    }
+
+    p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+
+    return err;
+}  /* End of function sf_console_perf_command */
+
+/******************************************************************************************************************//**
+* @brief  Lists or clears the statistics of the commands of a menu, then of the menus it leads to.
+* @param[in]      p_ctrl      Console control block, the TX channel must be locked
+* @param[in]      p_menu      Menu to list, may be NULL
+* @param[in]      p_path      Command leading to p_menu, shown before its commands.  NULL for the root menu.
+* @param[in,out]  pp_visited  Menus already listed, SF_CONSOLE_CFG_MAX_INDEXED_MENUS entries
+* @param[in,out]  p_visited   Number of entries of pp_visited used
+* @param[in,out]  p_rows      Number of commands listed so far
+* @param[in]      reset       true to clear the statistics instead of listing them
+* @retval     FSP_SUCCESS  The menus were listed.
+* @return                  See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t sf_console_perf_menu(sf_console_instance_ctrl_t       * const p_ctrl,
+                                     sf_console_menu_t          const * const p_menu,
+                                     uint8_t                    const * const p_path,
+                                     sf_console_menu_t          const **      pp_visited,
+                                     uint32_t                         * const p_visited,
+                                     uint32_t                         * const p_rows,
+                                     bool                               const reset)
+{
+    /** Menus lead back to the ones they came from, so each is only listed once. */
+    for (uint32_t i = 0U; (NULL != p_menu) && (i < *p_visited); i++)
+    {
+        if (p_menu == pp_visited[i])
+        {
+            return FSP_SUCCESS;
+        }
+    }
+    if ((NULL == p_menu) || (*p_visited >= SF_CONSOLE_CFG_MAX_INDEXED_MENUS))
+    {
+        return FSP_SUCCESS;
+    }
+    pp_visited[(*p_visited)++] = p_menu;
+
+    TX_INTERRUPT_SAVE_AREA
+    uint32_t err = FSP_SUCCESS;
+    for (uint32_t i = 0U; (i < p_menu->num_commands) && (FSP_SUCCESS == err); i++)
+    {
+        sf_console_command_t const * p_command = &p_menu->command_list[i];
+        if (SF_CONSOLE_CALLBACK_NEXT_FUNCTION == p_command->callback)
+        {
+            err = sf_console_perf_menu(p_ctrl, (sf_console_menu_t const *) p_command->context, p_command->command,
+                                       pp_visited, p_visited, p_rows, reset);
+            continue;
+        }
+        if (NULL == p_menu->p_stats)
+        {
+            continue;
+        }
+
+        if (reset)
+        {
+            TX_DISABLE
+            memset(&p_menu->p_stats[i], 0, sizeof(p_menu->p_stats[i]));
+            TX_RESTORE
+            continue;
+        }
+
+        /** Take a consistent copy, the command may be running on another console or a worker. */
+        sf_console_command_stats_t stats;
+        TX_DISABLE
+        stats = p_menu->p_stats[i];
+        TX_RESTORE
+        if (0U == stats.count)
+        {
+            continue;
+        }
+
+        if (0U == *p_rows)
+        {
+            err = SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT,
+                                         "|  Count |   Min us |   P50 us |   P99 us |   Max us |    Ticks | Command\r\n"
+                                         "|--------|----------|----------|----------|----------|----------|--------\r\n");
+        }
+        (*p_rows)++;
+
+        if (FSP_SUCCESS == err)
+        {
+            err = SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT,
+                                         "| %6lu | %8lu | %8lu | %8lu | %8lu | %8lu | %s%s%s\r\n",
+                                         (unsigned long) stats.count, (unsigned long) stats.min_us,
+                                         (unsigned long) sf_console_stats_percentile(&stats, 50U),
+                                         (unsigned long) sf_console_stats_percentile(&stats, 99U),
+                                         (unsigned long) stats.max_us, (unsigned long) stats.total_ticks,
+                                         (NULL != p_path) ? (char const *) p_path : "", (NULL != p_path) ? " " : "",
+                                         (char const *) p_command->command);
+        }
+    }
+
+    return err;
+}  /* End of function sf_console_perf_menu */
+
+/******************************************************************************************************************//**
+* @brief  Finds the root of the menu tree a menu is in.
+* @param[in]  p_menu  Menu to start from
+* @return  The menu with no previous menu
+***********************************************************************************************************************/
+static sf_console_menu_t const * sf_console_menu_root(sf_console_menu_t const * p_menu)
+{
+    while (NULL != p_menu->menu_prev)
+    {
+        p_menu = p_menu->menu_prev;
+    }
+
+    return p_menu;
+}  /* End of function sf_console_menu_root */
+
+/******************************************************************************************************************//**
+* @brief  Runs the output command, which shows how tables are rendered or chooses a renderer.
+* @param[in]  p_ctrl       Console control block
+* @param[in]  p_arg        Input following the output command
+* @retval     FSP_SUCCESS  The renderer was shown or chosen, or usage was printed.
+* @return                  See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t sf_console_output_command(sf_console_instance_ctrl_t * const p_ctrl, uint8_t const * const p_arg)
+{
+    static char const * const output_names[] = { "text", "csv", "json" };
+
+    uint8_t const * p_word = p_arg;
+    while (SPACE_CODE == *p_word)
+    {
+        p_word++;
+    }
+
+    if (NULL_CODE == *p_word)
+    {
+        return SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "Output is %s\r\n",
+                                      output_names[p_ctrl->output]);
+    }
+
+    for (uint32_t i = 0U; i < (sizeof(output_names) / sizeof(output_names[0])); i++)
+    {
+        int32_t length = check_for_match(p_word, (uint8_t const *) output_names[i]);
+        if ((length > 0) && ((NULL_CODE == p_word[length]) || (SPACE_CODE == p_word[length])))
+        {
+            p_ctrl->output = (sf_console_output_t) i;
+            return FSP_SUCCESS;
+        }
+    }
+
+    return SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "USAGE: %s [%s|%s|%s]\r\n",
+                                  (char const *) SF_CONSOLE_OUTPUT_COMMAND, output_names[0], output_names[1],
+                                  output_names[2]);
+}  /* End of function sf_console_output_command */
+
+/******************************************************************************************************************//**
+* @brief  Writes the heading of the open table.  JSON rows carry their keys, so they have no heading.
+* @param[in]  p_ctrl       Console control block, the TX channel must be locked
+* @retval     FSP_SUCCESS  The heading was written or buffered.
+* @return                  See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t sf_console_table_heading(sf_console_instance_ctrl_t * const p_ctrl)
+{
+    sf_console_column_t const * p_columns = p_ctrl->table.p_columns;
+    uint32_t count = p_ctrl->table.count;
+    uint32_t err = FSP_SUCCESS;
+
+    /** Host tools get the column names in a values frame. */
+    if (p_ctrl->rpc.active)
+    {
+        sf_console_value_t names[SF_CONSOLE_CFG_MAX_ARGS];
+        for (uint32_t i = 0U; i < count; i++)
+        {
+            SF_CONSOLE_ERROR_RETURN(i < SF_CONSOLE_CFG_MAX_ARGS, FSP_ERR_INVALID_SIZE);
+            names[i].type = SF_CONSOLE_ARG_TYPE_STRING;
+            names[i].arg.p_text = p_columns[i].p_name;
+            names[i].arg.length = (uint32_t) strlen((char const *) p_columns[i].p_name);
+        }
+
+        err = format_flush(p_ctrl);
+        SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+        return SF_CONSOLE_RpcValues(p_ctrl, &names[0], count);
+    }
+
+    if (SF_CONSOLE_OUTPUT_JSON == p_ctrl->output)
+    {
+        return FSP_SUCCESS;
+    }
+
+    for (uint32_t i = 0U; (i < count) && (FSP_SUCCESS == err); i++)
+    {
+        uint32_t length = (uint32_t) strlen((char const *) p_columns[i].p_name);
+        if (SF_CONSOLE_OUTPUT_CSV == p_ctrl->output)
+        {
+            err = (0U == i) ? FSP_SUCCESS : format_put(p_ctrl, ",", 1U);
+            err = (FSP_SUCCESS == err) ? sf_console_table_quote(p_ctrl, p_columns[i].p_name, length) : err;
+        }
+        else
+        {
+            err = format_put(p_ctrl, (0U == i) ? "| " : " | ", (0U == i) ? 2U : 3U);
+            err = (FSP_SUCCESS == err) ? format_pad(p_ctrl, sf_console_table_width(&p_columns[i]) - length) : err;
+            err = (FSP_SUCCESS == err) ? format_put(p_ctrl, (char const *) p_columns[i].p_name, length) : err;
+        }
+    }
+
+    if ((FSP_SUCCESS == err) && (SF_CONSOLE_OUTPUT_TEXT == p_ctrl->output))
+    {
+        /** Rule the heading off, a dash for each character of the columns and their separating spaces. */
+        err = format_put(p_ctrl, " |\r\n|", 5U);
+        for (uint32_t i = 0U; (i < count) && (FSP_SUCCESS == err); i++)
+        {
+            uint32_t dashes = sf_console_table_width(&p_columns[i]) + 2U;
+            while ((dashes > 0U) && (FSP_SUCCESS == err))
+            {
+                uint32_t chunk = (dashes > 8U) ? 8U : dashes;
+                err = format_put(p_ctrl, "--------", chunk);
+                dashes -= chunk;
+            }
+            err = (FSP_SUCCESS == err) ? format_put(p_ctrl, "|", 1U) : err;
+        }
+    }
+
+    return (FSP_SUCCESS == err) ? format_put(p_ctrl, "\r\n", 2U) : err;
+}  /* End of function sf_console_table_heading */
+
+/******************************************************************************************************************//**
+* @brief  Renders a row of the open table into the scratch buffer, which is written when it fills.
+* @param[in]  p_ctrl       Console control block, the TX channel must be locked
+* @param[in]  p_values     Values of the row, one per column
+* @retval     FSP_SUCCESS  The row was written or buffered.
+* @return                  See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t sf_console_table_row(sf_console_instance_ctrl_t       * const p_ctrl,
+                                     sf_console_value_t         const * const p_values)
+{
+    sf_console_column_t const * p_columns = p_ctrl->table.p_columns;
+    uint32_t err = FSP_SUCCESS;
+
+    /** Host tools get the row in a values frame, after any text written before it. */
+    if (p_ctrl->rpc.active)
+    {
+        err = format_flush(p_ctrl);
+        SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+        return SF_CONSOLE_RpcValues(p_ctrl, p_values, p_ctrl->table.count);
+    }
+
+    if (SF_CONSOLE_OUTPUT_JSON == p_ctrl->output)
+    {
+        err = format_put(p_ctrl, "{", 1U);
+    }
+
+    for (uint32_t i = 0U; (i < p_ctrl->table.count) && (FSP_SUCCESS == err); i++)
+    {
+        sf_console_value_t const * p_value = &p_values[i];
+        uint8_t const * p_text = p_value->arg.p_text;
+        uint32_t length = p_value->arg.length;
+
+        /** Numbers are printed into a local buffer, strings are used where they are. */
+        char number[32];
+        if (SF_CONSOLE_ARG_TYPE_STRING != p_value->type)
+        {
+            length = sf_console_table_number(p_ctrl->output, &p_columns[i], p_value, &number[0], sizeof(number));
+            p_text = (uint8_t const *) &number[0];
+        }
+
+        if (SF_CONSOLE_OUTPUT_TEXT == p_ctrl->output)
+        {
+            uint32_t width = sf_console_table_width(&p_columns[i]);
+            err = format_put(p_ctrl, (0U == i) ? "| " : " | ", (0U == i) ? 2U : 3U);
+            err = ((FSP_SUCCESS == err) && (length < width)) ? format_pad(p_ctrl, width - length) : err;
+            err = (FSP_SUCCESS == err) ? format_put(p_ctrl, (char const *) p_text, length) : err;
+            continue;
+        }
+
+        err = (0U == i) ? FSP_SUCCESS : format_put(p_ctrl, ",", 1U);
+        if (SF_CONSOLE_OUTPUT_JSON == p_ctrl->output)
+        {
+            err = (FSP_SUCCESS == err) ? sf_console_table_quote(p_ctrl, p_columns[i].p_name,
+                                                                 (uint32_t) strlen((char const *) p_columns[i].p_name))
+                                       : err;
+            err = (FSP_SUCCESS == err) ? format_put(p_ctrl, ":", 1U) : err;
+        }
+
+        if (SF_CONSOLE_ARG_TYPE_STRING == p_value->type)
+        {
+            err = (FSP_SUCCESS == err) ? sf_console_table_quote(p_ctrl, p_text, length) : err;
+        }
+        else
+        {
+            err = (FSP_SUCCESS == err) ? format_put(p_ctrl, (char const *) p_text, length) : err;
+        }
+    }
+
+    if (FSP_SUCCESS == err)
+    {
+        switch (p_ctrl->output)
+        {
+            case SF_CONSOLE_OUTPUT_TEXT: err = format_put(p_ctrl, " |\r\n", 4U); break;
+            case SF_CONSOLE_OUTPUT_JSON: err = format_put(p_ctrl, "}\r\n", 3U);  break;
+            default:                     err = format_put(p_ctrl, "\r\n", 2U);   break;
+        }
+    }
+
+    return err;
+}  /* End of function sf_console_table_row */
+
+/******************************************************************************************************************//**
+* @brief  Finds the width of a column in text, which is at least the width of its heading.
+* @param[in]  p_column  Column to measure
+* @return  Width of the column in characters
+***********************************************************************************************************************/
+static uint32_t sf_console_table_width(sf_console_column_t const * const p_column)
+{
+    uint32_t length = (uint32_t) strlen((char const *) p_column->p_name);
+
+    return (p_column->width > length) ? p_column->width : length;
+}  /* End of function sf_console_table_width */
+
+/******************************************************************************************************************//**
+* @brief  Prints a value that is not a string.  JSON gets hexadecimal values in decimal, and null for floats that are
+*         not finite.
+* @param[in]  output       Renderer the value is printed for
+* @param[in]  p_column     Column of the value, giving the precision of floats
+* @param[in]  p_value      Value to print
+* @param[out] p_dest       Buffer to print into
+* @param[in]  size         Size of p_dest in bytes
+* @return  Length of the printed value, without the NULL terminator
+***********************************************************************************************************************/
+static uint32_t sf_console_table_number(sf_console_output_t        const         output,
+                                        sf_console_column_t        const * const p_column,
+                                        sf_console_value_t         const * const p_value,
+                                        char                             * const p_dest,
+                                        uint32_t                           const size)
+{
+    int length = 0;
+
+    switch (p_value->type)
+    {
+        case SF_CONSOLE_ARG_TYPE_INT:
+            length = snprintf(p_dest, size, "%ld", (long) p_value->arg.value.integer);
+            break;
+        case SF_CONSOLE_ARG_TYPE_FLOAT:
+            if ((SF_CONSOLE_OUTPUT_JSON == output) && !isfinite(p_value->arg.value.real))
+            {
+                length = snprintf(p_dest, size, "null");
+            }
+            else
+            {
+                length = snprintf(p_dest, size, "%.*f", (int) p_column->precision, (double) p_value->arg.value.real);
+            }
+            break;
+        case SF_CONSOLE_ARG_TYPE_HEX:
+            length = snprintf(p_dest, size, (SF_CONSOLE_OUTPUT_JSON == output) ? "%lu" : "0x%lX",
+                              (unsigned long) p_value->arg.value.hex);
+            break;
+        default:
+            length = snprintf(p_dest, size, "%lu", (unsigned long) p_value->arg.value.choice);
+            break;
+    }
+
+    /** A value cut short by the buffer keeps what fitted. */
+    if (length < 0)
+    {
+        return 0U;
+    }
+
+    return ((uint32_t) length < size) ? (uint32_t) length : (size - 1U);
+}  /* End of function sf_console_table_number */
+
+/******************************************************************************************************************//**
+* @brief  Writes a string in double quotes for the output of the console.  CSV doubles the quotes in the string and
+*         only quotes strings that need it, JSON always quotes and escapes quotes, backslashes and control characters.
+* @param[in]  p_ctrl       Console control block, the TX channel must be locked
+* @param[in]  p_text       String to write, does not need to be NULL terminated
+* @param[in]  length       Length of the string in bytes
+* @retval     FSP_SUCCESS  The string was written or buffered.
+* @return                  See @ref Common_Error_Codes or lower level drivers for other possible return codes
+***********************************************************************************************************************/
+static uint32_t sf_console_table_quote(sf_console_instance_ctrl_t       * const p_ctrl,
+                                       uint8_t                    const * const p_text,
+                                       uint32_t                           const length)
+{
+    bool json = (SF_CONSOLE_OUTPUT_JSON == p_ctrl->output);
+    bool quote = json;
+
+    for (uint32_t i = 0U; (i < length) && !quote; i++)
+    {
+        quote = ((',' == p_text[i]) || ('"' == p_text[i]) || ('\r' == p_text[i]) || ('\n' == p_text[i]));
+    }
+
+    if (!quote)
+    {
+        return format_put(p_ctrl, (char const *) p_text, length);
+    }
+
+    /** Runs of characters that need no escape are added in one go. */
+    uint32_t err = format_put(p_ctrl, "\"", 1U);
+    uint32_t start = 0U;
+    for (uint32_t i = 0U; (i <= length) && (FSP_SUCCESS == err); i++)
+    {
+        bool escape = (i < length) &&
+                      (('"' == p_text[i]) || (json && (('\\' == p_text[i]) || (p_text[i] < (uint8_t) SPACE_CODE))));
+        if (!escape && (i < length))
+        {
+            continue;
+        }
+
+        err = format_put(p_ctrl, (char const *) &p_text[start], i - start);
+        start = i + 1U;
+        if ((FSP_SUCCESS == err) && escape)
+        {
+            char escaped[8];
+            int escaped_length = (!json || ('"' == p_text[i]) || ('\\' == p_text[i])) ?
+                                 snprintf(escaped, sizeof(escaped), "%c%c", json ? '\\' : '"', (char) p_text[i]) :
+                                 snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned int) p_text[i]);
+            err = format_put(p_ctrl, escaped, (uint32_t) escaped_length);
+        }
+    }
+
+    return (FSP_SUCCESS == err) ? format_put(p_ctrl, "\"", 1U) : err;
+}  /* End of function sf_console_table_quote */
+
+/******************************************************************************************************************//**
+* @brief  Adds a line to the history ring, dropping the oldest lines until it fits.  Empty lines, lines too long for the
+*         ring and repeats of the newest line are not added.
+* @param[in,out]  p_history  History ring
+* @param[in]      p_line     Line to add, does not need to be NULL terminated
+* @param[in]      length     Length of the line in bytes
+***********************************************************************************************************************/
+static void history_add(sf_console_history_t * const p_history, uint8_t const * const p_line, uint32_t const length)
+{
+    uint32_t entry = length + 2U;
+    if ((NULL == p_history->p_buffer) || (0U == length) || (length > UINT8_MAX) || (entry > p_history->size))
+    {
+        return;
+    }
+
+    /** Repeating the newest line adds nothing. */
+    if (p_history->count > 0U)
+    {
+        uint32_t offset = history_locate(p_history, 1U);
+        if (length == (uint32_t) p_history->p_buffer[offset])
+        {
+            uint32_t i = 0U;
+            while ((i < length) && (p_line[i] == p_history->p_buffer[history_wrap(p_history, offset + 1U + i)]))
+            {
+                i++;
+            }
+            if (i == length)
+            {
+                return;
+            }
+        }
+    }
+
+    /** Drop the oldest lines until there is room. */
+    while ((p_history->size - p_history->used) < entry)
+    {
+        uint32_t dropped = (uint32_t) p_history->p_buffer[p_history->tail] + 2U;
+        p_history->tail = history_wrap(p_history, p_history->tail + dropped);
+        p_history->used -= dropped;
+        p_history->count--;
+        p_history->first++;
+    }
+
+    /** Store the length before and after the line. */
+    p_history->p_buffer[p_history->head] = (uint8_t) length;
+    for (uint32_t i = 0U; i < length; i++)
+    {
+        p_history->p_buffer[history_wrap(p_history, p_history->head + 1U + i)] = p_line[i];
+    }
+    p_history->p_buffer[history_wrap(p_history, p_history->head + 1U + length)] = (uint8_t) length;
+
+    p_history->head = history_wrap(p_history, p_history->head + entry);
+    p_history->used += entry;
+    p_history->count++;
+}
+
+/******************************************************************************************************************//**
+* @brief  Finds a line in the history ring by walking back from the newest line.
+* @param[in]  p_history  History ring
+* @param[in]  back       1 for the newest line, up to the number of lines kept for the oldest.
+* @return  Offset of the length stored before the line
+***********************************************************************************************************************/
+static uint32_t history_locate(sf_console_history_t const * const p_history, uint32_t back)
+{
+    uint32_t offset = p_history->head;
+    while (back > 0U)
+    {
+        uint32_t length = (uint32_t) p_history->p_buffer[history_wrap(p_history, (offset + p_history->size) - 1U)];
+        offset = history_wrap(p_history, (offset + p_history->size) - (length + 2U));
+        back--;
+    }
+
+    return offset;
+}
+
+/******************************************************************************************************************//**
+* @brief  Copies a line out of the history ring and terminates it.
+* @param[in]   p_history  History ring
+* @param[in]   offset     Offset of the length stored before the line
+* @param[out]  p_dest     Destination, must hold the line and the terminating NULL
+* @return  Length of the line
+***********************************************************************************************************************/
+static uint32_t history_copy(sf_console_history_t const * const p_history, uint32_t offset, uint8_t * const p_dest)
+{
+    uint32_t length = (uint32_t) p_history->p_buffer[offset];
+    for (uint32_t i = 0U; i < length; i++)
     {
-        /* Print shifted string, then move cursor back to index after inserted character. */
-        uint32_t err;
-        if (0U == last_index)
-        {
-            /** When the first byte is received, lock transmission if echo is on. */
-            err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
-            SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
-        }
-        err = SF_CONSOLE_Write(p_ctrl, p_start, SF_CONSOLE_PRV_TIMEOUT);
-        if (FSP_SUCCESS == err)
-        {
-            move_cursor(p_ctrl, SF_CONSOLE_CURSOR_DIR_LEFT, (strlen((char *) p_start) - 1));
-        }
+        p_dest[i] = p_history->p_buffer[history_wrap(p_history, offset + 1U + i)];
     }
+    p_dest[length] = NULL_CODE;
 
-    return FSP_SUCCESS;
-} /* End of function insert_char */
+    return length;
+}
 
 /******************************************************************************************************************//**
-* @brief  Moves cursor in the direction specified by the number of spaces specified.
-* @pre    Lock the UART framework before calling this function.
-* @param[in]  p_ctrl       Console control block, used to print to the console if echo mode is on.
-* @param[in]  dir         Select to move cursor right or left.
-* @param[in]  num_spaces  Number of spaces to move cursor.
+* @brief  Wraps an offset into the history ring.
+* @param[in]  p_history  History ring
+* @param[in]  offset     Offset less than twice the ring size
+* @return  Offset within the ring
 ***********************************************************************************************************************/
-static void move_cursor(sf_console_instance_ctrl_t * p_ctrl, sf_console_cursor_dir_t dir, uint32_t num_spaces)
+static uint32_t history_wrap(sf_console_history_t const * const p_history, uint32_t offset)
 {
-    if (p_ctrl->echo)
+    return (offset >= p_history->size) ? (offset - p_history->size) : offset;
+}
+
+/******************************************************************************************************************//**
+* @brief  Replaces a history reference at the start of the input line with the line it refers to.  Any text after the
+*         reference is kept after the recalled line, and the resulting line is echoed so the operator sees what runs.
+* @param[in,out]  p_ctrl      Console control block holding the input line and the history
+* @retval FSP_SUCCESS         The reference was replaced.
+* @retval FSP_ERR_NOT_FOUND   The reference does not name a line kept in the history.
+***********************************************************************************************************************/
+static uint32_t sf_console_history_expand(sf_console_instance_ctrl_t * const p_ctrl)
+{
+    sf_console_history_t * p_history = &p_ctrl->history;
+    uint8_t const * p_rest = &p_ctrl->input[1];
+    uint32_t back = 0U;
+
+    /** !! is the newest line, !-n counts back from it and !n is line number n. */
+    if ((uint8_t) SF_CONSOLE_HISTORY_RECALL_CHAR == *p_rest)
     {
-        /** Prepare escape code to send */
-        uint8_t buf[4];
-        buf[0] = ESC_CODE_1;
-        buf[1] = ESC_CODE_2;
-        if (SF_CONSOLE_CURSOR_DIR_LEFT == dir)
+        back = 1U;
+        p_rest++;
+    }
+    else
+    {
+        bool relative = ('-' == *p_rest);
+        if (relative)
         {
-            buf[2] = LEFT_ARROW_CODE;
+            p_rest++;
         }
-        else
+        SF_CONSOLE_ERROR_RETURN(0 != isdigit((int32_t) *p_rest), FSP_ERR_NOT_FOUND);
+
+        char * p_end = NULL;
+        unsigned long number = strtoul((char const *) p_rest, &p_end, 10);
+        p_rest = (uint8_t const *) p_end;
+        if (relative)
         {
-            /* SF_CONSOLE_CURSOR_DIR_RIGHT == dir */
-            buf[2] = RIGHT_ARROW_CODE;
+            back = (number <= p_history->count) ? (uint32_t) number : 0U;
         }
-        buf[3] = NULL_CODE;
-
-        /** Send the escape code num_spaces times */
-        for (uint32_t i = 0U; i < num_spaces; i++)
+        else if ((number >= p_history->first) && ((number - p_history->first) < p_history->count))
+        {
+            back = (p_history->first + p_history->count) - (uint32_t) number;
+        }
+        else
         {
-            SF_CONSOLE_Write(p_ctrl, &buf[0], SF_CONSOLE_PRV_TIMEOUT);
+            /* Not kept. */
         }
     }
-} /* End of function move_cursor */
+    SF_CONSOLE_ERROR_RETURN((back > 0U) && (back <= p_history->count), FSP_ERR_NOT_FOUND);
+
+    /** Build the line aside, since the text after the reference is still in the input buffer. */
+    uint8_t line[SF_CONSOLE_MAX_INPUT_LENGTH];
+    uint32_t length = history_copy(p_history, history_locate(p_history, back), &line[0]);
+    uint32_t rest = (uint32_t) strlen((char const *) p_rest);
+    if (rest > ((SF_CONSOLE_MAX_INPUT_LENGTH - 1U) - length))
+    {
+        rest = (SF_CONSOLE_MAX_INPUT_LENGTH - 1U) - length;
+    }
+    memcpy(&line[length], p_rest, rest);
+    line[length + rest] = NULL_CODE;
+    memcpy(&p_ctrl->input[0], &line[0], length + rest + 1U);
+
+    if (p_ctrl->echo)
+    {
+        SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "%s\r\n", (char const *) p_ctrl->input);
+    }
+
+    return FSP_SUCCESS;
+}
 
 /******************************************************************************************************************//**
-* @brief  Prints help menu to console.
-* @param[in]  p_ctrl      Console control block, used to print to the console if echo mode is on.
-* @param[in]  p_menu      Menu to print help for.
-* @param[in]  timeout     Timeout value
-* @retval FSP_SUCCESS     Prints help menu to console successfully.
+* @brief  Lists the lines kept in the history with the numbers to recall them by.
+* @param[in]  p_ctrl      Console control block
+* @retval FSP_SUCCESS     The list was written.
 * @return                 See @ref Common_Error_Codes or lower level drivers for other possible return codes
 ***********************************************************************************************************************/
-static uint32_t print_help_menu(sf_console_instance_ctrl_t * const p_ctrl, sf_console_menu_t const * const p_menu,
-        UINT timeout)
+static uint32_t sf_console_history_list(sf_console_instance_ctrl_t * const p_ctrl)
 {
-    /** Lock console UART channel to reserve exclusive access for multiple writes */
+    sf_console_history_t * p_history = &p_ctrl->history;
+
+    /** Lock the console channel so the list is written in one piece. */
     uint32_t err;
-    err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, timeout);
+    err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
     SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
 
-    /** Print "<MENU_NAME> Help Menu" indented by 2 spaces. */
-    p_ctrl->p_comms->p_api->write(p_ctrl->p_comms->p_ctrl, &g_white_space[0], 2, SF_CONSOLE_PRV_TIMEOUT);
-    SF_CONSOLE_Write(p_ctrl, p_menu->menu_name, SF_CONSOLE_PRV_TIMEOUT);
-    SF_CONSOLE_Write(p_ctrl, (uint8_t *) " Help Menu\r\n", SF_CONSOLE_PRV_TIMEOUT);
-
-    /** If it is possible to go back one menu, print this option and the home option. */
-    if (NULL != p_ctrl->p_current_menu->menu_prev)
-    {
-    	p_ctrl->p_comms->p_api->write(p_ctrl->p_comms->p_ctrl, &g_white_space[0], 4, SF_CONSOLE_PRV_TIMEOUT);
-        SF_CONSOLE_Write(p_ctrl, SF_CONSOLE_ROOT_MENU_COMMAND, SF_CONSOLE_PRV_TIMEOUT);
-        SF_CONSOLE_Write(p_ctrl, (uint8_t *) " : Back to root menu\r\n", SF_CONSOLE_PRV_TIMEOUT);
-        p_ctrl->p_comms->p_api->write(p_ctrl->p_comms->p_ctrl, &g_white_space[0], 4, SF_CONSOLE_PRV_TIMEOUT);
-        SF_CONSOLE_Write(p_ctrl, SF_CONSOLE_MENU_PREVIOUS_COMMAND, SF_CONSOLE_PRV_TIMEOUT);
-        SF_CONSOLE_Write(p_ctrl, (uint8_t *) " : Up one menu level\r\n", SF_CONSOLE_PRV_TIMEOUT);
-    }
-
-    /** Print each command followed by the associated help string if one is provided. Commands are
-     *  indented by 4 spaces and followed by carriage return and newline characters. */
-    for (uint32_t i = 0U; i < p_menu->num_commands; i++)
+    /** Walk forward from the oldest line. */
+    uint32_t offset = p_history->tail;
+    for (uint32_t i = 0U; (i < p_history->count) && (FSP_SUCCESS == err); i++)
     {
-    	p_ctrl->p_comms->p_api->write(p_ctrl->p_comms->p_ctrl, &g_white_space[0], 4, SF_CONSOLE_PRV_TIMEOUT);
-        SF_CONSOLE_Write(p_ctrl, p_menu->command_list[i].command, SF_CONSOLE_PRV_TIMEOUT);
-        if (NULL != p_menu->command_list[i].help)
-        {
-            SF_CONSOLE_Write(p_ctrl, (uint8_t *) " : ", SF_CONSOLE_PRV_TIMEOUT);
-            SF_CONSOLE_Write(p_ctrl, p_menu->command_list[i].help, SF_CONSOLE_PRV_TIMEOUT);
-        }
-        SF_CONSOLE_Write(p_ctrl, (uint8_t *) "\r\n", SF_CONSOLE_PRV_TIMEOUT);
+        uint8_t line[SF_CONSOLE_MAX_INPUT_LENGTH];
+        uint32_t length = history_copy(p_history, offset, &line[0]);
+        offset = history_wrap(p_history, offset + length + 2U);
+        err = SF_CONSOLE_WriteFormat(p_ctrl, SF_CONSOLE_PRV_TIMEOUT, "%5lu  %s\r\n",
+                                     (unsigned long) (p_history->first + i), (char const *) &line[0]);
     }
-    SF_CONSOLE_Write(p_ctrl, (uint8_t *) "\r\n", SF_CONSOLE_PRV_TIMEOUT);
 
-    /** Unlock console UART channel after all writes are complete. */
     p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
 
-    return FSP_SUCCESS;
-} /* End of function print_help_menu */
-
+    return err;
+}
 
 /******************************************************************************************************************//**
-* @brief  Finds the end of the current string, then parses the remaining string.
-* @param[in]  p_ctrl      Console control block, passed to the parse command to parse the remaining string.
-* @param[in]  p_input     Used to search for the end of the current command, which marks the beginning of the remaining
-*                         string.
-* @param[in]  bytes       The total number of bytes in the input string p_input
+* @brief  Processes up and down arrow keys when history is kept, replacing the line with an older or newer history line.
+* @note   Only lines read by the prompt are replaced, other reads have their own buffer size.  Transmission stays locked
+*         while the line is non-empty, as for typed input.
+* @param[in,out]  p_ctrl       Console control block
+* @param[in,out]  p_dest       The destination buffer where input data is stored
+* @param[in,out]  p_index      The cursor index in the destination buffer
+* @param[in,out]  p_length     The length of the line in the destination buffer (in bytes)
+* @param[in]      older        true to go back one line, false to go forward one line
+* @retval         FSP_SUCCESS  Arrow key processed successfully.
+* @return                      See @ref Common_Error_Codes or lower level drivers for other possible return codes.
 ***********************************************************************************************************************/
-static void sf_console_continue_parsing(sf_console_instance_ctrl_t * const p_ctrl,
-                                        uint8_t              const * const p_input,
-                                        uint32_t                     const bytes)
+static uint32_t sf_console_read_history_recall(sf_console_instance_ctrl_t * const p_ctrl,
+                                               uint8_t                    * const p_dest,
+                                               uint32_t                   *       p_index,
+                                               uint32_t                   *       p_length,
+                                               bool                               older)
 {
+    sf_console_history_t * p_history = &p_ctrl->history;
+    if (&p_ctrl->input[0] != p_dest)
+    {
+        return FSP_SUCCESS;
+    }
 
-    if ((bytes > 0U) && (NULL_CODE != p_input[0]))
+    /** Stop at the oldest line, and at the empty line after the newest. */
+    if (older ? (p_history->browse >= p_history->count) : (0U == p_history->browse))
     {
-        uint32_t length = 1U;
-        /* Find the end of the string or the beginning of the next word to pass to the callback. */
-        while (((NULL_CODE != p_input[length]) && (SPACE_CODE != p_input[length - 1])) && (length < bytes))
-        {
-            length++;
-        }
-        if (NULL_CODE != p_input[length])
-        {
-            SF_CONSOLE_Parse(p_ctrl, p_ctrl->p_current_menu, &p_input[length], bytes - length);
-        }
+        return FSP_SUCCESS;
     }
-}
+    p_history->browse = older ? (p_history->browse + 1U) : (p_history->browse - 1U);
 
-/******************************************************************************************************************//**
-* @brief  Finds the end of the current string, then passes the remaining string to the callback.
-* @param[in]  p_ctrl      Console control block, passed in the callback arguments
-* @param[in]  p_callback  The callback function to call
-* @param[in]  p_context   The user context to pass in the callback arguments
-* @param[in]  p_input     Used to search for the end of the current command, which marks the beginning of the remaining
-*                         string.
-* @param[in]  bytes       The total number of bytes in the input string p_input
-* @param[in]  length      The starting index to search for the end of the current argument
-***********************************************************************************************************************/
-static void sf_console_call_callback(sf_console_instance_ctrl_t * const p_ctrl,
-                                     void                      (*       p_callback)(sf_console_callback_args_t * p_args),
-                                     void                 const *       p_context,
-                                     uint8_t              const * const p_input,
-                                     uint32_t                     const bytes,
-                                     int32_t                            length)
-{
-    if (NULL != p_callback)
+    uint32_t old_length = *p_length;
+    uint32_t new_length = 0U;
+    p_dest[0] = NULL_CODE;
+    if (p_history->browse > 0U)
     {
-        /* Find the end of the string or the beginning of the next word to pass to the callback. */
-        while (((NULL_CODE != p_input[length]) && (SPACE_CODE != p_input[length - 1])) && ((uint32_t) length < SF_CONSOLE_MAX_INPUT_LENGTH))
+        new_length = history_copy(p_history, history_locate(p_history, p_history->browse), p_dest);
+    }
+
+    if (p_ctrl->echo)
+    {
+        uint32_t err;
+        if ((0U == old_length) && (new_length > 0U))
         {
-            length++;
+            /** Lock transmission as when the first byte of a line is typed. */
+            err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
+            SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
         }
 
-        /* Call user provided callback */
-        sf_console_cb_args_t args;
-        args.p_ctrl = p_ctrl;
-        args.context = p_context;
-        args.p_remaining_string = &p_input[length];
-        args.bytes = bytes - (uint32_t) length;
-
-        if (SF_CONSOLE_CALLBACK_NEXT_FUNCTION == p_callback)
+        /** Draw the new line over the old one and blank what is left of the old one. */
+        move_cursor(p_ctrl, SF_CONSOLE_CURSOR_DIR_LEFT, *p_index);
+        frame_append(p_ctrl, p_dest, new_length);
+        if (old_length > new_length)
         {
-            SF_CONSOLE_CallbackNextMenu(&args);
+            uint32_t blank = old_length - new_length;
+            while (blank > 0U)
+            {
+                uint32_t chunk = (blank > sizeof(g_white_space)) ? sizeof(g_white_space) : blank;
+                frame_append(p_ctrl, &g_white_space[0], chunk);
+                blank -= chunk;
+            }
+            move_cursor(p_ctrl, SF_CONSOLE_CURSOR_DIR_LEFT, old_length - new_length);
         }
-        else
+
+        if ((old_length > 0U) && (0U == new_length))
         {
-            p_callback(&args);
+            /** Unlock transmission once the line is empty again.  The redraw goes out first. */
+            frame_send(p_ctrl);
+            err = p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+            SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
         }
     }
+
+    *p_index = new_length;
+    *p_length = new_length;
+
+    return FSP_SUCCESS;
 }
 
 /******************************************************************************************************************//**
@@ -865,8 +4852,9 @@ static uint32_t sf_console_read_process_up_arrow(sf_console_instance_ctrl_t * co
                                              uint32_t                   *       p_index,
                                              uint32_t                   *       p_length)
 {
-    /* Restore persistent value from last input.  This only works if no input has been entered. */
-    if ((&p_ctrl->input[0]) == (&p_dest[*p_index]))
+    /* Restore persistent value from last input.  This only works if no input has been entered, otherwise transmission
+     * is already locked for the echo and the line would be printed over itself. */
+    if (((&p_ctrl->input[0]) == (&p_dest[*p_index])) && (0U == *p_length))
     {
         uint32_t len = strlen((char *) p_dest);
         uint32_t err;
@@ -875,7 +4863,7 @@ static uint32_t sf_console_read_process_up_arrow(sf_console_instance_ctrl_t * co
             /** Lock transmission if echo is on. */
             err = p_ctrl->p_comms->p_api->lock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
             SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
-            SF_CONSOLE_Write(p_ctrl, p_dest, SF_CONSOLE_PRV_TIMEOUT);
+            frame_append(p_ctrl, p_dest, len);
         }
         *p_index += len;
         *p_length += len;
@@ -928,11 +4916,29 @@ static uint32_t sf_console_read_process_escape(sf_console_instance_ctrl_t * cons
     }
     case UP_ARROW_CODE:
     {
-        /* Restore persistent value from last input.  This only works if no input has been entered. */
-        err = sf_console_read_process_up_arrow(p_ctrl, p_dest, p_index, p_length);
+        if (NULL != p_ctrl->history.p_buffer)
+        {
+            /* Replace the line with the next older line in the history. */
+            err = sf_console_read_history_recall(p_ctrl, p_dest, p_index, p_length, true);
+        }
+        else
+        {
+            /* Restore persistent value from last input.  This only works if no input has been entered. */
+            err = sf_console_read_process_up_arrow(p_ctrl, p_dest, p_index, p_length);
+        }
         SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
     }
     break;
+    case DOWN_ARROW_CODE:
+    {
+        /* Replace the line with the next newer line in the history, or an empty line after the newest. */
+        if (NULL != p_ctrl->history.p_buffer)
+        {
+            err = sf_console_read_history_recall(p_ctrl, p_dest, p_index, p_length, false);
+            SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+        }
+    }
+    break;
     default:
     break;
     }
@@ -940,6 +4946,81 @@ static uint32_t sf_console_read_process_escape(sf_console_instance_ctrl_t * cons
     return FSP_SUCCESS;
 }
 
+/******************************************************************************************************************//**
+* @brief  Processes tab key input to the console, completing the command at the end of the line.
+* @note   The line is extended as far as all matching commands agree, followed by a space once it holds a whole command.
+*         If it cannot be extended the matching commands are listed and the line is drawn again below them.  Only
+*         lines read by the prompt are completed, with the cursor at the end of the line.
+* @param[in,out]  p_ctrl       Console control block
+* @param[in,out]  p_dest       The destination buffer where input data is stored
+* @param[in,out]  p_index      The cursor index in the destination buffer
+* @param[in,out]  p_length     The length of the line in the destination buffer (in bytes)
+* @retval         FSP_SUCCESS  Tab key processed successfully.
+* @return                      See @ref Common_Error_Codes or lower level drivers for other possible return codes.
+***********************************************************************************************************************/
+static uint32_t sf_console_read_process_tab(sf_console_instance_ctrl_t * const p_ctrl,
+                                            uint8_t                    * const p_dest,
+                                            uint32_t                   *       p_index,
+                                            uint32_t                   *       p_length)
+{
+    if ((&p_ctrl->input[0] != p_dest) || (*p_index != *p_length))
+    {
+        return FSP_SUCCESS;
+    }
+
+    /** Find the menu the last part of the line will be parsed in, then the commands there that start with it. */
+    p_dest[*p_length] = NULL_CODE;
+    uint32_t start;
+    sf_console_menu_t const * p_menu = sf_console_resolve_menu(p_ctrl, p_ctrl->p_current_menu, p_dest, &start);
+    uint32_t length = *p_length - start;
+    sf_console_completion_t completion;
+    sf_console_complete(p_ctrl, p_menu, &p_dest[start], length, &completion);
+
+    uint32_t err = FSP_SUCCESS;
+    if (completion.matched < length)
+    {
+        /** Nothing starts with the line. */
+        if (p_ctrl->echo)
+        {
+            frame_append(p_ctrl, (uint8_t const *) "\a", 1U);
+        }
+    }
+    else if ((completion.extend > 0U) || completion.unique)
+    {
+        /** Type the rest of the command as if it was entered, leaving room for the terminating NULL. */
+        uint8_t const * p_command = &p_menu->command_list[completion.command].command[length];
+        uint32_t count = completion.extend + (completion.unique ? 1U : 0U);
+        for (uint32_t i = 0U; (i < count) && (FSP_SUCCESS == err); i++)
+        {
+            if (*p_length >= (SF_CONSOLE_MAX_INPUT_LENGTH - 2U))
+            {
+                break;
+            }
+            uint8_t ch = (i < completion.extend) ? p_command[i] : SPACE_CODE;
+            err = insert_char(p_ctrl, p_dest, ch, *p_index, *p_length);
+            (*p_index)++;
+            (*p_length)++;
+        }
+    }
+    else if (p_ctrl->echo)
+    {
+        /** List the choices, then prompt again with the line as typed so far. */
+        frame_append(p_ctrl, (uint8_t const *) "\r\n", 2U);
+        sf_console_list_matches(p_ctrl, p_menu, &p_dest[start], length, UINT32_MAX, "  ");
+        frame_append(p_ctrl, (uint8_t const *) "\r\n", 2U);
+        frame_append(p_ctrl, p_ctrl->p_current_menu->menu_name,
+                     (uint32_t) strlen((char const *) p_ctrl->p_current_menu->menu_name));
+        frame_append(p_ctrl, (uint8_t const *) ">", 1U);
+        frame_append(p_ctrl, p_dest, *p_length);
+    }
+    else
+    {
+        /* Nothing to show without echo. */
+    }
+
+    return err;
+}
+
 /******************************************************************************************************************//**
 * @brief  Processes backspace inputs to the console.
 * @param[in,out]  p_ctrl      Console control block
@@ -959,7 +5040,7 @@ static uint32_t sf_console_read_process_backspace(sf_console_instance_ctrl_t * c
         if (p_ctrl->echo)
         {
             /* This moves the cursor backwards. */
-            SF_CONSOLE_Write(p_ctrl, (uint8_t *) "\b", SF_CONSOLE_PRV_TIMEOUT);
+            frame_append(p_ctrl, (uint8_t *) "\b", 1U);
         }
         (*p_index)--;
 
@@ -996,7 +5077,7 @@ static bool sf_console_read_process_new_line(sf_console_instance_ctrl_t * const
     if (p_ctrl->echo)
     {
         /* Carriage return indicates the end of the string.  Print carriage return and newline. */
-        SF_CONSOLE_Write(p_ctrl, (uint8_t *) "\r\n", SF_CONSOLE_PRV_TIMEOUT);
+        frame_append(p_ctrl, (uint8_t *) "\r\n", 2U);
     }
 
     /* Terminate the string with a null character. */
@@ -1055,6 +5136,11 @@ static uint32_t sf_console_read_process_byte(sf_console_instance_ctrl_t * const
         err = sf_console_read_process_escape(p_ctrl, p_dest, p_index, p_length);
         break;
     }
+    case TAB_CODE:
+    {
+        err = sf_console_read_process_tab(p_ctrl, p_dest, p_index, p_length);
+        break;
+    }
     case BACKSPACE_CODE:
     {
         err = sf_console_read_process_backspace(p_ctrl, p_dest, p_index, p_length);
@@ -1085,6 +5171,13 @@ static uint32_t sf_console_read_process_byte(sf_console_instance_ctrl_t * const
     }
     }
 
+    /** Everything the keystroke changed on the terminal goes out in one write. */
+    uint32_t send_err = frame_send(p_ctrl);
+    if (FSP_SUCCESS == err)
+    {
+        err = send_err;
+    }
+
     SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
     return FSP_SUCCESS;
 }
@@ -1094,7 +5187,8 @@ static uint32_t sf_console_read_process_byte(sf_console_instance_ctrl_t * const
 * @param[in]  p_ctrl            Console control block
 * @param[in]  p_dest            The destination buffer where input data is stored
 * @param[in]  bytes             The length of the destination buffer (in bytes)
-* @param[in]  timeout           The timeout accepted to read a single byte (in ThreadX ticks)
+* @param[in]  timeout           The timeout accepted to wait for the first byte of the line (in ThreadX ticks).  Once
+*                               input has started the rest of the line is waited for indefinitely.
 * @retval     FSP_SUCCESS       One byte of data is read successfully.
 * @retval     FSP_ERR_OVERFLOW  Input buffer is overflowed.
 * @return                       See @ref Common_Error_Codes or lower level drivers for other possible return codes.
@@ -1111,8 +5205,15 @@ static uint32_t sf_console_read_main(sf_console_instance_ctrl_t * const p_ctrl,
     uint32_t length = 0;
     while (true)
     {
-        /* Read a single byte. Return error if read fails. */
-        err = p_ctrl->p_comms->p_api->read(p_ctrl->p_comms->p_ctrl, &rx, 1, timeout);
+        /* Read a single byte. Return error if read fails.  Only an idle line may time out, a partially typed line
+         * would otherwise be lost along with the transmit lock taken for its echo. */
+        uint32_t wait = ((0U == length) && (0U == index)) ? timeout : SF_CONSOLE_PRV_TIMEOUT;
+        err = p_ctrl->p_comms->p_api->read(p_ctrl->p_comms->p_ctrl, &rx, 1, wait);
+        if ((FSP_SUCCESS != err) && (p_ctrl->echo) && (length > 0U))
+        {
+            /** Release the transmit lock taken for the echo of the abandoned line. */
+            p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+        }
         SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
 
         bool read_complete = false;
@@ -1132,7 +5233,8 @@ static uint32_t sf_console_read_main(sf_console_instance_ctrl_t * const p_ctrl,
     }
     SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
 
-    if ((p_ctrl->echo) && (index > 0U))
+    /* Transmission is locked while the line is non-empty, which the cursor position alone does not tell. */
+    if ((p_ctrl->echo) && (length > 0U))
     {
         /** Unlock transmission to allow debug messages.  Only needed when echo is on. */
         err = p_ctrl->p_comms->p_api->unlock(p_ctrl->p_comms->p_ctrl, SF_COMMS_LOCK_TX);
@@ -1142,6 +5244,124 @@ static uint32_t sf_console_read_main(sf_console_instance_ctrl_t * const p_ctrl,
     return FSP_SUCCESS;
 }
 
+/******************************************************************************************************************//**
+* @brief  Reads a line without echo, copying plain text straight out of the driver's receive spans.
+* @note   Control characters, and anything typed after the cursor was moved, are handed to the same per-byte editor as
+*         sf_console_read_main so a line reads the same either way.
+* @param[in]  p_ctrl            Console control block
+* @param[in]  p_dest            The destination buffer where input data is stored
+* @param[in]  bytes             The length of the destination buffer (in bytes)
+* @param[in]  timeout           The timeout accepted to wait for the first byte of the line (in ThreadX ticks).
+* @retval     FSP_SUCCESS       A line was read.
+* @retval     FSP_ERR_OVERFLOW  Input buffer is overflowed.
+* @return                       See @ref Common_Error_Codes or lower level drivers for other possible return codes.
+***********************************************************************************************************************/
+static uint32_t sf_console_read_raw(sf_console_instance_ctrl_t * const p_ctrl,
+                                     uint8_t                    * const p_dest,
+                                     uint32_t                     const bytes,
+                                     uint32_t                     const timeout)
+{
+    sf_comms_instance_t const * p_comms = p_ctrl->p_comms;
+    uint32_t err = FSP_SUCCESS;
+    uint32_t index = 0;
+    uint32_t length = 0;
+    bool read_complete = false;
+
+    while (!read_complete)
+    {
+        uint8_t const * p_span = NULL;
+        uint32_t span_bytes = 0;
+        uint32_t used = 0;
+
+        /* Only an idle line may time out. */
+        uint32_t wait = ((0U == length) && (0U == index)) ? timeout : SF_CONSOLE_PRV_TIMEOUT;
+        err = p_comms->p_api->readSpan(p_comms->p_ctrl, &p_span, &span_bytes, wait);
+        SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+        /** Copy plain text up to the next control character in one go while the cursor is at the end of the line. */
+        if (index == length)
+        {
+            uint32_t text = sf_console_find_control(p_span, span_bytes);
+            uint32_t room = (bytes - 1U) - length;
+            if (text > room)
+            {
+                text = room;
+            }
+            memcpy(&p_dest[length], p_span, text);
+            length += text;
+            index = length;
+            used = text;
+
+            err = check_for_overflow(p_ctrl, &index, bytes);
+            if (FSP_SUCCESS != err)
+            {
+                p_comms->p_api->readRelease(p_comms->p_ctrl, used);
+                return err;
+            }
+        }
+
+        /** Give the next byte to the editor.  It is released first since escape codes read the bytes after it. */
+        if (used < span_bytes)
+        {
+            uint8_t rx = p_span[used];
+            used++;
+            p_comms->p_api->readRelease(p_comms->p_ctrl, used);
+
+            err = sf_console_read_process_byte(p_ctrl, p_dest, rx, &index, &length, &read_complete);
+            SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+
+            if (!read_complete)
+            {
+                err = check_for_overflow(p_ctrl, &index, bytes);
+                SF_CONSOLE_ERROR_RETURN(FSP_SUCCESS == err, err);
+            }
+        }
+        else
+        {
+            p_comms->p_api->readRelease(p_comms->p_ctrl, used);
+        }
+    }
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************************************************//**
+* @brief  Finds the first byte the line editor has to handle, which is any ASCII control character or DEL.
+* @note   Looks at eight bytes per step with the usual has-less-than/has-zero word tricks, then pins down the byte
+*         within the word that flagged one.
+* @param[in]  p_src   Bytes to search
+* @param[in]  bytes   Number of bytes to search
+* @return  Index of the first control character, or bytes if there is none
+***********************************************************************************************************************/
+static uint32_t sf_console_find_control(uint8_t const * const p_src, uint32_t const bytes)
+{
+    uint64_t const ones = 0x0101010101010101ULL;
+    uint64_t const highs = 0x8080808080808080ULL;
+    uint32_t i = 0U;
+
+    while ((i + sizeof(uint64_t)) <= bytes)
+    {
+        uint64_t word;
+        memcpy(&word, &p_src[i], sizeof(word));
+
+        /* High bit set in a byte below SPACE_CODE, or equal to DELETE_CODE.  Bytes from 0x80 up never flag. */
+        uint64_t below_space = (word - (ones * SPACE_CODE)) & ~word & highs;
+        uint64_t delete_code = ((word ^ (ones * DELETE_CODE)) - ones) & ~(word ^ (ones * DELETE_CODE)) & highs;
+        if (0U != (below_space | delete_code))
+        {
+            break;
+        }
+        i += (uint32_t) sizeof(uint64_t);
+    }
+
+    while ((i < bytes) && (p_src[i] >= SPACE_CODE) && (DELETE_CODE != p_src[i]))
+    {
+        i++;
+    }
+
+    return i;
+}
+
 /******************************************************************************************************************//**
 * @brief  Checks to see overflow error condition.
 * @note   This function is insensitive to case.
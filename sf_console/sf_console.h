@@ -39,6 +39,8 @@
  * Includes
  **********************************************************************************************************************/
 #include "sf_console_api.h"
+#include "sf_console_jobs.h"
+#include "sf_console_rpc.h"
 
 /**********************************************************************************************************************
  * Macro definitions
@@ -47,9 +49,137 @@
 #define SF_CONSOLE_CODE_VERSION_MAJOR  (2U)
 #define SF_CONSOLE_CODE_VERSION_MINOR  (0U)
 
+/** Size of the buffer one keystroke's echo is built in, a full redraw of the line plus cursor movement */
+#define SF_CONSOLE_FRAME_LENGTH        (SF_CONSOLE_MAX_INPUT_LENGTH + 16U)
+
 /**********************************************************************************************************************
  * Typedef definitions
  **********************************************************************************************************************/
+/** Node of a case-folded command trie.  The children of a node are kept as a list of siblings, so a trie takes one
+ * node per distinct command prefix.  Node 0 is always a root and is never a child. */
+typedef struct st_sf_console_index_node
+{
+    uint16_t    child;      ///< First child node, 0 if none
+    uint16_t    sibling;    ///< Next child of the same parent, 0 if none
+    uint16_t    command;    ///< One plus the index of the first command ending at this node, 0 if none
+    uint8_t     ch;         ///< Upper case character leading to this node
+} sf_console_index_node_t;
+
+/** Command index of one menu. */
+typedef struct st_sf_console_menu_index
+{
+    sf_console_menu_t const * p_menu;             ///< Menu the index was built for
+    uint16_t                  root;               ///< Root node of the trie for this menu
+} sf_console_menu_index_t;
+
+/** Commands starting with a partly typed command, as found by sf_console_complete. */
+typedef struct st_sf_console_completion
+{
+    uint32_t                  matched;            ///< Length of the longest start of the prefix some command has
+    uint32_t                  command;            ///< A command starting with the matched characters, if matched > 0
+    uint32_t                  extend;             ///< Characters all commands starting with the whole prefix share after it
+    bool                      unique;             ///< Only one command starts with the whole prefix plus extend
+} sf_console_completion_t;
+
+/** Help menu kept from the last request.  The menu fields it was rendered from are stored with it, so a different menu
+ * or a change to the command list of the same menu causes it to be rendered again. */
+typedef struct st_sf_console_help_cache
+{
+    uint8_t                    * p_buffer;        ///< Memory the help is rendered into, NULL if help is not kept
+    uint32_t                     size;            ///< Size of p_buffer in bytes
+    uint32_t                     length;          ///< Length of the rendered help, 0 if it did not fit
+    sf_console_menu_t    const * p_menu;          ///< Menu the help was rendered for, NULL if none
+    sf_console_command_t const * p_command_list;  ///< Command list of p_menu when it was rendered
+    uint32_t                     num_commands;    ///< Number of commands in p_menu when it was rendered
+    bool                         back_options;    ///< Whether the root and previous menu options were rendered
+} sf_console_help_cache_t;
+
+/** Command history kept in a ring of bytes.  Each line is stored as its length, the line itself and its length again,
+ * so the ring can be walked from the oldest line forwards and from the newest line backwards.  Lines are numbered from
+ * 1 as they are added, and the oldest lines are dropped to make room for new ones. */
+typedef struct st_sf_console_history
+{
+    uint8_t                    * p_buffer;        ///< Ring memory, NULL if history is not kept
+    uint32_t                     size;            ///< Size of p_buffer in bytes
+    uint32_t                     head;            ///< Offset after the newest line
+    uint32_t                     tail;            ///< Offset of the oldest line
+    uint32_t                     used;            ///< Bytes between tail and head
+    uint32_t                     count;           ///< Number of lines kept
+    uint32_t                     first;           ///< Number of the oldest line kept
+    uint32_t                     browse;          ///< Lines back from the newest shown by the arrow keys, 0 if none
+} sf_console_history_t;
+
+/** One line of a script compiled by SF_CONSOLE_Batch.  Lines that fail to compile are kept, so they are reported in
+ * their turn. */
+typedef struct st_sf_console_batch_entry
+{
+    sf_console_menu_t    const * p_menu;          ///< Menu the line was looked up in
+    sf_console_command_t const * p_command;       ///< Command to run, NULL if the line is not a command
+    uint8_t              const * p_args;          ///< Rest of the line after the command, or the whole line if it failed
+    sf_console_arg_t           * p_argv;          ///< Arguments split out of p_args, kept at the end of the batch memory
+    uint32_t                     argc;            ///< Number of arguments in p_argv
+    uint32_t                     line;            ///< Line number in the script, from 1
+    uint32_t                     err;             ///< FSP_SUCCESS, or why the line cannot run
+    uint32_t                     ticks;           ///< ThreadX ticks the command took
+} sf_console_batch_entry_t;
+
+/** Batch memory given in the configuration. */
+typedef struct st_sf_console_batch
+{
+    uint8_t                    * p_buffer;        ///< Memory scripts are compiled into, NULL if batch is disabled
+    uint32_t                     size;            ///< Size of p_buffer in bytes
+} sf_console_batch_t;
+
+/** Table being written with SF_CONSOLE_TableRow.  Transmission stays locked while it is open. */
+typedef struct st_sf_console_table
+{
+    sf_console_column_t  const * p_columns;       ///< Columns given to SF_CONSOLE_TableStart
+    uint32_t                     count;           ///< Number of entries in p_columns
+    bool                         open;            ///< Whether a table is being written
+} sf_console_table_t;
+
+/** Command being run again by the watch command.  The timer only marks each interval, the command runs on the console
+ * thread. */
+typedef struct st_sf_console_watch
+{
+    TX_TIMER                     timer;           ///< Expires every interval
+    TX_EVENT_FLAGS_GROUP         events;          ///< Set by the timer, cleared by the run it starts
+    uint32_t                     lines;           ///< Lines written since the current run started
+    bool                         active;          ///< Whether a command is being watched
+} sf_console_watch_t;
+
+/** Filters output can be piped through. */
+typedef enum e_sf_console_pipe_filter
+{
+    SF_CONSOLE_PIPE_FILTER_GREP,                  ///< Passes lines containing a text
+    SF_CONSOLE_PIPE_FILTER_HEAD,                  ///< Passes the first lines
+    SF_CONSOLE_PIPE_FILTER_COUNT                  ///< Passes the number of lines once the command is done
+} sf_console_pipe_filter_t;
+
+/** One filter of a pipe. */
+typedef struct st_sf_console_pipe_stage
+{
+    sf_console_pipe_filter_t     filter;          ///< What the stage does
+    uint8_t              const * p_text;          ///< Text grep looks for, points into the copy of the line
+    uint32_t                     length;          ///< Number of bytes in p_text
+    bool                         invert;          ///< Whether grep passes the lines without the text instead
+    uint32_t                     limit;           ///< Lines head passes
+    uint32_t                     lines;           ///< Lines that reached the stage
+} sf_console_pipe_stage_t;
+
+/** Filters the output of the command being run goes through.  Output is collected a line at a time, and only lines
+ * passing every stage are written. */
+typedef struct st_sf_console_pipe
+{
+    uint8_t                      command[SF_CONSOLE_MAX_INPUT_LENGTH]; ///< Line split at each pipe, stages point into it
+    sf_console_pipe_stage_t      stages[SF_CONSOLE_CFG_PIPE_STAGES];  ///< Filters in the order output goes through them
+    uint32_t                     count;           ///< Number of entries in stages
+    uint8_t                      line[SF_CONSOLE_CFG_PIPE_LINE_LENGTH]; ///< Output line being collected
+    uint32_t                     line_length;     ///< Number of bytes in line
+    TX_THREAD                  * p_thread;        ///< Thread whose output is filtered, others write as usual
+    bool                         active;          ///< Whether a piped command is running
+} sf_console_pipe_t;
+
 /** Console instance control block. DO NOT INITIALIZE.  Initialization occurs when sf_console_api_t::open is called */
 typedef struct st_sf_console_instance_ctrl
 {
@@ -57,7 +187,27 @@ typedef struct st_sf_console_instance_ctrl
     sf_comms_instance_t const * p_comms;          ///< Pointer to communications driver instance
     uint8_t                     new_line;         ///< Whether to echo input commands to transmitter
     bool                        echo;             ///< Whether to echo input commands to transmitter
+    bool                        prompted;         ///< Whether the prompt for the pending input line was printed
     uint8_t                     input[SF_CONSOLE_MAX_INPUT_LENGTH]; ///< Input buffer used to store user input
+    uint8_t                     frame[SF_CONSOLE_FRAME_LENGTH];     ///< Echo output collected for a single write
+    uint32_t                    frame_length;     ///< Number of bytes in frame
+    uint8_t                     format_buffer[SF_CONSOLE_CFG_FORMAT_BUFFER_LENGTH]; ///< Formatted output staging
+    uint32_t                    format_length;    ///< Number of bytes in format_buffer
+    sf_console_index_node_t   * p_index_nodes;    ///< Node storage for the command indexes, NULL if not indexed
+    uint32_t                    index_nodes_max;  ///< Number of nodes in p_index_nodes
+    uint32_t                    index_nodes_used; ///< Number of nodes used by the indexes built so far
+    uint32_t                    menu_index_count; ///< Number of valid entries in menu_index
+    sf_console_menu_index_t     menu_index[SF_CONSOLE_CFG_MAX_INDEXED_MENUS]; ///< Indexed menus
+    sf_console_help_cache_t     help;             ///< Help menu kept from the last request
+    sf_console_history_t        history;          ///< Lines entered at the prompt
+    sf_console_jobs_t         * p_jobs;           ///< Worker pool for asynchronous commands, NULL if none
+    sf_console_batch_t          batch;            ///< Memory for scripts
+    uint64_t                 (* p_time_us)(void); ///< Clock commands are timed with, NULL to time them in ticks
+    sf_console_rpc_t            rpc;              ///< Binary frames exchanged with host tools
+    sf_console_output_t         output;           ///< How tables are rendered
+    sf_console_table_t          table;            ///< Table being written
+    sf_console_watch_t          watch;            ///< Command run again by the watch command
+    sf_console_pipe_t           pipe;             ///< Filters the output of the command being run goes through
 } sf_console_instance_ctrl_t;
 
 /**********************************************************************************************************************
@@ -68,6 +218,13 @@ typedef struct st_sf_console_instance_ctrl
 extern const sf_console_api_t g_sf_console_on_sf_console;
 /** @endcond */
 
+/**********************************************************************************************************************
+ * Functions shared with the worker pool
+ **********************************************************************************************************************/
+void SF_CONSOLE_CommandRun(sf_console_command_t const * const p_command,
+                           sf_console_command_stats_t * const p_stats,
+                           sf_console_callback_args_t * const p_args);
+
 /*******************************************************************************************************************//**
  * @} (end defgroup Console)
  **********************************************************************************************************************/
@@ -65,6 +65,67 @@ Macro definitions
 #define SF_CONSOLE_MENU_PREVIOUS_COMMAND ((uint8_t *) "^")
 /** Root menu command */
 #define SF_CONSOLE_ROOT_MENU_COMMAND ((uint8_t *) "~")
+/** Command to list the command history, available when history memory is configured */
+#define SF_CONSOLE_HISTORY_COMMAND ((uint8_t *) "history")
+/** Lines starting with this character recall a history entry: !! for the last line, !n for entry n, !-n for the
+ *  nth most recent line.  Text after the entry reference is appended to the recalled line. */
+#define SF_CONSOLE_HISTORY_RECALL_CHAR ('!')
+/** Command to list asynchronous commands, available when a worker pool is configured */
+#define SF_CONSOLE_JOBS_COMMAND ((uint8_t *) "jobs")
+/** Command to wait for an asynchronous command to finish, available when a worker pool is configured */
+#define SF_CONSOLE_WAIT_COMMAND ((uint8_t *) "wait")
+
+/** Command to run the commands in a file, available when batch memory is configured */
+#define SF_CONSOLE_SOURCE_COMMAND ((uint8_t *) "source")
+/** Command to show how long each command took, available when a menu keeps command statistics.  "perf reset" clears
+ *  them. */
+#define SF_CONSOLE_PERF_COMMAND ((uint8_t *) "perf")
+/** Word after the perf command that clears the statistics */
+#define SF_CONSOLE_PERF_RESET ((uint8_t *) "reset")
+
+/** Command to switch the console to binary RPC frames for host tools, available when enabled in the configuration.
+ *  See sf_console_rpc.h for the frame format. */
+#define SF_CONSOLE_RPC_COMMAND ((uint8_t *) "rpc")
+
+/** Command to show or choose how tables are rendered: "output text", "output csv" or "output json" */
+#define SF_CONSOLE_OUTPUT_COMMAND ((uint8_t *) "output")
+
+/** Command to run a command again every interval, drawing its output over the previous run until a key is pressed:
+ *  "watch <seconds> <command>" */
+#define SF_CONSOLE_WATCH_COMMAND ((uint8_t *) "watch")
+
+/** Separates a command from the filters its output goes through before it is written, one line at a time:
+ *  "<command> | grep [-v] <text> | head <lines> | count".  Up to SF_CONSOLE_CFG_PIPE_STAGES filters can follow a
+ *  command. */
+#define SF_CONSOLE_PIPE_CHAR ('|')
+/** Filter passing the lines that contain a text, or with "-v" the lines that do not */
+#define SF_CONSOLE_PIPE_GREP ((uint8_t *) "grep")
+/** Word after the grep filter that inverts it */
+#define SF_CONSOLE_PIPE_GREP_INVERT ((uint8_t *) "-v")
+/** Filter passing the first lines and dropping the rest */
+#define SF_CONSOLE_PIPE_HEAD ((uint8_t *) "head")
+/** Filter dropping the lines and passing the number of them when the command is done */
+#define SF_CONSOLE_PIPE_COUNT ((uint8_t *) "count")
+
+/** Buckets of a command latency histogram.  Each power of two of microseconds is split in four, so a percentile read
+ *  from the histogram is at most a quarter above the real one.  Times past the last bucket are counted in it. */
+#define SF_CONSOLE_STATS_BUCKETS (4U * SF_CONSOLE_CFG_STATS_OCTAVES)
+
+/** Lines of a script starting with this character are comments */
+#define SF_CONSOLE_COMMENT_CHAR ('#')
+/** Path that makes the source API read standard input.  Only for a session whose transport leaves standard input
+ *  alone, such as batch mode.  The source command refuses it. */
+#define SF_CONSOLE_SOURCE_STDIN ("-")
+
+/** Command flag to run the callback on a worker thread, so the prompt returns before the callback does */
+#define SF_CONSOLE_COMMAND_FLAG_ASYNC (1U << 0)
+
+/** Lets the compiler check the arguments of formatted writes against the format string. */
+#if defined(__GNUC__)
+#define SF_CONSOLE_FORMAT_CHECK(format_index, args_index) __attribute__((format(printf, format_index, args_index)))
+#else
+#define SF_CONSOLE_FORMAT_CHECK(format_index, args_index)
+#endif
 
 /** Use this macro to access the next menu layer from this command. */
 #define SF_CONSOLE_CALLBACK_NEXT_FUNCTION ((void(*)(sf_console_callback_args_t * p_args)) 0x70000000)
@@ -72,6 +133,27 @@ Macro definitions
 /**********************************************************************************************************************
 Typedef definitions
 ***********************************************************************************************************************/
+/** Outcome of running a script */
+typedef struct st_sf_console_batch_result
+{
+    uint32_t    commands;                    ///< Command lines in the script
+    uint32_t    passed;                      ///< Commands that were found, had valid arguments and ran
+    uint32_t    failed;                      ///< Commands that could not be run
+    uint32_t    ticks;                       ///< ThreadX ticks spent running the commands
+} sf_console_batch_result_t;
+
+/** Latency statistics of one command, kept for every call of its callback by any console using the menu */
+typedef struct st_sf_console_command_stats
+{
+    uint32_t    count;                       ///< Calls timed
+    uint32_t    min_us;                      ///< Shortest call in microseconds
+    uint32_t    max_us;                      ///< Longest call in microseconds
+    uint64_t    total_us;                    ///< Microseconds spent in all calls
+    uint32_t    total_ticks;                 ///< ThreadX ticks spent in all calls
+    uint32_t    max_ticks;                   ///< Longest call in ThreadX ticks
+    uint32_t    buckets[SF_CONSOLE_STATS_BUCKETS]; ///< Calls by latency, see SF_CONSOLE_STATS_BUCKETS
+} sf_console_command_stats_t;
+
 /** Console framework control block.  Allocate an instance specific control block to pass into the
  * console framework API calls.
  * @par Implemented as
@@ -79,6 +161,64 @@ Typedef definitions
  */
 typedef void sf_console_ctrl_t;
 
+/** Types of command arguments, checked and converted before the callback is called */
+typedef enum e_sf_console_arg_type
+{
+    SF_CONSOLE_ARG_TYPE_INT,        ///< Signed decimal integer, stored in value.integer
+    SF_CONSOLE_ARG_TYPE_FLOAT,      ///< Decimal number with optional fraction and exponent, stored in value.real
+    SF_CONSOLE_ARG_TYPE_HEX,        ///< Unsigned hexadecimal number with optional 0x prefix, stored in value.hex
+    SF_CONSOLE_ARG_TYPE_STRING,     ///< Any word, or any text in double quotes.  Only the span is set.
+    SF_CONSOLE_ARG_TYPE_ENUM,       ///< One of the choices of the argument, case insensitive, stored in value.choice
+} sf_console_arg_type_t;
+
+/** Description of one command argument */
+typedef struct st_sf_console_arg_spec
+{
+    uint8_t         const * name;            ///< Name shown in usage and error messages
+    sf_console_arg_type_t   type;            ///< Type the argument must have
+    bool                    optional;        ///< Whether the argument may be left out.  Arguments following an optional
+                                             ///< argument must be optional too.
+    uint8_t const * const * p_choices;       ///< Choices of a SF_CONSOLE_ARG_TYPE_ENUM argument
+    uint32_t                num_choices;     ///< Number of entries in p_choices
+} sf_console_arg_spec_t;
+
+/** One argument of a command line.  The span points into the line, nothing is copied. */
+typedef struct st_sf_console_arg
+{
+    uint8_t const * p_text;                  ///< Start of the argument, without quotes.  Not NULL terminated.
+    uint32_t        length;                  ///< Length of the argument in bytes
+    union
+    {
+        int32_t     integer;                 ///< SF_CONSOLE_ARG_TYPE_INT
+        float       real;                    ///< SF_CONSOLE_ARG_TYPE_FLOAT
+        uint32_t    hex;                     ///< SF_CONSOLE_ARG_TYPE_HEX
+        uint32_t    choice;                  ///< SF_CONSOLE_ARG_TYPE_ENUM, index into p_choices
+    } value;                                 ///< Converted value, set for arguments described by an argument spec
+} sf_console_arg_t;
+
+/** One value of a structured reply, sent in an RPC frame with a tag for its type */
+typedef struct st_sf_console_value
+{
+    sf_console_arg_type_t   type;            ///< Type of the value, SF_CONSOLE_ARG_TYPE_STRING sends the span
+    sf_console_arg_t        arg;             ///< The value, or the span of a string of up to 255 bytes
+} sf_console_value_t;
+
+/** How the tables commands write with sf_console_api_t::tableRow are rendered */
+typedef enum e_sf_console_output
+{
+    SF_CONSOLE_OUTPUT_TEXT,         ///< Aligned columns between bars, under a heading
+    SF_CONSOLE_OUTPUT_CSV,          ///< A heading line, then one line of comma separated fields per row
+    SF_CONSOLE_OUTPUT_JSON,         ///< One JSON object per row and line, keyed by column name
+} sf_console_output_t;
+
+/** One column of a table */
+typedef struct st_sf_console_column
+{
+    uint8_t const * p_name;                  ///< Heading of the column, and the key of its fields in JSON
+    uint32_t        width;                   ///< Width of the column in text, widened to fit the heading
+    uint32_t        precision;               ///< Digits after the point of SF_CONSOLE_ARG_TYPE_FLOAT fields
+} sf_console_column_t;
+
 /** Console callback arguments */
 typedef struct st_sf_console_callback_args
 {
@@ -86,6 +226,12 @@ typedef struct st_sf_console_callback_args
     uint8_t      const * p_remaining_string; ///< String remaining after parsing command.
     uint8_t      const * context;            ///< Pointer to user provided data.
     uint32_t             bytes;              ///< The number of bytes remaining in the input string
+    uint32_t             argc;               ///< Number of arguments in p_argv, at most SF_CONSOLE_CFG_MAX_ARGS
+    sf_console_arg_t const * p_argv;         ///< Words of the remaining string, split once per line and checked
+                                             ///< against the argument specs of the command.  Valid until the callback
+                                             ///< returns.
+    bool                 rpc;                ///< The command came in an RPC frame.  Results should be sent with
+                                             ///< sf_console_api_t::reply, text output is carried in output frames.
 } sf_console_callback_args_t;
 
 /** DEPRECATED definition, please use sf_console_callback_args_t instead. */
@@ -98,6 +244,9 @@ typedef struct st_sf_console_command
     uint8_t  * help;                         ///< Description of command
     void    (* callback)(sf_console_callback_args_t * p_args);  ///< Callback to call when command is selected
     void const * context;                    ///< User provided context passed into callback
+    uint32_t     flags;                      ///< SF_CONSOLE_COMMAND_FLAG_x options, 0 for none
+    sf_console_arg_spec_t const * p_arg_specs; ///< Arguments the command takes, NULL to accept any words unchecked
+    uint32_t     num_arg_specs;              ///< Number of entries in p_arg_specs
 } sf_console_command_t;
 
 /** Console menu structure. */
@@ -107,6 +256,8 @@ typedef struct st_sf_console_menu
     uint8_t                    const * menu_name;       ///< Menu name, used as a prompt
     uint32_t                           num_commands;    ///< Number of commands in this menu
     sf_console_command_t       const * command_list;    ///< Pointer to an array of commands of length num_commands
+    sf_console_command_stats_t       * p_stats;         ///< Array of num_commands statistics, one for each entry of
+                                                        ///< command_list, NULL to not time the commands
 } sf_console_menu_t;
 
 /** Configuration for RTOS integrated console framework. */
@@ -116,6 +267,26 @@ typedef struct st_sf_console_cfg
     sf_console_menu_t   const * p_initial_menu;   ///< First menu to print during Open.
     bool                        echo;             ///< Whether to echo input commands to transmitter
     bool                        autostart;        ///< If true, prompt will occur with p_initial_menu after initialization
+    void                      * p_index_memory;   ///< Memory for the command indexes built during Open, NULL to search
+                                                  ///< each menu linearly.  Must be aligned for uint16_t.
+    uint32_t                    index_memory_size;///< Size of p_index_memory in bytes
+    void                      * p_help_memory;    ///< Memory the help menu is rendered into and kept in, NULL to
+                                                  ///< render it on every request
+    uint32_t                    help_memory_size; ///< Size of p_help_memory in bytes
+    void                      * p_history_memory; ///< Memory the command history ring is kept in, NULL to only recall
+                                                  ///< the last line.  Each line takes its length plus 2 bytes.
+    uint32_t                    history_memory_size; ///< Size of p_history_memory in bytes
+    struct st_sf_console_jobs * p_jobs;           ///< Open worker pool that runs commands flagged
+                                                  ///< SF_CONSOLE_COMMAND_FLAG_ASYNC, NULL to run every callback on the
+                                                  ///< console thread.  May be shared by several consoles.
+    void                      * p_batch_memory;   ///< Memory scripts are compiled into, and source reads its file
+                                                  ///< into.  NULL to disable batch execution.  Must be aligned for
+                                                  ///< pointers.
+    uint32_t                    batch_memory_size;///< Size of p_batch_memory in bytes
+    uint64_t                 (* p_time_us)(void); ///< Monotonic microsecond clock commands are timed with, NULL to
+                                                  ///< time them in ThreadX ticks only
+    bool                        rpc;              ///< Whether the rpc command may switch the console to binary frames
+    sf_console_output_t         output;           ///< How tables are rendered until the output command changes it
 } sf_console_cfg_t;
 
 /** Console framework API structure.  Console implementations will use the following API. */
@@ -193,7 +364,7 @@ typedef struct st_sf_console_api
      * @par Implemented as
      *  - SF_CONSOLE_Write()
      * @param[in]   p_ctrl      Pointer to device control block initialized in Open call for UART driver.
-     * @param[in]   p_src       Pointer to a NULL terminated string.  Length must be less than SF_CONSOLE_MAX_WRITE_LENGTH.
+     * @param[in]   p_src       Pointer to a NULL terminated string of any length.
      * @param[in]   timeout     ThreadX timeout. Options include TX_NO_WAIT (0x00000000), TX_WAIT_FOREVER (0xFFFFFFFF),
      *                          and timeout value (0x00000001 through 0xFFFFFFFE) in ThreadX tick counts.
      */
@@ -201,6 +372,38 @@ typedef struct st_sf_console_api
                         uint8_t            const * const p_src,
                         uint32_t                   const timeout);
 
+     /** @brief  Writes a number of bytes to the console.  The data does not need to be NULL terminated and is passed to
+     *          the communications driver without being scanned.
+     * @par Implemented as
+     *  - SF_CONSOLE_WriteN()
+     * @param[in]   p_ctrl      Pointer to device control block initialized in Open call for UART driver.
+     * @param[in]   p_src       Pointer to the data to write.
+     * @param[in]   bytes       Number of bytes to write.  Nothing is written if this is zero.
+     * @param[in]   timeout     ThreadX timeout. Options include TX_NO_WAIT (0x00000000), TX_WAIT_FOREVER (0xFFFFFFFF),
+     *                          and timeout value (0x00000001 through 0xFFFFFFFE) in ThreadX tick counts.
+     */
+    fsp_err_t (* writeN)(sf_console_ctrl_t        * const p_ctrl,
+                         uint8_t            const * const p_src,
+                         uint32_t                   const bytes,
+                         uint32_t                   const timeout);
+
+     /** @brief  Writes printf style formatted output to the console.  Output of any length is streamed through a
+     *          scratch buffer of SF_CONSOLE_CFG_FORMAT_BUFFER_LENGTH bytes in the control block, and transmission stays
+     *          locked until the whole output is written.  Literal text and strings bypass the buffer when they do not
+     *          fit in it, a single numeric conversion must fit in the buffer.  %n is not supported.
+     * @par Implemented as
+     *  - SF_CONSOLE_WriteFormat()
+     * @param[in]   p_ctrl      Pointer to device control block initialized in Open call for UART driver.
+     * @param[in]   timeout     ThreadX timeout used to lock transmission. Options include TX_NO_WAIT (0x00000000),
+     *                          TX_WAIT_FOREVER (0xFFFFFFFF), and timeout value (0x00000001 through 0xFFFFFFFE) in
+     *                          ThreadX tick counts.
+     * @param[in]   p_format    printf style format string.
+     */
+    fsp_err_t (* writeFormat)(sf_console_ctrl_t        * const p_ctrl,
+                              uint32_t                   const timeout,
+                              char               const * const p_format,
+                              ...) SF_CONSOLE_FORMAT_CHECK(3, 4);
+
      /** @brief  Finds a command line argument in an input string and returns the index of the character immediately
      *         following the argument and any string numbers converted to integers.
      * @par Implemented as
@@ -217,6 +420,157 @@ typedef struct st_sf_console_api
                                uint8_t const * const p_str,
                                int32_t       * const p_index,
                                int32_t       * const p_data);
+
+     /** @brief  Splits a string into words in one pass and checks them against argument specs.  Words are separated
+     *         by spaces, a word in double quotes may contain spaces.  The console calls this for every command before
+     *         its callback, and does not call the callback if a command with argument specs gets this error.
+     * @par Implemented as
+     *  - SF_CONSOLE_ArgumentsParse()
+     *
+     * @param[in]   p_str      Pointer to the NULL terminated string to split.
+     * @param[in]   p_specs    Argument specs to check the words against, NULL to only split the string.
+     * @param[in]   num_specs  Number of entries in p_specs.
+     * @param[out]  p_argv     Array the words are stored in.
+     * @param[in]   max_args   Number of entries in p_argv.
+     * @param[out]  p_argc     Number of words stored.  On FSP_ERR_INVALID_ARGUMENT, the index of the word that does
+     *                         not match its spec.
+     * @retval FSP_SUCCESS                The string was split and all words match their specs.
+     * @retval FSP_ERR_INVALID_ARGUMENT   A word does not match its spec.
+     * @retval FSP_ERR_INSUFFICIENT_DATA  A required argument is missing.
+     * @retval FSP_ERR_INVALID_SIZE       There are more words than argument specs, or than entries in p_argv.
+     */
+    fsp_err_t (* argumentsParse)(uint8_t               const * const p_str,
+                                 sf_console_arg_spec_t const * const p_specs,
+                                 uint32_t                      const num_specs,
+                                 sf_console_arg_t            * const p_argv,
+                                 uint32_t                      const max_args,
+                                 uint32_t                    * const p_argc);
+
+     /** @brief  Runs a script without echo or prompts.  All lines are looked up in the menus first, then the
+     *         commands are run back to back on the calling thread, asynchronous ones included.  A line that is not a
+     *         command, or whose arguments do not match the command's specs, fails when its turn comes and the rest
+     *         still run.  Each command is timed, and a table of the results and a pass/fail summary follow the
+     *         output of the commands.
+     * @par Implemented as
+     *  - SF_CONSOLE_Batch()
+     *
+     * @param[in]      p_ctrl      Pointer to device control block initialized in Open call for UART driver.
+     * @param[in]      p_menu      Menu the first line is looked up in, NULL for the current menu.  Menu commands in
+     *                             the script only affect the lines after them.
+     * @param[in,out]  p_script    Lines of commands separated by LF or CR LF.  Line endings are replaced with NULL
+     *                             characters, and the script must stay valid while it runs.
+     * @param[in]      bytes       Length of the script.
+     * @param[out]     p_result    Counts of passed and failed commands, may be NULL.
+     * @retval FSP_SUCCESS           The script ran, p_result tells whether all of it passed.
+     * @retval FSP_ERR_NOT_ENABLED   No batch memory is configured.
+     * @retval FSP_ERR_OUT_OF_MEMORY The compiled script does not fit the batch memory, nothing was run.
+     */
+    fsp_err_t (* batch)(sf_console_ctrl_t               * const p_ctrl,
+                        sf_console_menu_t         const * const p_menu,
+                        uint8_t                         * const p_script,
+                        uint32_t                          const bytes,
+                        sf_console_batch_result_t       * const p_result);
+
+     /** @brief  Reads a script file into the batch memory and runs it as batch does.  This is what the source command
+     *         does.
+     * @par Implemented as
+     *  - SF_CONSOLE_Source()
+     *
+     * @param[in]   p_ctrl      Pointer to device control block initialized in Open call for UART driver.
+     * @param[in]   p_menu      Menu the first line is looked up in, NULL for the current menu.
+     * @param[in]   p_path      Path of the script, or SF_CONSOLE_SOURCE_STDIN to read standard input to its end.
+     * @param[out]  p_result    Counts of passed and failed commands, may be NULL.
+     * @retval FSP_SUCCESS           The script ran, p_result tells whether all of it passed.
+     * @retval FSP_ERR_NOT_ENABLED   No batch memory is configured.
+     * @retval FSP_ERR_NOT_FOUND     The file could not be opened.
+     * @retval FSP_ERR_OUT_OF_MEMORY The file or the compiled script does not fit the batch memory, nothing was run.
+     */
+    fsp_err_t (* source)(sf_console_ctrl_t               * const p_ctrl,
+                         sf_console_menu_t         const * const p_menu,
+                         char                      const * const p_path,
+                         sf_console_batch_result_t       * const p_result);
+
+     /** @brief  Copies a line out of the command history, to save the history somewhere that outlives the console.
+     *          Call from the thread that prompts.
+     * @par Implemented as
+     *  - SF_CONSOLE_HistoryGet()
+     *
+     * @param[in]   p_ctrl      Pointer to device control block initialized in Open call for UART driver.
+     * @param[in]   index       Position of the line in the history, 0 for the oldest line kept.
+     * @param[out]  p_dest      Destination for the NULL terminated line.
+     * @param[in]   bytes       Size of p_dest in bytes.  SF_CONSOLE_MAX_INPUT_LENGTH fits any line.
+     */
+    fsp_err_t (* historyGet)(sf_console_ctrl_t       * const p_ctrl,
+                             uint32_t                  const index,
+                             uint8_t                 * const p_dest,
+                             uint32_t                  const bytes);
+
+     /** @brief  Adds a line to the command history as if it had been entered, to restore a saved history after Open.
+     *          The oldest lines are dropped to make room.  Call from the thread that prompts.
+     * @par Implemented as
+     *  - SF_CONSOLE_HistoryAdd()
+     *
+     * @param[in]   p_ctrl      Pointer to device control block initialized in Open call for UART driver.
+     * @param[in]   p_line      NULL terminated line, shorter than SF_CONSOLE_MAX_INPUT_LENGTH.
+     */
+    fsp_err_t (* historyAdd)(sf_console_ctrl_t       * const p_ctrl,
+                             uint8_t           const * const p_line);
+
+     /** @brief  Sends values as the structured reply of a command that came in an RPC frame, in place of the text the
+     *         command would format.  Each call sends one frame, so a table is sent a row per call.
+     * @par Implemented as
+     *  - SF_CONSOLE_Reply()
+     *
+     * @param[in]   p_ctrl      Pointer to device control block initialized in Open call for UART driver.
+     * @param[in]   p_values    Values to send.
+     * @param[in]   count       Number of entries in p_values.
+     * @retval FSP_SUCCESS           The frame was sent.
+     * @retval FSP_ERR_INVALID_MODE  The console is not exchanging RPC frames.
+     * @retval FSP_ERR_INVALID_SIZE  The values do not fit in a frame.
+     */
+    fsp_err_t (* reply)(sf_console_ctrl_t          * const p_ctrl,
+                        sf_console_value_t   const * const p_values,
+                        uint32_t                     const count);
+
+     /** @brief  Starts a table, which the rows written until tableEnd belong to.  The heading is written in the
+     *         output chosen for the console, and transmission stays locked until tableEnd so the table is not
+     *         interleaved with other output.  Text written in between with writeFormat stays in order.
+     * @par Implemented as
+     *  - SF_CONSOLE_TableStart()
+     *
+     * @param[in]   p_ctrl      Pointer to device control block initialized in Open call for UART driver.
+     * @param[in]   p_columns   Columns of the table, must stay valid until tableEnd.
+     * @param[in]   count       Number of entries in p_columns.
+     * @retval FSP_SUCCESS           The table was started.
+     * @retval FSP_ERR_IN_USE        A table is already being written to this console.
+     */
+    fsp_err_t (* tableStart)(sf_console_ctrl_t           * const p_ctrl,
+                             sf_console_column_t   const * const p_columns,
+                             uint32_t                      const count);
+
+     /** @brief  Writes a row of the table, one value per column.  Rows are built in the scratch buffer and written
+     *         when it fills, so a table takes few transfers.  Over RPC each row is sent as a values frame.
+     * @par Implemented as
+     *  - SF_CONSOLE_TableRow()
+     *
+     * @param[in]   p_ctrl      Pointer to device control block initialized in Open call for UART driver.
+     * @param[in]   p_values    Values of the row, as many as the table has columns.
+     * @retval FSP_SUCCESS           The row was written.
+     * @retval FSP_ERR_NOT_OPEN      No table was started.
+     */
+    fsp_err_t (* tableRow)(sf_console_ctrl_t          * const p_ctrl,
+                           sf_console_value_t   const * const p_values);
+
+     /** @brief  Ends the table, writing what is left of it and unlocking transmission.  A table the callback left
+     *         open is ended when the callback returns.
+     * @par Implemented as
+     *  - SF_CONSOLE_TableEnd()
+     *
+     * @param[in]   p_ctrl      Pointer to device control block initialized in Open call for UART driver.
+     * @retval FSP_SUCCESS           The table was ended.
+     * @retval FSP_ERR_NOT_OPEN      No table was started.
+     */
+    fsp_err_t (* tableEnd)(sf_console_ctrl_t          * const p_ctrl);
 } sf_console_api_t;
 
 /** This structure encompasses everything that is needed to use an instance of this interface. */
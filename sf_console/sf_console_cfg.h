@@ -3,7 +3,13 @@
 
 #define SF_CONSOLE_CFG_PARAM_CHECKING_ENABLE (BSP_CFG_PARAM_CHECKING_ENABLE)
 #define SF_CONSOLE_MAX_INPUT_LENGTH (128U)
-#define SF_CONSOLE_MAX_WRITE_LENGTH (128U)
 #define SF_CONSOLE_PRV_TIMEOUT (0xFFFFFFFFUL)
+#define SF_CONSOLE_CFG_MAX_INDEXED_MENUS (8U)
+#define SF_CONSOLE_CFG_FORMAT_BUFFER_LENGTH (64U)
+#define SF_CONSOLE_CFG_MAX_SUGGESTIONS (4U)
+#define SF_CONSOLE_CFG_MAX_ARGS (8U)
+#define SF_CONSOLE_CFG_STATS_OCTAVES (24U)
+#define SF_CONSOLE_CFG_PIPE_STAGES (4U)
+#define SF_CONSOLE_CFG_PIPE_LINE_LENGTH (128U)
 
 #endif /* SF_CONSOLE_CFG_H_ */
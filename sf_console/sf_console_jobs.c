@@ -0,0 +1,380 @@
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "sf_console.h"
+#include "sf_console_jobs.h"
+
+/******************************************************************************
+ * CONSTANTS
+ *****************************************************************************/
+#define SF_CONSOLE_JOBS_EVENTS_ALL      ((ULONG) ((1ULL << SF_CONSOLE_JOBS_MAX) - 1U))
+#define SF_CONSOLE_JOBS_EVENT(slot)     ((ULONG) (1UL << (slot)))
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+static VOID sf_console_jobs_worker_entry(ULONG thread_input);
+static fsp_err_t sf_console_jobs_slot_find(sf_console_jobs_t * p_jobs, ULONG id, ULONG * p_slot);
+static void sf_console_jobs_delete(sf_console_jobs_t * p_jobs, ULONG worker_count);
+
+/******************************************************************************
+ * FUNCTION: SF_CONSOLE_JobsOpen
+ *****************************************************************************/
+fsp_err_t SF_CONSOLE_JobsOpen(sf_console_jobs_t * const p_jobs, sf_console_jobs_cfg_t const * const p_cfg)
+{
+    UINT tx_err = TX_SUCCESS;
+
+    if((NULL == p_jobs) || (NULL == p_cfg) || (NULL == p_cfg->p_worker_stacks) ||
+       (0U == p_cfg->worker_count) || (p_cfg->worker_count > SF_CONSOLE_JOBS_WORKERS_MAX))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if(p_jobs->open)
+    {
+        return FSP_ERR_ALREADY_OPEN;
+    }
+
+    p_jobs->p_cfg   = p_cfg;
+    p_jobs->next_id = 1U;
+    memset(p_jobs->jobs, 0, sizeof(p_jobs->jobs));
+
+    tx_err = tx_mutex_create(&p_jobs->mutex, SF_CONSOLE_JOBS_MUTEX_NAME, TX_INHERIT);
+    if(TX_SUCCESS != tx_err)
+    {
+        return FSP_ERR_INTERNAL;
+    }
+
+    tx_err = tx_event_flags_create(&p_jobs->done_events, SF_CONSOLE_JOBS_EVENTS_NAME);
+    if(TX_SUCCESS != tx_err)
+    {
+        tx_mutex_delete(&p_jobs->mutex);
+        return FSP_ERR_INTERNAL;
+    }
+
+    /* No slot has anything outstanding yet */
+    tx_event_flags_set(&p_jobs->done_events, SF_CONSOLE_JOBS_EVENTS_ALL, TX_OR);
+
+    /* There are never more queued jobs than slots, so sending cannot block */
+    tx_err = tx_queue_create(&p_jobs->queue,
+                             SF_CONSOLE_JOBS_QUEUE_NAME,
+                             TX_1_ULONG,
+                             p_jobs->queue_storage,
+                             sizeof(p_jobs->queue_storage));
+    if(TX_SUCCESS != tx_err)
+    {
+        tx_event_flags_delete(&p_jobs->done_events);
+        tx_mutex_delete(&p_jobs->mutex);
+        return FSP_ERR_INTERNAL;
+    }
+
+    for(ULONG worker_num = 0; worker_num < p_cfg->worker_count; worker_num++)
+    {
+        tx_err = tx_thread_create(&p_jobs->workers[worker_num],
+                                  SF_CONSOLE_JOBS_WORKER_NAME,
+                                  sf_console_jobs_worker_entry,
+                                  (ULONG) p_jobs,
+                                  (UCHAR *) p_cfg->p_worker_stacks + (worker_num * p_cfg->worker_stack_size),
+                                  p_cfg->worker_stack_size,
+                                  p_cfg->worker_priority,
+                                  p_cfg->worker_priority,
+                                  p_cfg->worker_time_slice,
+                                  TX_DONT_START);
+        if(TX_SUCCESS != tx_err)
+        {
+            sf_console_jobs_delete(p_jobs, worker_num);
+            return FSP_ERR_INTERNAL;
+        }
+    }
+
+    p_jobs->open = true;
+
+    for(ULONG worker_num = 0; worker_num < p_cfg->worker_count; worker_num++)
+    {
+        tx_thread_resume(&p_jobs->workers[worker_num]);
+    }
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: SF_CONSOLE_JobsClose
+ *****************************************************************************/
+fsp_err_t SF_CONSOLE_JobsClose(sf_console_jobs_t * const p_jobs)
+{
+    if(!p_jobs->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    /* Jobs still queued or running are abandoned */
+    p_jobs->open = false;
+    sf_console_jobs_delete(p_jobs, p_jobs->p_cfg->worker_count);
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: SF_CONSOLE_JobsSubmit
+ *****************************************************************************/
+fsp_err_t SF_CONSOLE_JobsSubmit(sf_console_jobs_t * const p_jobs,
+                                sf_console_ctrl_t * const p_console,
+                                sf_console_command_t const * const p_command,
+                                sf_console_command_stats_t * const p_stats,
+                                uint8_t const * const p_input,
+                                uint32_t const argc,
+                                sf_console_arg_t const * const p_argv,
+                                ULONG * const p_id)
+{
+    fsp_err_t   fsp_err = FSP_SUCCESS;
+    ULONG       slot    = SF_CONSOLE_JOBS_MAX;
+
+    if(!p_jobs->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    if(TX_SUCCESS != tx_mutex_get(&p_jobs->mutex, TX_WAIT_FOREVER))
+    {
+        return FSP_ERR_INTERNAL;
+    }
+
+    /* Take a free slot, otherwise the one of the oldest finished job */
+    for(ULONG slot_num = 0; slot_num < SF_CONSOLE_JOBS_MAX; slot_num++)
+    {
+        sf_console_job_t * p_job = &p_jobs->jobs[slot_num];
+
+        if(SF_CONSOLE_JOB_STATE_FREE == p_job->state)
+        {
+            slot = slot_num;
+            break;
+        }
+
+        if((SF_CONSOLE_JOB_STATE_DONE == p_job->state) &&
+           ((SF_CONSOLE_JOBS_MAX == slot) || (p_job->id < p_jobs->jobs[slot].id)))
+        {
+            slot = slot_num;
+        }
+    }
+
+    if(SF_CONSOLE_JOBS_MAX == slot)
+    {
+        fsp_err = FSP_ERR_IN_USE;
+    }
+    else
+    {
+        sf_console_job_t * p_job = &p_jobs->jobs[slot];
+
+        p_job->id           = p_jobs->next_id++;
+        p_job->state        = SF_CONSOLE_JOB_STATE_QUEUED;
+        p_job->p_console    = p_console;
+        p_job->p_command    = p_command;
+        p_job->p_stats      = p_stats;
+        p_job->submit_ticks = tx_time_get();
+        p_job->start_ticks  = p_job->submit_ticks;
+        p_job->end_ticks    = p_job->submit_ticks;
+        strncpy((char *) p_job->input, (char const *) p_input, sizeof(p_job->input) - 1U);
+        p_job->input[sizeof(p_job->input) - 1U] = '\0';
+
+        /* Arguments are spans of the caller's line, move them to the copy */
+        p_job->argc = (argc > SF_CONSOLE_CFG_MAX_ARGS) ? SF_CONSOLE_CFG_MAX_ARGS : argc;
+        for(uint32_t arg_num = 0; arg_num < p_job->argc; arg_num++)
+        {
+            p_job->argv[arg_num]        = p_argv[arg_num];
+            p_job->argv[arg_num].p_text = &p_job->input[p_argv[arg_num].p_text - p_input];
+        }
+
+        tx_event_flags_set(&p_jobs->done_events, ~SF_CONSOLE_JOBS_EVENT(slot), TX_AND);
+        tx_queue_send(&p_jobs->queue, &slot, TX_NO_WAIT);
+
+        if(NULL != p_id)
+        {
+            *p_id = p_job->id;
+        }
+    }
+
+    tx_mutex_put(&p_jobs->mutex);
+
+    return fsp_err;
+}
+
+/******************************************************************************
+ * FUNCTION: SF_CONSOLE_JobsGet
+ *****************************************************************************/
+fsp_err_t SF_CONSOLE_JobsGet(sf_console_jobs_t * const p_jobs, ULONG const slot, sf_console_job_t * const p_job)
+{
+    if(!p_jobs->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    if(slot >= SF_CONSOLE_JOBS_MAX)
+    {
+        return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    if(TX_SUCCESS != tx_mutex_get(&p_jobs->mutex, TX_WAIT_FOREVER))
+    {
+        return FSP_ERR_INTERNAL;
+    }
+
+    *p_job = p_jobs->jobs[slot];
+
+    tx_mutex_put(&p_jobs->mutex);
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: SF_CONSOLE_JobsWait
+ *****************************************************************************/
+fsp_err_t SF_CONSOLE_JobsWait(sf_console_jobs_t * const p_jobs,
+                              ULONG const id,
+                              UINT const timeout,
+                              sf_console_job_t * const p_job)
+{
+    ULONG       slot    = 0;
+    ULONG       events  = 0;
+    bool        issued  = false;
+    bool        found   = false;
+
+    if(!p_jobs->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    if(TX_SUCCESS != tx_mutex_get(&p_jobs->mutex, TX_WAIT_FOREVER))
+    {
+        return FSP_ERR_INTERNAL;
+    }
+
+    issued  = (0U != id) && (id < p_jobs->next_id);
+    found   = issued && (FSP_SUCCESS == sf_console_jobs_slot_find(p_jobs, id, &slot));
+
+    tx_mutex_put(&p_jobs->mutex);
+
+    if(!issued)
+    {
+        return FSP_ERR_NOT_FOUND;
+    }
+
+    /* A job whose slot was reused finished long ago, and only its id is left to report */
+    memset(p_job, 0, sizeof(sf_console_job_t));
+    p_job->id       = id;
+    p_job->state    = SF_CONSOLE_JOB_STATE_DONE;
+    if(!found)
+    {
+        return FSP_SUCCESS;
+    }
+
+    /* The slot flag is set when the job finishes and stays set until the slot
+     * is reused, so any number of consoles can wait on the same job */
+    if(TX_SUCCESS != tx_event_flags_get(&p_jobs->done_events,
+                                        SF_CONSOLE_JOBS_EVENT(slot),
+                                        TX_OR,
+                                        &events,
+                                        timeout))
+    {
+        return FSP_ERR_TIMEOUT;
+    }
+
+    if(TX_SUCCESS != tx_mutex_get(&p_jobs->mutex, TX_WAIT_FOREVER))
+    {
+        return FSP_ERR_INTERNAL;
+    }
+
+    if(p_jobs->jobs[slot].id == id)
+    {
+        *p_job = p_jobs->jobs[slot];
+    }
+
+    tx_mutex_put(&p_jobs->mutex);
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_jobs_worker_entry
+ *****************************************************************************/
+static VOID sf_console_jobs_worker_entry(ULONG thread_input)
+{
+    sf_console_jobs_t * p_jobs = (sf_console_jobs_t *) thread_input;
+    ULONG               slot   = 0;
+
+    while(1)
+    {
+        if(TX_SUCCESS != tx_queue_receive(&p_jobs->queue, &slot, TX_WAIT_FOREVER))
+        {
+            continue;
+        }
+
+        sf_console_job_t * p_job = &p_jobs->jobs[slot];
+
+        tx_mutex_get(&p_jobs->mutex, TX_WAIT_FOREVER);
+        p_job->state        = SF_CONSOLE_JOB_STATE_RUNNING;
+        p_job->start_ticks  = tx_time_get();
+        tx_mutex_put(&p_jobs->mutex);
+
+        /* The slot cannot be reused while the job runs, so its input is read without the mutex */
+        sf_console_callback_args_t args;
+        args.p_ctrl             = p_job->p_console;
+        args.p_remaining_string = p_job->input;
+        args.context            = p_job->p_command->context;
+        args.bytes              = sizeof(p_job->input);
+        args.argc               = p_job->argc;
+        args.p_argv             = p_job->argv;
+        args.rpc                = false;
+        SF_CONSOLE_CommandRun(p_job->p_command, p_job->p_stats, &args);
+        ULONG end_ticks = tx_time_get();
+
+        /* Tell the operator, who has been at the prompt since the job was submitted */
+        g_sf_console_on_sf_console.writeFormat(p_job->p_console,
+                                               SF_CONSOLE_PRV_TIMEOUT,
+                                               "[%lu] Done %s (%lu ticks)\r\n",
+                                               (unsigned long) p_job->id,
+                                               (char const *) p_job->p_command->command,
+                                               (unsigned long) (end_ticks - p_job->start_ticks));
+
+        tx_mutex_get(&p_jobs->mutex, TX_WAIT_FOREVER);
+        p_job->state        = SF_CONSOLE_JOB_STATE_DONE;
+        p_job->end_ticks    = end_ticks;
+        tx_mutex_put(&p_jobs->mutex);
+
+        tx_event_flags_set(&p_jobs->done_events, SF_CONSOLE_JOBS_EVENT(slot), TX_OR);
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_jobs_slot_find
+ *****************************************************************************/
+static fsp_err_t sf_console_jobs_slot_find(sf_console_jobs_t * p_jobs, ULONG id, ULONG * p_slot)
+{
+    for(ULONG slot_num = 0; slot_num < SF_CONSOLE_JOBS_MAX; slot_num++)
+    {
+        if((SF_CONSOLE_JOB_STATE_FREE != p_jobs->jobs[slot_num].state) && (id == p_jobs->jobs[slot_num].id))
+        {
+            *p_slot = slot_num;
+            return FSP_SUCCESS;
+        }
+    }
+
+    return FSP_ERR_NOT_FOUND;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_jobs_delete
+ *****************************************************************************/
+static void sf_console_jobs_delete(sf_console_jobs_t * p_jobs, ULONG worker_count)
+{
+    for(ULONG worker_num = 0; worker_num < worker_count; worker_num++)
+    {
+        tx_thread_terminate(&p_jobs->workers[worker_num]);
+        tx_thread_delete(&p_jobs->workers[worker_num]);
+    }
+
+    tx_queue_delete(&p_jobs->queue);
+    tx_event_flags_delete(&p_jobs->done_events);
+    tx_mutex_delete(&p_jobs->mutex);
+}
@@ -0,0 +1,110 @@
+#ifndef SF_CONSOLE_JOBS_H
+#define SF_CONSOLE_JOBS_H
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdbool.h>
+#include "sf_console_api.h"
+
+/******************************************************************************
+ * CONSTANTS
+ *****************************************************************************/
+/* Job slots, each has one completion event flag so there can be at most 32 */
+#define SF_CONSOLE_JOBS_MAX             (8U)
+#define SF_CONSOLE_JOBS_WORKERS_MAX     (4U)
+
+#define SF_CONSOLE_JOBS_WORKER_NAME     ("Console Worker Thread")
+#define SF_CONSOLE_JOBS_MUTEX_NAME      ("Console Jobs Mutex")
+#define SF_CONSOLE_JOBS_QUEUE_NAME      ("Console Jobs Queue")
+#define SF_CONSOLE_JOBS_EVENTS_NAME     ("Console Jobs Events")
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+typedef enum e_sf_console_job_state
+{
+    SF_CONSOLE_JOB_STATE_FREE,          /* Slot never used */
+    SF_CONSOLE_JOB_STATE_QUEUED,        /* Waiting for a worker */
+    SF_CONSOLE_JOB_STATE_RUNNING,       /* Callback running on a worker */
+    SF_CONSOLE_JOB_STATE_DONE,          /* Kept for listing until the slot is reused */
+} sf_console_job_state_t;
+
+typedef struct st_sf_console_job
+{
+    /* Ids count up from 1 and are never reused */
+    ULONG                           id;
+    sf_console_job_state_t          state;
+
+    /* Console that received the command, the callback writes to it */
+    sf_console_ctrl_t               *p_console;
+    sf_console_command_t const      *p_command;
+
+    /* Statistics the run is timed into, NULL if the menu keeps none */
+    sf_console_command_stats_t      *p_stats;
+
+    /* Rest of the command line, copied since the console reuses its input
+     * buffer for the next line */
+    uint8_t                         input[SF_CONSOLE_MAX_INPUT_LENGTH];
+
+    /* Arguments split out of input, pointing into the copy */
+    uint32_t                        argc;
+    sf_console_arg_t                argv[SF_CONSOLE_CFG_MAX_ARGS];
+
+    ULONG                           submit_ticks;
+    ULONG                           start_ticks;
+    ULONG                           end_ticks;
+} sf_console_job_t;
+
+typedef struct st_sf_console_jobs_cfg
+{
+    /* Stacks of the worker threads, worker_count blocks of worker_stack_size
+     * bytes each */
+    VOID                            *p_worker_stacks;
+    ULONG                           worker_stack_size;
+    ULONG                           worker_count;
+    UINT                            worker_priority;
+    ULONG                           worker_time_slice;
+} sf_console_jobs_cfg_t;
+
+/* Worker pool shared by any number of consoles */
+typedef struct st_sf_console_jobs
+{
+    sf_console_jobs_cfg_t const     *p_cfg;
+    bool                            open;
+    ULONG                           next_id;
+
+    /* Guards the job slots and next_id */
+    TX_MUTEX                        mutex;
+
+    /* Bit n is clear while slot n is queued or running */
+    TX_EVENT_FLAGS_GROUP            done_events;
+
+    /* Slot numbers of queued jobs, one ULONG message each */
+    TX_QUEUE                        queue;
+    ULONG                           queue_storage[SF_CONSOLE_JOBS_MAX];
+
+    TX_THREAD                       workers[SF_CONSOLE_JOBS_WORKERS_MAX];
+    sf_console_job_t                jobs[SF_CONSOLE_JOBS_MAX];
+} sf_console_jobs_t;
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+fsp_err_t SF_CONSOLE_JobsOpen(sf_console_jobs_t * const p_jobs, sf_console_jobs_cfg_t const * const p_cfg);
+fsp_err_t SF_CONSOLE_JobsClose(sf_console_jobs_t * const p_jobs);
+fsp_err_t SF_CONSOLE_JobsSubmit(sf_console_jobs_t * const p_jobs,
+                                sf_console_ctrl_t * const p_console,
+                                sf_console_command_t const * const p_command,
+                                sf_console_command_stats_t * const p_stats,
+                                uint8_t const * const p_input,
+                                uint32_t const argc,
+                                sf_console_arg_t const * const p_argv,
+                                ULONG * const p_id);
+fsp_err_t SF_CONSOLE_JobsGet(sf_console_jobs_t * const p_jobs, ULONG const slot, sf_console_job_t * const p_job);
+fsp_err_t SF_CONSOLE_JobsWait(sf_console_jobs_t * const p_jobs,
+                              ULONG const id,
+                              UINT const timeout,
+                              sf_console_job_t * const p_job);
+
+#endif // SF_CONSOLE_JOBS_H
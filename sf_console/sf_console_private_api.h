@@ -44,10 +44,48 @@ fsp_err_t SF_CONSOLE_Read(sf_console_ctrl_t * const p_ctrl,
 fsp_err_t SF_CONSOLE_Write(sf_console_ctrl_t * const p_ctrl,
                            uint8_t     const * const p_src,
                            uint32_t            const timeout);
+fsp_err_t SF_CONSOLE_WriteN(sf_console_ctrl_t * const p_ctrl,
+                            uint8_t     const * const p_src,
+                            uint32_t            const bytes,
+                            uint32_t            const timeout);
+fsp_err_t SF_CONSOLE_WriteFormat(sf_console_ctrl_t * const p_ctrl,
+                                 uint32_t            const timeout,
+                                 char        const * const p_format,
+                                 ...) SF_CONSOLE_FORMAT_CHECK(3, 4);
 fsp_err_t SF_CONSOLE_ArgumentFind(uint8_t const * const p_arg,
                                   uint8_t const * const p_str,
                                   int32_t       * const p_index,
                                   int32_t       * const p_data);
+fsp_err_t SF_CONSOLE_ArgumentsParse(uint8_t               const * const p_str,
+                                    sf_console_arg_spec_t const * const p_specs,
+                                    uint32_t                      const num_specs,
+                                    sf_console_arg_t            * const p_argv,
+                                    uint32_t                      const max_args,
+                                    uint32_t                    * const p_argc);
+fsp_err_t SF_CONSOLE_HistoryGet(sf_console_ctrl_t * const p_ctrl,
+                                uint32_t            const index,
+                                uint8_t           * const p_dest,
+                                uint32_t            const bytes);
+fsp_err_t SF_CONSOLE_HistoryAdd(sf_console_ctrl_t * const p_ctrl,
+                                uint8_t     const * const p_line);
+fsp_err_t SF_CONSOLE_Batch(sf_console_ctrl_t               * const p_ctrl,
+                           sf_console_menu_t         const * const p_menu,
+                           uint8_t                         * const p_script,
+                           uint32_t                          const bytes,
+                           sf_console_batch_result_t       * const p_result);
+fsp_err_t SF_CONSOLE_Source(sf_console_ctrl_t               * const p_ctrl,
+                            sf_console_menu_t         const * const p_menu,
+                            char                      const * const p_path,
+                            sf_console_batch_result_t       * const p_result);
+fsp_err_t SF_CONSOLE_Reply(sf_console_ctrl_t          * const p_ctrl,
+                           sf_console_value_t   const * const p_values,
+                           uint32_t                     const count);
+fsp_err_t SF_CONSOLE_TableStart(sf_console_ctrl_t           * const p_ctrl,
+                                sf_console_column_t   const * const p_columns,
+                                uint32_t                      const count);
+fsp_err_t SF_CONSOLE_TableRow(sf_console_ctrl_t          * const p_ctrl,
+                              sf_console_value_t   const * const p_values);
+fsp_err_t SF_CONSOLE_TableEnd(sf_console_ctrl_t * const p_ctrl);
 void SF_CONSOLE_CallbackNextMenu(sf_console_callback_args_t * p_args);
 
 
@@ -0,0 +1,749 @@
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <string.h>
+#include "sf_console.h"
+#include "sf_console_rpc.h"
+
+/******************************************************************************
+ * CONSTANTS
+ *****************************************************************************/
+#define SF_CONSOLE_RPC_CRC_INIT         (0xFFFFU)
+#define SF_CONSOLE_RPC_CRC_POLYNOMIAL   (0x1021U)
+
+/* Offsets in a frame */
+#define SF_CONSOLE_RPC_LENGTH_OFFSET    (1U)
+#define SF_CONSOLE_RPC_PAYLOAD_OFFSET   (SF_CONSOLE_RPC_HEADER_LENGTH)
+#define SF_CONSOLE_RPC_BODY_OFFSET      (SF_CONSOLE_RPC_PAYLOAD_OFFSET + SF_CONSOLE_RPC_PAYLOAD_HEADER_LENGTH)
+#define SF_CONSOLE_RPC_BODY_MAX         (SF_CONSOLE_RPC_PAYLOAD_MAX - SF_CONSOLE_RPC_PAYLOAD_HEADER_LENGTH)
+
+/* Result body, the status then the index of the argument it is about */
+#define SF_CONSOLE_RPC_RESULT_LENGTH    (5U)
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+static fsp_err_t sf_console_rpc_run(sf_console_instance_ctrl_t * p_ctrl,
+                                    sf_console_menu_t const * p_root,
+                                    uint8_t const * p_body,
+                                    uint32_t body_length);
+static fsp_err_t sf_console_rpc_arguments_unpack(sf_console_command_t const * p_command,
+                                                 uint8_t const * p_body,
+                                                 uint32_t body_length,
+                                                 sf_console_arg_t * p_argv,
+                                                 uint32_t * p_argc);
+static fsp_err_t sf_console_rpc_list(sf_console_instance_ctrl_t * p_ctrl, sf_console_menu_t const * p_root);
+static fsp_err_t sf_console_rpc_result(sf_console_instance_ctrl_t * p_ctrl, fsp_err_t status, uint32_t arg_num);
+static fsp_err_t sf_console_rpc_send(sf_console_instance_ctrl_t * p_ctrl, uint8_t type, uint32_t body_length, UINT timeout);
+static bool sf_console_rpc_command_get(sf_console_menu_t const * p_root,
+                                       uint32_t id,
+                                       sf_console_menu_t const ** pp_menu,
+                                       uint32_t * p_command_num);
+static bool sf_console_rpc_command_find(sf_console_menu_t const * p_menu,
+                                        uint32_t * p_id,
+                                        sf_console_menu_t const ** pp_visited,
+                                        uint32_t * p_visited_count,
+                                        sf_console_menu_t const ** pp_menu,
+                                        uint32_t * p_command_num);
+static bool sf_console_rpc_value_put(sf_console_rpc_t * p_rpc,
+                                     uint32_t * p_used,
+                                     sf_console_arg_type_t type,
+                                     sf_console_arg_t const * p_arg);
+static bool sf_console_rpc_string_put(sf_console_rpc_t * p_rpc, uint32_t * p_used, uint8_t const * p_text);
+static bool sf_console_rpc_integer_put(sf_console_rpc_t * p_rpc, uint32_t * p_used, int32_t integer);
+static uint32_t sf_console_rpc_value_pack(uint8_t * p_dest,
+                                          uint32_t space,
+                                          sf_console_arg_type_t type,
+                                          sf_console_arg_t const * p_arg);
+static uint32_t sf_console_rpc_value_unpack(uint8_t const * p_src,
+                                            uint32_t bytes,
+                                            sf_console_arg_type_t * p_type,
+                                            sf_console_arg_t * p_arg);
+static uint16_t sf_console_rpc_crc(uint8_t const * p_data, uint32_t bytes);
+
+/******************************************************************************
+ * FUNCTION: SF_CONSOLE_RpcStart
+ *****************************************************************************/
+fsp_err_t SF_CONSOLE_RpcStart(sf_console_ctrl_t * const p_console)
+{
+    sf_console_instance_ctrl_t * p_ctrl = (sf_console_instance_ctrl_t *) p_console;
+
+    if(!p_ctrl->rpc.enabled)
+    {
+        return FSP_ERR_NOT_ENABLED;
+    }
+
+    p_ctrl->rpc.active      = true;
+    p_ctrl->rpc.sequence    = 0U;
+    p_ctrl->rpc.id          = SF_CONSOLE_RPC_ID_OPEN;
+
+    /* The host looks for this frame to know the console stopped echoing */
+    return sf_console_rpc_result(p_ctrl, FSP_SUCCESS, 0U);
+}
+
+/******************************************************************************
+ * FUNCTION: SF_CONSOLE_RpcServe
+ *****************************************************************************/
+fsp_err_t SF_CONSOLE_RpcServe(sf_console_ctrl_t * const p_console,
+                              sf_console_menu_t const * const p_menu,
+                              UINT const timeout)
+{
+    sf_console_instance_ctrl_t  *p_ctrl     = (sf_console_instance_ctrl_t *) p_console;
+    sf_comms_instance_t const   *p_comms    = p_ctrl->p_comms;
+    sf_console_rpc_t            *p_rpc      = &p_ctrl->rpc;
+    uint8_t                     *p_frame    = p_rpc->rx_frame;
+    uint32_t                    length      = 0;
+    bool                        framed      = false;
+    fsp_err_t                   fsp_err     = FSP_SUCCESS;
+
+    fsp_err = p_comms->p_api->lock(p_comms->p_ctrl, SF_COMMS_LOCK_RX, timeout);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        return fsp_err;
+    }
+
+    /* Skip whatever comes before the start of a frame, such as the end of the
+     * line that switched to frames */
+    do
+    {
+        fsp_err = p_comms->p_api->read(p_comms->p_ctrl, &p_frame[0], 1U, timeout);
+    }
+    while((FSP_SUCCESS == fsp_err) && (SF_CONSOLE_RPC_SOF != p_frame[0]));
+
+    /* The rest of the frame must follow promptly, otherwise it is dropped */
+    if(FSP_SUCCESS == fsp_err)
+    {
+        fsp_err = p_comms->p_api->read(p_comms->p_ctrl, &p_frame[SF_CONSOLE_RPC_LENGTH_OFFSET], 2U,
+                                       SF_CONSOLE_RPC_FRAME_TIMEOUT);
+        length  = (uint32_t) p_frame[SF_CONSOLE_RPC_LENGTH_OFFSET] |
+                  ((uint32_t) p_frame[SF_CONSOLE_RPC_LENGTH_OFFSET + 1U] << 8);
+    }
+
+    /* A length no frame can have means the SOF was not the start of a frame */
+    framed = (FSP_SUCCESS == fsp_err) &&
+             (length >= SF_CONSOLE_RPC_PAYLOAD_HEADER_LENGTH) && (length <= SF_CONSOLE_RPC_PAYLOAD_MAX);
+    if(framed)
+    {
+        fsp_err = p_comms->p_api->read(p_comms->p_ctrl, &p_frame[SF_CONSOLE_RPC_PAYLOAD_OFFSET],
+                                       length + SF_CONSOLE_RPC_CRC_LENGTH, SF_CONSOLE_RPC_FRAME_TIMEOUT);
+    }
+
+    p_comms->p_api->unlock(p_comms->p_ctrl, SF_COMMS_LOCK_RX);
+
+    if((FSP_SUCCESS != fsp_err) || !framed)
+    {
+        return fsp_err;
+    }
+
+    uint8_t const * p_payload = &p_frame[SF_CONSOLE_RPC_PAYLOAD_OFFSET];
+    uint16_t        crc       = (uint16_t) (p_payload[length] | (p_payload[length + 1U] << 8));
+
+    p_rpc->sequence = p_payload[1];
+    p_rpc->id       = (uint16_t) (p_payload[2] | (p_payload[3] << 8));
+
+    /* Answer a damaged frame too, so the host can send it again rather than
+     * wait for a reply */
+    if(crc != sf_console_rpc_crc(&p_frame[SF_CONSOLE_RPC_LENGTH_OFFSET], 2U + length))
+    {
+        return sf_console_rpc_result(p_ctrl, FSP_ERR_INVALID_DATA, 0U);
+    }
+
+    if(SF_CONSOLE_RPC_TYPE_REQUEST != p_payload[0])
+    {
+        return sf_console_rpc_result(p_ctrl, FSP_ERR_UNSUPPORTED, 0U);
+    }
+
+    /* Ids number the commands of the whole menu tree, whichever menu is current */
+    sf_console_menu_t const * p_root = p_menu;
+    while(NULL != p_root->menu_prev)
+    {
+        p_root = p_root->menu_prev;
+    }
+
+    switch(p_rpc->id)
+    {
+        case SF_CONSOLE_RPC_ID_LIST:
+            fsp_err = sf_console_rpc_list(p_ctrl, p_root);
+            break;
+
+        case SF_CONSOLE_RPC_ID_EXIT:
+            fsp_err = sf_console_rpc_result(p_ctrl, FSP_SUCCESS, 0U);
+            p_rpc->active = false;
+            break;
+
+        default:
+            fsp_err = sf_console_rpc_run(p_ctrl,
+                                         p_root,
+                                         &p_payload[SF_CONSOLE_RPC_PAYLOAD_HEADER_LENGTH],
+                                         length - SF_CONSOLE_RPC_PAYLOAD_HEADER_LENGTH);
+            break;
+    }
+
+    return fsp_err;
+}
+
+/******************************************************************************
+ * FUNCTION: SF_CONSOLE_RpcOutput
+ *****************************************************************************/
+fsp_err_t SF_CONSOLE_RpcOutput(sf_console_ctrl_t * const p_console,
+                               uint8_t const * const p_src,
+                               uint32_t const bytes,
+                               UINT const timeout)
+{
+    sf_console_instance_ctrl_t  *p_ctrl     = (sf_console_instance_ctrl_t *) p_console;
+    sf_comms_instance_t const   *p_comms    = p_ctrl->p_comms;
+    uint32_t                    sent        = 0;
+    fsp_err_t                   fsp_err     = FSP_SUCCESS;
+
+    /* The reply frame is shared by every thread writing to the console */
+    fsp_err = p_comms->p_api->lock(p_comms->p_ctrl, SF_COMMS_LOCK_TX, timeout);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        return fsp_err;
+    }
+
+    while((FSP_SUCCESS == fsp_err) && (sent < bytes))
+    {
+        uint32_t chunk = bytes - sent;
+        if(chunk > SF_CONSOLE_RPC_BODY_MAX)
+        {
+            chunk = SF_CONSOLE_RPC_BODY_MAX;
+        }
+
+        memcpy(&p_ctrl->rpc.tx_frame[SF_CONSOLE_RPC_BODY_OFFSET], &p_src[sent], chunk);
+        fsp_err = sf_console_rpc_send(p_ctrl, SF_CONSOLE_RPC_TYPE_OUTPUT, chunk, timeout);
+        sent += chunk;
+    }
+
+    p_comms->p_api->unlock(p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+
+    return fsp_err;
+}
+
+/******************************************************************************
+ * FUNCTION: SF_CONSOLE_RpcValues
+ *****************************************************************************/
+fsp_err_t SF_CONSOLE_RpcValues(sf_console_ctrl_t * const p_console,
+                               sf_console_value_t const * const p_values,
+                               uint32_t const count)
+{
+    sf_console_instance_ctrl_t  *p_ctrl     = (sf_console_instance_ctrl_t *) p_console;
+    sf_comms_instance_t const   *p_comms    = p_ctrl->p_comms;
+    uint32_t                    used        = 0;
+    bool                        fits        = true;
+    fsp_err_t                   fsp_err     = FSP_SUCCESS;
+
+    fsp_err = p_comms->p_api->lock(p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        return fsp_err;
+    }
+
+    for(uint32_t value_num = 0; fits && (value_num < count); value_num++)
+    {
+        fits = sf_console_rpc_value_put(&p_ctrl->rpc, &used, p_values[value_num].type, &p_values[value_num].arg);
+    }
+
+    fsp_err = fits ? sf_console_rpc_send(p_ctrl, SF_CONSOLE_RPC_TYPE_VALUES, used, SF_CONSOLE_PRV_TIMEOUT) :
+                     FSP_ERR_INVALID_SIZE;
+
+    p_comms->p_api->unlock(p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+
+    return fsp_err;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_rpc_run
+ *****************************************************************************/
+static fsp_err_t sf_console_rpc_run(sf_console_instance_ctrl_t * p_ctrl,
+                                    sf_console_menu_t const * p_root,
+                                    uint8_t const * p_body,
+                                    uint32_t body_length)
+{
+    sf_console_menu_t const     *p_menu         = NULL;
+    uint32_t                    command_num     = 0;
+    sf_console_arg_t            argv[SF_CONSOLE_CFG_MAX_ARGS];
+    uint32_t                    argc            = 0;
+    fsp_err_t                   fsp_err         = FSP_SUCCESS;
+
+    if(!sf_console_rpc_command_get(p_root, p_ctrl->rpc.id, &p_menu, &command_num))
+    {
+        return sf_console_rpc_result(p_ctrl, FSP_ERR_NOT_FOUND, 0U);
+    }
+
+    sf_console_command_t const * p_command = &p_menu->command_list[command_num];
+
+    /* On failure argc is the index of the argument at fault */
+    fsp_err = sf_console_rpc_arguments_unpack(p_command, p_body, body_length, argv, &argc);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        return sf_console_rpc_result(p_ctrl, fsp_err, argc);
+    }
+
+    /* Asynchronous commands run here too, so the result frame follows all of
+     * their output */
+    if(NULL != p_command->callback)
+    {
+        sf_console_callback_args_t args;
+        args.p_ctrl             = p_ctrl;
+        args.p_remaining_string = (uint8_t const *) "";
+        args.context            = p_command->context;
+        args.bytes              = 1U;
+        args.argc               = argc;
+        args.p_argv             = argv;
+        args.rpc                = true;
+        SF_CONSOLE_CommandRun(p_command,
+                              (NULL != p_menu->p_stats) ? &p_menu->p_stats[command_num] : NULL,
+                              &args);
+    }
+
+    return sf_console_rpc_result(p_ctrl, FSP_SUCCESS, 0U);
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_rpc_arguments_unpack
+ *****************************************************************************/
+static fsp_err_t sf_console_rpc_arguments_unpack(sf_console_command_t const * p_command,
+                                                 uint8_t const * p_body,
+                                                 uint32_t body_length,
+                                                 sf_console_arg_t * p_argv,
+                                                 uint32_t * p_argc)
+{
+    /* Commands without specs take any values, as they take any words */
+    bool        checked     = (NULL != p_command->p_arg_specs) && (0U != p_command->num_arg_specs);
+    uint32_t    max_args    = SF_CONSOLE_CFG_MAX_ARGS;
+    uint32_t    offset      = 0;
+    uint32_t    argc        = 0;
+
+    if(checked && (p_command->num_arg_specs < max_args))
+    {
+        max_args = p_command->num_arg_specs;
+    }
+
+    while(offset < body_length)
+    {
+        if(argc >= max_args)
+        {
+            *p_argc = argc;
+            return FSP_ERR_INVALID_SIZE;
+        }
+
+        /* The value must be whole, of the type its spec asks for, and one of
+         * the choices of an enum */
+        sf_console_arg_spec_t const *p_spec = checked ? &p_command->p_arg_specs[argc] : NULL;
+        sf_console_arg_type_t       type    = SF_CONSOLE_ARG_TYPE_STRING;
+        uint32_t                    used    = sf_console_rpc_value_unpack(&p_body[offset],
+                                                                          body_length - offset,
+                                                                          &type,
+                                                                          &p_argv[argc]);
+        if((0U == used) ||
+           ((NULL != p_spec) && ((type != p_spec->type) ||
+                                 ((SF_CONSOLE_ARG_TYPE_ENUM == type) &&
+                                  (p_argv[argc].value.choice >= p_spec->num_choices)))))
+        {
+            *p_argc = argc;
+            return FSP_ERR_INVALID_ARGUMENT;
+        }
+
+        offset += used;
+        argc++;
+    }
+
+    *p_argc = argc;
+
+    if(checked && (argc < p_command->num_arg_specs) && !p_command->p_arg_specs[argc].optional)
+    {
+        return FSP_ERR_INSUFFICIENT_DATA;
+    }
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_rpc_list
+ *****************************************************************************/
+static fsp_err_t sf_console_rpc_list(sf_console_instance_ctrl_t * p_ctrl, sf_console_menu_t const * p_root)
+{
+    sf_comms_instance_t const   *p_comms    = p_ctrl->p_comms;
+    sf_console_rpc_t            *p_rpc      = &p_ctrl->rpc;
+    sf_console_menu_t const     *p_menu     = NULL;
+    uint32_t                    command_num = 0;
+    fsp_err_t                   status      = FSP_SUCCESS;
+    fsp_err_t                   fsp_err     = FSP_SUCCESS;
+
+    fsp_err = p_comms->p_api->lock(p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        return fsp_err;
+    }
+
+    for(uint32_t id = 0; (FSP_SUCCESS == fsp_err) && sf_console_rpc_command_get(p_root, id, &p_menu, &command_num); id++)
+    {
+        sf_console_command_t const  *p_command  = &p_menu->command_list[command_num];
+        sf_console_arg_t            flags       = { 0 };
+        uint32_t                    used        = 0;
+        bool                        fits        = true;
+
+        flags.value.hex = p_command->flags;
+        fits = fits && sf_console_rpc_integer_put(p_rpc, &used, (int32_t) id);
+        fits = fits && sf_console_rpc_string_put(p_rpc, &used, p_command->command);
+        fits = fits && sf_console_rpc_value_put(p_rpc, &used, SF_CONSOLE_ARG_TYPE_HEX, &flags);
+
+        for(uint32_t spec_num = 0; (NULL != p_command->p_arg_specs) && (spec_num < p_command->num_arg_specs); spec_num++)
+        {
+            sf_console_arg_spec_t const * p_spec = &p_command->p_arg_specs[spec_num];
+
+            fits = fits && sf_console_rpc_string_put(p_rpc, &used, p_spec->name);
+            fits = fits && sf_console_rpc_integer_put(p_rpc, &used, (int32_t) p_spec->type);
+            fits = fits && sf_console_rpc_integer_put(p_rpc, &used, p_spec->optional ? 1 : 0);
+            fits = fits && sf_console_rpc_integer_put(p_rpc, &used, (int32_t) p_spec->num_choices);
+            for(uint32_t choice_num = 0; (NULL != p_spec->p_choices) && (choice_num < p_spec->num_choices); choice_num++)
+            {
+                fits = fits && sf_console_rpc_string_put(p_rpc, &used, p_spec->p_choices[choice_num]);
+            }
+        }
+
+        /* A command too big to describe is left out, and the result says so */
+        if(fits)
+        {
+            fsp_err = sf_console_rpc_send(p_ctrl, SF_CONSOLE_RPC_TYPE_VALUES, used, SF_CONSOLE_PRV_TIMEOUT);
+        }
+        else
+        {
+            status = FSP_ERR_INVALID_SIZE;
+        }
+    }
+
+    if(FSP_SUCCESS == fsp_err)
+    {
+        fsp_err = sf_console_rpc_result(p_ctrl, status, 0U);
+    }
+
+    p_comms->p_api->unlock(p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+
+    return fsp_err;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_rpc_result
+ *****************************************************************************/
+static fsp_err_t sf_console_rpc_result(sf_console_instance_ctrl_t * p_ctrl, fsp_err_t status, uint32_t arg_num)
+{
+    sf_comms_instance_t const   *p_comms    = p_ctrl->p_comms;
+    uint8_t                     *p_body     = &p_ctrl->rpc.tx_frame[SF_CONSOLE_RPC_BODY_OFFSET];
+    fsp_err_t                   fsp_err     = FSP_SUCCESS;
+
+    fsp_err = p_comms->p_api->lock(p_comms->p_ctrl, SF_COMMS_LOCK_TX, SF_CONSOLE_PRV_TIMEOUT);
+    if(FSP_SUCCESS != fsp_err)
+    {
+        return fsp_err;
+    }
+
+    p_body[0] = (uint8_t) ((uint32_t) status);
+    p_body[1] = (uint8_t) ((uint32_t) status >> 8);
+    p_body[2] = (uint8_t) ((uint32_t) status >> 16);
+    p_body[3] = (uint8_t) ((uint32_t) status >> 24);
+    p_body[4] = (uint8_t) arg_num;
+    fsp_err = sf_console_rpc_send(p_ctrl, SF_CONSOLE_RPC_TYPE_RESULT, SF_CONSOLE_RPC_RESULT_LENGTH,
+                                  SF_CONSOLE_PRV_TIMEOUT);
+
+    p_comms->p_api->unlock(p_comms->p_ctrl, SF_COMMS_LOCK_TX);
+
+    return fsp_err;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_rpc_send
+ *****************************************************************************/
+static fsp_err_t sf_console_rpc_send(sf_console_instance_ctrl_t * p_ctrl, uint8_t type, uint32_t body_length, UINT timeout)
+{
+    /* The body is already in place, transmission must be locked */
+    sf_console_rpc_t    *p_rpc      = &p_ctrl->rpc;
+    uint8_t             *p_frame    = p_rpc->tx_frame;
+    uint32_t            length      = SF_CONSOLE_RPC_PAYLOAD_HEADER_LENGTH + body_length;
+    uint16_t            crc         = 0;
+
+    p_frame[0]  = SF_CONSOLE_RPC_SOF;
+    p_frame[1]  = (uint8_t) length;
+    p_frame[2]  = (uint8_t) (length >> 8);
+    p_frame[3]  = type;
+    p_frame[4]  = p_rpc->sequence;
+    p_frame[5]  = (uint8_t) p_rpc->id;
+    p_frame[6]  = (uint8_t) (p_rpc->id >> 8);
+
+    crc = sf_console_rpc_crc(&p_frame[SF_CONSOLE_RPC_LENGTH_OFFSET], 2U + length);
+    p_frame[SF_CONSOLE_RPC_PAYLOAD_OFFSET + length]      = (uint8_t) crc;
+    p_frame[SF_CONSOLE_RPC_PAYLOAD_OFFSET + length + 1U] = (uint8_t) (crc >> 8);
+
+    return p_ctrl->p_comms->p_api->write(p_ctrl->p_comms->p_ctrl,
+                                         p_frame,
+                                         SF_CONSOLE_RPC_HEADER_LENGTH + length + SF_CONSOLE_RPC_CRC_LENGTH,
+                                         timeout);
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_rpc_command_get
+ *****************************************************************************/
+static bool sf_console_rpc_command_get(sf_console_menu_t const * p_root,
+                                       uint32_t id,
+                                       sf_console_menu_t const ** pp_menu,
+                                       uint32_t * p_command_num)
+{
+    /* Only as many menus are numbered as can be indexed */
+    sf_console_menu_t const     *visited[SF_CONSOLE_CFG_MAX_INDEXED_MENUS];
+    uint32_t                    visited_count   = 0;
+    uint32_t                    remaining       = id;
+
+    return sf_console_rpc_command_find(p_root, &remaining, visited, &visited_count, pp_menu, p_command_num);
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_rpc_command_find
+ *****************************************************************************/
+static bool sf_console_rpc_command_find(sf_console_menu_t const * p_menu,
+                                        uint32_t * p_id,
+                                        sf_console_menu_t const ** pp_visited,
+                                        uint32_t * p_visited_count,
+                                        sf_console_menu_t const ** pp_menu,
+                                        uint32_t * p_command_num)
+{
+    if((NULL == p_menu) || (*p_visited_count >= SF_CONSOLE_CFG_MAX_INDEXED_MENUS))
+    {
+        return false;
+    }
+
+    /* Menus lead back to the ones they came from, each is numbered once */
+    for(uint32_t visited_num = 0; visited_num < *p_visited_count; visited_num++)
+    {
+        if(p_menu == pp_visited[visited_num])
+        {
+            return false;
+        }
+    }
+    pp_visited[(*p_visited_count)++] = p_menu;
+
+    /* Commands of a menu are numbered where the command leading to it is */
+    for(uint32_t command_num = 0; command_num < p_menu->num_commands; command_num++)
+    {
+        sf_console_command_t const * p_command = &p_menu->command_list[command_num];
+
+        if(SF_CONSOLE_CALLBACK_NEXT_FUNCTION == p_command->callback)
+        {
+            if(sf_console_rpc_command_find((sf_console_menu_t const *) p_command->context,
+                                           p_id, pp_visited, p_visited_count, pp_menu, p_command_num))
+            {
+                return true;
+            }
+        }
+        else if(0U == *p_id)
+        {
+            *pp_menu        = p_menu;
+            *p_command_num  = command_num;
+            return true;
+        }
+        else
+        {
+            (*p_id)--;
+        }
+    }
+
+    return false;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_rpc_value_put
+ *****************************************************************************/
+static bool sf_console_rpc_value_put(sf_console_rpc_t * p_rpc,
+                                     uint32_t * p_used,
+                                     sf_console_arg_type_t type,
+                                     sf_console_arg_t const * p_arg)
+{
+    uint32_t added = sf_console_rpc_value_pack(&p_rpc->tx_frame[SF_CONSOLE_RPC_BODY_OFFSET + *p_used],
+                                               SF_CONSOLE_RPC_BODY_MAX - *p_used,
+                                               type,
+                                               p_arg);
+    *p_used += added;
+
+    return (0U != added);
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_rpc_string_put
+ *****************************************************************************/
+static bool sf_console_rpc_string_put(sf_console_rpc_t * p_rpc, uint32_t * p_used, uint8_t const * p_text)
+{
+    sf_console_arg_t arg = { 0 };
+
+    arg.p_text = (NULL != p_text) ? p_text : (uint8_t const *) "";
+    arg.length = (uint32_t) strlen((char const *) arg.p_text);
+
+    return sf_console_rpc_value_put(p_rpc, p_used, SF_CONSOLE_ARG_TYPE_STRING, &arg);
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_rpc_integer_put
+ *****************************************************************************/
+static bool sf_console_rpc_integer_put(sf_console_rpc_t * p_rpc, uint32_t * p_used, int32_t integer)
+{
+    sf_console_arg_t arg = { 0 };
+
+    arg.value.integer = integer;
+
+    return sf_console_rpc_value_put(p_rpc, p_used, SF_CONSOLE_ARG_TYPE_INT, &arg);
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_rpc_value_pack
+ *****************************************************************************/
+static uint32_t sf_console_rpc_value_pack(uint8_t * p_dest,
+                                          uint32_t space,
+                                          sf_console_arg_type_t type,
+                                          sf_console_arg_t const * p_arg)
+{
+    uint32_t word = 0;
+
+    switch(type)
+    {
+        case SF_CONSOLE_ARG_TYPE_INT:
+        case SF_CONSOLE_ARG_TYPE_FLOAT:
+        case SF_CONSOLE_ARG_TYPE_HEX:
+            if(space < 5U)
+            {
+                return 0;
+            }
+
+            /* Floats are sent as their bit pattern */
+            if(SF_CONSOLE_ARG_TYPE_FLOAT == type)
+            {
+                memcpy(&word, &p_arg->value.real, sizeof(word));
+            }
+            else
+            {
+                word = p_arg->value.hex;
+            }
+
+            p_dest[0] = (uint8_t) type;
+            p_dest[1] = (uint8_t) word;
+            p_dest[2] = (uint8_t) (word >> 8);
+            p_dest[3] = (uint8_t) (word >> 16);
+            p_dest[4] = (uint8_t) (word >> 24);
+            return 5U;
+
+        case SF_CONSOLE_ARG_TYPE_STRING:
+            if((p_arg->length > UINT8_MAX) || (space < (2U + p_arg->length)))
+            {
+                return 0;
+            }
+
+            p_dest[0] = (uint8_t) type;
+            p_dest[1] = (uint8_t) p_arg->length;
+            memcpy(&p_dest[2], p_arg->p_text, p_arg->length);
+            return 2U + p_arg->length;
+
+        case SF_CONSOLE_ARG_TYPE_ENUM:
+            if((space < 2U) || (p_arg->value.choice > UINT8_MAX))
+            {
+                return 0;
+            }
+
+            p_dest[0] = (uint8_t) type;
+            p_dest[1] = (uint8_t) p_arg->value.choice;
+            return 2U;
+
+        default:
+            return 0;
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_rpc_value_unpack
+ *****************************************************************************/
+static uint32_t sf_console_rpc_value_unpack(uint8_t const * p_src,
+                                            uint32_t bytes,
+                                            sf_console_arg_type_t * p_type,
+                                            sf_console_arg_t * p_arg)
+{
+    uint32_t word = 0;
+    uint32_t used = 0;
+
+    if(bytes < 2U)
+    {
+        return 0;
+    }
+
+    /* Only strings have a span, the others point at an empty one */
+    p_arg->p_text   = (uint8_t const *) "";
+    p_arg->length   = 0;
+
+    switch(p_src[0])
+    {
+        case SF_CONSOLE_ARG_TYPE_INT:
+        case SF_CONSOLE_ARG_TYPE_FLOAT:
+        case SF_CONSOLE_ARG_TYPE_HEX:
+            if(bytes < 5U)
+            {
+                return 0;
+            }
+
+            word = (uint32_t) p_src[1] | ((uint32_t) p_src[2] << 8) |
+                   ((uint32_t) p_src[3] << 16) | ((uint32_t) p_src[4] << 24);
+            if(SF_CONSOLE_ARG_TYPE_INT == p_src[0])
+            {
+                p_arg->value.integer = (int32_t) word;
+            }
+            else if(SF_CONSOLE_ARG_TYPE_FLOAT == p_src[0])
+            {
+                memcpy(&p_arg->value.real, &word, sizeof(word));
+            }
+            else
+            {
+                p_arg->value.hex = word;
+            }
+            used = 5U;
+            break;
+
+        case SF_CONSOLE_ARG_TYPE_STRING:
+            if(bytes < (2U + p_src[1]))
+            {
+                return 0;
+            }
+
+            p_arg->p_text   = &p_src[2];
+            p_arg->length   = p_src[1];
+            used            = 2U + p_src[1];
+            break;
+
+        case SF_CONSOLE_ARG_TYPE_ENUM:
+            p_arg->value.choice = p_src[1];
+            used                = 2U;
+            break;
+
+        default:
+            return 0;
+    }
+
+    *p_type = (sf_console_arg_type_t) p_src[0];
+
+    return used;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_console_rpc_crc
+ *****************************************************************************/
+static uint16_t sf_console_rpc_crc(uint8_t const * p_data, uint32_t bytes)
+{
+    /* CRC-16/CCITT-FALSE, bit by bit since frames are short */
+    uint16_t crc = SF_CONSOLE_RPC_CRC_INIT;
+
+    for(uint32_t byte_num = 0; byte_num < bytes; byte_num++)
+    {
+        crc ^= (uint16_t) (p_data[byte_num] << 8);
+        for(uint32_t bit_num = 0; bit_num < 8U; bit_num++)
+        {
+            crc = (0U != (crc & 0x8000U)) ? (uint16_t) ((crc << 1) ^ SF_CONSOLE_RPC_CRC_POLYNOMIAL) :
+                                            (uint16_t) (crc << 1);
+        }
+    }
+
+    return crc;
+}
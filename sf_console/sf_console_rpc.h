@@ -0,0 +1,90 @@
+#ifndef SF_CONSOLE_RPC_H
+#define SF_CONSOLE_RPC_H
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdbool.h>
+#include "sf_console_api.h"
+
+/******************************************************************************
+ * CONSTANTS
+ *****************************************************************************/
+/* A frame is
+ *
+ *   SOF | length (2) | payload (length bytes) | CRC (2)
+ *
+ * with fields of more than one byte little endian. The CRC is
+ * CRC-16/CCITT-FALSE over the length and the payload. The payload is
+ *
+ *   type (1) | sequence (1) | command id (2) | body
+ *
+ * Replies carry the sequence and command id of their request: any number of
+ * output and values frames, then one result frame.
+ *
+ * Values are packed as a tag holding their sf_console_arg_type_t, then an
+ * int32 for SF_CONSOLE_ARG_TYPE_INT, a float for SF_CONSOLE_ARG_TYPE_FLOAT, a
+ * uint32 for SF_CONSOLE_ARG_TYPE_HEX, a length byte and that many bytes for
+ * SF_CONSOLE_ARG_TYPE_STRING, or a choice byte for SF_CONSOLE_ARG_TYPE_ENUM */
+#define SF_CONSOLE_RPC_SOF              (0x7EU)
+#define SF_CONSOLE_RPC_HEADER_LENGTH    (3U)
+#define SF_CONSOLE_RPC_CRC_LENGTH       (2U)
+#define SF_CONSOLE_RPC_PAYLOAD_HEADER_LENGTH (4U)
+#define SF_CONSOLE_RPC_PAYLOAD_MAX      (256U)
+#define SF_CONSOLE_RPC_FRAME_LENGTH     (SF_CONSOLE_RPC_HEADER_LENGTH + SF_CONSOLE_RPC_PAYLOAD_MAX + \
+                                         SF_CONSOLE_RPC_CRC_LENGTH)
+
+/* Frame types */
+#define SF_CONSOLE_RPC_TYPE_REQUEST     (0x01U) /* Runs a command, the body holds its arguments as values */
+#define SF_CONSOLE_RPC_TYPE_OUTPUT      (0x02U) /* Text the command wrote */
+#define SF_CONSOLE_RPC_TYPE_VALUES      (0x03U) /* Values the command replied with */
+#define SF_CONSOLE_RPC_TYPE_RESULT      (0x04U) /* Ends a reply, the body is a uint32 fsp_err_t and the index
+                                                 * of the argument it is about */
+
+/* Command ids past the commands of the menus. The others number the commands
+ * of the menu tree from 0, root menu first, in the order listed */
+#define SF_CONSOLE_RPC_ID_OPEN          (0xFFFDU) /* Result sent when the rpc command switches to frames */
+#define SF_CONSOLE_RPC_ID_EXIT          (0xFFFEU) /* Switches back to text */
+#define SF_CONSOLE_RPC_ID_LIST          (0xFFFFU) /* One values frame per command: id, name and flags, then the
+                                                   * name, type, whether it is optional, the number of choices and
+                                                   * the choices of each argument */
+
+/* Time allowed for the rest of a frame once its SOF arrived */
+#define SF_CONSOLE_RPC_FRAME_TIMEOUT    (TX_TIMER_TICKS_PER_SECOND)
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+typedef struct st_sf_console_rpc
+{
+    /* Whether the rpc command may switch to frames, and whether it has */
+    bool                            enabled;
+    bool                            active;
+
+    /* Request being served, copied into its replies */
+    uint8_t                         sequence;
+    uint16_t                        id;
+
+    /* Request being served, string arguments point into it */
+    uint8_t                         rx_frame[SF_CONSOLE_RPC_FRAME_LENGTH];
+
+    /* Reply being sent, only used with transmission locked */
+    uint8_t                         tx_frame[SF_CONSOLE_RPC_FRAME_LENGTH];
+} sf_console_rpc_t;
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+fsp_err_t SF_CONSOLE_RpcStart(sf_console_ctrl_t * const p_console);
+fsp_err_t SF_CONSOLE_RpcServe(sf_console_ctrl_t * const p_console,
+                              sf_console_menu_t const * const p_menu,
+                              UINT const timeout);
+fsp_err_t SF_CONSOLE_RpcOutput(sf_console_ctrl_t * const p_console,
+                               uint8_t const * const p_src,
+                               uint32_t const bytes,
+                               UINT const timeout);
+fsp_err_t SF_CONSOLE_RpcValues(sf_console_ctrl_t * const p_console,
+                               sf_console_value_t const * const p_values,
+                               uint32_t const count);
+
+#endif // SF_CONSOLE_RPC_H
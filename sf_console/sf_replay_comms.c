@@ -0,0 +1,724 @@
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "sf_replay_comms.h"
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/******************************************************************************
+ * CONSTANTS
+ *****************************************************************************/
+#if defined(_WIN32)
+#define SF_REPLAY_COMMS_SYS_READ(fd, p_buf, bytes)  _read((fd), (p_buf), (unsigned int) (bytes))
+#else
+#define SF_REPLAY_COMMS_SYS_READ(fd, p_buf, bytes)  read((fd), (p_buf), (size_t) (bytes))
+#endif
+
+/* FNV-1a, lines are compared by length and hash so only their start is kept */
+#define SF_REPLAY_COMMS_HASH_BASIS      (2166136261UL)
+#define SF_REPLAY_COMMS_HASH_PRIME      (16777619UL)
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+static fsp_err_t sf_replay_comms_cursor_open(sf_replay_comms_cursor_t * p_cursor, int fd, uint8_t direction);
+static bool sf_replay_comms_cursor_next(sf_replay_comms_cursor_t * p_cursor);
+static bool sf_replay_comms_cursor_byte(sf_replay_comms_cursor_t * p_cursor, uint8_t * p_byte);
+static bool sf_replay_comms_cursor_varint(sf_replay_comms_cursor_t * p_cursor, uint64_t * p_value);
+static fsp_err_t sf_replay_comms_wait(sf_replay_comms_instance_ctrl_t * p_comms_ctrl,
+                                      ULONG start_ticks,
+                                      UINT timeout);
+static ULONG sf_replay_comms_ticks_left(ULONG start_ticks, UINT timeout);
+static void sf_replay_comms_line_end(sf_replay_comms_instance_ctrl_t * p_comms_ctrl);
+static bool sf_replay_comms_line_expected(sf_replay_comms_instance_ctrl_t * p_comms_ctrl,
+                                          uint8_t * p_line,
+                                          uint32_t * p_length,
+                                          uint32_t * p_hash);
+static void sf_replay_comms_difference(sf_replay_comms_instance_ctrl_t * p_comms_ctrl,
+                                       uint8_t const * p_expected,
+                                       uint32_t expected_length,
+                                       uint8_t const * p_actual,
+                                       uint32_t actual_length);
+static void sf_replay_comms_finish(sf_replay_comms_instance_ctrl_t * p_comms_ctrl);
+
+/******************************************************************************
+ * FUNCTION: SF_REPLAY_COMMS_Open
+ *****************************************************************************/
+fsp_err_t SF_REPLAY_COMMS_Open(sf_comms_ctrl_t * const p_ctrl, sf_comms_cfg_t const * const p_cfg)
+{
+    fsp_err_t fsp_err = FSP_SUCCESS;
+    sf_replay_comms_instance_ctrl_t * p_comms_ctrl = (sf_replay_comms_instance_ctrl_t *) p_ctrl;
+
+    if((NULL == p_comms_ctrl) || (NULL == p_cfg) || (NULL == p_cfg->p_extend))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    if(p_comms_ctrl->open)
+    {
+        return FSP_ERR_ALREADY_OPEN;
+    }
+
+    p_comms_ctrl->p_cfg = (sf_replay_comms_cfg_t const *) p_cfg->p_extend;
+    if(NULL == p_comms_ctrl->p_cfg->p_time_us)
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    memset(&p_comms_ctrl->stats, 0, sizeof(p_comms_ctrl->stats));
+    p_comms_ctrl->rx_pending    = false;
+    p_comms_ctrl->rx_given_us   = 0;
+    p_comms_ctrl->line_length   = 0;
+    p_comms_ctrl->line_hash     = SF_REPLAY_COMMS_HASH_BASIS;
+
+    fsp_err = sf_replay_comms_cursor_open(&p_comms_ctrl->rx, p_comms_ctrl->p_cfg->rx_fd, SF_CMD_COMMS_RECORD_RX);
+    if(FSP_SUCCESS == fsp_err)
+    {
+        fsp_err = sf_replay_comms_cursor_open(&p_comms_ctrl->tx, p_comms_ctrl->p_cfg->tx_fd, SF_CMD_COMMS_RECORD_TX);
+    }
+    if(FSP_SUCCESS != fsp_err)
+    {
+        return fsp_err;
+    }
+
+    if(TX_SUCCESS != tx_mutex_create(&p_comms_ctrl->rx_lock, SF_REPLAY_COMMS_RX_MUTEX_NAME, TX_INHERIT))
+    {
+        return FSP_ERR_INTERNAL;
+    }
+
+    if(TX_SUCCESS != tx_mutex_create(&p_comms_ctrl->tx_lock, SF_REPLAY_COMMS_TX_MUTEX_NAME, TX_INHERIT))
+    {
+        tx_mutex_delete(&p_comms_ctrl->rx_lock);
+        return FSP_ERR_INTERNAL;
+    }
+
+    if(TX_SUCCESS != tx_event_flags_create(&p_comms_ctrl->events, SF_REPLAY_COMMS_EVENTS_NAME))
+    {
+        tx_mutex_delete(&p_comms_ctrl->tx_lock);
+        tx_mutex_delete(&p_comms_ctrl->rx_lock);
+        return FSP_ERR_INTERNAL;
+    }
+
+    p_comms_ctrl->open_us   = p_comms_ctrl->p_cfg->p_time_us();
+    p_comms_ctrl->open      = true;
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: SF_REPLAY_COMMS_Close
+ *****************************************************************************/
+fsp_err_t SF_REPLAY_COMMS_Close(sf_comms_ctrl_t * const p_ctrl)
+{
+    sf_replay_comms_instance_ctrl_t * p_comms_ctrl = (sf_replay_comms_instance_ctrl_t *) p_ctrl;
+
+    if(!p_comms_ctrl->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    p_comms_ctrl->open = false;
+
+    /* The recording belongs to the caller, only the objects go */
+    tx_event_flags_delete(&p_comms_ctrl->events);
+    tx_mutex_delete(&p_comms_ctrl->tx_lock);
+    tx_mutex_delete(&p_comms_ctrl->rx_lock);
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: SF_REPLAY_COMMS_Read
+ *****************************************************************************/
+fsp_err_t SF_REPLAY_COMMS_Read(sf_comms_ctrl_t * const p_ctrl,
+                               uint8_t * const p_dest,
+                               uint32_t const bytes,
+                               UINT const timeout)
+{
+    fsp_err_t fsp_err = FSP_SUCCESS;
+    sf_replay_comms_instance_ctrl_t * p_comms_ctrl = (sf_replay_comms_instance_ctrl_t *) p_ctrl;
+    sf_replay_comms_cursor_t * p_rx = &p_comms_ctrl->rx;
+    ULONG start_ticks = tx_time_get();
+    uint32_t bytes_read = 0;
+
+    if(!p_comms_ctrl->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    if(TX_SUCCESS != tx_mutex_get(&p_comms_ctrl->rx_lock, timeout))
+    {
+        return FSP_ERR_TIMEOUT;
+    }
+
+    while((FSP_SUCCESS == fsp_err) && (bytes_read < bytes))
+    {
+        if(0U == p_rx->remaining)
+        {
+            /* A record is pending from when it is found until it is given, which may take several calls */
+            if(!p_comms_ctrl->rx_pending)
+            {
+                if(p_comms_ctrl->stats.finished)
+                {
+                    fsp_err = FSP_ERR_ABORTED;
+                    break;
+                }
+
+                /* Past the last record, other_bytes holds all the output recorded */
+                sf_replay_comms_cursor_next(p_rx);
+                p_comms_ctrl->rx_pending    = true;
+                p_comms_ctrl->pending_ticks = tx_time_get();
+            }
+
+            fsp_err = sf_replay_comms_wait(p_comms_ctrl, start_ticks, timeout);
+            if(FSP_SUCCESS != fsp_err)
+            {
+                break;
+            }
+
+            p_comms_ctrl->rx_pending = false;
+
+            /* The session hangs up once the console wrote what was recorded after the last input */
+            if(p_rx->end)
+            {
+                sf_replay_comms_finish(p_comms_ctrl);
+                fsp_err = FSP_ERR_ABORTED;
+                break;
+            }
+
+            p_comms_ctrl->stats.exchanges++;
+            p_comms_ctrl->rx_given_us = p_comms_ctrl->p_cfg->p_time_us();
+        }
+
+        uint8_t byte = 0;
+        if(!sf_replay_comms_cursor_byte(p_rx, &byte))
+        {
+            /* The recording ends inside a record, what was given is all there is */
+            p_rx->remaining = 0;
+            p_rx->end = true;
+            continue;
+        }
+
+        p_dest[bytes_read++] = byte;
+        p_rx->remaining--;
+        p_comms_ctrl->stats.rx_bytes++;
+    }
+
+    tx_mutex_put(&p_comms_ctrl->rx_lock);
+
+    return fsp_err;
+}
+
+/******************************************************************************
+ * FUNCTION: SF_REPLAY_COMMS_Write
+ *****************************************************************************/
+fsp_err_t SF_REPLAY_COMMS_Write(sf_comms_ctrl_t * const p_ctrl,
+                                uint8_t const * const p_src,
+                                uint32_t const bytes,
+                                UINT const timeout)
+{
+    sf_replay_comms_instance_ctrl_t * p_comms_ctrl = (sf_replay_comms_instance_ctrl_t *) p_ctrl;
+
+    if(!p_comms_ctrl->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    if(TX_SUCCESS != tx_mutex_get(&p_comms_ctrl->tx_lock, timeout))
+    {
+        return FSP_ERR_TIMEOUT;
+    }
+
+    for(uint32_t byte_num = 0; byte_num < bytes; byte_num++)
+    {
+        if(p_comms_ctrl->line_length < SF_REPLAY_COMMS_LINE_MAX)
+        {
+            p_comms_ctrl->line[p_comms_ctrl->line_length] = p_src[byte_num];
+        }
+        p_comms_ctrl->line_length++;
+        p_comms_ctrl->line_hash = (p_comms_ctrl->line_hash ^ p_src[byte_num]) * SF_REPLAY_COMMS_HASH_PRIME;
+
+        if('\n' == p_src[byte_num])
+        {
+            sf_replay_comms_line_end(p_comms_ctrl);
+        }
+    }
+
+    p_comms_ctrl->stats.tx_bytes += bytes;
+
+    tx_mutex_put(&p_comms_ctrl->tx_lock);
+
+    /* Wakes a read waiting for this output */
+    tx_event_flags_set(&p_comms_ctrl->events, SF_REPLAY_COMMS_EVENT_TX, TX_OR);
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: SF_REPLAY_COMMS_Lock
+ *****************************************************************************/
+fsp_err_t SF_REPLAY_COMMS_Lock(sf_comms_ctrl_t * const p_ctrl, sf_comms_lock_t lock_type, UINT timeout)
+{
+    sf_replay_comms_instance_ctrl_t * p_comms_ctrl = (sf_replay_comms_instance_ctrl_t *) p_ctrl;
+
+    if(!p_comms_ctrl->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    switch(lock_type)
+    {
+        case SF_COMMS_LOCK_TX:
+            return (TX_SUCCESS == tx_mutex_get(&p_comms_ctrl->tx_lock, timeout)) ? FSP_SUCCESS : FSP_ERR_TIMEOUT;
+
+        case SF_COMMS_LOCK_RX:
+            return (TX_SUCCESS == tx_mutex_get(&p_comms_ctrl->rx_lock, timeout)) ? FSP_SUCCESS : FSP_ERR_TIMEOUT;
+
+        case SF_COMMS_LOCK_ALL:
+            /* Always RX before TX, the console takes them in this order too */
+            if(TX_SUCCESS != tx_mutex_get(&p_comms_ctrl->rx_lock, timeout))
+            {
+                return FSP_ERR_TIMEOUT;
+            }
+            if(TX_SUCCESS != tx_mutex_get(&p_comms_ctrl->tx_lock, timeout))
+            {
+                tx_mutex_put(&p_comms_ctrl->rx_lock);
+                return FSP_ERR_TIMEOUT;
+            }
+            return FSP_SUCCESS;
+
+        default:
+            return FSP_ERR_INVALID_ARGUMENT;
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: SF_REPLAY_COMMS_Unlock
+ *****************************************************************************/
+fsp_err_t SF_REPLAY_COMMS_Unlock(sf_comms_ctrl_t * const p_ctrl, sf_comms_lock_t lock_type)
+{
+    sf_replay_comms_instance_ctrl_t * p_comms_ctrl = (sf_replay_comms_instance_ctrl_t *) p_ctrl;
+    UINT tx_err = TX_SUCCESS;
+
+    if(!p_comms_ctrl->open)
+    {
+        return FSP_ERR_NOT_OPEN;
+    }
+
+    switch(lock_type)
+    {
+        case SF_COMMS_LOCK_TX:
+            tx_err = tx_mutex_put(&p_comms_ctrl->tx_lock);
+            break;
+
+        case SF_COMMS_LOCK_RX:
+            tx_err = tx_mutex_put(&p_comms_ctrl->rx_lock);
+            break;
+
+        case SF_COMMS_LOCK_ALL:
+            tx_err = tx_mutex_put(&p_comms_ctrl->tx_lock);
+            if(TX_SUCCESS == tx_err)
+            {
+                tx_err = tx_mutex_put(&p_comms_ctrl->rx_lock);
+            }
+            break;
+
+        default:
+            return FSP_ERR_INVALID_ARGUMENT;
+    }
+
+    return (TX_SUCCESS == tx_err) ? FSP_SUCCESS : FSP_ERR_INVALID_CALL;
+}
+
+/******************************************************************************
+ * FUNCTION: SF_REPLAY_COMMS_StatsGet
+ *****************************************************************************/
+fsp_err_t SF_REPLAY_COMMS_StatsGet(sf_comms_ctrl_t * const p_ctrl, sf_replay_comms_stats_t * const p_stats)
+{
+    sf_replay_comms_instance_ctrl_t * p_comms_ctrl = (sf_replay_comms_instance_ctrl_t *) p_ctrl;
+
+    if((NULL == p_comms_ctrl) || (NULL == p_stats))
+    {
+        return FSP_ERR_ASSERTION;
+    }
+
+    /* Still valid after close, so the outcome can be reported once the session ended */
+    if(p_comms_ctrl->open)
+    {
+        tx_mutex_get(&p_comms_ctrl->tx_lock, TX_WAIT_FOREVER);
+        *p_stats = p_comms_ctrl->stats;
+        tx_mutex_put(&p_comms_ctrl->tx_lock);
+    }
+    else
+    {
+        *p_stats = p_comms_ctrl->stats;
+    }
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_replay_comms_cursor_open
+ *****************************************************************************/
+static fsp_err_t sf_replay_comms_cursor_open(sf_replay_comms_cursor_t * p_cursor, int fd, uint8_t direction)
+{
+    uint8_t header[SF_CMD_COMMS_RECORD_MAGIC_LENGTH + 1U];
+
+    memset(p_cursor, 0, sizeof(sf_replay_comms_cursor_t));
+    p_cursor->fd        = fd;
+    p_cursor->direction = direction;
+
+    for(uint32_t byte_num = 0; byte_num < sizeof(header); byte_num++)
+    {
+        if(!sf_replay_comms_cursor_byte(p_cursor, &header[byte_num]))
+        {
+            return FSP_ERR_INVALID_DATA;
+        }
+    }
+
+    if((0 != memcmp(header, SF_CMD_COMMS_RECORD_MAGIC, SF_CMD_COMMS_RECORD_MAGIC_LENGTH)) ||
+       (SF_CMD_COMMS_RECORD_VERSION != header[SF_CMD_COMMS_RECORD_MAGIC_LENGTH]))
+    {
+        return FSP_ERR_INVALID_DATA;
+    }
+
+    return FSP_SUCCESS;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_replay_comms_cursor_next
+ *****************************************************************************/
+static bool sf_replay_comms_cursor_next(sf_replay_comms_cursor_t * p_cursor)
+{
+    uint8_t byte = 0;
+
+    /* Whatever is left of the current record is not wanted */
+    while((p_cursor->remaining > 0U) && sf_replay_comms_cursor_byte(p_cursor, &byte))
+    {
+        p_cursor->remaining--;
+    }
+    p_cursor->remaining = 0;
+
+    while(!p_cursor->end)
+    {
+        uint8_t direction = 0;
+        uint64_t time_us = 0;
+        uint64_t length = 0;
+
+        if((!sf_replay_comms_cursor_byte(p_cursor, &direction)) ||
+           (!sf_replay_comms_cursor_varint(p_cursor, &time_us)) ||
+           (!sf_replay_comms_cursor_varint(p_cursor, &length)))
+        {
+            p_cursor->end = true;
+            break;
+        }
+
+        p_cursor->time_us += time_us;
+
+        if((direction == p_cursor->direction) && (length > 0U))
+        {
+            p_cursor->remaining = length;
+            return true;
+        }
+
+        /* Records of the other direction are skipped, but counted so input can wait for the output before it */
+        p_cursor->other_bytes += length;
+        while((length > 0U) && sf_replay_comms_cursor_byte(p_cursor, &byte))
+        {
+            length--;
+        }
+    }
+
+    return false;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_replay_comms_cursor_byte
+ *****************************************************************************/
+static bool sf_replay_comms_cursor_byte(sf_replay_comms_cursor_t * p_cursor, uint8_t * p_byte)
+{
+    if(p_cursor->head == p_cursor->tail)
+    {
+        int result = (int) SF_REPLAY_COMMS_SYS_READ(p_cursor->fd, p_cursor->buffer, SF_REPLAY_COMMS_BUFFER_SIZE);
+        if(result <= 0)
+        {
+            p_cursor->end = true;
+            return false;
+        }
+
+        p_cursor->head = (uint32_t) result;
+        p_cursor->tail = 0;
+    }
+
+    *p_byte = p_cursor->buffer[p_cursor->tail++];
+    return true;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_replay_comms_cursor_varint
+ *****************************************************************************/
+static bool sf_replay_comms_cursor_varint(sf_replay_comms_cursor_t * p_cursor, uint64_t * p_value)
+{
+    uint64_t value = 0;
+
+    /* 7 bits at a time, least significant first, a set top bit means more follow */
+    for(uint32_t shift = 0; shift < 64U; shift += 7U)
+    {
+        uint8_t byte = 0;
+        if(!sf_replay_comms_cursor_byte(p_cursor, &byte))
+        {
+            return false;
+        }
+
+        value |= ((uint64_t) (byte & 0x7FU)) << shift;
+        if(0U == (byte & 0x80U))
+        {
+            *p_value = value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_replay_comms_wait
+ *****************************************************************************/
+static fsp_err_t sf_replay_comms_wait(sf_replay_comms_instance_ctrl_t * p_comms_ctrl,
+                                      ULONG start_ticks,
+                                      UINT timeout)
+{
+    sf_replay_comms_cfg_t const * p_cfg = p_comms_ctrl->p_cfg;
+    sf_replay_comms_cursor_t * p_rx = &p_comms_ctrl->rx;
+
+    while(1)
+    {
+        ULONG ticks = 0;
+        uint64_t now_us = p_cfg->p_time_us();
+
+        if(p_cfg->paced)
+        {
+            uint64_t due_us = p_comms_ctrl->open_us + p_rx->time_us;
+            if(now_us >= due_us)
+            {
+                return FSP_SUCCESS;
+            }
+
+            /* Rounded up, waking early would only spin */
+            ticks = (ULONG) ((((due_us - now_us) * TX_TIMER_TICKS_PER_SECOND) + 999999U) / 1000000U);
+        }
+        else
+        {
+            ULONG waited = tx_time_get() - p_comms_ctrl->pending_ticks;
+            bool synced = (p_comms_ctrl->stats.tx_bytes >= p_rx->other_bytes);
+
+            if((!synced) && (waited >= p_cfg->sync_timeout))
+            {
+                /* The output never came, the input goes anyway so the rest of the recording still runs */
+                p_comms_ctrl->stats.stalls++;
+                p_comms_ctrl->rx_given_us = 0;
+                return FSP_SUCCESS;
+            }
+
+            if(synced)
+            {
+                /* The console answered the previous input, the time it took is the latency of that exchange */
+                if(0U != p_comms_ctrl->rx_given_us)
+                {
+                    uint64_t latency_us = now_us - p_comms_ctrl->rx_given_us;
+                    p_comms_ctrl->stats.latency_count++;
+                    p_comms_ctrl->stats.latency_total_us += latency_us;
+                    if(latency_us > p_comms_ctrl->stats.latency_max_us)
+                    {
+                        p_comms_ctrl->stats.latency_max_us = latency_us;
+                    }
+                    p_comms_ctrl->rx_given_us = 0;
+                }
+                return FSP_SUCCESS;
+            }
+
+            ticks = p_cfg->sync_timeout - waited;
+        }
+
+        ULONG ticks_left = sf_replay_comms_ticks_left(start_ticks, timeout);
+        if(0U == ticks_left)
+        {
+            return FSP_ERR_TIMEOUT;
+        }
+
+        if(ticks > ticks_left)
+        {
+            ticks = ticks_left;
+        }
+
+        if(p_cfg->paced)
+        {
+            tx_thread_sleep(ticks);
+        }
+        else
+        {
+            ULONG actual_events = 0;
+            tx_event_flags_get(&p_comms_ctrl->events, SF_REPLAY_COMMS_EVENT_TX, TX_OR_CLEAR, &actual_events, ticks);
+        }
+    }
+}
+
+/******************************************************************************
+ * FUNCTION: sf_replay_comms_ticks_left
+ *****************************************************************************/
+static ULONG sf_replay_comms_ticks_left(ULONG start_ticks, UINT timeout)
+{
+    if(TX_WAIT_FOREVER == timeout)
+    {
+        return TX_WAIT_FOREVER;
+    }
+
+    ULONG elapsed = tx_time_get() - start_ticks;
+    return (elapsed >= timeout) ? 0U : (timeout - elapsed);
+}
+
+/******************************************************************************
+ * FUNCTION: sf_replay_comms_line_end
+ *****************************************************************************/
+static void sf_replay_comms_line_end(sf_replay_comms_instance_ctrl_t * p_comms_ctrl)
+{
+    uint8_t expected[SF_REPLAY_COMMS_LINE_MAX];
+    uint32_t expected_length = 0;
+    uint32_t expected_hash = 0;
+    uint32_t actual_length = p_comms_ctrl->line_length;
+
+    if(actual_length > SF_REPLAY_COMMS_LINE_MAX)
+    {
+        actual_length = SF_REPLAY_COMMS_LINE_MAX;
+    }
+
+    p_comms_ctrl->stats.lines++;
+
+    if(!sf_replay_comms_line_expected(p_comms_ctrl, expected, &expected_length, &expected_hash))
+    {
+        p_comms_ctrl->stats.lines_extra++;
+        sf_replay_comms_difference(p_comms_ctrl, NULL, 0, p_comms_ctrl->line, actual_length);
+    }
+    else if((expected_length != p_comms_ctrl->line_length) || (expected_hash != p_comms_ctrl->line_hash))
+    {
+        p_comms_ctrl->stats.lines_differ++;
+        if(expected_length > SF_REPLAY_COMMS_LINE_MAX)
+        {
+            expected_length = SF_REPLAY_COMMS_LINE_MAX;
+        }
+        sf_replay_comms_difference(p_comms_ctrl, expected, expected_length, p_comms_ctrl->line, actual_length);
+    }
+
+    p_comms_ctrl->line_length   = 0;
+    p_comms_ctrl->line_hash     = SF_REPLAY_COMMS_HASH_BASIS;
+}
+
+/******************************************************************************
+ * FUNCTION: sf_replay_comms_line_expected
+ *****************************************************************************/
+static bool sf_replay_comms_line_expected(sf_replay_comms_instance_ctrl_t * p_comms_ctrl,
+                                          uint8_t * p_line,
+                                          uint32_t * p_length,
+                                          uint32_t * p_hash)
+{
+    sf_replay_comms_cursor_t * p_tx = &p_comms_ctrl->tx;
+    uint32_t length = 0;
+    uint32_t hash = SF_REPLAY_COMMS_HASH_BASIS;
+    uint8_t byte = 0;
+
+    /* Lines may span records, the console writes a line in as many pieces as it likes */
+    while(('\n' != byte) && ((p_tx->remaining > 0U) || sf_replay_comms_cursor_next(p_tx)))
+    {
+        if(!sf_replay_comms_cursor_byte(p_tx, &byte))
+        {
+            p_tx->remaining = 0;
+            break;
+        }
+        p_tx->remaining--;
+
+        if(length < SF_REPLAY_COMMS_LINE_MAX)
+        {
+            p_line[length] = byte;
+        }
+        length++;
+        hash = (hash ^ byte) * SF_REPLAY_COMMS_HASH_PRIME;
+    }
+
+    *p_length   = length;
+    *p_hash     = hash;
+    return (length > 0U);
+}
+
+/******************************************************************************
+ * FUNCTION: sf_replay_comms_difference
+ *****************************************************************************/
+static void sf_replay_comms_difference(sf_replay_comms_instance_ctrl_t * p_comms_ctrl,
+                                       uint8_t const * p_expected,
+                                       uint32_t expected_length,
+                                       uint8_t const * p_actual,
+                                       uint32_t actual_length)
+{
+    sf_replay_comms_stats_t * p_stats = &p_comms_ctrl->stats;
+
+    if(0U != p_stats->first_difference)
+    {
+        return;
+    }
+
+    p_stats->first_difference = p_stats->lines;
+
+    /* Kept printable, the report shows them between quotes */
+    for(uint32_t char_num = 0; char_num < expected_length; char_num++)
+    {
+        p_stats->expected[char_num] = ((p_expected[char_num] < 0x20U) || (p_expected[char_num] > 0x7EU)) ?
+                                      '.' : (CHAR) p_expected[char_num];
+    }
+    p_stats->expected[expected_length] = '\0';
+
+    for(uint32_t char_num = 0; char_num < actual_length; char_num++)
+    {
+        p_stats->actual[char_num] = ((p_actual[char_num] < 0x20U) || (p_actual[char_num] > 0x7EU)) ?
+                                    '.' : (CHAR) p_actual[char_num];
+    }
+    p_stats->actual[actual_length] = '\0';
+}
+
+/******************************************************************************
+ * FUNCTION: sf_replay_comms_finish
+ *****************************************************************************/
+static void sf_replay_comms_finish(sf_replay_comms_instance_ctrl_t * p_comms_ctrl)
+{
+    uint8_t expected[SF_REPLAY_COMMS_LINE_MAX];
+    uint32_t expected_length = 0;
+    uint32_t expected_hash = 0;
+
+    tx_mutex_get(&p_comms_ctrl->tx_lock, TX_WAIT_FOREVER);
+
+    /* The output usually ends with a prompt, which has no line end of its own */
+    if(p_comms_ctrl->line_length > 0U)
+    {
+        sf_replay_comms_line_end(p_comms_ctrl);
+    }
+
+    while(sf_replay_comms_line_expected(p_comms_ctrl, expected, &expected_length, &expected_hash))
+    {
+        p_comms_ctrl->stats.lines++;
+        p_comms_ctrl->stats.lines_missing++;
+        if(expected_length > SF_REPLAY_COMMS_LINE_MAX)
+        {
+            expected_length = SF_REPLAY_COMMS_LINE_MAX;
+        }
+        sf_replay_comms_difference(p_comms_ctrl, expected, expected_length, NULL, 0);
+    }
+
+    p_comms_ctrl->stats.elapsed_us  = p_comms_ctrl->p_cfg->p_time_us() - p_comms_ctrl->open_us;
+    p_comms_ctrl->stats.finished    = true;
+
+    tx_mutex_put(&p_comms_ctrl->tx_lock);
+}
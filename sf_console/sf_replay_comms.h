@@ -0,0 +1,142 @@
+#ifndef SF_REPLAY_COMMS_H
+#define SF_REPLAY_COMMS_H
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdbool.h>
+#include "sf_comms_api.h"
+#include "sf_cmd_comms.h"
+
+/******************************************************************************
+ * CONSTANTS
+ *****************************************************************************/
+/* Bytes of the recording read ahead by each cursor */
+#define SF_REPLAY_COMMS_BUFFER_SIZE     (256U)
+
+/* Characters of the first differing line kept for the report, longer lines
+ * still compare in full */
+#define SF_REPLAY_COMMS_LINE_MAX        (80U)
+
+#define SF_REPLAY_COMMS_RX_MUTEX_NAME   ("Replay Comms RX Mutex")
+#define SF_REPLAY_COMMS_TX_MUTEX_NAME   ("Replay Comms TX Mutex")
+#define SF_REPLAY_COMMS_EVENTS_NAME     ("Replay Comms Events")
+#define SF_REPLAY_COMMS_EVENT_TX        (0x00000001UL)
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+typedef struct st_sf_replay_comms_cfg
+{
+    /* The recording opened twice, one cursor feeds the input records and the
+     * other follows the output records the console is diffed against */
+    int                         rx_fd;
+    int                         tx_fd;
+
+    /* When false, input is given as soon as the console has written the
+     * output recorded before it, or after sync_timeout ticks without it.
+     * When true, input is given at the times it was recorded instead */
+    bool                        paced;
+    ULONG                       sync_timeout;
+
+    uint64_t                    (*p_time_us)(void);
+} sf_replay_comms_cfg_t;
+
+/* Position in one direction of the recording */
+typedef struct st_sf_replay_comms_cursor
+{
+    int                         fd;
+    uint8_t                     direction;
+    bool                        end;
+
+    /* Data bytes left in the current record */
+    uint64_t                    remaining;
+
+    /* Recorded time of the current record since the transport opened, and
+     * bytes of the other direction recorded before it */
+    uint64_t                    time_us;
+    uint64_t                    other_bytes;
+
+    uint32_t                    head;
+    uint32_t                    tail;
+    uint8_t                     buffer[SF_REPLAY_COMMS_BUFFER_SIZE];
+} sf_replay_comms_cursor_t;
+
+/* Outcome of a replay, output is compared a line at a time so a difference
+ * is counted once and the lines after it still line up */
+typedef struct st_sf_replay_comms_stats
+{
+    uint64_t                    rx_bytes;
+    uint64_t                    tx_bytes;
+
+    /* Input records given, and those given without the output recorded
+     * before them */
+    ULONG                       exchanges;
+    ULONG                       stalls;
+
+    /* Output lines compared, then those that differ, that were recorded but
+     * not written, and that were written past the end of the recording */
+    ULONG                       lines;
+    ULONG                       lines_differ;
+    ULONG                       lines_missing;
+    ULONG                       lines_extra;
+
+    /* First line that did not match, counting from 1, 0 if all did */
+    ULONG                       first_difference;
+    CHAR                        expected[SF_REPLAY_COMMS_LINE_MAX + 1U];
+    CHAR                        actual[SF_REPLAY_COMMS_LINE_MAX + 1U];
+
+    /* From open until the end of the recording was reached */
+    bool                        finished;
+    uint64_t                    elapsed_us;
+
+    /* Time from giving an input record until the console wrote the output
+     * recorded after it, only measured when not paced */
+    ULONG                       latency_count;
+    uint64_t                    latency_total_us;
+    uint64_t                    latency_max_us;
+} sf_replay_comms_stats_t;
+
+typedef struct st_sf_replay_comms_instance_ctrl
+{
+    sf_replay_comms_cfg_t const *p_cfg;
+    bool                        open;
+    uint64_t                    open_us;
+
+    TX_MUTEX                    rx_lock;
+    TX_MUTEX                    tx_lock;
+    TX_EVENT_FLAGS_GROUP        events;
+
+    /* Input record waiting to be given, since pending_ticks */
+    sf_replay_comms_cursor_t    rx;
+    bool                        rx_pending;
+    ULONG                       pending_ticks;
+    uint64_t                    rx_given_us;
+
+    /* Output line being written, only the start of it is kept */
+    sf_replay_comms_cursor_t    tx;
+    uint32_t                    line_length;
+    uint32_t                    line_hash;
+    uint8_t                     line[SF_REPLAY_COMMS_LINE_MAX];
+
+    sf_replay_comms_stats_t     stats;
+} sf_replay_comms_instance_ctrl_t;
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+fsp_err_t SF_REPLAY_COMMS_Open(sf_comms_ctrl_t * const p_ctrl, sf_comms_cfg_t const * const p_cfg);
+fsp_err_t SF_REPLAY_COMMS_Close(sf_comms_ctrl_t * const p_ctrl);
+fsp_err_t SF_REPLAY_COMMS_Read(sf_comms_ctrl_t * const p_ctrl,
+                               uint8_t * const p_dest,
+                               uint32_t const bytes,
+                               UINT const timeout);
+fsp_err_t SF_REPLAY_COMMS_Write(sf_comms_ctrl_t * const p_ctrl,
+                                uint8_t const * const p_src,
+                                uint32_t const bytes,
+                                UINT const timeout);
+fsp_err_t SF_REPLAY_COMMS_Lock(sf_comms_ctrl_t * const p_ctrl, sf_comms_lock_t lock_type, UINT timeout);
+fsp_err_t SF_REPLAY_COMMS_Unlock(sf_comms_ctrl_t * const p_ctrl, sf_comms_lock_t lock_type);
+fsp_err_t SF_REPLAY_COMMS_StatsGet(sf_comms_ctrl_t * const p_ctrl, sf_replay_comms_stats_t * const p_stats);
+
+#endif // SF_REPLAY_COMMS_H